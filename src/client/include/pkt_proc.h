@@ -42,6 +42,10 @@ void proc_pr_userlist(struct packet *pkt);
 void proc_pr_hot_load_enable(struct packet *pkt);
 void proc_pr_hot_load_disable(struct packet *pkt);
 void proc_pr_video_uri(struct packet *pkt);
+void proc_pr_sim_time(struct packet *pkt);
+void proc_pr_spec_seg(struct packet *pkt);
+void proc_pr_track(struct packet *pkt);
+void proc_pr_obs_status(struct packet *pkt);
 
 
 #endif /* _CLIENT_INCLUDE_PKT_PROC_H_ */
@@ -39,6 +39,9 @@ void sig_pr_userlist(const gchar *msg);
 void sig_pr_hot_load_enable(void);
 void sig_pr_hot_load_disable(void);
 void sig_pr_video_uri(const gchar *msg);
+void sig_pr_spec_seg(const struct spec_data *s);
+void sig_pr_track(const struct track *t);
+void sig_pr_obs_status(const struct obs_status *s);
 
 void sig_status_push(const gchar *msg);
 void sig_tracking(gboolean track, double ra, double de);
@@ -119,6 +119,22 @@ void process_pkt(struct packet *pkt)
 		proc_pr_video_uri(pkt);
 		break;
 
+	case PR_SIM_TIME:
+		proc_pr_sim_time(pkt);
+		break;
+
+	case PR_SPEC_SEG:
+		proc_pr_spec_seg(pkt);
+		break;
+
+	case PR_TRACK:
+		proc_pr_track(pkt);
+		break;
+
+	case PR_OBS_STATUS:
+		proc_pr_obs_status(pkt);
+		break;
+
 	default:
 		g_message("Service command %x not understood\n", pkt->service);
 		break;
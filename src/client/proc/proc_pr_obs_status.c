@@ -0,0 +1,46 @@
+/**
+ * @file    client/proc/proc_pr_obs_status.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <protocol.h>
+#include <signals.h>
+
+
+/**
+ * @brief process observation job status
+ */
+
+void proc_pr_obs_status(struct packet *pkt)
+{
+	struct obs_status *s;
+
+
+	g_debug("Server sent observation job status");
+
+	if (pkt->data_size != sizeof(struct obs_status)) {
+		g_message("\tobs status payload size mismatch %d != %d",
+			  sizeof(struct obs_status), pkt->data_size);
+		return;
+	}
+
+
+	s = (struct obs_status *) pkt->data;
+
+	sig_pr_obs_status(s);
+
+	return;
+}
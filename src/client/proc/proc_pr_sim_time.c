@@ -0,0 +1,68 @@
+/**
+ * @file    client/proc/proc_pr_sim_time.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief follow the simulated clock of the server
+ *
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <protocol.h>
+#include <coordinates.h>
+
+
+static struct {
+	gint64 epoch;	/* simulated time at last update (usec) */
+	gint64 ref;	/* local monotonic time at last update (usec) */
+	gdouble rate;	/* clock rate relative to real time */
+} sim_clk;
+
+
+/**
+ * @brief extrapolate the simulated time from the last update
+ */
+
+static time_t proc_pr_sim_time_now(void)
+{
+	gint64 t;
+
+
+	t = sim_clk.epoch;
+	t += (gint64) (sim_clk.rate * (gdouble) (g_get_monotonic_time()
+						 - sim_clk.ref));
+
+	return (time_t) (t / G_USEC_PER_SEC);
+}
+
+
+void proc_pr_sim_time(struct packet *pkt)
+{
+	struct sim_time t;
+
+
+	g_debug("Server sent simulated time");
+
+	if (pkt->data_size != sizeof(struct sim_time))
+		return;
+
+	memcpy(&t, pkt->data, sizeof(struct sim_time));
+
+	sim_clk.epoch = t.epoch_usec;
+	sim_clk.ref   = g_get_monotonic_time();
+	sim_clk.rate  = (gdouble) t.rate_milli * 0.001;
+
+	/* all coordinate computations now follow the server's clock */
+	coord_set_time_source(proc_pr_sim_time_now);
+}
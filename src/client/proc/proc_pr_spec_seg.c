@@ -0,0 +1,128 @@
+/**
+ * @file    client/proc/proc_pr_spec_seg.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief assemble the segments of a spectral sweep
+ *
+ * @note the sweep received so far is emitted as "pr-spec-seg" with every
+ *	 segment, the complete sweep is emitted as "pr-spec-data", just as if
+ *	 it had been sent in one piece; a sweep that was joined midway or is
+ *	 superseded by a new one before it completes is dropped
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <protocol.h>
+#include <signals.h>
+
+
+static struct {
+	uint32_t id;		/* the sweep being assembled */
+	uint16_t n_seg;		/* the number of segments in the sweep */
+	uint16_t n_rcv;		/* segments received in order */
+	uint32_t n_max;		/* the number of bins in the sweep */
+
+	struct spec_data *s;	/* the bins received so far */
+} sweep;
+
+
+/**
+ * @brief drop the current sweep
+ */
+
+static void proc_pr_spec_seg_drop(void)
+{
+	g_free(sweep.s);
+	sweep.s = NULL;
+}
+
+
+/**
+ * @brief start assembly of a new sweep
+ */
+
+static void proc_pr_spec_seg_new(const struct spec_seg *seg)
+{
+	proc_pr_spec_seg_drop();
+
+	sweep.id    = seg->sweep_id;
+	sweep.n_seg = seg->n_seg;
+	sweep.n_rcv = 0;
+	sweep.n_max = seg->sweep_n;
+
+	sweep.s = g_malloc0(sizeof(struct spec_data)
+			    + seg->sweep_n * sizeof(uint32_t));
+
+	sweep.s->freq_min_hz = seg->sweep_min_hz;
+	sweep.s->freq_max_hz = seg->sweep_max_hz;
+	sweep.s->freq_inc_hz = seg->freq_inc_hz;
+}
+
+
+/**
+ * @brief add a segment to the sweep
+ */
+
+static void proc_pr_spec_seg_add(const struct spec_seg *seg)
+{
+	if (!seg->idx)
+		proc_pr_spec_seg_new(seg);
+
+	/* segments arrive in order, anything else is from a sweep we did not
+	 * see from the start, or is inconsistent with the current one
+	 */
+	if (!sweep.s || seg->sweep_id != sweep.id || seg->idx != sweep.n_rcv ||
+	    seg->offset != sweep.s->n || seg->offset + seg->n > sweep.n_max) {
+		proc_pr_spec_seg_drop();
+		return;
+	}
+
+	memcpy(&sweep.s->spec[seg->offset], seg->spec,
+	       seg->n * sizeof(uint32_t));
+
+	sweep.s->n += seg->n;
+	sweep.n_rcv++;
+
+	if (sweep.n_rcv < sweep.n_seg) {
+		sig_pr_spec_seg(sweep.s);
+		return;
+	}
+
+	sig_pr_spec_data(sweep.s);
+
+	proc_pr_spec_seg_drop();
+}
+
+
+void proc_pr_spec_seg(struct packet *pkt)
+{
+	struct spec_seg *seg;
+
+
+	g_debug("Server sent spectral sweep segment");
+
+	if (pkt->data_size < sizeof(struct spec_seg))
+		return;
+
+	seg = g_malloc(pkt->data_size);
+
+	memcpy(seg, pkt->data, pkt->data_size);
+
+	if (pkt->data_size == sizeof(struct spec_seg)
+			      + seg->n * sizeof(uint32_t))
+		proc_pr_spec_seg_add(seg);
+
+	/* cleanup */
+	g_free(seg);
+}
@@ -0,0 +1,46 @@
+/**
+ * @file    client/proc/proc_pr_track.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <protocol.h>
+#include <signals.h>
+
+
+/**
+ * @brief process server tracking state
+ */
+
+void proc_pr_track(struct packet *pkt)
+{
+	struct track *t;
+
+
+	g_debug("Server sent tracking state");
+
+	if (pkt->data_size != sizeof(struct track)) {
+		g_message("\ttrack payload size mismatch %d != %d",
+			  sizeof(struct track), pkt->data_size);
+		return;
+	}
+
+
+	t = (struct track *) pkt->data;
+
+	sig_pr_track(t);
+
+	return;
+}
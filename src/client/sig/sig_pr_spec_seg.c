@@ -0,0 +1,33 @@
+/**
+ * @file    client/sig/sig_pr_spec_seg.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <signals.h>
+
+
+/**
+ * @brief emit pr-spec-seg signal
+ *
+ * @param s the part of the sweep received so far
+ */
+
+void sig_pr_spec_seg(const struct spec_data *s)
+{
+	g_debug("Emit signal \"pr-spec-seg\"");
+
+	g_signal_emit_by_name(sig_get_instance(), "pr-spec-seg", s);
+}
@@ -116,6 +116,30 @@ static void setup_sig_pr_spec_data(void)
 		     G_TYPE_NONE, 1, G_TYPE_POINTER);
 }
 
+static void setup_sig_pr_spec_seg(void)
+{
+	g_signal_new("pr-spec-seg",
+		     G_TYPE_OBJECT, G_SIGNAL_RUN_FIRST,
+		     0, NULL, NULL, NULL,
+		     G_TYPE_NONE, 1, G_TYPE_POINTER);
+}
+
+static void setup_sig_pr_track(void)
+{
+	g_signal_new("pr-track",
+		     G_TYPE_OBJECT, G_SIGNAL_RUN_FIRST,
+		     0, NULL, NULL, NULL,
+		     G_TYPE_NONE, 1, G_TYPE_POINTER);
+}
+
+static void setup_sig_pr_obs_status(void)
+{
+	g_signal_new("pr-obs-status",
+		     G_TYPE_OBJECT, G_SIGNAL_RUN_FIRST,
+		     0, NULL, NULL, NULL,
+		     G_TYPE_NONE, 1, G_TYPE_POINTER);
+}
+
 static void setup_sig_pr_getpos_azel(void)
 {
 	g_signal_new("pr-getpos-azel",
@@ -258,6 +282,9 @@ void sig_init(void)
 	setup_sig_pr_capabilities();
 	setup_sig_pr_capabilities_load();
 	setup_sig_pr_spec_data();
+	setup_sig_pr_spec_seg();
+	setup_sig_pr_track();
+	setup_sig_pr_obs_status();
 	setup_sig_pr_getpos_azel();
 	setup_sig_pr_spec_acq_enable();
 	setup_sig_pr_spec_acq_disable();
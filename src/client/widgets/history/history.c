@@ -37,19 +37,6 @@ G_DEFINE_TYPE_WITH_PRIVATE(History, history, GTK_TYPE_BOX)
 
 #define HISTORY_DEFAULT_HST_LEN 100
 
-/* waterfall colours */
-#define HISTORY_R_LO		0
-#define HISTORY_G_LO		0
-#define HISTORY_B_LO		0
-
-#define HISTORY_R_MID		255
-#define HISTORY_G_MID		0
-#define HISTORY_B_MID		0
-
-#define HISTORY_R_HI		255
-#define HISTORY_G_HI		255
-#define HISTORY_B_H		0
-
 #define HISTORY_REFRESH_HZ_CAP  30.
 
 #define HISTORY_REFRESH_AVG_LEN 10.
@@ -276,102 +263,6 @@ static void history_append_hst(History *p, const gdouble *amp, gsize len)
 }
 
 
-/**
- * @brief get an rgb colour mapping for a value
- *
- * @note the is scheme is stolen from somewhere, but I don't remember... d'oh!
- */
-
-static void history_wf_get_rgb(gdouble val, gdouble thr_lo, gdouble thr_hi,
-			       guchar *r, guchar *g, guchar *b)
-{
-	gdouble R, G, B;
-
-	gdouble f;
-
-
-	if (val < thr_lo) {
-		(*r) = HISTORY_R_LO;
-		(*g) = HISTORY_G_LO;
-		(*b) = HISTORY_G_LO;
-		return;
-	}
-
-	if (val > thr_hi) {
-		(*r) = HISTORY_R_HI;
-		(*g) = HISTORY_G_HI;
-		(*b) = HISTORY_G_HI;
-		return;
-	}
-
-	f = (val - thr_lo) / (thr_hi - thr_lo);
-
-	if (f < 2.0/9.0) {
-
-		f = f / (2.0 / 9.0);
-
-		R = (1.0 - f) * (gdouble) HISTORY_R_LO;
-		G = (1.0 - f) * (gdouble) HISTORY_G_LO;
-		B = HISTORY_B_LO + f * (gdouble) (255 - HISTORY_B_LO);
-
-
-	} else if (f < (3.0 / 9.0)) {
-
-		f = (f - 2.0 / 9.0 ) / (1.0 / 9.0);
-
-		R = 0.0;
-		G = 255.0 * f;
-		B = 255.0;
-
-	} else if (f < (4.0 / 9.0) ) {
-
-		f = (f - 3.0 / 9.0) / (1.0 / 9.0);
-
-		R = 0.0;
-		G = 255.0;
-		B = 255.0 * (1.0 - f);
-
-	} else if (f < (5.0 / 9.0)) {
-
-		f = (f - 4.0 / 9.0 ) / (1.0 / 9.0);
-
-		R = 255.0 * f;
-		G = 255.0;
-		B = 0.0;
-
-	} else if ( f < (7.0 / 9.0)) {
-
-		f = (f - 5.0 / 9.0 ) / (2.0 / 9.0);
-
-		R = 255.0;
-		G = 255.0 * (1.0 - f);
-		B = 0.0;
-
-	} else if( f < (8.0 / 9.0)) {
-
-		f = (f - 7.0 / 9.0 ) / (1.0 / 9.0);
-
-		R = 255.0;
-		G = 0.0;
-		B = 255.0 * f;
-
-	} else {
-
-		f = (f - 8.0 / 9.0 ) / (1.0 / 9.0);
-
-		R = 255.0 * (0.75 + 0.25 * (1.0 - f));
-		G = 0.5 * 255.0 * f;
-		B = 255.0;
-	}
-
-	(*r) = (guchar) R;
-	(*g) = (guchar) G;
-	(*b) = (guchar) B;
-}
-
-
-
-
 /**
  * @brief append new data set to waterfall
  */
@@ -388,7 +279,6 @@ static void history_append_wf(History *p, const gdouble *amp, gsize len)
 	gdouble n, n1;
 
 	guchar *wf;
-	guchar *pix;
 
 
 
@@ -462,15 +352,9 @@ static void history_append_wf(History *p, const gdouble *amp, gsize len)
 	gtk_range_set_range(GTK_RANGE(p->cfg->s_min),
 			    p->cfg->wf_av_min, p->cfg->wf_av_max);
 
-	pix = wf;
-
 	/* add new line */
-	for (i = 0; i < len; i++) {
-		history_wf_get_rgb((amp[i] - p->cfg->wf_min) / (max - min),
-				   p->cfg->th_lo, p->cfg->th_hi,
-				   &pix[0], &pix[1], &pix[2]);
-		pix += nc;
-	}
+	cmap_fill(&p->cfg->wf_cmap, amp, len, p->cfg->wf_min, 1.0 / (max - min),
+		  p->cfg->th_lo, p->cfg->th_hi, wf, nc);
 
 
 	gtk_widget_queue_draw(GTK_WIDGET(p->cfg->wf_da));
@@ -824,6 +708,7 @@ static void history_init(History *p)
 
 	p->cfg->wf_pb = NULL;
 	p->cfg->wf_da = GTK_DRAWING_AREA(gtk_drawing_area_new());
+	cmap_init(&p->cfg->wf_cmap);
 
 	p->cfg->th_lo = 0.01;
 	p->cfg->th_hi = 0.99;
@@ -20,6 +20,7 @@
 #include <history.h>
 #include <cmd.h>
 #include <xyplot.h>
+#include <colourmap.h>
 
 struct _HistoryConfig {
 
@@ -37,6 +38,7 @@ struct _HistoryConfig {
 
 	GdkPixbuf	       *wf_pb;
 	GtkDrawingArea	       *wf_da;
+	struct cmap		wf_cmap;
 
 	GtkScale               *s_lo;
 	GtkScale               *s_hi;
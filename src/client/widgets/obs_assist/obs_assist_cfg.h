@@ -294,7 +294,11 @@ struct _ObsAssistConfig {
 
 		gint n_avg;
 
-		gboolean wait;
+		guint32 id;		/* assigned by the server */
+		guint32 tag;		/* identifies the job until then */
+		guint16 trans_id;	/* of the job submission */
+		gulong id_status;
+		gulong id_fail;
 
 		GtkSpinButton *sb_glon_deg;
 		GtkSpinButton *sb_glat_deg;
@@ -307,6 +311,9 @@ struct _ObsAssistConfig {
 
 		GtkSpinButton *sb_avg;
 
+		GtkToggleButton *cb_otf;
+		gboolean otf;
+
 		GtkWidget *pbar_glon;
 		GtkWidget *pbar_glat;
 
@@ -30,32 +30,6 @@
 #include <math.h>
 
 
-static int once;
-
-/* a mechanism to allow recording of at least one
- * spectrum when a position has been reached;
- * this prevents apparent stalls in the zenith region
- * when tracking objects in coordinate systems other
- * than horizon; note: this is due to the zenith being
- * a pole where the changes in angular position between
- * the coordinate systems may occur faster than
- * the recording speed of a single spectrum
- */
-
-static void npoint_set_once(int arg)
-{
-	if (arg)
-		once = 1;
-	else
-		once = 0;
-}
-
-static int npoint_get_once(void)
-{
-	return once;
-}
-
-
 /**
  * @brief update the az progress bar
  */
@@ -160,235 +134,140 @@ static void npoint_draw_graph(ObsAssist *p)
 
 
 /**
- * @brief verify position and issue move command if necessary
- *
- * @param az the actual target Azimuth
- * @param el the actual target Elevation
- *
- * @returns TRUE if in position
- *
- * @note we use 1.5x the axis resolution for tolerance to avoid sampling issues
- *
+ * @brief stop following the observation job
  */
 
-static gboolean npoint_in_position(ObsAssist *p, gdouble az, gdouble el)
+static void npoint_release(ObsAssist *p)
 {
-	gdouble d_az;
-	gdouble d_el;
-
-	const gdouble az_tol = 1.5 * p->cfg->az_res;
-	const gdouble el_tol = 1.5 * p->cfg->el_res;
-
-
-	if (az < 0.0)
-		az = 360.0 + az;
-
-	d_az = fmod(fabs(az - p->cfg->az), 360.0);
-	d_el = fmod(fabs(el - p->cfg->el), 90.0);
-
-	if ((d_az > az_tol) || (d_el > el_tol)) {
-
-		obs_assist_clear_spec(p);
-
-		/* disable acquisition first */
-		if (p->cfg->acq_enabled)
-			cmd_spec_acq_disable(PKT_TRANS_ID_UNDEF);
+	if (!p->cfg->npoint.id_status)
+		return;
 
-		/* update position if telescope is not moving already */
-		if (!p->cfg->moving)
-			cmd_moveto_azel(PKT_TRANS_ID_UNDEF, az, el);
+	g_signal_handler_disconnect(sig_get_instance(),
+				    p->cfg->npoint.id_status);
+	g_signal_handler_disconnect(sig_get_instance(),
+				    p->cfg->npoint.id_fail);
 
-		return FALSE;
-	}
+	p->cfg->npoint.id_status = 0;
+	p->cfg->npoint.id_fail   = 0;
 
-	return TRUE;
+	g_array_free(p->cfg->npoint.glon,  TRUE);
+	g_array_free(p->cfg->npoint.glat,  TRUE);
+	g_array_free(p->cfg->npoint.amp, TRUE);
 }
 
 
 /**
- * @brief take a measurement
- *
- * @brief returns TRUE if measurement was taken
+ * @brief handle the status of the observation job
  *
- * @todo this should take actual glat/glon back-converted from the
- *	 horizontal position to avoid position aliasing, but needs
- *	 support in npoint_draw_graph for one-graph-per-scanline as well
+ * @note the job is executed by the server, we only collect the results
  */
 
-static gboolean npoint_measure(ObsAssist *p)
+static void npoint_handle_pr_obs_status(gpointer instance,
+					const struct obs_status *s,
+					ObsAssist *p)
 {
-	gsize i;
-
-	gdouble tmp = 0.0;
-
-	static guint sample;
-	static gdouble avg;
-#if 0
-	struct coord_horizontal hor;
-	struct coord_galactic gal;
-#endif
-
-	/* enable acquisition at current position */
-	if (!p->cfg->acq_enabled) {
-		cmd_spec_acq_enable(PKT_TRANS_ID_UNDEF);
-		return FALSE;
-	}
+	gdouble amp;
 
-	/* has new spectral data arrived? */
-	if (!p->cfg->spec.n)
-		return FALSE;
 
-	/* spec data has arrived, we may track again */
-	npoint_set_once(FALSE);
-
-	/* compute continuum flux */
-	for (i = 0; i < p->cfg->spec.n; i++)
-		tmp += p->cfg->spec.y[i];
-
-	tmp = tmp / (gdouble) p->cfg->spec.n;
+	if (s->tag != p->cfg->npoint.tag)
+		return;
 
-	avg += tmp;
+	p->cfg->npoint.id = s->id;
 
-	obs_assist_clear_spec(p);
+	if (p->cfg->abort) {
+		/* the job was not known yet when the user quit */
+		if (s->state == OBS_STATE_QUEUED ||
+		    s->state == OBS_STATE_RUNNING)
+			cmd_obs_cancel(PKT_TRANS_ID_UNDEF, s->id);
 
-	if (sample < p->cfg->npoint.n_avg) {
-		sample++;
-		return FALSE;
+		npoint_release(p);
+		return;
 	}
 
-	avg /= (gdouble) (sample + 1);
+	switch (s->state) {
+	case OBS_STATE_RUNNING:
+		p->cfg->npoint.glon_cur = (gdouble) s->lon_arcsec / 3600.0;
+		p->cfg->npoint.glat_cur = (gdouble) s->lat_arcsec / 3600.0;
 
-#if 0
-	hor.az = p->cfg->az;
-	hor.el = p->cfg->el;
+		if (s->valid) {
+			amp = (gdouble) s->amp * 0.001;
 
-	gal = horizontal_to_galactic(hor, p->cfg->lat, p->cfg->lon);
+			g_array_append_val(p->cfg->npoint.glon,
+					   p->cfg->npoint.glon_cur);
+			g_array_append_val(p->cfg->npoint.glat,
+					   p->cfg->npoint.glat_cur);
+			g_array_append_val(p->cfg->npoint.amp, amp);
 
-	g_print("at %g %g: %g %g vs %g %g\n", hor.az, hor.el, gal.lat, gal.lon,
-		p->cfg->npoint.glon_cur, p->cfg->npoint.glat_cur);
+			npoint_draw_graph(p);
+		}
+		break;
 
-	g_array_append_val(p->cfg->npoint.glon, gal.lon);
-	g_array_append_val(p->cfg->npoint.glat, gal.lat);
-#else
-	g_array_append_val(p->cfg->npoint.glon, p->cfg->npoint.glon_cur);
-	g_array_append_val(p->cfg->npoint.glat, p->cfg->npoint.glat_cur);
-#endif
-	g_array_append_val(p->cfg->npoint.amp, avg);
+	case OBS_STATE_DONE:
+		/* indicate complete, we stay at the final position */
+		p->cfg->npoint.glon_cur = p->cfg->npoint.glon_hi;
+		p->cfg->npoint.glat_cur = p->cfg->npoint.glat_hi;
+		npoint_release(p);
+		break;
 
+	case OBS_STATE_CANCELLED:
+		npoint_release(p);
+		return;
 
-	sample = 0;
-	avg = 0.0;
+	default:
+		return;
+	}
 
-	return TRUE;
+	npoint_update_pbar_glon(p);
+	npoint_update_pbar_glat(p);
 }
 
 
 /**
- * @brief move into position in glat/glon
+ * @brief handle a rejected job submission
  *
- * @returns TRUE if observation is ongoing, FALSE if complete
+ * @note the server reports no status for jobs it rejected, the failure
+ *	 itself is shown by the main window
  */
 
-static gboolean npoint_obs_pos(ObsAssist *p)
+static void npoint_handle_pr_fail(gpointer instance, guint16 trans_id,
+				  ObsAssist *p)
 {
-	gdouble lim;
-
-	struct coord_horizontal hor;
-	struct coord_galactic gal;
-
-
-	npoint_update_pbar_glon(p);
-	npoint_update_pbar_glat(p);
-
-	/* upper bound reached?  (glon after glat) */
-	lim = p->cfg->npoint.glon_cur;
-	if (p->cfg->npoint.glon_hi < lim) {
-		p->cfg->npoint.glat_cur = p->cfg->npoint.glat_hi;
-		p->cfg->npoint.glon_cur = p->cfg->npoint.glon_hi;
-		/* indicate complete */
-		npoint_update_pbar_glat(p);
-		npoint_update_pbar_glon(p);
-		return FALSE;
-	}
-
-
-	/* reset glat if upper glat bound reached and update glon */
-	if (p->cfg->npoint.glat_hi < p->cfg->npoint.glat_cur) {
-		p->cfg->npoint.glat_cur = p->cfg->npoint.glat_hi;
-		p->cfg->npoint.glon_cur += p->cfg->npoint.glon_stp;
-		p->cfg->npoint.glat_stp *= -1.0;
-
-	} else if (p->cfg->npoint.glat_lo > p->cfg->npoint.glat_cur) {
-		p->cfg->npoint.glat_cur = p->cfg->npoint.glat_lo;
-		p->cfg->npoint.glon_cur += p->cfg->npoint.glon_stp;
-		p->cfg->npoint.glat_stp *= -1.0;
-	}
-
-	gal.lat = p->cfg->npoint.glat_cur;
-	gal.lon = p->cfg->npoint.glon_cur;
-
-	hor = galactic_to_horizontal(gal, p->cfg->lat, p->cfg->lon, 0.0);
-
-
-	/* actual pointing is done in horizon system */
-	if (!npoint_get_once())
-		if (!npoint_in_position(p, hor.az, hor.el))
-			return TRUE;
-
-	/* we reached the position, allow at least one spectrum;
-	 * this will be cleared in npoint_measure()
-	 */
-	npoint_set_once(TRUE);
-
-	if (!npoint_measure(p))
-		return TRUE;
-
-	npoint_draw_graph(p);
-
-	/* update glat */
-	p->cfg->npoint.glat_cur += p->cfg->npoint.glat_stp;
-
-	/* set telescope position to be far off next measurement point
-	 * this mitigates aliasing if the galactic and horizontal grids
-	 * overlap in a way where the converted coordinates fall within
-	 * the move tolerance (i.e. aixs step size)
-	 */
+	if (trans_id != p->cfg->npoint.trans_id)
+		return;
 
-	p->cfg->az = -p->cfg->az;
-	p->cfg->el = -p->cfg->el;
+	if (p->cfg->npoint.id)
+		return;
 
-	return TRUE;
+	npoint_release(p);
 }
 
 
 /**
- * @brief perform azel scan
+ * @brief quit the observation
  */
 
-static gboolean npoint_obs(void *data)
+static void npoint_quit(GtkWidget *w, ObsAssist *p)
 {
-	ObsAssist *p;
-
-
-	p = OBS_ASSIST(data);
-
-	if (p->cfg->abort) {
-		/* we stay where we are */
-		return G_SOURCE_REMOVE;
+	/* if the job is not known yet, it is cancelled once it is */
+	if (p->cfg->npoint.id) {
+		cmd_obs_cancel(PKT_TRANS_ID_UNDEF, p->cfg->npoint.id);
+		npoint_release(p);
 	}
 
-	if (npoint_obs_pos(p))
-		return G_SOURCE_CONTINUE;
+	obs_assist_abort(w, p);
+}
 
-	/* on final, we stay at the current position */
 
+/**
+ * @brief convert degrees to arcseconds
+ */
 
-	/* done */
-	g_array_free(p->cfg->npoint.glon,  TRUE);
-	g_array_free(p->cfg->npoint.glat,  TRUE);
-	g_array_free(p->cfg->npoint.amp, TRUE);
+static int32_t npoint_arcsec(gdouble deg)
+{
+	if (!isfinite(deg))
+		return 0;
 
-	return G_SOURCE_REMOVE;
+	return (int32_t) lround(deg * 3600.0);
 }
 
 
@@ -402,6 +281,11 @@ static void on_assistant_apply(GtkWidget *as, ObsAssist *p)
 
 	GtkGrid *grid;
 
+	struct obs_job j = {0};
+
+
+	/* stop following a previous scan that never reported back */
+	npoint_release(p);
 
 	p->cfg->npoint.glon = g_array_new(FALSE, FALSE, sizeof(gdouble));
 	p->cfg->npoint.glat = g_array_new(FALSE, FALSE, sizeof(gdouble));
@@ -442,17 +326,51 @@ static void on_assistant_apply(GtkWidget *as, ObsAssist *p)
 	gtk_widget_set_tooltip_text(w, "Quit observation");
 	gtk_grid_attach(grid, w, 0, 3, 1, 1);
 	g_signal_connect(G_OBJECT(w), "clicked",
-			 G_CALLBACK(obs_assist_abort), p);
+			 G_CALLBACK(npoint_quit), p);
 
 
 	gtk_box_pack_start(GTK_BOX(p), GTK_WIDGET(grid), TRUE, TRUE, 0);
 	gtk_widget_show_all(GTK_WIDGET(grid));
 
+	npoint_update_pbar_glon(p);
+	npoint_update_pbar_glat(p);
 
-	/* the actual work is done asynchronously, .05 seconds calls
-	 * per should be fine
+
+	/* the scan is executed by the server, so it continues even if
+	 * we disconnect; the job is identified by a random tag until the
+	 * server has assigned an id
 	 */
-	g_timeout_add(50, npoint_obs, p);
+	p->cfg->npoint.id  = 0;
+	p->cfg->npoint.tag = g_random_int();
+
+	p->cfg->npoint.trans_id = (guint16) g_random_int_range(0,
+							PKT_TRANS_ID_UNDEF);
+
+	p->cfg->npoint.id_status = g_signal_connect(sig_get_instance(),
+				"pr-obs-status",
+				G_CALLBACK(npoint_handle_pr_obs_status),
+				(gpointer) p);
+
+	p->cfg->npoint.id_fail = g_signal_connect(sig_get_instance(),
+				"pr-fail",
+				G_CALLBACK(npoint_handle_pr_fail),
+				(gpointer) p);
+
+	j.tag   = p->cfg->npoint.tag;
+	j.sys   = OBS_SYS_GAL;
+	j.mode  = p->cfg->npoint.otf ? OBS_MODE_OTF : OBS_MODE_GRID;
+	j.n_avg = p->cfg->npoint.n_avg + 1;
+
+	j.lon_lo_arcsec  = npoint_arcsec(p->cfg->npoint.glon_lo);
+	j.lon_hi_arcsec  = npoint_arcsec(p->cfg->npoint.glon_hi);
+	j.lon_stp_arcsec = npoint_arcsec(p->cfg->npoint.glon_stp);
+	j.lat_lo_arcsec  = npoint_arcsec(p->cfg->npoint.glat_lo);
+	j.lat_hi_arcsec  = npoint_arcsec(p->cfg->npoint.glat_hi);
+	j.lat_stp_arcsec = npoint_arcsec(p->cfg->npoint.glat_stp);
+
+	g_strlcpy(j.name, "NPoint Scan", OBS_JOB_NAME_LEN);
+
+	cmd_obs_job(p->cfg->npoint.trans_id, &j);
 }
 
 
@@ -505,6 +423,9 @@ static void obs_assist_on_prepare_npoint(GtkWidget *as, GtkWidget *pg,
 	sb = p->cfg->npoint.sb_avg;
 	p->cfg->npoint.n_avg = gtk_spin_button_get_value_as_int(sb);
 
+	p->cfg->npoint.otf =
+		gtk_toggle_button_get_active(p->cfg->npoint.cb_otf);
+
 
 	/* swap around */
 	if (p->cfg->npoint.glon_lo > p->cfg->npoint.glon_hi) {
@@ -553,7 +474,8 @@ static void obs_assist_on_prepare_npoint(GtkWidget *as, GtkWidget *pg,
 	      "Gal. Lat. lower bound:     <b>%5.2f°</b>\n"
 	      "Gal. Lat. upper bound:     <b>%5.2f°</b>\n"
 	      "Gal. Lat. step size:       <b>%5.2f°</b>\n"
-	      "Samples per position:      <b>%d</b>\n\n"
+	      "Samples per position:      <b>%d</b>\n"
+	      "On-the-fly:                <b>%s</b>\n\n"
 	      "NOTE: step sizes may have been adjusted "
 	      "to fit specified ranges."
 	      "</tt>",
@@ -561,7 +483,8 @@ static void obs_assist_on_prepare_npoint(GtkWidget *as, GtkWidget *pg,
 	      p->cfg->npoint.glon_stp,
 	      p->cfg->npoint.glat_lo, p->cfg->npoint.glat_hi,
 	      p->cfg->npoint.glat_stp,
-	      p->cfg->npoint.n_avg);
+	      p->cfg->npoint.n_avg,
+	      p->cfg->npoint.otf ? "yes" : "no");
 
 
         gtk_label_set_markup(GTK_LABEL(w), lbl);
@@ -744,6 +667,24 @@ static void obs_assist_npoint_create_page_2(GtkAssistant *as, ObsAssist *p)
 	p->cfg->npoint.sb_avg = GTK_SPIN_BUTTON(sb);
 
 
+	/** On-the-fly **/
+	w = gui_create_desclabel("On-the-fly Scan",
+				 "If enabled, the telescope sweeps every "
+				 "Galactic Latitude row continuously and each "
+				 "spectrum is mapped at the position it was "
+				 "recorded at. The Latitude step size and the "
+				 "samples per position are not used. The "
+				 "server rejects the scan if its drive cannot "
+				 "be observed while moving, e.g. the SRT or "
+				 "the simulator.");
+	gtk_grid_attach(grid, w, 0, 7, 1, 1);
+
+	w = gtk_check_button_new_with_label("On-the-fly");
+	gtk_widget_set_valign(w, GTK_ALIGN_CENTER);
+	gtk_grid_attach(grid, w, 1, 7, 1, 1);
+	p->cfg->npoint.cb_otf = GTK_TOGGLE_BUTTON(w);
+
+
 
 	gtk_widget_show_all(GTK_WIDGET(grid));
 
@@ -1567,7 +1567,7 @@ static PangoLayout *sky_time_info_layout(cairo_t *cr, double time_offset)
 	s = ((time_offset - h) * 60.0 - m) * 60.0;
 
 
-	t = time(NULL);
+	t = coord_time();
 	now = (*localtime(&t));
 	now.tm_hour += (int) h;
 	now.tm_min  += (int) m;
@@ -984,6 +984,9 @@ static void spectrum_handle_pr_spec_data(gpointer instance,
 	if (!s->n)
 		return;
 
+	/* the sweep is complete */
+	xyplot_drop_graph(p->cfg->plot, p->cfg->r_seg);
+	p->cfg->r_seg = NULL;
 
 
 	/* update positions */
@@ -1026,6 +1029,52 @@ static void spectrum_handle_pr_spec_data(gpointer instance,
 }
 
 
+/**
+ * @brief handle a partial sweep
+ *
+ * @note the part of the sweep received so far replaces the previous one, it
+ *	 is dropped once the sweep is complete
+ */
+
+static void spectrum_handle_pr_spec_seg(gpointer instance,
+					const struct spec_data *s,
+					gpointer data)
+{
+	uint64_t i;
+	uint64_t f;
+
+	gdouble *frq;
+	gdouble *amp;
+
+	Spectrum *p;
+
+	p = SPECTRUM(data);
+
+
+	xyplot_drop_graph(p->cfg->plot, p->cfg->r_seg);
+	p->cfg->r_seg = NULL;
+
+	if (!s->n)
+		return;
+
+
+	frq = g_malloc(s->n * sizeof(gdouble));
+	amp = g_malloc(s->n * sizeof(gdouble));
+
+	for (i = 0, f = s->freq_min_hz; i < s->n; i++, f += s->freq_inc_hz) {
+		frq[i] = (gdouble) f * 1e-6;		/* Hz to Mhz */
+		amp[i] = (gdouble) s->spec[i] * 0.001;	/* mK to K */
+	}
+
+	p->cfg->r_seg = xyplot_add_graph(p->cfg->plot, frq, amp, NULL, s->n,
+					 g_strdup_printf("SWEEP"));
+	xyplot_set_graph_style(p->cfg->plot, p->cfg->r_seg, p->cfg->s_per);
+	xyplot_set_graph_rgba(p->cfg->plot, p->cfg->r_seg, p->cfg->c_per);
+
+	spectrum_plot_try_refresh(p->cfg->plot, p);
+}
+
+
 /**
  * @brief button reset average callback
  */
@@ -1531,6 +1580,7 @@ static gboolean spectrum_destroy(GtkWidget *w, void *data)
 	p = SPECTRUM(w);
 
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_spd);
+	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_seg);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_acq);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_ena);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_dis);
@@ -1580,6 +1630,8 @@ static void spectrum_init(Spectrum *p)
 	p->cfg->s_avg = STAIRS;
 	p->cfg->c_avg = COLOR_WHITE;
 
+	p->cfg->r_seg = NULL;
+
 	p->cfg->per   = NULL;
 	p->cfg->n_per = SPECTRUM_DEFAULT_PER_LEN;
 	p->cfg->r_per = NULL;
@@ -1601,6 +1653,10 @@ static void spectrum_init(Spectrum *p)
 			 G_CALLBACK(spectrum_handle_pr_spec_data),
 			 (gpointer) p);
 
+	p->cfg->id_seg = g_signal_connect(sig_get_instance(), "pr-spec-seg",
+			 G_CALLBACK(spectrum_handle_pr_spec_seg),
+			 (gpointer) p);
+
 	p->cfg->id_acq = g_signal_connect(sig_get_instance(), "pr-status-acq",
 			 G_CALLBACK(spectrum_handle_pr_status_acq),
 			 (gpointer) p);
@@ -63,6 +63,8 @@ struct _SpectrumConfig {
 	enum xyplot_graph_style s_avg;
 	GdkRGBA                 c_avg;
 
+	void                   *r_seg;
+
 	GtkSwitch *sw_acq;
 
 	struct fitdata fit;
@@ -79,6 +81,7 @@ struct _SpectrumConfig {
 	gdouble refresh;
 
 	guint id_spd;
+	guint id_seg;
 	guint id_acq;
 	guint id_ena;
 	guint id_dis;
@@ -122,15 +122,13 @@ static gboolean telescope_destroy(GtkWidget *w, void *data)
 
 	p = TELESCOPE(w);
 
-	if (p->cfg->tracking)
-		g_source_remove(p->cfg->id_to);
-
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_tgt);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_cap);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_pos);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_trk);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_mov);
 	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_con);
+	g_signal_handler_disconnect(sig_get_instance(), p->cfg->id_srv);
 
 	return TRUE;
 }
@@ -201,6 +199,10 @@ static void telescope_init(Telescope *p)
 				  (GCallback) telescope_connected,
 				  (gpointer) p);
 
+	p->cfg->id_srv = g_signal_connect(sig_get_instance(), "pr-track",
+				  (GCallback) telescope_tracker_pr_track_cb,
+				  (gpointer) p);
+
 	g_signal_connect(p, "destroy", G_CALLBACK(telescope_destroy), NULL);
 }
 
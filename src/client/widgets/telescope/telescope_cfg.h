@@ -61,13 +61,13 @@ struct _TelescopeConfig {
 
 	GtkSwitch *sw_trk;
 
-	guint id_to;
 	guint id_cap;
 	guint id_pos;
 	guint id_trk;
 	guint id_mov;
 	guint id_tgt;
 	guint id_con;
+	guint id_srv;
 };
 
 
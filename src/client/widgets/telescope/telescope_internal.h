@@ -38,5 +38,8 @@ void telescope_tracker_getpos_azel_cb(gpointer instance,
 void telescope_tracker_moveto_azel_cb(gpointer instance,
 				      gdouble az, gdouble el, Telescope *p);
 
+void telescope_tracker_pr_track_cb(gpointer instance,
+				   const struct track *t, Telescope *p);
+
 
 #endif /* _WIDGETS_TELESCOPE_INTERNAL_H_ */
@@ -131,10 +131,11 @@ static void telescope_set_pos_cb(GtkWidget *w, Telescope *p)
 	p->cfg->track_ra = equ.ra;
 	p->cfg->track_de = equ.dec;
 
-	/* if tracking is on, let the tracker do the move */
+	/* if tracking is on, let the tracker do the move; this also
+	 * signals the tracked position to other components
+	 */
 	if (p->cfg->tracking) {
-		/* signal tracked position to other components */
-		sig_tracking(TRUE, equ.ra, equ.dec);
+		sig_tracking(TRUE, hor.az, hor.el);
 		return;
 	}
 
@@ -333,70 +334,16 @@ GtkWidget *telescope_recal_pointing_new(Telescope *p)
 
 
 /**
- * @brief signal handler (tracker) for the timeout callback
+ * @brief send the tracked position to the server
  *
+ * @note the server tracks the position on its own, so it remains pointed
+ *	 at the target even if we disconnect
  */
 
-static gboolean telescope_track_timeout_cb(void *data)
+static void telescope_track_send(Telescope *p)
 {
-	static int once;
-
-	struct coord_horizontal hor;
-	struct coord_equatorial	equ;
-
-	Telescope *p;
-
-
-
-	p = (Telescope *) data;
-
-
-	/* Attempt one position update on the remote, but otherwise do not
-	 * send updates while the telescope is moving. This way we do not spam
-	 * the server for no reason, but can still insert a position update
-	 * if the current move different from our target location
-	 */
-	if (p->cfg->moving) {
-		if (once)
-			return p->cfg->tracking;
-		once++;
-	}
-	once = 0;
-
-	equ.ra  = p->cfg->track_ra;
-	equ.dec = p->cfg->track_de;
-
-	hor = equatorial_to_horizontal(equ, p->cfg->lat, p->cfg->lon, 0.0);
-
-	/* stop tracking if out of bounds
-	 * NOTE: identical az limits are interpreted as no limit!
-	 */
-
-	if (p->cfg->az_max != p->cfg->az_min) {
-		if (hor.az > p->cfg->az_max)
-			p->cfg->tracking = G_SOURCE_REMOVE;
-
-		if (hor.az < p->cfg->az_min)
-			p->cfg->tracking = G_SOURCE_REMOVE;
-	}
-
-	if (hor.el > p->cfg->el_max)
-		p->cfg->tracking = G_SOURCE_REMOVE;
-
-	if (hor.el < p->cfg->el_min)
-		p->cfg->tracking = G_SOURCE_REMOVE;
-
-
-	if ((fabs(hor.az - p->cfg->tgt_az) < p->cfg->az_res) &&
-	     fabs(hor.el - p->cfg->tgt_el) < p->cfg->el_res)
-		return p->cfg->tracking;
-
-	if (p->cfg->tracking)
-		cmd_moveto_azel(PKT_TRANS_ID_UNDEF, hor.az, hor.el);
-	else
-		gtk_switch_set_state(GTK_SWITCH(p->cfg->sw_trk), FALSE);
-
-	return p->cfg->tracking;
+	cmd_track(PKT_TRANS_ID_UNDEF, TRUE, TRACK_SYS_EQU,
+		  HOUR_TO_DEG(p->cfg->track_ra), p->cfg->track_de);
 }
 
 
@@ -407,9 +354,6 @@ static gboolean telescope_track_timeout_cb(void *data)
 static gboolean telescope_track_sky_toggle_cb(GtkWidget *w,
 					      gboolean state, Telescope *p)
 {
-	const GSourceFunc sf = telescope_track_timeout_cb;
-
-
 	if (p->cfg->track_ra == DBL_MIN) {
 		gtk_switch_set_state(GTK_SWITCH(w), FALSE);
 
@@ -421,11 +365,15 @@ static gboolean telescope_track_sky_toggle_cb(GtkWidget *w,
 		if (p->cfg->tracking)	/* already at it */
 			return TRUE;
 
-		p->cfg->tracking = G_SOURCE_CONTINUE;
-		p->cfg->id_to = g_timeout_add_seconds(1, sf, p);
+		p->cfg->tracking = TRUE;
+		telescope_track_send(p);
 	} else {
-		g_source_remove(p->cfg->id_to);
-		p->cfg->tracking = G_SOURCE_REMOVE;
+		/* already stopped, e.g. by the server */
+		if (!p->cfg->tracking)
+			return FALSE;
+
+		p->cfg->tracking = FALSE;
+		cmd_track(PKT_TRANS_ID_UNDEF, FALSE, TRACK_SYS_EQU, 0.0, 0.0);
 
 		sig_tracking(FALSE, 0.0, 0.0);
 
@@ -511,7 +459,7 @@ void telescope_tracker_ctrl(gpointer instance, gboolean state,
 	struct coord_equatorial	equ;
 
 
-	if (state == p->cfg->tracking)
+	if (!state && !p->cfg->tracking)
 		return;
 
 	if (state) {
@@ -524,6 +472,12 @@ void telescope_tracker_ctrl(gpointer instance, gboolean state,
 		p->cfg->track_de = equ.dec;
 	}
 
+	/* already tracking, just update the target */
+	if (state && p->cfg->tracking) {
+		telescope_track_send(p);
+		return;
+	}
+
 
 	if (state)
 		gtk_switch_set_state(p->cfg->sw_trk, TRUE);
@@ -533,6 +487,49 @@ void telescope_tracker_ctrl(gpointer instance, gboolean state,
 }
 
 
+/**
+ * @brief callback to follow the tracking state of the server
+ */
+
+void telescope_tracker_pr_track_cb(gpointer instance, const struct track *t,
+				   Telescope *p)
+{
+	gdouble lon;
+	gdouble lat;
+
+	struct coord_galactic gal;
+	struct coord_equatorial	equ;
+
+
+	if (t->enable) {
+		lon = (gdouble) t->lon_arcsec / 3600.0;
+		lat = (gdouble) t->lat_arcsec / 3600.0;
+
+		if (t->sys == TRACK_SYS_GAL) {
+			gal.lon = lon;
+			gal.lat = lat;
+			equ = galactic_to_equatorial(gal);
+		} else {
+			equ.ra  = DEG_TO_HOUR(lon);
+			equ.dec = lat;
+		}
+
+		p->cfg->track_ra = equ.ra;
+		p->cfg->track_de = equ.dec;
+	}
+
+	if ((t->enable != 0) == p->cfg->tracking)
+		return;
+
+	/* update the state first, so the switch does not send a command */
+	p->cfg->tracking = (t->enable != 0);
+	gtk_switch_set_state(p->cfg->sw_trk, p->cfg->tracking);
+
+	if (!p->cfg->tracking)
+		sig_tracking(FALSE, 0.0, 0.0);
+}
+
+
 /**
  * @brief create telescope PARK button
  */
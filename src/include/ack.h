@@ -48,6 +48,11 @@ struct packet *ack_hot_load_disable_gen(uint16_t trans_id);
 struct packet *ack_cold_load_enable_gen(uint16_t trans_id);
 struct packet *ack_cold_load_disable_gen(uint16_t trans_id);
 struct packet *ack_video_uri_gen(uint16_t trans_id, const uint8_t *uri, uint16_t len);
+struct packet *ack_sim_time_gen(uint16_t trans_id, struct sim_time *t);
+struct packet *ack_spec_seg_gen(uint16_t trans_id, struct spec_seg *s);
+struct packet *ack_track_gen(uint16_t trans_id, uint32_t enable, uint32_t sys,
+			     double lon, double lat);
+struct packet *ack_obs_status_gen(uint16_t trans_id, struct obs_status *s);
 
 
 
@@ -76,6 +81,19 @@ void ack_hot_load_disable(uint16_t trans_id);
 void ack_cold_load_enable(uint16_t trans_id);
 void ack_cold_load_disable(uint16_t trans_id);
 void ack_video_uri(uint16_t trans_id, const uint8_t *uri, uint16_t len);
+void ack_sim_time(uint16_t trans_id, struct sim_time *t);
+void ack_spec_seg(uint16_t trans_id, struct spec_seg *s);
+void ack_spec_data_seg(uint16_t trans_id, const struct spec_data *s,
+		       uint32_t sweep_id, uint16_t idx, uint16_t n_seg,
+		       uint32_t sweep_n, uint32_t off, uint32_t n);
+void ack_track(uint16_t trans_id, uint32_t enable, uint32_t sys,
+	       double lon, double lat);
+void ack_obs_status(uint16_t trans_id, struct obs_status *s);
+
+/* observer of the spectral data sent by the server */
+void ack_spec_set_observer(void (*fn)(const uint32_t *spec, uint32_t n,
+				      gboolean last));
+void ack_spec_notify(const uint32_t *spec, uint32_t n, gboolean last);
 
 #endif /* _INCLUDE_ACK_H_ */
 
@@ -51,6 +51,10 @@ struct packet *cmd_hot_load_enable_gen(uint16_t trans_id);
 struct packet *cmd_hot_load_disable_gen(uint16_t trans_id);
 struct packet *cmd_cold_load_enable_gen(uint16_t trans_id);
 struct packet *cmd_cold_load_disable_gen(uint16_t trans_id);
+struct packet *cmd_track_gen(uint16_t trans_id, uint32_t enable, uint32_t sys,
+			     double lon, double lat);
+struct packet *cmd_obs_job_gen(uint16_t trans_id, struct obs_job *j);
+struct packet *cmd_obs_cancel_gen(uint16_t trans_id, uint32_t id);
 
 
 /* command generation and sending functions */
@@ -77,6 +81,10 @@ void cmd_hot_load_enable(uint16_t trans_id);
 void cmd_hot_load_disable(uint16_t trans_id);
 void cmd_cold_load_enable(uint16_t trans_id);
 void cmd_cold_load_disable(uint16_t trans_id);
+void cmd_track(uint16_t trans_id, uint32_t enable, uint32_t sys,
+	       double lon, double lat);
+void cmd_obs_job(uint16_t trans_id, struct obs_job *j);
+void cmd_obs_cancel(uint16_t trans_id, uint32_t id);
 
 
 #endif /* _INCLUDE_CMD_H_ */
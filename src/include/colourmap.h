@@ -0,0 +1,47 @@
+/**
+ * @file    colourmap.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _COLOURMAP_H_
+#define _COLOURMAP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/* number of colours between the lower and upper threshold */
+#define CMAP_LUT_LEN	4096
+
+
+/**
+ * @brief a false-colour lookup table
+ *
+ * @note entry 0 is the colour below the lower threshold, entry
+ *	 CMAP_LUT_LEN + 1 the colour above the upper threshold
+ */
+
+struct cmap {
+	uint8_t rgb[CMAP_LUT_LEN + 2][3];
+};
+
+
+void cmap_init(struct cmap *c);
+
+void cmap_fill(const struct cmap *c, const double *val, size_t n,
+	       double off, double scale, double th_lo, double th_hi,
+	       uint8_t *pix, size_t nc);
+
+
+#endif /* _COLOURMAP_H_ */
@@ -42,6 +42,10 @@ struct coord_galactic{
 };
 
 
+void coord_set_time_source(time_t (*src)(void));
+
+time_t coord_time(void);
+
 struct tm *get_UT(void);
 
 time_t epoch(void);
@@ -17,6 +17,7 @@
 #ifndef _FOURIER_TRANSFORM_H_
 #define _FOURIER_TRANSFORM_H_
 
+#include <stddef.h>
 #include <complex.h>
 
 #define FFT_FORWARD 0
@@ -34,6 +35,21 @@ double complex *fft_extract(const double complex *data, size_t fftsize,
 
 double complex *fft_prepare_coeff(size_t n, int inv);
 
+struct fft_plan;
+
+struct fft_plan *fft_plan_create(size_t n, int inv);
+void fft_plan_destroy(struct fft_plan *p);
+size_t fft_plan_size(const struct fft_plan *p);
+void fft_plan_execute(const struct fft_plan *p, double complex *data);
+
+struct fft2d_plan;
+
+struct fft2d_plan *fft2d_plan_create(size_t w, size_t h);
+void fft2d_plan_destroy(struct fft2d_plan *p);
+void fft2d_r2c(const struct fft2d_plan *p, const double *data,
+	       double complex *out);
+void fft2d_c2r(const struct fft2d_plan *p, double complex *data, double *out);
+
 
 void dft(double complex *in, double complex *out, int N);
 void idft(double complex *in, double complex *out, int N);
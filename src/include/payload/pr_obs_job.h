@@ -0,0 +1,78 @@
+/**
+ * @file    include/payload/pr_obs_job.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief payload structures for PR_OBS_JOB and PR_OBS_CANCEL
+ *
+ * @note a job maps a grid of positions; the inner axis is latitude (or
+ *	 elevation, declination), traversed back and forth for every step
+ *	 of the outer axis
+ *
+ * @note in on-the-fly mode, the drive sweeps every row of the inner axis
+ *	 continuously while spectra are recorded; every spectrum is reported
+ *	 at the position the drive was in during its integration, so the
+ *	 inner axis step is not used and neither is the number of averages
+ */
+
+#ifndef _INCLUDE_PAYLOAD_PR_OBS_JOB_H_
+#define _INCLUDE_PAYLOAD_PR_OBS_JOB_H_
+
+
+#define OBS_SYS_EQU	TRACK_SYS_EQU	/* right ascension/declination */
+#define OBS_SYS_GAL	TRACK_SYS_GAL	/* galactic longitude/latitude */
+#define OBS_SYS_HOR	2		/* azimuth/elevation */
+
+#define OBS_MODE_GRID	0		/* stop at every position */
+#define OBS_MODE_OTF	1		/* scan rows on the fly */
+
+#define OBS_JOB_NAME_LEN	32
+
+
+/**
+ * PR_OBS_JOB packet payload structure
+ */
+
+struct obs_job {
+	uint32_t id;			/* assigned by the server */
+	uint32_t tag;			/* chosen by the submitter, echoed in
+					 * the job's status updates
+					 */
+	uint32_t sys;			/* OBS_SYS_* */
+	uint32_t mode;			/* OBS_MODE_* */
+
+	/* RA is in degrees, not hours! */
+	int32_t lon_lo_arcsec;		/* outer axis lower bound */
+	int32_t lon_hi_arcsec;		/* outer axis upper bound */
+	int32_t lon_stp_arcsec;		/* outer axis step, 0 for a single one */
+
+	int32_t lat_lo_arcsec;		/* inner axis lower bound */
+	int32_t lat_hi_arcsec;		/* inner axis upper bound */
+	int32_t lat_stp_arcsec;		/* inner axis step, 0 for a single one */
+
+	uint32_t n_avg;			/* spectra to average per position */
+
+	char name[OBS_JOB_NAME_LEN];	/* NUL-terminated */
+};
+
+
+/**
+ * PR_OBS_CANCEL packet payload structure
+ */
+
+struct obs_cancel {
+	uint32_t id;			/* the job to cancel, 0 for all */
+};
+
+
+
+#endif /* _INCLUDE_PAYLOAD_PR_OBS_JOB_H_ */
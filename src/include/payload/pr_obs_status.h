@@ -0,0 +1,51 @@
+/**
+ * @file    include/payload/pr_obs_status.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief payload structure for PR_OBS_STATUS
+ *
+ */
+
+#ifndef _INCLUDE_PAYLOAD_PR_OBS_STATUS_H_
+#define _INCLUDE_PAYLOAD_PR_OBS_STATUS_H_
+
+
+#define OBS_STATE_QUEUED	0
+#define OBS_STATE_RUNNING	1	/* a position was observed */
+#define OBS_STATE_DONE		2
+#define OBS_STATE_CANCELLED	3
+
+
+/**
+ * PR_OBS_STATUS packet payload structure
+ */
+
+struct obs_status {
+	uint32_t id;			/* the job */
+	uint32_t tag;			/* as submitted */
+	uint32_t state;			/* OBS_STATE_* */
+
+	uint32_t idx;			/* index of the position (or row) */
+	uint32_t n;			/* number of positions (or rows) */
+	uint32_t n_queued;		/* jobs in the queue, including this */
+
+	int32_t lon_arcsec;		/* the position */
+	int32_t lat_arcsec;
+
+	uint32_t valid;			/* 0 if the position was skipped */
+	uint32_t amp;			/* average continuum in milli-Kelvins */
+};
+
+
+
+#endif /* _INCLUDE_PAYLOAD_PR_OBS_STATUS_H_ */
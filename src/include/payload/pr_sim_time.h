@@ -0,0 +1,36 @@
+/**
+ * @file    include/payload/pr_sim_time.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief payload structure for PR_SIM_TIME
+ *
+ */
+
+#ifndef _INCLUDE_PAYLOAD_PR_SIM_TIME_H_
+#define _INCLUDE_PAYLOAD_PR_SIM_TIME_H_
+
+
+/**
+ * PR_SIM_TIME packet payload structure
+ */
+
+struct sim_time {
+	int64_t  epoch_usec;	/* simulated time since the unix epoch */
+	uint32_t rate_milli;	/* clock rate relative to real time in 1/1000,
+				 * 0 == clock advances only with updates
+				 */
+};
+
+
+
+#endif /* _INCLUDE_PAYLOAD_PR_SIM_TIME_H_ */
@@ -0,0 +1,48 @@
+/**
+ * @file    include/payload/pr_spec_seg.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief payload structure for PR_SPEC_SEG
+ *
+ * @note a sweep that takes more than one acquisition step is sent as one
+ *	 segment per step as soon as the step completes, the client assembles
+ *	 the segments into the full spectrum; sweeps of a single step are
+ *	 still sent as PR_SPEC_DATA
+ */
+
+#ifndef _INCLUDE_PAYLOAD_PR_SPEC_SEG_H_
+#define _INCLUDE_PAYLOAD_PR_SPEC_SEG_H_
+
+
+struct spec_seg {
+
+	uint32_t sweep_id;		/* changes with every sweep */
+	uint16_t idx;			/* index of this segment */
+	uint16_t n_seg;			/* number of segments in the sweep */
+
+	uint64_t sweep_min_hz;		/* lower frequency limit of the sweep */
+	uint64_t sweep_max_hz;		/* upper frequency limit of the sweep */
+	uint32_t sweep_n;		/* number of data points in the sweep */
+	uint32_t offset;		/* index of the first point in the sweep */
+
+	uint64_t freq_min_hz;		/* lower frequency limit */
+	uint64_t freq_max_hz;		/* upper frequency limit */
+	uint64_t freq_inc_hz;		/* frequency increment   */
+
+	/* NOTE: spectral data unit is milli-Kelvins ! */
+	uint32_t n;			/* number of data points */
+	uint32_t spec[];		/* the actual spectral data */
+};
+
+
+#endif /* _INCLUDE_PAYLOAD_PR_SPEC_SEG_H_ */
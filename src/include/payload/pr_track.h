@@ -0,0 +1,42 @@
+/**
+ * @file    include/payload/pr_track.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief payload structure for PR_TRACK
+ *
+ */
+
+#ifndef _INCLUDE_PAYLOAD_PR_TRACK_H_
+#define _INCLUDE_PAYLOAD_PR_TRACK_H_
+
+
+#define TRACK_SYS_EQU	0	/* right ascension/declination */
+#define TRACK_SYS_GAL	1	/* galactic longitude/latitude */
+
+
+/**
+ * PR_TRACK packet payload structure
+ */
+
+struct track {
+	uint32_t enable;	/* 0 == tracking stopped */
+	uint32_t sys;		/* coordinate system of the target */
+	int32_t  lon_arcsec;	/* right ascension (in degrees, not hours!)
+				 * or galactic longitude
+				 */
+	int32_t  lat_arcsec;	/* declination or galactic latitude */
+};
+
+
+
+#endif /* _INCLUDE_PAYLOAD_PR_TRACK_H_ */
@@ -0,0 +1,42 @@
+/**
+ * @file    prng.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _PRNG_H_
+#define _PRNG_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/**
+ * @brief xoshiro256** generator state, one per thread
+ */
+
+struct prng {
+	uint64_t s[4];
+};
+
+
+void prng_seed(struct prng *p, uint64_t seed);
+void prng_jump(struct prng *p);
+
+uint64_t prng_next(struct prng *p);
+double prng_uniform(struct prng *p);
+
+void prng_gauss_fill(struct prng *p, double *buf, size_t n);
+
+
+#endif /* _PRNG_H_ */
@@ -52,6 +52,11 @@
 #include <payload/pr_nick.h>
 #include <payload/pr_capabilities_load.h>
 #include <payload/pr_video_uri.h>
+#include <payload/pr_sim_time.h>
+#include <payload/pr_spec_seg.h>
+#include <payload/pr_track.h>
+#include <payload/pr_obs_job.h>
+#include <payload/pr_obs_status.h>
 
 
 #define DEFAULT_PORT 1420
@@ -88,6 +93,12 @@
 #define PR_HOT_LOAD_ENABLE	0xa019  /* enable hot load */
 #define PR_HOT_LOAD_DISABLE	0xa01a  /* disable hot load */
 #define PR_VIDEO_URI		0xa01b  /* URI of webcam stream */
+#define PR_SIM_TIME		0xa01c  /* simulated clock epoch and rate */
+#define PR_SPEC_SEG		0xa01d  /* segment of a spectral sweep */
+#define PR_TRACK		0xa01e  /* track a position on the sky */
+#define PR_OBS_JOB		0xa01f  /* queue an observation job */
+#define PR_OBS_CANCEL		0xa020  /* cancel observation jobs */
+#define PR_OBS_STATUS		0xa021  /* observation job progress */
 
 
 
@@ -0,0 +1,65 @@
+/**
+ * @file    acks/ack_obs_status.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <ack.h>
+#include <net_common.h>
+
+
+struct packet *ack_obs_status_gen(uint16_t trans_id, struct obs_status *s)
+{
+	gsize pkt_size;
+
+	struct packet *pkt;
+
+
+	pkt_size = sizeof(struct packet) + sizeof(struct obs_status);
+
+	/* allocate zeroed packet + payload */
+	pkt = g_malloc0(pkt_size);
+
+	pkt->service   = PR_OBS_STATUS;
+	pkt->trans_id  = trans_id;
+	pkt->data_size = sizeof(struct obs_status);
+
+	memcpy(pkt->data, s, pkt->data_size);
+
+	pkt_set_data_crc16(pkt);
+
+	pkt_hdr_to_net_order(pkt);
+
+	return pkt;
+}
+
+
+/**
+ * @brief distribute the progress of an observation job
+ */
+
+void ack_obs_status(uint16_t trans_id, struct obs_status *s)
+{
+	struct packet *pkt;
+
+
+	pkt = ack_obs_status_gen(trans_id, s);
+
+	g_debug("Sending observation job %u status", s->id);
+	net_send((void *) pkt, pkt_size_get(pkt));
+
+	g_free(pkt);
+}
@@ -0,0 +1,65 @@
+/**
+ * @file    net/acks/ack_sim_time.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <ack.h>
+#include <net_common.h>
+
+
+struct packet *ack_sim_time_gen(uint16_t trans_id, struct sim_time *t)
+{
+	gsize pkt_size;
+
+	struct packet *pkt;
+
+
+	pkt_size = sizeof(struct packet) + sizeof(struct sim_time);
+
+	/* allocate zeroed packet + payload */
+	pkt = g_malloc0(pkt_size);
+
+	pkt->service   = PR_SIM_TIME;
+	pkt->trans_id  = trans_id;
+	pkt->data_size = sizeof(struct sim_time);
+
+	memcpy(pkt->data, t, pkt->data_size);
+
+	pkt_set_data_crc16(pkt);
+
+	pkt_hdr_to_net_order(pkt);
+
+	return pkt;
+}
+
+
+/**
+ * @brief distribute the simulated clock state
+ */
+
+void ack_sim_time(uint16_t trans_id, struct sim_time *t)
+{
+	struct packet *pkt;
+
+
+	pkt = ack_sim_time_gen(trans_id, t);
+
+	g_debug("Sending simulated time");
+	net_send((void *) pkt, pkt_size_get(pkt));
+
+	g_free(pkt);
+}
@@ -20,6 +20,36 @@
 #include <ack.h>
 
 
+static void (*spec_observer)(const uint32_t *spec, uint32_t n, gboolean last);
+
+
+/**
+ * @brief install a function that sees all spectral data sent
+ *
+ * @param fn the observer, called with the data of every spectrum and sweep
+ *	  segment; last is set for the final part of a spectrum
+ *
+ * @note this lets the server act on completed integrations, the observer
+ *	 is called from the thread that sends the data
+ */
+
+void ack_spec_set_observer(void (*fn)(const uint32_t *spec, uint32_t n,
+				      gboolean last))
+{
+	spec_observer = fn;
+}
+
+
+/**
+ * @brief pass spectral data to the observer
+ */
+
+void ack_spec_notify(const uint32_t *spec, uint32_t n, gboolean last)
+{
+	if (spec_observer)
+		spec_observer(spec, n, last);
+}
+
 
 struct packet *ack_spec_data_gen(uint16_t trans_id, struct spec_data *s)
 {
@@ -64,6 +94,7 @@ void ack_spec_data(uint16_t trans_id, struct spec_data *s)
 
 	pkt = ack_spec_data_gen(trans_id, s);
 
+	ack_spec_notify(s->spec, s->n, TRUE);
 
 	g_debug("Transmitting spectral data");
 	net_send((void *) pkt, pkt_size_get(pkt));
@@ -0,0 +1,118 @@
+/**
+ * @file    net/acks/ack_spec_seg.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <ack.h>
+
+
+
+struct packet *ack_spec_seg_gen(uint16_t trans_id, struct spec_seg *s)
+{
+	gsize pkt_size;
+	gsize data_size;
+
+	struct packet *pkt;
+
+
+	data_size = sizeof(struct spec_seg)
+		    + s->n * sizeof(uint32_t);
+
+	pkt_size = sizeof(struct packet) + data_size;
+
+	pkt = g_malloc(pkt_size);
+
+	pkt->service   = PR_SPEC_SEG;
+	pkt->trans_id  = trans_id;
+	pkt->data_size = data_size;
+
+	memcpy(pkt->data, s, data_size);
+
+	pkt_set_data_crc16(pkt);
+
+	pkt_hdr_to_net_order(pkt);
+
+
+	return pkt;
+}
+
+
+/**
+ * @brief send a segment of a spectral sweep
+ *
+ * @note the caller must take care to clean the segment supplied
+ */
+
+void ack_spec_seg(uint16_t trans_id, struct spec_seg *s)
+{
+	struct packet *pkt;
+
+
+	pkt = ack_spec_seg_gen(trans_id, s);
+
+	ack_spec_notify(s->spec, s->n, s->idx + 1 == s->n_seg);
+
+	g_debug("Transmitting spectral sweep segment %u/%u", s->idx + 1,
+		s->n_seg);
+	net_send((void *) pkt, pkt_size_get(pkt));
+
+	/* clean up packet */
+	g_free(pkt);
+}
+
+
+/**
+ * @brief send a section of a spectral sweep as a segment
+ *
+ * @param trans_id the transaction identifier
+ * @param s the sweep
+ * @param sweep_id the identifier of the sweep
+ * @param idx the index of the segment
+ * @param n_seg the number of segments in the sweep
+ * @param sweep_n the number of bins in the full sweep
+ * @param off the index of the first bin of the segment in the sweep
+ * @param n the number of bins in the segment
+ */
+
+void ack_spec_data_seg(uint16_t trans_id, const struct spec_data *s,
+		       uint32_t sweep_id, uint16_t idx, uint16_t n_seg,
+		       uint32_t sweep_n, uint32_t off, uint32_t n)
+{
+	struct spec_seg *seg;
+
+
+	seg = g_malloc0(sizeof(struct spec_seg) + n * sizeof(uint32_t));
+
+	seg->sweep_id     = sweep_id;
+	seg->idx          = idx;
+	seg->n_seg        = n_seg;
+	seg->sweep_min_hz = s->freq_min_hz;
+	seg->sweep_max_hz = s->freq_max_hz;
+	seg->sweep_n      = sweep_n;
+	seg->offset       = off;
+
+	seg->freq_inc_hz  = s->freq_inc_hz;
+	seg->freq_min_hz  = s->freq_min_hz + off * s->freq_inc_hz;
+	seg->freq_max_hz  = seg->freq_min_hz + n * s->freq_inc_hz;
+	seg->n            = n;
+
+	memcpy(seg->spec, &s->spec[off], n * sizeof(uint32_t));
+
+	ack_spec_seg(trans_id, seg);
+
+	g_free(seg);
+}
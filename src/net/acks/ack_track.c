@@ -0,0 +1,40 @@
+/**
+ * @file    acks/ack_track.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <cmd.h>
+#include <ack.h>
+#include <net_common.h>
+
+
+struct packet *ack_track_gen(uint16_t trans_id, uint32_t enable, uint32_t sys,
+			     double lon, double lat)
+{
+	return cmd_track_gen(trans_id, enable, sys, lon, lat);
+}
+
+
+
+/**
+ * @brief distribute the tracking state
+ */
+
+void ack_track(uint16_t trans_id, uint32_t enable, uint32_t sys,
+	       double lon, double lat)
+{
+	cmd_track(trans_id, enable, sys, lon, lat);
+}
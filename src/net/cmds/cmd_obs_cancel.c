@@ -0,0 +1,70 @@
+/**
+ * @file    net/cmds/cmd_obs_cancel.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <cmd.h>
+
+
+struct packet *cmd_obs_cancel_gen(uint16_t trans_id, uint32_t id)
+{
+	gsize pkt_size;
+
+	struct packet *pkt;
+
+	struct obs_cancel *c;
+
+
+	pkt_size = sizeof(struct packet) + sizeof(struct obs_cancel);
+
+	/* allocate zeroed packet + payload */
+	pkt = g_malloc0(pkt_size);
+
+	pkt->service   = PR_OBS_CANCEL;
+	pkt->trans_id  = trans_id;
+	pkt->data_size = sizeof(struct obs_cancel);
+
+
+	c = (struct obs_cancel *) pkt->data;
+
+	c->id = id;
+
+
+	pkt_set_data_crc16(pkt);
+
+	pkt_hdr_to_net_order(pkt);
+
+	return pkt;
+}
+
+
+/**
+ * @brief cancel an observation job, 0 cancels all
+ */
+
+void cmd_obs_cancel(uint16_t trans_id, uint32_t id)
+{
+	struct packet *pkt;
+
+
+	pkt = cmd_obs_cancel_gen(trans_id, id);
+
+	g_debug("Sending command cancel observation job %u", id);
+	net_send((void *) pkt, pkt_size_get(pkt));
+
+	/* clean up */
+	g_free(pkt);
+}
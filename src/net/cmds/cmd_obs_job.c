@@ -0,0 +1,65 @@
+/**
+ * @file    net/cmds/cmd_obs_job.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include <cmd.h>
+
+
+struct packet *cmd_obs_job_gen(uint16_t trans_id, struct obs_job *j)
+{
+	gsize pkt_size;
+
+	struct packet *pkt;
+
+
+	pkt_size = sizeof(struct packet) + sizeof(struct obs_job);
+
+	/* allocate zeroed packet + payload */
+	pkt = g_malloc0(pkt_size);
+
+	pkt->service   = PR_OBS_JOB;
+	pkt->trans_id  = trans_id;
+	pkt->data_size = sizeof(struct obs_job);
+
+	memcpy(pkt->data, j, pkt->data_size);
+
+	pkt_set_data_crc16(pkt);
+
+	pkt_hdr_to_net_order(pkt);
+
+	return pkt;
+}
+
+
+/**
+ * @brief submit an observation job to the server queue
+ */
+
+void cmd_obs_job(uint16_t trans_id, struct obs_job *j)
+{
+	struct packet *pkt;
+
+
+	pkt = cmd_obs_job_gen(trans_id, j);
+
+	g_debug("Sending observation job %s", j->name);
+	net_send((void *) pkt, pkt_size_get(pkt));
+
+	/* clean up */
+	g_free(pkt);
+}
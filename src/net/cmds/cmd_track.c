@@ -0,0 +1,82 @@
+/**
+ * @file    net/cmds/cmd_track.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <cmd.h>
+
+
+struct packet *cmd_track_gen(uint16_t trans_id, uint32_t enable, uint32_t sys,
+			     double lon, double lat)
+{
+	gsize pkt_size;
+
+	struct packet *pkt;
+
+	struct track *t;
+
+
+	pkt_size = sizeof(struct packet) + sizeof(struct track);
+
+	/* allocate zeroed packet + payload */
+	pkt = g_malloc0(pkt_size);
+
+	pkt->service   = PR_TRACK;
+	pkt->trans_id  = trans_id;
+	pkt->data_size = sizeof(struct track);
+
+
+	t = (struct track *) pkt->data;
+
+	t->enable = enable;
+	t->sys    = sys;
+
+	/* convert to integer arcseconds */
+	t->lon_arcsec = (int32_t) (lon * 3600.0);
+	t->lat_arcsec = (int32_t) (lat * 3600.0);
+
+
+	pkt_set_data_crc16(pkt);
+
+	pkt_hdr_to_net_order(pkt);
+
+	return pkt;
+}
+
+
+/**
+ * @brief request tracking of a sky position or stop tracking
+ *
+ * @param enable 0 to stop tracking
+ * @param sys the coordinate system (TRACK_SYS_*)
+ * @param lon the right ascension or galactic longitude in degrees
+ * @param lat the declination or galactic latitude in degrees
+ */
+
+void cmd_track(uint16_t trans_id, uint32_t enable, uint32_t sys,
+	       double lon, double lat)
+{
+	struct packet *pkt;
+
+
+	pkt = cmd_track_gen(trans_id, enable, sys, lon, lat);
+
+	g_debug("Sending command track %d (%d) %g/%g", enable, sys, lon, lat);
+	net_send((void *) pkt, pkt_size_get(pkt));
+
+	/* clean up */
+	g_free(pkt);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file    server/api/be_drive_otf_capable.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <backend.h>
+
+
+static gboolean (*p_drive_otf_capable)(void);
+
+
+/**
+ * @brief executes be_drive_otf_capable on a backend
+ *
+ * @returns TRUE if the drive reports its position and spectra can be
+ *	    acquired while it moves, FALSE otherwise
+ */
+
+gboolean be_drive_otf_capable(void)
+{
+	if (p_drive_otf_capable)
+		return p_drive_otf_capable();
+
+	return FALSE;	/* assume the drive blocks while moving */
+}
+
+
+/**
+ * @brief try to load the be_drive_otf_capable symbol in a backend plugin
+ */
+
+int be_drive_otf_capable_load(GModule *mod)
+{
+	gboolean ret;
+
+	gpointer func;
+
+
+	ret = g_module_symbol(mod, "be_drive_otf_capable", &func);
+	if (!ret)
+		return -1;
+
+	g_message("BACKEND: found symbol %s", __func__);
+
+	p_drive_otf_capable = (typeof(p_drive_otf_capable)) func;
+
+	return 0;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file    server/api/be_drive_slew_time.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <backend.h>
+
+
+static gdouble (*p_drive_slew_time)(gdouble az0, gdouble el0,
+				   gdouble az1, gdouble el1);
+
+
+/**
+ * @brief executes be_drive_slew_time on a backend
+ *
+ * @returns the estimated duration of a move in seconds or a negative value
+ *	    if the backend cannot estimate it
+ */
+
+gdouble be_drive_slew_time(gdouble az0, gdouble el0, gdouble az1, gdouble el1)
+{
+	if (p_drive_slew_time)
+		return p_drive_slew_time(az0, el0, az1, el1);
+
+	return -1.0;
+}
+
+
+/**
+ * @brief try to load the be_drive_slew_time symbol in a backend plugin
+ */
+
+int be_drive_slew_time_load(GModule *mod)
+{
+	gboolean ret;
+
+	gpointer func;
+
+
+	ret = g_module_symbol(mod, "be_drive_slew_time", &func);
+	if (!ret)
+		return -1;
+
+	g_message("BACKEND: found symbol %s", __func__);
+
+	p_drive_slew_time = (typeof(p_drive_slew_time)) func;
+
+	return 0;
+}
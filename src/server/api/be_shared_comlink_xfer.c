@@ -0,0 +1,82 @@
+/**
+ * @file    server/api/be_shared_comlink_xfer.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <backend.h>
+
+
+static gchar *(*p_shared_comlink_xfer)(enum comlink_class cls,
+				       const gchar *buf, gsize nbytes,
+				       gint timeout_ms, gsize *rsp_len,
+				       gdouble *exec_ms);
+
+
+/**
+ * @brief executes be_shared_comlink_xfer on a backend
+ *
+ * @param cls the class of the request
+ * @param buf the command to send
+ * @param nbytes the length of the command
+ * @param timeout_ms the time the request may wait for its turn, -1 for no
+ *	  limit
+ * @param[out] rsp_len the number of bytes in the response
+ * @param[out] exec_ms the time the command took on the link, excluding the
+ *	       time it was queued; may be NULL
+ *
+ * @returns the response
+ *
+ * @note this function blocks until the response was received
+ *
+ * @note g_free() the returned buffer to deallocate
+ */
+
+gchar *be_shared_comlink_xfer(enum comlink_class cls,
+			      const gchar *buf, gsize nbytes,
+			      gint timeout_ms, gsize *rsp_len,
+			      gdouble *exec_ms)
+{
+	gchar *rsp = NULL;
+
+	if (p_shared_comlink_xfer)
+		rsp = p_shared_comlink_xfer(cls, buf, nbytes, timeout_ms,
+					    rsp_len, exec_ms);
+	else
+		g_message("BACKEND: function %s not available\n", __func__);
+
+	return rsp;
+}
+
+
+/**
+ * @brief try to load the be_shared_comlink_xfer symbol in a backend plugin
+ */
+
+int be_shared_comlink_xfer_load(GModule *mod)
+{
+	gboolean ret;
+
+	gpointer func;
+
+
+	ret = g_module_symbol(mod, "be_shared_comlink_xfer", &func);
+	if (!ret)
+		return -1;
+
+	g_message("BACKEND: found symbol %s", __func__);
+
+	p_shared_comlink_xfer = (typeof(p_shared_comlink_xfer)) func;
+
+	return 0;
+}
@@ -35,8 +35,7 @@ static void backend_try_load_symbols(GModule *mod)
 	be_moveto_azel_load(mod);
 	be_shared_comlink_acquire_load(mod);
 	be_shared_comlink_release_load(mod);
-	be_shared_comlink_write_load(mod);
-	be_shared_comlink_read_load(mod);
+	be_shared_comlink_xfer_load(mod);
 	be_recalibrate_pointing_load(mod);
 	be_park_telescope_load(mod);
 	be_spec_acq_cfg_load(mod);
@@ -52,6 +51,8 @@ static void backend_try_load_symbols(GModule *mod)
 	be_drive_pwr_ctrl_load(mod);
 	be_drive_pwr_cycle_load(mod);
 	be_drive_pwr_status_load(mod);
+	be_drive_slew_time_load(mod);
+	be_drive_otf_capable_load(mod);
 }
 
 
@@ -19,9 +19,6 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <termios.h>
 
 #include <glib.h>
 #include <gmodule.h>
@@ -29,7 +26,9 @@
 
 #include <math.h>
 #include <backend.h>
+#include <serial.h>
 #include <ack.h>
+#include <pos_pub.h>
 
 #include <net.h>
 
@@ -41,6 +40,11 @@
 #define ROT2PROG_CMD_CONFIG	498	/* typo in protocol table? */
 #define ROT2PROG_ACK_CONFIG	499
 
+/* response timeout */
+#define MD01_TIMEOUT_MS		500
+/* input is discarded until the link was quiet for this long */
+#define MD01_FLUSH_QUIET_MS	50
+
 #define CMD_STOP		0x0f	/* stop rotation */
 #define CMD_STATUS		0x1f	/* get position */
 #define CMD_SET			0x2f	/* set position */
@@ -58,9 +62,13 @@
 
 /* default tty configuration, overridable in config file */
 static char *md01_tty = "/dev/ttyUSB0";
-static speed_t tty_rate = B460800;
+static gint md01_baud = 460800;
+
+static struct serial_link *md01_link;
+static GMutex md01_link_lock;
+static GMutex md01_state_lock;		/* guards md01.pos.busy */
 
-static int fd;
+static struct pos_pub *md01_pub;
 
 
 static struct {
@@ -92,6 +100,8 @@ static struct {
 
 		double az_tgt;		/* target azimuth */
 		double el_tgt;		/* target elevation */
+
+		gboolean busy;		/* target not yet reached */
 	} pos;
 
 	/* drive resolution */
@@ -109,49 +119,6 @@ static struct {
 static void md01_rot2prog_eval_response(const char *msg, gsize len);
 
 
-/**
- * @brief convert numerical value to speed_t
- * @note see man 3 termios
- */
-
-static speed_t get_baudrate(gint baud)
-{
-	switch (baud) {
-	case 9600:
-		return B9600;
-	case 19200:
-		return B19200;
-	case 38400:
-		return B38400;
-	case 57600:
-		return B57600;
-	case 115200:
-		return B115200;
-	case 230400:
-		return B230400;
-	case 460800:
-		return B460800;
-	case 500000:
-		return B500000;
-	case 576000:
-		return B576000;
-	case 921600:
-		return B921600;
-	case 1000000:
-		return B1000000;
-	case 1152000:
-		return B1152000;
-	case 1500000:
-		return B1500000;
-	case 2000000:
-		return B2000000;
-	default:
-		g_warning(MSG "unsupported baud rate %d", baud);
-		return B0;	/* hang up */
-	}
-}
-
-
 /**
  * @brief load configuration keys
  */
@@ -170,7 +137,7 @@ static void md01_rot2prog_load_keys(GKeyFile *kf)
 		g_error(error->message);
 
 
-	tty_rate = get_baudrate(g_key_file_get_integer(kf, "Serial", "baud", &error));
+	md01_baud = g_key_file_get_integer(kf, "Serial", "baud", &error);
 	if (error)
 		g_error(error->message);
 
@@ -306,208 +273,43 @@ int md01_rot2prog_load_config(void)
 
 
 /**
- * @brief open a serial tty
- * @param tty the path to the tty
+ * @brief send a command and read the response
  *
- * @return 0 on error, file descriptor otherwise
- */
-
-static int md01_rot2prog_serial_open_port(const char *tty)
-{
-	int fd;
-
-
-
-	fd = open(tty, O_RDWR | O_NOCTTY | O_NDELAY);
-
-
-	if (fd < 0) {
-		perror("unable to open serial port");
-		return 0;
-	}
-
-	fcntl(fd, F_SETFL, 0);
-
-	return fd;
-}
-
-
-/**
- * @brief close a serial tty
- * @param fd the file descriptor to close
- * @return see man 3 close()
- */
-__attribute__((unused))
-static int md01_rot2prog_serial_close_port(int fd)
-{
-	return close(fd);
-}
-
-
-/**
- * @brief set the serial link parameters (for the SRT)
- *
- * @param fd the file descriptor of the serial tty
- *
- * @return see man 3 tcsetattr
- */
-
-static int md01_rot2prog_serial_set_comm_param(int fd)
-{
-#if 0
-	struct termios cfg;
-
-
-	/* get current port attributes */
-	tcgetattr(fd, &cfg);
-
-
-	/* char size is 8 */
-	cfg.c_cflag &= ~CSIZE;		/* clear character size bits */
-	cfg.c_cflag |= CS8;		/* set with to 8 bits */
-
-	/* baud rate is fixed at 460800 for USB link */
-	/* TODO: make configurable */
-	cfsetispeed(&cfg, tty_rate);
-	cfsetospeed(&cfg, tty_rate);
-
-	/* single stop bit */
-	cfg.c_cflag &= ~CSTOPB;	/* 1 stop bit */
-
-	/* no parity */
-	cfg.c_cflag &= ~PARENB;
-	cfg.c_iflag &=  ~INPCK;
-
-	/* no flow control */
-	cfg.c_iflag &= ~(IXON | IXOFF | IXANY);
-
-	/* set raw i/o */
-	cfg.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
-	cfg.c_oflag &= ~OPOST;
-
-	/* enable receiver and set local mode */
-	cfg.c_cflag |= (CLOCAL | CREAD);
-
-	/* cfg.c_cc[VMIN] = ROT2PROG_ACK_BYTES; */
-	cfg.c_cc[VMIN] = 0;
-	cfg.c_cc[VTIME] = 10;
-
-	/* set configuration */
-	return tcsetattr (fd, TCSANOW, &cfg);
-
-#else
-        struct termios cfg = {0};
-
-
-        /* we start from a cleared struct, so we need only set our config */
-        cfg.c_cflag = CS8 | CLOCAL | CREAD;
-        cfg.c_iflag = IGNPAR;
-
-        cfsetispeed(&cfg, B460800);
-        cfsetospeed(&cfg, B460800);
-
-        cfg.c_cc[VTIME] = 1;
-
-        /* set configuration */
-        return tcsetattr (fd, TCSANOW, &cfg);
-#endif
-}
-
-
-/**
- * @brief write to the serial port
+ * @param cmd the command, ROT2PROG_CMD_BYTES long
+ * @param buf the buffer for the response
+ * @param n the expected length of the response
  *
- * @param fd the file descriptor of the serial tty
- * @param buf the buffer to write from
- * @parma nbyte the size of the data in the buffer
- * @param drain if set, waits until all output has been transmitted
+ * @returns the number of bytes received
  *
- * @return see man 3 write
- */
-
-static int md01_rot2prog_serial_write(int fd, const char *buf,
-				size_t nbyte, int drain)
-{
-	int n;
-
-
-	n = write(fd, buf, nbyte);
-
-	if (drain)
-		tcdrain(fd);
-
-	if (n < 0)
-		perror("serial port write failed");
-
-	return n;
-}
-
-
-
-
-
-static int myread(int fd, uint8_t *p, size_t left)
-{
-        size_t n = 0;
-        while (left > 0)
-        {
-                ssize_t nr = read(fd, p, left);
-                if (nr <= 0)    {
-                        if (nr < 0)
-                                perror("read");  /* Error! */
-                        break;
-                }
-                else {
-                        n += nr;     /* We have read some more data */
-                        left -= nr;     /* Less data left to read */
-                        p += nr; /* So we don't read over already read data */
-                }
-        }
-
-	return n;
-}
-
-
-
-/**
- * @brief flush pending bytes
+ * @note if the response is incomplete, the input is flushed so a late
+ *	 remainder does not end up in front of the next response
  */
 
-static void md01_rot2prog_serial_flush(int fd)
+static gssize md01_rot2prog_xfer(const char *cmd, char *buf, gsize n)
 {
-        int n;
-        unsigned char c;
-	return;
-        printf("flushing...");
-        while ((n = read(fd, &c, sizeof(c))) > 0);
-        printf("done\n");
-}
-
+	gssize ret = 0;
 
 
+	/* the position poller and the move commands share the link */
+	g_mutex_lock(&md01_link_lock);
 
-/**
- * @brief read from the serial port
- *
- * @param fd the file descriptor of the serial tty
- * @param buf the buffer to read to
- * @parma nbyte the size of the buffer (maximum number of bytes to read)
- *
- * @return see man 3 read
- *
- * @note unused
- */
+	if (serial_write(md01_link, cmd, ROT2PROG_CMD_BYTES,
+			 MD01_TIMEOUT_MS) != ROT2PROG_CMD_BYTES)
+		goto exit;
 
-static int md01_rot2prog_serial_read(int fd, char *buf, size_t nbyte)
-{
-	int n;
+	ret = serial_read(md01_link, buf, n, MD01_TIMEOUT_MS);
+	if (ret < 0) {
+		ret = 0;
+		goto exit;
+	}
 
-	n = myread(fd, buf, nbyte);
+	if ((gsize) ret != n)
+		serial_flush(md01_link, MD01_FLUSH_QUIET_MS);
 
-	if (n < 0)
-		perror("serial port read failed");
+exit:
+	g_mutex_unlock(&md01_link_lock);
 
-	return n;
+	return ret;
 }
 
 
@@ -639,11 +441,9 @@ static int md01_rot2prog_moveto(double az, double el)
 	}
 #endif
 
-	md01_rot2prog_serial_write(fd, cmdstr, ROT2PROG_CMD_BYTES, 0);
-
 #if 1
 	int n;
-	n = md01_rot2prog_serial_read(fd, buf, ROT2PROG_ACK_BYTES);
+	n = md01_rot2prog_xfer(cmdstr, buf, ROT2PROG_ACK_BYTES);
 
 	if (n != ROT2PROG_ACK_BYTES) {
 
@@ -654,8 +454,6 @@ static int md01_rot2prog_moveto(double az, double el)
 
 		g_print("\n");
 
-		md01_rot2prog_serial_flush(fd);
-
 #if 0
 		g_warning(MSG "moveto mismatch in message length. expected %d, got %d",
 				ROT2PROG_ACK_BYTES, n);
@@ -677,7 +475,11 @@ static int md01_rot2prog_moveto(double az, double el)
 	ack_status_move(PKT_TRANS_ID_UNDEF, &s);
 	ack_status_slew(PKT_TRANS_ID_UNDEF, &s);
 
+	g_mutex_lock(&md01_state_lock);
+	md01.pos.busy = TRUE;
+	g_mutex_unlock(&md01_state_lock);
 
+	pos_pub_moving(md01_pub);
 
 #endif
 	ack_moveto_azel(PKT_TRANS_ID_UNDEF, md01.pos.az_tgt, md01.pos.el_tgt);
@@ -710,9 +512,7 @@ static void md01_rot2prog_get_position(double *az, double *el)
 		return;
 	}
 
-	md01_rot2prog_serial_write(fd, get, ROT2PROG_CMD_BYTES, 0);
-
-	n = md01_rot2prog_serial_read(fd, buf, ROT2PROG_ACK_BYTES);
+	n = md01_rot2prog_xfer(get, buf, ROT2PROG_ACK_BYTES);
 
 	if (n != ROT2PROG_ACK_BYTES) {
 #if 0
@@ -732,9 +532,7 @@ static void md01_rot2prog_get_position(double *az, double *el)
 
 
 
-	md01_rot2prog_serial_write(fd, poll, ROT2PROG_CMD_BYTES, 0);
-
-	n = md01_rot2prog_serial_read(fd, buf, 2);
+	n = md01_rot2prog_xfer(poll, buf, 2);
 
 	if (n != 2) {
 		g_warning(MSG "mismatch in message length. expected %d, got %d",
@@ -753,34 +551,42 @@ static void md01_rot2prog_get_position(double *az, double *el)
 
 static void md01_rot2prog_notify_pos_update(void)
 {
-	double az_arcsec;
-	double el_arcsec;
+	double az;
+	double el;
 
-	struct status s;
-	struct getpos pos;
+	gboolean arrived = FALSE;
 
+	struct status s;
 
 
-	md01_rot2prog_get_position(&az_arcsec, &el_arcsec);
 
-	/* value is in degrees, convert */
-	az_arcsec *= 3600.0;
-	el_arcsec *= 3600.0;
+	md01_rot2prog_get_position(&az, &el);
 
-	/* emit notification */
-	pos.az_arcsec = (typeof(pos.az_arcsec)) az_arcsec;
-	pos.el_arcsec = (typeof(pos.el_arcsec)) el_arcsec;
-	ack_getpos_azel(PKT_TRANS_ID_UNDEF, &pos);
+	/* report arrival once */
+	g_mutex_lock(&md01_state_lock);
 
-	if (fabs(md01.pos.az_cur - md01.pos.az_tgt) <= md01.res.h) {
-		if (fabs(md01.pos.el_cur - md01.pos.el_tgt) <= md01.res.v)  {
-			s.busy = 0;
-			s.eta_msec = 0;
-			ack_status_move(PKT_TRANS_ID_UNDEF, &s);
-			ack_status_slew(PKT_TRANS_ID_UNDEF, &s);
+	if (md01.pos.busy) {
+		if (fabs(md01.pos.az_cur - md01.pos.az_tgt) <= md01.res.h &&
+		    fabs(md01.pos.el_cur - md01.pos.el_tgt) <= md01.res.v) {
+			md01.pos.busy = FALSE;
+			arrived = TRUE;
 		}
 	}
 
+	g_mutex_unlock(&md01_state_lock);
+
+	if (!arrived) {
+		/* only sent if the position changed or a heartbeat is due */
+		pos_pub_push(md01_pub, az, el);
+		return;
+	}
+
+	pos_pub_arrived(md01_pub, az, el);
+
+	s.busy = 0;
+	s.eta_msec = 0;
+	ack_status_move(PKT_TRANS_ID_UNDEF, &s);
+	ack_status_slew(PKT_TRANS_ID_UNDEF, &s);
 }
 
 
@@ -847,6 +653,17 @@ int be_getpos_azel(double *az, double *el)
 }
 
 
+/**
+ * @brief the rotator reports its position while it moves
+ */
+
+G_MODULE_EXPORT
+gboolean be_drive_otf_capable(void)
+{
+	return TRUE;
+}
+
+
 /**
  * @brief get telescope drive capabilities
  */
@@ -871,15 +688,17 @@ int be_get_capabilities_drive(struct capabilities *c)
 }
 
 /**
- * dummy rotation push push thread (1/s)
+ * @brief position push thread
  *
- * maybe trigger something like this once per rotation command
+ * @note the position is polled fast while the drive moves and slowly while
+ *	 it is idle, see pos_pub_wait()
  */
+
 static gpointer md01_rot2prog_pos_push_thread(gpointer data)
 {
 	while (1) {
+		pos_pub_wait(md01_pub);
 		md01_rot2prog_notify_pos_update();
-		g_usleep(0.1 * G_USEC_PER_SEC);
 	}
 
 
@@ -894,15 +713,9 @@ void module_extra_init(void)
 {
 	g_message(MSG "configuring serial link");
 
-	fd = md01_rot2prog_serial_open_port(md01_tty);
-	if (!fd)
+	md01_link = serial_open(md01_tty, md01_baud);
+	if (!md01_link)
 		g_error(MSG "Error opening serial port %s\n", md01_tty);
-
-	if (md01_rot2prog_serial_set_comm_param(fd))
-		g_error(MSG "Error setting parameters for serial port %s\n",
-			md01_tty);
-
-         md01_rot2prog_serial_flush(fd);
 #if 1
 	/* dummy */
 	g_thread_new(NULL, md01_rot2prog_pos_push_thread, NULL);
@@ -924,6 +737,8 @@ const gchar *g_module_check_init(void)
 	if (md01_rot2prog_load_config())
 		g_warning(MSG "Error loading module configuration, this plugin may not function properly.");
 
+	md01_pub = pos_pub_new(md01.res.h, md01.res.v);
+
 
 	return NULL;
 }
@@ -27,8 +27,11 @@
 #include <string.h>
 
 #include <backend.h>
+#include <serial.h>
 #include <cmd.h>
 #include <ack.h>
+#include <eta.h>
+#include <cfg_snap.h>
 
 #include <math.h>
 
@@ -46,11 +49,13 @@
 
 #include <ad6620.h>
 
-#include <termios.h>
-
 
 #define MSG "SDR14 SPEC: "
 
+#ifndef CONFDIR
+#define CONFDIR "radtel"
+#endif
+
 
 #define SDR14_HDR_LEN	2
 /* SDR14 data items are fixed for type 0 data items (I/Q or real samples) */
@@ -64,6 +69,18 @@ struct sdr14_data_pkt {
 
 #define SDR14_NSAM  2048	/* 2048 16 bit I/Q pairs (in AD66220 mode)  */
 
+/* serial link rate and timeouts */
+#define SDR14_BAUD		230400
+#define SDR14_CMD_TIMEOUT_MS	500
+#define SDR14_PKT_TIMEOUT_MS	2000
+/* input is discarded until the link was quiet for this long */
+#define SDR14_FLUSH_QUIET_MS	100
+
+/* packets buffered between capture and processing, must be a power of 2 */
+#define SDR14_PKT_POOL		8
+/* sleep while waiting on the packet queue */
+#define SDR14_PKT_POLL_US	200
+
 
 /* when using the AD6620 modes, the total decimation is 170, see
  * M_CICx in the sdr14_ad6620_data setup block
@@ -112,6 +129,20 @@ struct sdr14_data_pkt {
 #define SDR14_INIT_BIN_DIV		         6
 #define SDR14_INIT_NSTACK		        64
 
+/* the planner effort, FFTW_PATIENT takes a lot longer, but that is paid only
+ * once, as the result is kept in the wisdom file
+ */
+#define SDR14_FFTW_PLANNER	FFTW_MEASURE
+#define SDR14_FFTW_WISDOM	"sdr14_fftw.wisdom"
+
+/* initial duration of a tuning step in ms per data packet, i.e. the time the
+ * samples take at the output rate; refined with every step
+ */
+#define SDR14_ETA_INIT_PKT_MS	((double) SDR14_NSAM * 1000.0 / SDR14_RT_BW)
+
+/* per bin_div, the step time per packet */
+static struct eta_model *sdr14_eta;
+
 
 
 /**
@@ -152,21 +183,65 @@ static struct {
 	};
 
 
-double *reamin0, *reamout0;
-fftw_plan p0;
+/**
+ * @brief the transform plans, one per bin divider
+ *
+ * @note the plans are created once at startup; their buffers are only used by
+ *	 the acquisition thread
+ *
+ * @note a plan transforms all SDR14_NSAM / blsize blocks of a data packet in
+ *	 one call, so the buffers always hold SDR14_NSAM samples
+ */
+
+static struct {
+	fftw_plan plan;
+	fftw_complex *in;
+	fftw_complex *out;
+} sdr14_fft[SDR14_BIN_DIV_MAX + 1];
 
 
 static char *sdr14_tty = "/dev/ttyUSB1";
-static int sdr14_fd;
+static struct serial_link *sdr14_link;
 static gboolean last_acq_mode = TRUE;
 
 /* I'm beginning to suspect that we use too many locks :D */
 static GThread *thread;
 static GCond	acq_cond;
 static GMutex   acq_lock;
-static GMutex   acq_abort;
 static GMutex   acq_pause;
-static GRWLock  obs_rwlock;
+
+
+/**
+ * @brief the packet queue between the capture thread and the acquisition
+ *	  thread
+ *
+ * @note this is a single-producer, single-consumer ring: only the capture
+ *	 thread advances head, only the acquisition thread advances tail, so
+ *	 neither needs a lock; a packet slot is owned by the capture thread
+ *	 until head passes it and by the acquisition thread until tail does
+ *
+ * @note the lock and condition are only used to hand a capture request to
+ *	 the idle capture thread, never per packet
+ *
+ * @note a slot is marked bad if its packet could not be read; after a failed
+ *	 read, the remaining packets of the request are not read, but are
+ *	 still passed on as bad, so the acquisition thread never waits for
+ *	 packets that will not arrive
+ */
+
+static struct {
+	struct sdr14_data_pkt pkt[SDR14_PKT_POOL];
+	gboolean bad[SDR14_PKT_POOL];
+
+	gint head;		/* next slot to fill */
+	gint tail;		/* next slot to process */
+
+	gint req;		/* packets still to capture */
+	GMutex lock;
+	GCond cond;
+
+	GThread *thread;
+} sdr14_cap;
 
 
 
@@ -185,127 +260,178 @@ struct observation {
 	double bw_eff;
 };
 
-static struct observation g_obs;
+/* the current observation, see sdr14_acquisition_update() */
+static struct cfg_snap *obs_snap;
 
 
 
 /**
- * @brief flush pending bytes
+ * @brief send a command and read its acknowledgement
+ *
+ * @param cmd the command
+ * @param n the length of the command
+ * @param ack the buffer for the acknowledgement
+ * @param nack the length of the acknowledgement
+ *
+ * @returns 0 on success, -1 on error or timeout
  */
 
-static void sdr14_serial_flush(int fd)
+static int sdr14_cmd(const void *cmd, gsize n, void *ack, gsize nack)
 {
-	int n;
-	unsigned char c;
+	if (serial_write(sdr14_link, cmd, n, SDR14_CMD_TIMEOUT_MS) != (gssize) n)
+		return -1;
+
+	if (serial_read(sdr14_link, ack, nack, SDR14_CMD_TIMEOUT_MS)
+	    != (gssize) nack)
+		return -1;
 
-	while ((n = read(fd, &c, sizeof(c))) > 0);
+	return 0;
 }
 
 
 /**
- * @brief open a serial tty
- * @param tty the path to the tty
+ * @brief read a data packet
  *
- * @return 0 on error, file descriptor otherwise
+ * @returns 0 on success, -1 on error or timeout
  */
 
-static int sdr14_serial_open_port(const char *tty)
+static int sdr14_read(struct sdr14_data_pkt *pkt)
 {
-	int fd;
+	gssize n;
 
 
-	fd = open(tty, O_RDWR);
-
-	if (fd < 0) {
-		perror("unable to open serial port");
-		return 0;
-	}
+	n = serial_read(sdr14_link, pkt, sizeof(struct sdr14_data_pkt),
+			SDR14_PKT_TIMEOUT_MS);
 
+	if (n != (gssize) sizeof(struct sdr14_data_pkt))
+		return -1;
 
-	return fd;
+	return 0;
 }
 
+
 /**
- * @brief set the serial link parameters for the SDR14 with the ftdi_sio module
- *
- * @param fd the file descriptor of the serial tty
- *
- * @return see man 3 tcsetattr
+ * @brief thread function that reads the requested number of data packets
+ *	  into the packet queue
  */
 
-static int sdr14_serial_set_comm_param(int fd)
+static gpointer sdr14_capture_thread(gpointer data)
 {
-	struct termios cfg = {0};
+	gint n;
+	guint head;
+	guint slot;
 
+	gboolean fail;
 
-	/* we start from a cleared struct, so we need only set our config */
-	cfg.c_cflag = CS8 | CLOCAL | CREAD;
-        cfg.c_iflag = IGNPAR;
 
-        cfsetispeed(&cfg, B230400);
-        cfsetospeed(&cfg, B230400);
+	while (1) {
 
-        cfg.c_cc[VTIME] = 1;
+		g_mutex_lock(&sdr14_cap.lock);
 
-	/* set configuration */
-	return tcsetattr (fd, TCSANOW, &cfg);
-}
+		while (!sdr14_cap.req)
+			g_cond_wait(&sdr14_cap.cond, &sdr14_cap.lock);
 
+		n = sdr14_cap.req;
+		sdr14_cap.req = 0;
 
+		g_mutex_unlock(&sdr14_cap.lock);
 
-static int read_bytes(size_t left, uint8_t *p)
-{
-	size_t n = 0;
-	while (left > 0)
-	{
-		ssize_t nr = read(sdr14_fd, p, left);
-		if (nr <= 0) 	{
-			if (nr < 0)
-				perror("read");  /* Error! */
-			break;
-		}
-		else {
-			n += nr;     /* We have read some more data */
-			left -= nr;     /* Less data left to read */
-			p += nr; /* So we don't read over already read data */
+		fail = FALSE;
+
+		for (; n; n--) {
+
+			head = (guint) sdr14_cap.head;
+
+			/* wait for a free slot */
+			while (head - (guint) g_atomic_int_get(&sdr14_cap.tail)
+			       >= SDR14_PKT_POOL)
+				g_usleep(SDR14_PKT_POLL_US);
+
+			slot = head & (SDR14_PKT_POOL - 1);
+
+			if (!fail && sdr14_read(&sdr14_cap.pkt[slot])) {
+				g_warning(MSG "data packet read failed, "
+					      "discarding %d packets", n);
+				/* drop what is left of a partial packet */
+				serial_flush(sdr14_link, SDR14_FLUSH_QUIET_MS);
+				fail = TRUE;
+			}
+
+			sdr14_cap.bad[slot] = fail;
+
+			/* publish the packet */
+			g_atomic_int_set(&sdr14_cap.head, (gint) (head + 1));
 		}
 	}
 
+	return NULL;
 }
 
 
-static int sdr14_read(struct sdr14_data_pkt *pkt)
+/**
+ * @brief start the capture of data packets
+ *
+ * @param n the number of packets
+ *
+ * @note the capture thread owns the serial link until all n packets were
+ *	 taken from the queue
+ */
+
+static void sdr14_capture_start(gint n)
 {
-	uint8_t *p;
-
-	size_t n = 0;
-	size_t left = sizeof(struct sdr14_data_pkt);  /* The total size of the buffer */
-	p = (uint8_t *) pkt;
-	while (left > 0)
-	{
-		ssize_t nr = read(sdr14_fd, p, left);
-		if (nr <= 0) 	{
-			if (nr < 0)
-				perror("read");  /* Error! */
-			break;
-		}
-		else {
-			n += nr;     /* We have read some more data */
-			left -= nr;     /* Less data left to read */
-			p += nr; /* So we don't read over already read data */
-		}
-	}
+	g_mutex_lock(&sdr14_cap.lock);
+	sdr14_cap.req = n;
+	g_cond_signal(&sdr14_cap.cond);
+	g_mutex_unlock(&sdr14_cap.lock);
+}
 
-	return 0;
+
+/**
+ * @brief get the next captured data packet, waits until one is available
+ *
+ * @returns the packet or NULL if it could not be read
+ *
+ * @note release the packet with sdr14_capture_release() when done, even if
+ *	 it could not be read
+ */
+
+static const struct sdr14_data_pkt *sdr14_capture_get(void)
+{
+	gint tail;
+	guint slot;
+
+
+	tail = sdr14_cap.tail;
+
+	while (g_atomic_int_get(&sdr14_cap.head) == tail)
+		g_usleep(SDR14_PKT_POLL_US);
+
+	slot = (guint) tail & (SDR14_PKT_POOL - 1);
+
+	if (sdr14_cap.bad[slot])
+		return NULL;
+
+	return &sdr14_cap.pkt[slot];
+}
+
+
+/**
+ * @brief return the current data packet to the capture thread
+ */
+
+static void sdr14_capture_release(void)
+{
+	g_atomic_int_set(&sdr14_cap.tail,
+			 (gint) ((guint) sdr14_cap.tail + 1));
 }
 
+
 __attribute__((unused))
 static void sdr14_get_mode(void)
 {
 	uint8_t cmd[6] = {0x50, 0x20, 0x18, 0x00, 0x00};
 
-	write(sdr14_fd, cmd, sizeof(cmd));
-	read(sdr14_fd, cmd, sizeof(cmd));
+	sdr14_cmd(cmd, sizeof(cmd), cmd, sizeof(cmd));
 }
 
 
@@ -323,10 +449,9 @@ static void sdr14_setup_ad6620(void)
 		       &sdr14_ad6620_data[i * AD6620_DATA_BLKSZ],
 		       AD6620_DATA_BLKSZ);
 
-		write(sdr14_fd, cmd, sizeof(cmd));
-
-		/* XXX want timeout here */
-		read(sdr14_fd, ack, sizeof(ack));
+		if (sdr14_cmd(cmd, sizeof(cmd), ack, sizeof(ack)))
+			g_warning(MSG "no acknowledgement for AD6620 setup "
+				      "item %zu", i);
 	}
 }
 
@@ -342,8 +467,7 @@ static void sdr14_set_freq(uint32_t hz)
 	uint8_t ack[10] = {0};
 
 
-	write(sdr14_fd, smpl, sizeof(smpl));
-	read(sdr14_fd, smpl, sizeof(smpl));
+	sdr14_cmd(smpl, sizeof(smpl), smpl, sizeof(smpl));
 
 
 	/* NOTE: the SDR14 expects the frequency in little endian
@@ -353,44 +477,162 @@ static void sdr14_set_freq(uint32_t hz)
 	 */
 
 	memcpy(&cmd[5], &hz, 4);
-	write(sdr14_fd, &cmd[0], 10);
-	read_bytes(10, ack);
+	sdr14_cmd(cmd, sizeof(cmd), ack, sizeof(ack));
+
+	sdr14_cmd(cmd2, sizeof(cmd2), cmd2, sizeof(cmd2));
+	sdr14_cmd(cmd3, sizeof(cmd3), cmd3, sizeof(cmd3));
+}
 
-	write(sdr14_fd, cmd2, sizeof(cmd2));
-	read(sdr14_fd, cmd2, sizeof(cmd2));
 
-	write(sdr14_fd, cmd3, sizeof(cmd3));
-	read(sdr14_fd, cmd3, sizeof(cmd3));
+/**
+ * @brief get the path of the FFTW wisdom file
+ *
+ * @note the caller must free the string
+ */
+
+static gchar *sdr14_fft_wisdom_path(void)
+{
+	return g_build_filename(g_get_user_config_dir(), CONFDIR,
+				SDR14_FFTW_WISDOM, NULL);
 }
 
 
-static void fft_init(int n, fftw_plan * p, double **reamin0, double **reamout0)
+/**
+ * @brief create the transform plans for all bin dividers
+ *
+ * @returns 0 on success, -1 on error
+ *
+ * @note previously accumulated wisdom is imported first, so planning is quick
+ *	 unless the FFTW library or the machine changed; new wisdom is saved
+ */
+
+static int sdr14_fft_init(void)
 {
-	fftw_complex *in;
-	fftw_complex *out;
+	int i;
+	int n;
+	int ret = 0;
 
+	gchar *path;
+	gchar *dir;
+	gchar *old;
+	gchar *new;
 
-	in  = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * n);
-	out = (fftw_complex *) fftw_malloc(sizeof(fftw_complex) * n);
 
-	(*p) = fftw_plan_dft_1d(n, in, out, FFTW_FORWARD, FFTW_ESTIMATE);
+	path = sdr14_fft_wisdom_path();
 
-	(*reamin0)  = (double *) in;
-	(*reamout0) = (double *) out;
+	fftw_import_system_wisdom();
+
+	if (fftw_import_wisdom_from_filename(path))
+		g_message(MSG "loaded FFTW wisdom from %s", path);
+
+	old = fftw_export_wisdom_to_string();
+
+	g_message(MSG "planning transforms");
+
+	for (i = 0; i <= SDR14_BIN_DIV_MAX; i++) {
+
+		n = sdr14.bins >> i;
+
+		sdr14_fft[i].in  = fftw_malloc(sizeof(fftw_complex) * SDR14_NSAM);
+		sdr14_fft[i].out = fftw_malloc(sizeof(fftw_complex) * SDR14_NSAM);
+
+		if (!sdr14_fft[i].in || !sdr14_fft[i].out) {
+			ret = -1;
+			break;
+		}
+
+		/* SDR14_NSAM / n contiguous blocks of n samples */
+		sdr14_fft[i].plan = fftw_plan_many_dft(1, &n, SDR14_NSAM / n,
+						       sdr14_fft[i].in,
+						       NULL, 1, n,
+						       sdr14_fft[i].out,
+						       NULL, 1, n,
+						       FFTW_FORWARD,
+						       SDR14_FFTW_PLANNER);
+		if (!sdr14_fft[i].plan) {
+			ret = -1;
+			break;
+		}
+	}
+
+	new = fftw_export_wisdom_to_string();
+
+	/* don't rewrite the file on every start */
+	if (!ret && new && g_strcmp0(old, new)) {
+
+		dir = g_path_get_dirname(path);
+		g_mkdir_with_parents(dir, 0755);
+		g_free(dir);
+
+		if (fftw_export_wisdom_to_filename(path))
+			g_message(MSG "saved FFTW wisdom to %s", path);
+		else
+			g_warning(MSG "could not save FFTW wisdom to %s", path);
+	}
+
+	free(old);
+	free(new);
+	g_free(path);
+
+	return ret;
 }
 
 
-static void fft_free(fftw_plan * p, double **reamin0, double **reamout0)
+/**
+ * @brief convert the I/Q samples of a data packet to the transform input
+ *
+ * @param in the transform input, SDR14_NSAM complex values
+ * @param pkt the data packet
+ */
+
+static void sdr14_fft_load(double *restrict in,
+			   const struct sdr14_data_pkt *restrict pkt)
 {
-	fftw_destroy_plan(*p);
-	fftw_free((fftw_complex *) * reamin0);
-	fftw_free((fftw_complex *) * reamout0);
+	int i;
+
+
+#pragma omp simd
+	for (i = 0; i < SDR14_DATA0_LEN; i++)
+		in[i] = (double) pkt->data[i];
 }
 
 
-static void cfft(fftw_plan * p)
+/**
+ * @brief accumulate the magnitudes of all transformed blocks
+ *
+ * @param spec the spectrum to add to, n - 1 bins
+ * @param out the transform output, SDR14_NSAM / n blocks of n values
+ * @param n the block size
+ *
+ * @note the negative frequencies go first; the upper half skips the DC bin,
+ *	 so the two halves are contiguous runs without index arithmetic
+ */
+
+static void sdr14_fft_accumulate(double *restrict spec,
+				 const double *restrict out, int n)
 {
-	fftw_execute(*p);
+	int i;
+	int z;
+
+	const int h = n / 2;
+
+	const double *x;
+
+
+	for (z = 0; z < SDR14_NSAM / n; z++) {
+
+		x = &out[2 * z * n];
+
+#pragma omp simd
+		for (i = 0; i < h; i++)
+			spec[i] += sqrt(x[2 * (i + h)] * x[2 * (i + h)] +
+					x[2 * (i + h) + 1] * x[2 * (i + h) + 1]);
+
+#pragma omp simd
+		for (i = 0; i < h - 1; i++)
+			spec[i + h] += sqrt(x[2 * (i + 1)] * x[2 * (i + 1)] +
+					    x[2 * (i + 1) + 1] * x[2 * (i + 1) + 1]);
+	}
 }
 
 
@@ -428,6 +670,24 @@ static void sdr14_comp_obs_strategy(struct observation *obs)
 }
 
 
+/**
+ * @brief set up the acquisition time model
+ */
+
+static void sdr14_eta_init(void)
+{
+	int i;
+
+	gdouble init[SDR14_BIN_DIV_MAX + 1];
+
+
+	for (i = 0; i <= SDR14_BIN_DIV_MAX; i++)
+		init[i] = SDR14_ETA_INIT_PKT_MS;
+
+	sdr14_eta = eta_model_new("sdr14_acq", SDR14_BIN_DIV_MAX + 1, init);
+}
+
+
 /**
  * @brief apply temperature calibration
  *
@@ -437,34 +697,37 @@ static void sdr14_comp_obs_strategy(struct observation *obs)
  * @todo polynomial preamp/inputfilter curve calibration
  */
 
-static void sdr14_apply_temp_calibration(struct spec_data *s)
+static void sdr14_apply_temp_calibration(uint32_t *spec, gsize n)
 {
 	gsize i;
 
-	for (i = 0; i < s->n; i++)
-		s->spec[i] = (uint32_t) ((double) s->spec[i]) * sdr14.temp_cal_factor;
+	for (i = 0; i < n; i++)
+		spec[i] = (uint32_t) ((double) spec[i]) * sdr14.temp_cal_factor;
 }
 
 
 /**
  * @brief acquire spectrea
  *
- u @param acq the acquisition configuration
+ * @param obs the observation
+ * @param acq_left the number of acquisitions left
  * @returns 0 on completion, 1 if more acquisitions are pending
  *
+ * @note if the sweep takes more than one tuning step, the bins of each step
+ *	 are sent as a segment as soon as the step completes; the full
+ *	 spectrum is assembled by the client
  */
-#define AVG_LEN 5.
 #define MIN_MS_ACQ_STATUS 500
-static uint32_t sdr14_spec_acquire(struct observation *obs)
+static uint32_t sdr14_spec_acquire(const struct observation *obs,
+				   uint32_t *acq_left)
 {
-	int i, j, k, l;
+	int i, k, l;
 
 	uint8_t oneshot_cmd[8] = {0x08, 0x00, 0x18, 0x00, 0x81, 0x02, 0x02, 0};
 	uint8_t ack[8];
 #if 0
 	uint8_t hbeat[3] = {0x03,0x60,0x00};
 #endif
-	static double acq_time[SDR14_BIN_DIV_MAX + 1] = {[0 ... SDR14_BIN_DIV_MAX] = 0.001};	/* bin_div starts at 1 */
 
 	GTimer *timer;
 
@@ -474,14 +737,23 @@ static uint32_t sdr14_spec_acquire(struct observation *obs)
 	struct status s_rec;
 
 	struct spec_data *s = NULL;
-	struct sdr14_data_pkt pkt;
+
+	static guint32 sweep_id;
 
 	double freq;
 	double scale;
 
+	double *reamin0;
+	double *reamout0;
+
+	fftw_plan p0;
+
 	int len;
+	int off;
+
+	gboolean fail;
 
-	if (!obs->acq.acq_max)
+	if (!(*acq_left))
 		return 0;
 
 
@@ -498,13 +770,22 @@ static uint32_t sdr14_spec_acquire(struct observation *obs)
 	//printf("len %d %d %d %d %d\n", len, obs->blsize, obs->disc_raw, obs->n_seq, obs->disc_fin);
 	s = g_malloc0(sizeof(struct spec_data) + len * sizeof(uint32_t));
 
-	fft_init(obs->blsize, &p0, &reamin0, &reamout0);
+	s->freq_min_hz = (typeof(s->freq_min_hz)) obs->acq.freq_start_hz;
+	s->freq_max_hz = (typeof(s->freq_max_hz)) obs->acq.freq_stop_hz;
+	s->freq_inc_hz = (typeof(s->freq_inc_hz)) ((s->freq_max_hz - s->freq_min_hz) / len);
+
+	sweep_id++;
+
+	/* blsize is sdr14.bins >> bin_div */
+	p0       = sdr14_fft[obs->acq.bin_div].plan;
+	reamin0  = (double *) sdr14_fft[obs->acq.bin_div].in;
+	reamout0 = (double *) sdr14_fft[obs->acq.bin_div].out;
 
 	/* update number of SDR14_NSAM sequences to record in the one shot command */
 	oneshot_cmd[7] = obs->acq.n_stack;
 
 	s_rec.busy = 1;
-	s_rec.eta_msec = (typeof(s_acq.eta_msec))(acq_time[obs->acq.bin_div] *  1000. * (double) obs->n_seq * obs->acq.n_stack * SDR14_NSAM / obs->blsize);
+	s_rec.eta_msec = (typeof(s_acq.eta_msec))(eta_model_get(sdr14_eta, obs->acq.bin_div) * (double) obs->n_seq * obs->acq.n_stack);
 	ack_status_rec(PKT_TRANS_ID_UNDEF, &s_rec);
 
 
@@ -512,61 +793,78 @@ static uint32_t sdr14_spec_acquire(struct observation *obs)
 	for (l = 0; l < obs->n_seq; l++) {
 	
 
-		sdr14_serial_flush(sdr14_fd);
+		serial_flush(sdr14_link, SDR14_FLUSH_QUIET_MS);
 		sdr14_set_freq(freq);
 
 		freq = freq + obs->bw_eff;
 
-		if (!g_mutex_trylock(&acq_abort)) {
+		if (!cfg_snap_is_current(obs_snap, obs)) {
 			g_message(MSG "acquisition loop abort indicated");
 			goto cleanup;
 		}
 
-		g_mutex_unlock(&acq_abort);
+		/* the step is timed from the start of the sampling */
+		g_timer_start(timer);
 
-		write(sdr14_fd, oneshot_cmd, sizeof(oneshot_cmd));
-		read(sdr14_fd, ack, sizeof(ack));
+		sdr14_cmd(oneshot_cmd, sizeof(oneshot_cmd), ack, sizeof(ack));
 
 
 		for (i = 0; i < obs->blsize; i++)
 			spec[i] = 0;
 
-		s_acq.eta_msec = (typeof(s_acq.eta_msec))(acq_time[obs->acq.bin_div] * 1000. * (double) obs->acq.n_stack * SDR14_NSAM / obs->blsize);
+		s_acq.eta_msec = (typeof(s_acq.eta_msec))(eta_model_get(sdr14_eta, obs->acq.bin_div) * (double) obs->acq.n_stack);
 		if (s_acq.eta_msec > MIN_MS_ACQ_STATUS) {
 			s_acq.busy = 1;
 			ack_status_acq(PKT_TRANS_ID_UNDEF, &s_acq);
 		}
 
+		/* the packets are read in the background, so the next one is
+		 * transferred while we process the current one
+		 */
+		sdr14_capture_start(obs->acq.n_stack);
+
+		fail = FALSE;
+
+		/* all packets of the step are taken, even after a failure */
 		for (k = 0; k < obs->acq.n_stack; k++) {
 
-			int z;
+			const struct sdr14_data_pkt *pkt = sdr14_capture_get();
 
-			sdr14_read(&pkt);
+			if (pkt)
+				sdr14_fft_load(reamin0, pkt);
+			else
+				fail = TRUE;
 
-			g_timer_start(timer);
-			for (z = 0; z < SDR14_NSAM / obs->blsize; z++) {
+			sdr14_capture_release();
 
-				for (j = 0; j < 2* obs->blsize; j++)
-					reamin0[j] = (double) (pkt.data[j + z * obs->blsize * 2 ]);
+			if (fail)
+				continue;
 
-				cfft(&p0);
+			fftw_execute(p0);
+			/* skip one for DC?? TOOD: VERIFY with sig gen */
+			sdr14_fft_accumulate(spec, reamout0, obs->blsize);
+		}
 
-				for (i = 0; i < obs->blsize -1; i++) {
+		if (fail) {
+			g_warning(MSG "step %d of %zu failed, spectrum discarded",
+				  l, obs->n_seq);
 
-					if (i < obs->blsize / 2)
-						j = i + obs->blsize / 2;
-					else
-						j = i - obs->blsize / 2 + 1; /* skip one for DC?? TOOD: VERIFY with sig gen */
+			s_acq.busy = 0;
+			s_acq.eta_msec = 0;
+			ack_status_acq(PKT_TRANS_ID_UNDEF, &s_acq);
 
-					spec[i] +=  sqrt((reamout0[2 * j] * reamout0[2 * j]
-						    + reamout0[2 * j + 1] * reamout0[2 * j + 1]) );
-				}
-			}
+			s_rec.busy = 0;
+			s_rec.eta_msec = 0;
+			ack_status_rec(PKT_TRANS_ID_UNDEF, &s_rec);
 
-			g_timer_stop(timer);
-			acq_time[obs->acq.bin_div] =(acq_time[obs->acq.bin_div] * (AVG_LEN - 1.0) +  g_timer_elapsed(timer, NULL)) / AVG_LEN;
+			goto cleanup;
 		}
 
+		g_timer_stop(timer);
+		eta_model_update(sdr14_eta, obs->acq.bin_div,
+				 g_timer_elapsed(timer, NULL) * 1000.0 /
+				 (double) obs->acq.n_stack);
+
 		if (s_acq.eta_msec > MIN_MS_ACQ_STATUS) {
 			s_acq.busy = 0;
 			s_acq.eta_msec = 0;
@@ -577,7 +875,10 @@ static uint32_t sdr14_spec_acquire(struct observation *obs)
 		scale *= sqrt((double)obs->blsize);
 		scale = 1.0 / scale;
 
-		for (i = 0; i < obs->blsize - 2 * obs->disc_raw ; i++) {
+		off = s->n;
+
+		/* the final discarded bins are skipped */
+		for (i = 0; i < obs->blsize - 2 * obs->disc_raw && s->n < len; i++) {
 
 			double tmp;
 
@@ -585,25 +886,20 @@ static uint32_t sdr14_spec_acquire(struct observation *obs)
 			tmp *= tmp;	/* ADC samples voltage, we want power-equivalent -> P ~ V^2 */
 			s->spec[s->n] = (uint32_t) tmp;
 
-			if (s->n == (len - 1))	/* will skip final discarded bins */
-				goto done;
 			s->n++;
 		}
-		
-	}
 
+		sdr14_apply_temp_calibration(&s->spec[off], s->n - off);
 
-done:
-	s->freq_min_hz = (typeof(s->freq_min_hz)) obs->acq.freq_start_hz;
-	s->freq_max_hz = (typeof(s->freq_max_hz)) obs->acq.freq_stop_hz;
-	s->freq_inc_hz = (typeof(s->freq_inc_hz)) ((s->freq_max_hz - s->freq_min_hz) / s->n);
-
-	//printf("%d %d %d %d\n", s->freq_min_hz, s->freq_max_hz, s->freq_inc_hz,  s->n );
+		if (obs->n_seq > 1 && last_acq_mode)
+			ack_spec_data_seg(PKT_TRANS_ID_UNDEF, s, sweep_id,
+					  l, obs->n_seq, len, off,
+					  s->n - off);
+	}
 
-	sdr14_apply_temp_calibration(s);
 
 	/* handover for transmission */
-	if (last_acq_mode)
+	if (obs->n_seq == 1 && last_acq_mode)
 		ack_spec_data(PKT_TRANS_ID_UNDEF, s);
 
 
@@ -617,12 +913,10 @@ cleanup:
 
 	g_free(s);
 
-	fft_free(&p0, &reamin0, &reamout0);
-
 noobs:
-	obs->acq.acq_max--;
+	(*acq_left)--;
 
-	return obs->acq.acq_max;
+	return (*acq_left);
 }
 
 
@@ -711,12 +1005,20 @@ static void sdr14_spec_acq_enable(gboolean mode)
 
 /**
  * @brief thread function that does all the spectrum readout work
+ *
+ * @note the newest observation is picked up before every sweep, the count
+ *	 of acquisitions starts over with each one
  */
 
 static gpointer sdr14_spec_thread(gpointer data)
 {
 	int run;
 
+	uint32_t acq_left = 0;
+
+	struct observation *obs = NULL;
+
+
 	while (1) {
 
 		g_mutex_lock(&acq_lock);
@@ -735,18 +1037,25 @@ static gpointer sdr14_spec_thread(gpointer data)
 
 			g_mutex_unlock(&acq_pause);
 
-			g_rw_lock_reader_lock(&obs_rwlock);
+			if (!cfg_snap_is_current(obs_snap, obs)) {
+				cfg_snap_put(obs_snap, obs);
+				obs = cfg_snap_get(obs_snap);
+				acq_left = obs ? obs->acq.acq_max : 0;
+			}
+
+			if (!obs) {
+				run = 0;
+				break;
+			}
 #if 1	/* set 0 to annoy squatters by constantly turning off everything */
-			run = sdr14_spec_acquire(&g_obs);
+			run = sdr14_spec_acquire(obs, &acq_left);
 #else
 			/* disable acquisition on drive power off */
 			if (be_drive_pwr_status())
-				run = sdr14_spec_acquire(&g_obs);
+				run = sdr14_spec_acquire(obs, &acq_left);
 			else
 				run = 0;
 #endif
-
-			g_rw_lock_reader_unlock(&obs_rwlock);
 		} while (run);
 
 
@@ -757,29 +1066,20 @@ static gpointer sdr14_spec_thread(gpointer data)
 
 
 /**
- * @brief thread function to update the acquisition information
+ * @brief publish a new observation
+ *
+ * @note a sweep in progress is aborted at its next tuning step, the
+ *	 acquisition thread then picks up the new observation
  */
 
-static gpointer sdr14_acquisition_update(gpointer data)
+static void sdr14_acquisition_update(struct observation *obs)
 {
-	struct observation *obs;
-
-
-	obs = (struct observation *) data;
-
-
-	/* wait for mutex lock to indicate abort to a single acquisition cycle
-	 * this is needed if a very wide frequency span had been selected
-	 */
-	g_mutex_lock(&acq_abort);
-
-	g_rw_lock_writer_lock(&obs_rwlock);
+	struct spec_acq_cfg acq;
 
-	memcpy(&g_obs, obs, sizeof(struct observation));
 
-	g_rw_lock_writer_unlock(&obs_rwlock);
+	memcpy(&acq, &obs->acq, sizeof(struct spec_acq_cfg));
 
-	g_mutex_unlock(&acq_abort);
+	cfg_snap_publish(obs_snap, obs);
 #if 0
 	/* signal the acquisition thread outer loop */
 	if (g_mutex_trylock(&acq_lock)) {
@@ -788,9 +1088,7 @@ static gpointer sdr14_acquisition_update(gpointer data)
 	}
 #endif
 	/* push current configuration to clients */
-	ack_spec_acq_cfg(PKT_TRANS_ID_UNDEF, &g_obs.acq);
-
-	g_free(data);
+	ack_spec_acq_cfg(PKT_TRANS_ID_UNDEF, &acq);
 }
 
 
@@ -822,7 +1120,7 @@ static int sdr14_spec_acquisition_configure(struct spec_acq_cfg *acq)
 		      acq->acq_max);
 
 
-	obs = g_malloc(sizeof(struct observation));
+	obs = cfg_snap_alloc(sizeof(struct observation));
 	if (!obs) {
 		g_error(MSG "memory allocation failed: %s: %d",
 			__func__, __LINE__);
@@ -834,10 +1132,7 @@ static int sdr14_spec_acquisition_configure(struct spec_acq_cfg *acq)
 
 	sdr14_comp_obs_strategy(obs);
 
-	/* create new thread to update acquisition thread, so we don't
-	 * lock down the main loop
-	 */
-	g_thread_new(NULL, sdr14_acquisition_update, (gpointer) obs);
+	sdr14_acquisition_update(obs);
 
 
 
@@ -852,7 +1147,7 @@ static void sdr14_spec_cfg_defaults(void)
 {
 	struct observation *obs;
 
-	obs = g_malloc(sizeof(struct observation));
+	obs = cfg_snap_alloc(sizeof(struct observation));
 	if (!obs) {
 		g_error(MSG "memory allocation failed: %s: %d",
 				__func__, __LINE__);
@@ -868,7 +1163,7 @@ static void sdr14_spec_cfg_defaults(void)
 
 	sdr14_comp_obs_strategy(obs);
 
-	g_thread_new(NULL, sdr14_acquisition_update, (gpointer) obs);
+	sdr14_acquisition_update(obs);
 }
 
 
@@ -895,10 +1190,19 @@ int be_spec_acq_cfg(struct spec_acq_cfg *acq)
 G_MODULE_EXPORT
 int be_spec_acq_cfg_get(struct spec_acq_cfg *acq)
 {
+	struct observation *obs;
+
+
 	if (!acq)
 		return -1;
 
-	memcpy(acq, &g_obs.acq, sizeof(struct spec_acq_cfg));
+	obs = cfg_snap_get(obs_snap);
+	if (!obs)
+		return -1;
+
+	memcpy(acq, &obs->acq, sizeof(struct spec_acq_cfg));
+
+	cfg_snap_put(obs_snap, obs);
 
 	return 0;
 }
@@ -984,21 +1288,23 @@ void module_extra_init(void)
 
 	g_message(MSG "configuring serial link");
 
-	sdr14_fd = sdr14_serial_open_port(sdr14_tty);
-	if (!sdr14_fd)
+	sdr14_link = serial_open(sdr14_tty, SDR14_BAUD);
+	if (!sdr14_link)
 		g_error(MSG "Error opening serial port %s\n", sdr14_tty);
 
-	if (sdr14_serial_set_comm_param(sdr14_fd))
-		g_error(MSG "Error setting parameters for serial port %s\n",
-			sdr14_tty);
-
-
-	sdr14_serial_flush(sdr14_fd);
+	serial_flush(sdr14_link, SDR14_FLUSH_QUIET_MS);
 #if 0
 	sdr14_get_mode();
 #endif
 	sdr14_setup_ad6620();
 
+	if (sdr14_fft_init())
+		g_error(MSG "Error creating the transform plans");
+
+	sdr14_eta_init();
+
+	sdr14_cap.thread = g_thread_new(NULL, sdr14_capture_thread, NULL);
+
 	g_message(MSG "starting spectrum acquisition thread");
 
 	thread = g_thread_new(NULL, sdr14_spec_thread, NULL);
@@ -1028,5 +1334,7 @@ const gchar *g_module_check_init(void)
 
 	srt_spec_load_calibration();
 #endif
+	obs_snap = cfg_snap_new(NULL);
+
 	return NULL;
 }
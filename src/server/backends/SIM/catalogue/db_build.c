@@ -1,52 +1,229 @@
+/**
+ * @file    server/backends/SIM/catalogue/db_build.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief convert the HI profiles fetched by data_dl.sh into the simulator's
+ *	  HI survey data cube
+ *
+ * @note build with
+ *	 gcc -O2 -fopenmp -I.. db_build.c ../hi_cube.c \
+ *	     $(pkg-config --cflags --libs gio-2.0) -lm -o db_build
+ *
+ *	 usage: db_build [dl dir] [out file] [flat|tiled]
+ *
+ *	 the default is to read dl/ and write the flat vel_short_int.dat,
+ *	 which is what the simulator expects as sky_vel.dat; "tiled" writes a
+ *	 compressed HI cube for use as sky_vel.hic instead, the flat file is
+ *	 not needed for that
+ *
+ * @note the profiles are processed one strip of longitudes at a time; all
+ *	 files of a strip are mapped and parsed in parallel, then the strip
+ *	 is written out, so the memory needed stays small
+ */
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
 
+#include <glib.h>
+
+#include "hi_cube.h"
+
 
 /* velocity bins */
 #define VEL 801
 
+/* the survey grid, 0.5 deg steps, 0/360 lon and 0 lat included */
+#define GRID_RES	0.5
+#define GRID_NLON	721
+#define GRID_NLAT	361
 
-static void import_spec(FILE *f, FILE *data)
-{
-	char *t;
-	char line[256];
+/* longitude columns per strip (and per tile in longitude) */
+#define STRIP_COLS	16
 
-	short as[VEL];
-	float a[VEL];
-	int n[VEL];
 
-	float tmp;
+struct build {
+	const gchar *dir;	/* directory holding the profiles */
 
-	int i;
+	guint col;		/* next longitude column to read */
 
+	guint64 bytes;		/* input bytes parsed */
+	guint   files;		/* profiles processed */
+	guint   missing;	/* profiles not found */
 
+	gint64  start;		/* start time (usec) */
+};
 
-	memset(n, 0, sizeof(int) * VEL);
-	memset(a, sizeof(float) * VEL);
 
+/**
+ * @brief parse a decimal floating point number
+ *
+ * @param p the start of the number, leading blanks are skipped
+ * @param end the end of the buffer
+ * @param[out] val the number
+ *
+ * @returns a pointer to the first character after the number or NULL if
+ *	    there was none
+ *
+ * @note this is only as good as needed for the survey data, but a lot
+ *	 faster than strtod(), which honours the locale and is exact to the
+ *	 last bit
+ */
 
-	while (fgets(line, 256, f)) {
+static const gchar *parse_num(const gchar *p, const gchar *end, gdouble *val)
+{
+	gint e = 0;
+	gint ex = 0;
+	gint esgn = 1;
+
+	gdouble sgn = 1.0;
+	gdouble v = 0.0;
 
-		t = strtok(line, "\t ");
+	gboolean digits = FALSE;
 
-		if (t) {
-			if (t[0] == '%')
-				continue; /* comment, go to next line */
 
-			tmp = strtod(t, NULL);
+	while (p < end && (*p == ' ' || *p == '\t'))
+		p++;
 
-			t = strtok(NULL, "\t ");
+	if (p < end && (*p == '-' || *p == '+')) {
+		if (*p == '-')
+			sgn = -1.0;
+		p++;
+	}
+
+	while (p < end && g_ascii_isdigit(*p)) {
+		v = v * 10.0 + (gdouble) (*p - '0');
+		digits = TRUE;
+		p++;
+	}
+
+	if (p < end && *p == '.') {
+		p++;
+		while (p < end && g_ascii_isdigit(*p)) {
+			v = v * 10.0 + (gdouble) (*p - '0');
+			digits = TRUE;
+			e--;
+			p++;
 		}
+	}
+
+	if (!digits)
+		return NULL;
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
 
-		if (t) {
+		if (p < end && (*p == '-' || *p == '+')) {
+			if (*p == '-')
+				esgn = -1;
+			p++;
+		}
 
-			i = (int) (400. + nearbyint(tmp));
-			tmp = strtod(t, NULL);
-			a[i] += tmp;
-			n[i]++;
+		while (p < end && g_ascii_isdigit(*p)) {
+			ex = ex * 10 + (*p - '0');
+			p++;
 		}
+
+		e += esgn * ex;
+	}
+
+	if (e)
+		v *= pow(10.0, (gdouble) e);
+
+	(*val) = sgn * v;
+
+	return p;
+}
+
+
+/**
+ * @brief import a HI profile
+ *
+ * @param fname the file name of the profile
+ * @param[out] as the VEL velocity bins in cK
+ *
+ * @returns the size of the file, 0 if it could not be read
+ *
+ * @note the profile is a list of lines holding velocity and brightness
+ *	 temperature, lines starting with % are comments
+ */
+
+static gsize import_spec(const gchar *fname, gint16 *as)
+{
+	gint i;
+	gint i1, i2;
+
+	gsize len;
+
+	gdouble v, t;
+
+	const gchar *p;
+	const gchar *end;
+	const gchar *nxt;
+
+	GMappedFile *mf;
+
+	gint n[VEL];
+	gdouble a[VEL];
+
+
+	memset(as, 0, VEL * sizeof(gint16));
+
+	mf = g_mapped_file_new(fname, FALSE, NULL);
+	if (!mf)
+		return 0;
+
+	len = g_mapped_file_get_length(mf);
+	p   = g_mapped_file_get_contents(mf);
+	end = p + len;
+
+	memset(n, 0, sizeof(n));
+	memset(a, 0, sizeof(a));
+
+	while (p < end) {
+
+		nxt = memchr(p, '\n', end - p);
+		if (!nxt)
+			nxt = end;
+
+		/* comment, go to next line */
+		if (*p == '%')
+			goto next;
+
+		p = parse_num(p, nxt, &v);
+		if (!p)
+			goto next;
+
+		p = parse_num(p, nxt, &t);
+		if (!p)
+			goto next;
+
+		i = (gint) (400. + nearbyint(v));
+		if (i < 0 || i >= VEL)
+			goto next;
+
+		a[i] += t;
+		n[i]++;
+next:
+		p = nxt + 1;
+	}
+
+	g_mapped_file_unref(mf);
+
+	for (i = 0; i < VEL; i++) {
+		if (n[i])
+			a[i] /= (gdouble) n[i];
 	}
 
 	for (i = 0; i < VEL; i++) {
@@ -57,75 +234,242 @@ static void import_spec(FILE *f, FILE *data)
 		 */
 
 		if (!n[i]) {
-			int i1, i2;
 
-			i1 = i - 1;
-			i2 = i + 1;
+			i1 = MAX(i - 1, 0);
+			i2 = MIN(i + 1, VEL - 1);
 
-			if (i1 < 0)
-				i1 = i;
+			if (n[i1] && n[i2])
+				a[i] = 0.5 * (a[i1] + a[i2]);
+			else if (n[i1])
+				a[i] = a[i1];
+			else if (n[i2])
+				a[i] = a[i2];
+		}
+
+		/* drop one digit, cK resolution will suffice */
+		as[i] = (gint16) (a[i] * 100.);
+	}
+
+	return len;
+}
 
-			if (i2 > VEL)
-				i2 = i;
 
-			n[i] = 1;
+/**
+ * @brief print the progress of the conversion
+ */
 
-			a[i] = (a[i1] * (float) n[i1]+ a[i2] * (float) n[i2]);
-			a[i] = a[i] / ((float) n[i1] + (float)n[i2]);
+static void report(struct build *b)
+{
+	gdouble t;
+	gdouble r;
+	gdouble done;
+
+	const guint total = GRID_NLON * GRID_NLAT;
+
+
+	t = (gdouble) (g_get_monotonic_time() - b->start) * 1e-6;
+	if (t <= 0.0)
+		return;
+
+	r    = (gdouble) b->files / t;
+	done = (gdouble) b->files / (gdouble) total;
+
+	fprintf(stderr, "\r%5.1f%% %u/%u profiles, %.0f files/s, %.1f MiB/s, "
+		"ETA %.0f s   ", 100.0 * done, b->files, total, r,
+		(gdouble) b->bytes / t / (1024.0 * 1024.0),
+		r > 0.0 ? (gdouble) (total - b->files) / r : 0.0);
+}
+
+
+/**
+ * @brief read the next strip of longitude columns
+ *
+ * @param buf the output buffer, ordered velocity fastest, then latitude,
+ *	  then longitude
+ * @param n the number of samples to read
+ * @param data a struct build
+ *
+ * @returns the number of samples read
+ */
+
+static gsize read_strip(guint16 *buf, gsize n, gpointer data)
+{
+	gint i;
+	gint npos;
+
+	guint64 bytes = 0;
+	guint   missing = 0;
+
+	struct build *b = (struct build *) data;
+
+
+	npos = (gint) (n / VEL);
+
+	if ((gsize) npos * VEL != n)
+		return 0;
+
+	if (b->col * GRID_NLAT + npos > GRID_NLON * GRID_NLAT)
+		return 0;
+
+#pragma omp parallel for schedule(dynamic, 8) reduction(+:bytes, missing)
+	for (i = 0; i < npos; i++) {
+
+		gsize len;
+		gchar *fname;
+		gdouble glon, glat;
+
+		glon = (gdouble) (b->col + i / GRID_NLAT) * GRID_RES;
+		glat = (gdouble) (i % GRID_NLAT) * GRID_RES - 90.0;
+
+		fname = g_strdup_printf("%s/%.1f_%.1f.txt", b->dir, glon, glat);
+
+		len = import_spec(fname, (gint16 *) &buf[(gsize) i * VEL]);
+		if (!len) {
+			fprintf(stderr, "\nerror opening file %s\n", fname);
+			missing++;
 		}
 
-		a[i] /= (float) n[i];
+		bytes += len;
 
-		/* drop one digit, cK resolution will suffice */
-		as[i] = (short) (a[i] * 100.);
+		g_free(fname);
 	}
 
-	fwrite(as, sizeof(short), 801, data);
-}
+	b->col     += npos / GRID_NLAT;
+	b->files   += npos;
+	b->bytes   += bytes;
+	b->missing += missing;
 
+	report(b);
+
+	return n;
+}
 
 
+/**
+ * @brief write the flat data cube
+ *
+ * @returns 0 on success, otherwise error
+ */
 
-void convert(void)
+static gint write_flat(const gchar *path, struct build *b)
 {
+	gint ret = 0;
+
+	gsize n;
+	guint cols;
+
+	guint16 *strip;
+
 	FILE *f;
 
-	char fname[256];
 
-	double glon;
-	double glat;
+	f = fopen(path, "wb");
+	if (!f)
+		return -1;
 
+	strip = g_malloc((gsize) STRIP_COLS * GRID_NLAT * VEL * sizeof(guint16));
 
+	while (b->col < GRID_NLON) {
 
-	FILE *data = fopen("vel_short_int.dat", "wb");
+		cols = MIN(STRIP_COLS, GRID_NLON - b->col);
+		n = (gsize) cols * GRID_NLAT * VEL;
 
+		if (read_strip(strip, n, b) != n) {
+			ret = -1;
+			break;
+		}
 
+		if (fwrite(strip, sizeof(guint16), n, f) != n) {
+			ret = -1;
+			break;
+		}
+	}
+
+	if (fclose(f))
+		ret = -1;
 
-	for (glon = 0.0; glon <= 360.0; glon+=0.5) {
+	g_free(strip);
 
-		for (glat = -90.0; glat <= 90.0; glat+=0.5) {
+	return ret;
+}
 
-			fprintf(stderr, "offset %ld, pos %.1f, %.1f\n", ftell(data), glon, glat);
 
-			snprintf(fname, sizeof(fname), "dl/%.1f_%.1f.txt", glon, glat);
-			f = fopen(fname, "r");
+/**
+ * @brief write the tiled data cube
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static gint write_tiled(const gchar *path, struct build *b)
+{
+	struct hi_cube_hdr hdr = {
+		.nlon = GRID_NLON,
+		.nlat = GRID_NLAT,
+		.nvel = VEL,
+		.tlon = STRIP_COLS,
+		.tlat = STRIP_COLS,
+		.tvel = VEL,
+		.lon0 =   0.0,
+		.lat0 = -90.0,
+		.res  = GRID_RES,
+		.vel0 = -400.0,
+		.vres =   1.0,
+	};
+
+
+	return hi_cube_write(path, &hdr, read_strip, b);
+}
+
+
+int main(int argc, char *argv[])
+{
+	gint ret;
 
-			if (!f) {
-				printf("%s: error opening file %s\n", __func__, fname);
-			} else {
-				import_spec(f, data);
-				fclose(f);
-			}
+	gboolean tiled = FALSE;
 
+	const gchar *out = "vel_short_int.dat";
+
+	struct build b = {
+		.dir = "dl",
+	};
+
+
+	if (argc > 1)
+		b.dir = argv[1];
+
+	if (argc > 3) {
+		if (!strcmp(argv[3], "tiled")) {
+			tiled = TRUE;
+		} else if (strcmp(argv[3], "flat")) {
+			fprintf(stderr, "usage: %s [dl dir] [out file] "
+					"[flat|tiled]\n", argv[0]);
+			return EXIT_FAILURE;
 		}
 	}
 
-	fclose(data);
-}
+	if (argc > 2)
+		out = argv[2];
 
+	b.start = g_get_monotonic_time();
 
-int main(void)
-{
-	convert();
-	return 0;
+	if (tiled)
+		ret = write_tiled(out, &b);
+	else
+		ret = write_flat(out, &b);
+
+	fprintf(stderr, "\n");
+
+	if (b.missing)
+		fprintf(stderr, "%u profiles were missing and left empty\n",
+			b.missing);
+
+	if (ret) {
+		fprintf(stderr, "could not write %s\n", out);
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stderr, "wrote %s in %.1f s\n", out,
+		(gdouble) (g_get_monotonic_time() - b.start) * 1e-6);
+
+	return EXIT_SUCCESS;
 }
@@ -0,0 +1,98 @@
+/**
+ * @file    server/backends/SIM/catalogue/hi_cube_build.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief convert a flat HI survey file (as made by db_build) into a tiled,
+ *	  compressed HI cube for the simulator
+ *
+ * @note build with
+ *	 gcc -O2 -I.. hi_cube_build.c ../hi_cube.c \
+ *	     $(pkg-config --cflags --libs gio-2.0) -lm -o hi_cube_build
+ *
+ *	 usage: hi_cube_build <in.dat> <out.hic> [res] [nlon] [nlat] [tile]
+ *		[chunk]
+ *
+ *	 the defaults match sky_vel.dat: 0.5 deg grid, 721 x 361 positions
+ *	 starting at GLON 0, GLAT -90, 801 velocity bins from -400 km/s in
+ *	 1 km/s steps, 16 x 16 position tiles holding the full velocity range
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "hi_cube.h"
+
+
+static gsize read_strip(guint16 *buf, gsize n, gpointer data)
+{
+	return fread(buf, sizeof(guint16), n, (FILE *) data);
+}
+
+
+int main(int argc, char *argv[])
+{
+	int ret;
+
+	FILE *in;
+
+	struct hi_cube_hdr hdr = {
+		.nlon = 721,
+		.nlat = 361,
+		.nvel = 801,
+		.tlon = 16,
+		.tlat = 16,
+		.tvel = 801,
+		.lon0 =   0.0,
+		.lat0 = -90.0,
+		.res  =   0.5,
+		.vel0 = -400.0,
+		.vres =   1.0,
+	};
+
+
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s <in.dat> <out.hic> [res] [nlon] "
+				"[nlat] [tile] [chunk]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (argc > 3)
+		hdr.res = strtod(argv[3], NULL);
+	if (argc > 4)
+		hdr.nlon = strtoul(argv[4], NULL, 0);
+	if (argc > 5)
+		hdr.nlat = strtoul(argv[5], NULL, 0);
+	if (argc > 6)
+		hdr.tlon = hdr.tlat = strtoul(argv[6], NULL, 0);
+	if (argc > 7)
+		hdr.tvel = strtoul(argv[7], NULL, 0);
+
+	in = fopen(argv[1], "rb");
+	if (!in) {
+		perror(argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	ret = hi_cube_write(argv[2], &hdr, read_strip, in);
+
+	fclose(in);
+
+	if (ret) {
+		fprintf(stderr, "could not write %s\n", argv[2]);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,785 @@
+/**
+ * @file    server/backends/SIM/hi_cube.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief a tiled, compressed HI survey data cube
+ *
+ * @note the cube is split into spatial tiles and velocity chunks which are
+ *	 compressed individually; the file is mapped and tiles are only
+ *	 inflated when they are accessed, the most recently used tiles are
+ *	 kept in a cache of bounded size; when the lookups move into a new
+ *	 tile, the next tile in the same direction is prefetched in the
+ *	 background, so a scan across the sky rarely has to wait
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "hi_cube.h"
+
+
+#define MSG "HI CUBE: "
+
+
+/**
+ * @brief a cached, inflated tile
+ */
+
+struct tile {
+	guint id;
+	guint16 *data;
+};
+
+
+struct hi_cube {
+	GMappedFile *file;
+	const guint8 *base;
+
+	struct hi_cube_hdr hdr;
+	const struct hi_cube_idx *idx;
+
+	guint ntlon;			/* number of tiles in longitude */
+	guint nlon_wrap;		/* grid columns per 360 deg */
+	guint ntlon_wrap;		/* tiles per 360 deg */
+	guint ntlat;			/* number of tiles in latitude */
+	guint ntvel;			/* number of velocity chunks */
+	gsize tile_len;			/* number of samples per tile */
+
+	GMutex lock;
+	GHashTable *tiles;		/* tile id to link in lru */
+	GQueue lru;			/* most recently used first */
+	gsize cache_tiles;		/* maximum number of cached tiles */
+
+	GThreadPool *pool;		/* background prefetcher */
+	GHashTable *queued;		/* tile ids pending or in flight */
+	gint last_tlon;			/* last tile accessed */
+	gint last_tlat;
+};
+
+
+/**
+ * @brief inflate a tile
+ *
+ * @param c the HI cube
+ * @param id the tile id
+ * @param buf a buffer of tile_len samples
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static gint hi_cube_inflate(struct hi_cube *c, guint id, guint16 *buf)
+{
+	gsize rd;
+	gsize wr;
+	gsize len;
+
+	GConverter *conv;
+	GConverterResult res;
+
+	GError *error = NULL;
+
+	const struct hi_cube_idx *e;
+
+
+	e   = &c->idx[id];
+	len = c->tile_len * sizeof(guint16);
+
+	conv = G_CONVERTER(g_zlib_decompressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB));
+
+	res = g_converter_convert(conv, c->base + e->offset, e->len, buf, len,
+				  G_CONVERTER_INPUT_AT_END, &rd, &wr, &error);
+
+	g_object_unref(conv);
+
+	if (error) {
+		g_warning(MSG "could not inflate tile %u: %s", id,
+			  error->message);
+		g_clear_error(&error);
+		return -1;
+	}
+
+	if ((res != G_CONVERTER_FINISHED) || (wr != len)) {
+		g_warning(MSG "tile %u is corrupt", id);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief look up a cached tile and mark it most recently used
+ *
+ * @note call with the cache lock held
+ */
+
+static struct tile *hi_cube_lookup(struct hi_cube *c, guint id)
+{
+	GList *link;
+
+
+	link = g_hash_table_lookup(c->tiles, GUINT_TO_POINTER(id));
+	if (!link)
+		return NULL;
+
+	g_queue_unlink(&c->lru, link);
+	g_queue_push_head_link(&c->lru, link);
+
+	return (struct tile *) link->data;
+}
+
+
+/**
+ * @brief add an inflated tile to the cache and evict the least recently
+ *	  used tiles if the cache is full
+ *
+ * @returns the cached tile
+ *
+ * @note call with the cache lock held; if another thread was faster, the
+ *	 data are released and the tile already in the cache is returned
+ */
+
+static struct tile *hi_cube_insert(struct hi_cube *c, guint id,
+				   guint16 *data)
+{
+	GList *link;
+
+	struct tile *t;
+
+
+	t = hi_cube_lookup(c, id);
+	if (t) {
+		g_free(data);
+		return t;
+	}
+
+	t = g_malloc(sizeof(struct tile));
+	t->id   = id;
+	t->data = data;
+
+	g_queue_push_head(&c->lru, t);
+	g_hash_table_insert(c->tiles, GUINT_TO_POINTER(id), c->lru.head);
+
+	while (g_queue_get_length(&c->lru) > c->cache_tiles) {
+
+		link = g_queue_peek_tail_link(&c->lru);
+		g_queue_unlink(&c->lru, link);
+
+		t = (struct tile *) link->data;
+		g_hash_table_remove(c->tiles, GUINT_TO_POINTER(t->id));
+
+		g_free(t->data);
+		g_free(t);
+		g_list_free_1(link);
+	}
+
+	return (struct tile *) c->lru.head->data;
+}
+
+
+/**
+ * @brief inflate a tile into the cache, unless it is already there
+ */
+
+static void hi_cube_fetch(struct hi_cube *c, guint id)
+{
+	gboolean hit;
+
+	guint16 *buf;
+
+
+	g_mutex_lock(&c->lock);
+	hit = g_hash_table_contains(c->tiles, GUINT_TO_POINTER(id));
+	g_mutex_unlock(&c->lock);
+
+	if (hit)
+		return;
+
+	buf = g_malloc(c->tile_len * sizeof(guint16));
+
+	if (hi_cube_inflate(c, id, buf)) {
+		g_free(buf);
+		return;
+	}
+
+	g_mutex_lock(&c->lock);
+	hi_cube_insert(c, id, buf);
+	g_mutex_unlock(&c->lock);
+}
+
+
+/**
+ * @brief the prefetch worker
+ *
+ * @note tile ids are offset by one, so tile 0 is not a NULL pointer
+ */
+
+static void hi_cube_prefetch_worker(gpointer data, gpointer user_data)
+{
+	struct hi_cube *c = (struct hi_cube *) user_data;
+
+
+	hi_cube_fetch(c, GPOINTER_TO_UINT(data) - 1);
+
+	g_mutex_lock(&c->lock);
+	g_hash_table_remove(c->queued, data);
+	g_mutex_unlock(&c->lock);
+}
+
+
+/**
+ * @brief queue the next tile along the direction of the last tile change
+ *
+ * @param c the HI cube
+ * @param tlon the longitude index of the current tile
+ * @param tlat the latitude index of the current tile
+ */
+
+static void hi_cube_prefetch(struct hi_cube *c, gint tlon, gint tlat)
+{
+	guint v;
+	guint id;
+
+	gint dlon;
+	gint dlat;
+
+
+	g_mutex_lock(&c->lock);
+
+	if ((tlon == c->last_tlon) && (tlat == c->last_tlat)) {
+		g_mutex_unlock(&c->lock);
+		return;
+	}
+
+	if (c->last_tlon < 0) {
+		c->last_tlon = tlon;
+		c->last_tlat = tlat;
+		g_mutex_unlock(&c->lock);
+		return;
+	}
+
+	dlon = (tlon > c->last_tlon) - (tlon < c->last_tlon);
+	dlat = (tlat > c->last_tlat) - (tlat < c->last_tlat);
+
+	c->last_tlon = tlon;
+	c->last_tlat = tlat;
+
+	/* longitude is circular, latitude is not */
+	tlon = (tlon + dlon + (gint) c->ntlon_wrap) % (gint) c->ntlon_wrap;
+	tlat = tlat + dlat;
+
+	if ((tlat < 0) || (tlat >= (gint) c->ntlat)) {
+		g_mutex_unlock(&c->lock);
+		return;
+	}
+
+	/* a tile is queued at most once, so the queue stays bounded */
+	for (v = 0; v < c->ntvel; v++) {
+
+		id = ((guint) tlon * c->ntlat + (guint) tlat) * c->ntvel + v;
+
+		if (g_hash_table_contains(c->tiles, GUINT_TO_POINTER(id)))
+			continue;
+
+		if (!g_hash_table_add(c->queued, GUINT_TO_POINTER(id + 1)))
+			continue;
+
+		g_thread_pool_push(c->pool, GUINT_TO_POINTER(id + 1), NULL);
+	}
+
+	g_mutex_unlock(&c->lock);
+}
+
+
+/**
+ * @brief get a spectrum from the cube
+ *
+ * @param c the HI cube
+ * @param glat the galactic latitude
+ * @param glon the galactic longitude
+ * @param[out] spec a buffer of nvel samples
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the coordinates are mapped to the nearest grid point
+ */
+
+gint hi_cube_get_spec(struct hi_cube *c, gdouble glat, gdouble glon,
+		      guint16 *spec)
+{
+	guint v;
+	guint n;
+	guint id;
+
+	gint ilon, ilat;
+	gint tlon, tlat;
+
+	gsize off;
+
+	guint16 *buf;
+
+	struct tile *t;
+
+	const struct hi_cube_hdr *h = &c->hdr;
+
+
+	ilon = (gint) round((glon - h->lon0) / h->res);
+	ilat = (gint) round((glat - h->lat0) / h->res);
+
+	ilon = ((ilon % (gint) c->nlon_wrap) + (gint) c->nlon_wrap)
+	       % (gint) c->nlon_wrap;
+	ilat = CLAMP(ilat, 0, (gint) h->nlat - 1);
+
+	tlon = ilon / (gint) h->tlon;
+	tlat = ilat / (gint) h->tlat;
+
+	off = ((gsize) (ilon % h->tlon) * h->tlat + (gsize) (ilat % h->tlat))
+	      * h->tvel;
+
+	for (v = 0; v < c->ntvel; v++) {
+
+		id = ((guint) tlon * c->ntlat + (guint) tlat) * c->ntvel + v;
+		n  = MIN(h->tvel, h->nvel - v * h->tvel);
+
+		g_mutex_lock(&c->lock);
+
+		t = hi_cube_lookup(c, id);
+
+		if (!t) {
+			/* don't hold the lock while inflating */
+			g_mutex_unlock(&c->lock);
+
+			buf = g_malloc(c->tile_len * sizeof(guint16));
+
+			if (hi_cube_inflate(c, id, buf)) {
+				g_free(buf);
+				return -1;
+			}
+
+			g_mutex_lock(&c->lock);
+			t = hi_cube_insert(c, id, buf);
+		}
+
+		memcpy(&spec[v * h->tvel], &t->data[off], n * sizeof(guint16));
+
+		g_mutex_unlock(&c->lock);
+	}
+
+	hi_cube_prefetch(c, tlon, tlat);
+
+	return 0;
+}
+
+
+/**
+ * @brief get the header of the cube
+ */
+
+const struct hi_cube_hdr *hi_cube_get_hdr(struct hi_cube *c)
+{
+	return &c->hdr;
+}
+
+
+/**
+ * @brief validate the header and index of a mapped cube
+ *
+ * @returns 0 on success, otherwise error
+ */
+
+static gint hi_cube_validate(struct hi_cube *c, gsize len)
+{
+	gsize i;
+	gsize n;
+
+	const struct hi_cube_hdr *h = &c->hdr;
+
+
+	if (memcmp(h->magic, HI_CUBE_MAGIC, sizeof(h->magic)))
+		return -1;
+
+	if (h->bom != HI_CUBE_BOM) {
+		g_warning(MSG "cube was written on a host of different "
+			      "byte order");
+		return -1;
+	}
+
+	if (!h->nlon || !h->nlat || !h->nvel)
+		return -1;
+
+	if (!h->tlon || !h->tlat || !h->tvel)
+		return -1;
+
+	if (!(h->res > 0.0))
+		return -1;
+
+	n = (gsize) c->ntlon * c->ntlat * c->ntvel;
+
+	if (len < sizeof(struct hi_cube_hdr) + n * sizeof(struct hi_cube_idx))
+		return -1;
+
+	for (i = 0; i < n; i++) {
+		if (c->idx[i].offset + c->idx[i].len > len)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief open a tiled HI cube
+ *
+ * @param path the path to the file
+ * @param cache_tiles the maximum number of inflated tiles to keep
+ *
+ * @returns the cube or NULL on error
+ */
+
+struct hi_cube *hi_cube_open(const gchar *path, gsize cache_tiles)
+{
+	gsize len;
+
+	GError *error = NULL;
+
+	struct hi_cube *c;
+
+
+	c = g_malloc0(sizeof(struct hi_cube));
+
+	c->file = g_mapped_file_new(path, FALSE, &error);
+	if (!c->file) {
+		g_clear_error(&error);
+		g_free(c);
+		return NULL;
+	}
+
+	len = g_mapped_file_get_length(c->file);
+
+	if (len < sizeof(struct hi_cube_hdr)) {
+		g_warning(MSG "%s is too short", path);
+		goto error;
+	}
+
+	c->base = (const guint8 *) g_mapped_file_get_contents(c->file);
+
+	memcpy(&c->hdr, c->base, sizeof(struct hi_cube_hdr));
+
+	c->idx = (const struct hi_cube_idx *)
+		 (c->base + sizeof(struct hi_cube_hdr));
+
+	c->ntlon = (c->hdr.nlon + c->hdr.tlon - 1) / MAX(c->hdr.tlon, 1);
+	c->ntlat = (c->hdr.nlat + c->hdr.tlat - 1) / MAX(c->hdr.tlat, 1);
+	c->ntvel = (c->hdr.nvel + c->hdr.tvel - 1) / MAX(c->hdr.tvel, 1);
+
+	c->tile_len = (gsize) c->hdr.tlon * c->hdr.tlat * c->hdr.tvel;
+
+	if (hi_cube_validate(c, len)) {
+		g_warning(MSG "%s is not a valid HI cube", path);
+		goto error;
+	}
+
+	/* a full-sky grid may repeat 0 deg as 360 deg in its last column,
+	 * which must be skipped when the longitude wraps
+	 */
+	c->nlon_wrap  = (guint) round(360.0 / c->hdr.res);
+	c->nlon_wrap  = CLAMP(c->nlon_wrap, 1, c->hdr.nlon);
+	c->ntlon_wrap = (c->nlon_wrap + c->hdr.tlon - 1) / c->hdr.tlon;
+
+	/* we need at least all velocity chunks of one tile */
+	c->cache_tiles = MAX(cache_tiles, 2 * c->ntvel);
+
+	c->tiles = g_hash_table_new(g_direct_hash, g_direct_equal);
+	c->queued = g_hash_table_new(g_direct_hash, g_direct_equal);
+	g_queue_init(&c->lru);
+	g_mutex_init(&c->lock);
+
+	c->last_tlon = -1;
+	c->last_tlat = -1;
+
+	c->pool = g_thread_pool_new(hi_cube_prefetch_worker, c, 1, FALSE,
+				    NULL);
+
+	g_message(MSG "%s: %ux%ux%u samples at %g deg, %ux%ux%u tiles, "
+		  "caching up to %" G_GSIZE_FORMAT " tiles (%" G_GSIZE_FORMAT
+		  " kiB)", path, c->hdr.nlon, c->hdr.nlat, c->hdr.nvel,
+		  c->hdr.res, c->ntlon, c->ntlat, c->ntvel, c->cache_tiles,
+		  c->cache_tiles * c->tile_len * sizeof(guint16) / 1024);
+
+	return c;
+
+error:
+	g_mapped_file_unref(c->file);
+	g_free(c);
+
+	return NULL;
+}
+
+
+/**
+ * @brief close a HI cube and release all cached tiles
+ */
+
+void hi_cube_close(struct hi_cube *c)
+{
+	struct tile *t;
+
+
+	if (!c)
+		return;
+
+	/* drop pending prefetches, wait for the running one */
+	g_thread_pool_free(c->pool, TRUE, TRUE);
+
+	while ((t = g_queue_pop_head(&c->lru))) {
+		g_free(t->data);
+		g_free(t);
+	}
+
+	g_hash_table_destroy(c->tiles);
+	g_hash_table_destroy(c->queued);
+	g_mutex_clear(&c->lock);
+	g_mapped_file_unref(c->file);
+
+	g_free(c);
+}
+
+
+/**
+ * @brief deflate a tile
+ *
+ * @param tile the raw tile
+ * @param len the size of the raw tile in bytes
+ * @param buf the output buffer
+ * @param size the size of the output buffer
+ *
+ * @returns the compressed size, 0 on error
+ */
+
+static gsize hi_cube_deflate(const guint16 *tile, gsize len,
+			     guint8 *buf, gsize size)
+{
+	gsize rd;
+	gsize wr;
+
+	GConverter *conv;
+	GConverterResult res;
+
+	GError *error = NULL;
+
+
+	conv = G_CONVERTER(g_zlib_compressor_new(G_ZLIB_COMPRESSOR_FORMAT_ZLIB,
+						 9));
+
+	res = g_converter_convert(conv, tile, len, buf, size,
+				  G_CONVERTER_INPUT_AT_END, &rd, &wr, &error);
+
+	g_object_unref(conv);
+
+	if (error) {
+		g_warning(MSG "could not deflate tile: %s", error->message);
+		g_clear_error(&error);
+		return 0;
+	}
+
+	if (res != G_CONVERTER_FINISHED)
+		return 0;
+
+	return wr;
+}
+
+
+/**
+ * @brief copy a tile out of a strip of the flat source cube
+ *
+ * @param h the cube header
+ * @param strip the current longitude strip of the source
+ * @param tx the longitude index of the tile
+ * @param ty the latitude index of the tile
+ * @param tv the velocity chunk index of the tile
+ * @param[out] tile the tile buffer, zero-padded at the edges of the cube
+ */
+
+static void hi_cube_fill_tile(const struct hi_cube_hdr *h,
+			      const guint16 *strip,
+			      guint tx, guint ty, guint tv, guint16 *tile)
+{
+	guint i, j, k;
+	guint lat, vel;
+
+
+	memset(tile, 0, (gsize) h->tlon * h->tlat * h->tvel * sizeof(guint16));
+
+	for (i = 0; i < h->tlon; i++) {
+
+		if (tx * h->tlon + i >= h->nlon)
+			break;
+
+		for (j = 0; j < h->tlat; j++) {
+
+			lat = ty * h->tlat + j;
+			if (lat >= h->nlat)
+				break;
+
+			for (k = 0; k < h->tvel; k++) {
+
+				vel = tv * h->tvel + k;
+				if (vel >= h->nvel)
+					break;
+
+				tile[((gsize) i * h->tlat + j) * h->tvel + k] =
+				    strip[((gsize) i * h->nlat + lat) * h->nvel + vel];
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief write a tiled HI cube
+ *
+ * @param path the path of the output file
+ * @param hdr the cube header, magic and byte order mark are set for you
+ * @param read_strip a function which reads the next n samples of the
+ *	  flat source cube (ordered like sky_vel.dat, i.e. velocity fastest,
+ *	  then latitude, then longitude) and returns the number of samples
+ *	  read
+ * @param data user data passed to read_strip
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note the source is read one strip of tiles in longitude at a time, so
+ *	 the memory needed does not depend on the size of the survey
+ */
+
+gint hi_cube_write(const gchar *path, const struct hi_cube_hdr *hdr,
+		   gsize (*read_strip)(guint16 *buf, gsize n, gpointer data),
+		   gpointer data)
+{
+	gint ret = -1;
+
+	guint tx, ty, tv;
+	guint ntlon, ntlat, ntvel;
+
+	gsize n;
+	gsize id;
+	gsize clen;
+	gsize tile_len;
+	gsize strip_len;
+	gsize ntiles;
+
+	guint64 offset;
+
+	guint16 *strip = NULL;
+	guint16 *tile  = NULL;
+	guint8  *cbuf  = NULL;
+
+	FILE *f;
+
+	struct hi_cube_hdr h;
+	struct hi_cube_idx *idx;
+
+
+	h = (*hdr);
+	memcpy(h.magic, HI_CUBE_MAGIC, sizeof(h.magic));
+	h.bom = HI_CUBE_BOM;
+
+	if (!h.nlon || !h.nlat || !h.nvel || !h.tlon || !h.tlat || !h.tvel)
+		return -1;
+
+	ntlon = (h.nlon + h.tlon - 1) / h.tlon;
+	ntlat = (h.nlat + h.tlat - 1) / h.tlat;
+	ntvel = (h.nvel + h.tvel - 1) / h.tvel;
+
+	ntiles    = (gsize) ntlon * ntlat * ntvel;
+	tile_len  = (gsize) h.tlon * h.tlat * h.tvel;
+	strip_len = (gsize) h.tlon * h.nlat * h.nvel;
+
+	f = fopen(path, "wb");
+	if (!f)
+		return -1;
+
+	idx   = g_malloc0(ntiles * sizeof(struct hi_cube_idx));
+	strip = g_malloc(strip_len * sizeof(guint16));
+	tile  = g_malloc(tile_len * sizeof(guint16));
+
+	/* zlib's worst case is well below that */
+	clen = tile_len * sizeof(guint16);
+	clen = clen + clen / 8 + 64;
+	cbuf = g_malloc(clen);
+
+	/* the index is written again at the end */
+	if (fwrite(&h, sizeof(h), 1, f) != 1)
+		goto cleanup;
+
+	if (fwrite(idx, sizeof(struct hi_cube_idx), ntiles, f) != ntiles)
+		goto cleanup;
+
+	offset = sizeof(h) + ntiles * sizeof(struct hi_cube_idx);
+
+	for (tx = 0; tx < ntlon; tx++) {
+
+		n = (gsize) MIN(h.tlon, h.nlon - tx * h.tlon) * h.nlat * h.nvel;
+
+		if (read_strip(strip, n, data) != n) {
+			g_warning(MSG "short read in longitude strip %u", tx);
+			goto cleanup;
+		}
+
+		for (ty = 0; ty < ntlat; ty++) {
+			for (tv = 0; tv < ntvel; tv++) {
+
+				hi_cube_fill_tile(&h, strip, tx, ty, tv, tile);
+
+				n = hi_cube_deflate(tile, tile_len * sizeof(guint16),
+						    cbuf, clen);
+				if (!n)
+					goto cleanup;
+
+				if (fwrite(cbuf, 1, n, f) != n)
+					goto cleanup;
+
+				id = ((gsize) tx * ntlat + ty) * ntvel + tv;
+
+				idx[id].offset = offset;
+				idx[id].len    = (guint32) n;
+
+				offset += n;
+			}
+		}
+	}
+
+	if (fseek(f, sizeof(h), SEEK_SET))
+		goto cleanup;
+
+	if (fwrite(idx, sizeof(struct hi_cube_idx), ntiles, f) != ntiles)
+		goto cleanup;
+
+	ret = 0;
+
+cleanup:
+	if (fclose(f))
+		ret = -1;
+
+	g_free(idx);
+	g_free(strip);
+	g_free(tile);
+	g_free(cbuf);
+
+	return ret;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file    server/backends/SIM/hi_cube.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief a tiled, compressed HI survey data cube
+ *
+ */
+
+#ifndef _HI_CUBE_H_
+#define _HI_CUBE_H_
+
+#include <glib.h>
+
+
+#define HI_CUBE_MAGIC	"RTHICUB1"
+#define HI_CUBE_BOM	0x01020304
+
+
+/**
+ * @brief the file header of a tiled HI cube
+ *
+ * @note the file is made of the header, followed by an index of
+ *	 struct hi_cube_idx for all tiles and the zlib-compressed tiles;
+ *	 tiles are numbered with the velocity chunk running fastest, then
+ *	 latitude, then longitude; within a tile, the raw 16 bit samples are
+ *	 ordered the same way, so a spectrum is contiguous, just like in the
+ *	 flat sky_vel.dat; edge tiles are zero-padded to full size
+ *
+ * @note all values are in host byte order, bom marks the byte order of the
+ *	 host that wrote the file
+ */
+
+struct hi_cube_hdr {
+	gchar   magic[8];	/* HI_CUBE_MAGIC, not terminated */
+	guint32 bom;		/* HI_CUBE_BOM */
+
+	guint32 nlon;		/* grid size in longitude */
+	guint32 nlat;		/* grid size in latitude */
+	guint32 nvel;		/* number of velocity bins */
+
+	guint32 tlon;		/* tile size in longitude */
+	guint32 tlat;		/* tile size in latitude */
+	guint32 tvel;		/* tile size in velocity */
+
+	guint32 pad;
+
+	gdouble lon0;		/* longitude of the first grid column */
+	gdouble lat0;		/* latitude of the first grid row */
+	gdouble res;		/* spatial grid resolution in degrees */
+
+	gdouble vel0;		/* velocity of the first bin in km/s */
+	gdouble vres;		/* velocity resolution in km/s */
+};
+
+/**
+ * @brief a tile index entry
+ */
+
+struct hi_cube_idx {
+	guint64 offset;		/* offset of the compressed tile in the file */
+	guint32 len;		/* length of the compressed tile */
+	guint32 pad;
+};
+
+
+struct hi_cube;
+
+
+struct hi_cube *hi_cube_open(const gchar *path, gsize cache_tiles);
+void hi_cube_close(struct hi_cube *c);
+
+const struct hi_cube_hdr *hi_cube_get_hdr(struct hi_cube *c);
+
+gint hi_cube_get_spec(struct hi_cube *c, gdouble glat, gdouble glon,
+		      guint16 *spec);
+
+gint hi_cube_write(const gchar *path, const struct hi_cube_hdr *hdr,
+		   gsize (*read_strip)(guint16 *buf, gsize n, gpointer data),
+		   gpointer data);
+
+
+#endif /* _HI_CUBE_H_ */
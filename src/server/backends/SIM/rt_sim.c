@@ -1,5 +1,5 @@
 /**
- * @file    server/backends/RTsim/rt_sim.c
+ * @file    server/backends/SIM/rt_sim.c
  * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
  *
  * @copyright GPLv2
@@ -26,6 +26,7 @@
 #include <string.h>
 #include <coordinates.h>
 #include <fourier_transform.h>
+#include <prng.h>
 
 #include <pkt_proc.h>
 
@@ -35,8 +36,11 @@
 #include <ack.h>
 
 #include <cfg.h>
+#include <pos_pub.h>
+#include <cfg_snap.h>
 
-#include <gtk/gtk.h>
+#include "rt_sim.h"
+#include "hi_cube.h"
 
 
 #define MSG "RT SIM: "
@@ -58,17 +62,6 @@
 #define DOPPLER_VEL(freq, ref)     (((freq) / (ref) - 1.0)* 299790.0)
 
 
-/**
- * default limits by velocity and rest frequency reference
- */
-
-#define SIM_V_REF_MHZ	1420.406
-#define SIM_V_RED_KMS	 400.0
-#define SIM_V_BLU_KMS	-400.0
-#define SIM_V_RES_KMS	   1.0
-#define SIM_HI_BINS	 801
-#define SIM_HI_AMP_CAL	  10.0	/* conversion from cK to mK */
-
 #define SIM_V_REF_HZ	(SIM_V_REF_MHZ * 1e6)
 
 
@@ -94,29 +87,16 @@
 #define SIM_SUN_SFU		48.	/* Sun @1415 as of Jun 11 2019 12 UTC */
 #define SIM_HOT_LOAD_TEMP	290.	/* default hot load temperature */
 #define SIM_NOISE_FIG		0.1	/* default amplifier noise figure */
+#define SIM_SEED		0	/* default noise seed (0: random) */
 
+#define SIM_BENCH_REPORT_SEC	5.0	/* throughput report interval */
+#define SIM_CLOCK_HEARTBEAT_SEC	60	/* free-running clock push interval */
 
-#define SKY_GAUSS_INTG_STP	0.10	/* integration step for gaussian */
-#define SKY_BASE_RES		0.5	/* resolution of the underlying data */
-
-/* +2 and +1 extra for 0/360 lon and 0 deg lat */
-#define SKY_WIDTH		((gint) ceil(360.0 / SKY_BASE_RES) + 2)
-#define SKY_HEIGHT		((gint) ceil(180.0 / SKY_BASE_RES) + 1)
-
-#define SKY_SIG_TO_KELVIN	10.0	/* data to Kelvin conversion */
-
-/* waterfall colours */
-#define RTSIM_R_LO		0
-#define RTSIM_G_LO		0
-#define RTSIM_B_LO		0
-
-#define RTSIM_R_MID		255
-#define RTSIM_G_MID		0
-#define RTSIM_B_MID		0
-
-#define RTSIM_R_HI		255
-#define RTSIM_G_HI		255
-#define RTSIM_B_H		0
+#define SIM_HI_SURVEY		"sky_vel.dat"	/* HI survey data file */
+#define SIM_HI_CUBE		"sky_vel.hic"	/* tiled HI survey data cube */
+#define SIM_HI_CACHE_TILES	256	/* default HI cube tile cache size */
+#define SIM_HI_ID_BLOCKS	64	/* blocks sampled for the survey id */
+#define SIM_HI_ID_BLOCK_SIZE	4096	/* size of a sampled block */
 
 
 
@@ -162,26 +142,25 @@ static struct {
 	gdouble noise_fig;			/* noise figure of the amplifier chain */
 	gdouble sig_rms;			/* theoretical rms noise  */
 
-	struct {
-		GdkPixbuf	*pb_sky;
-		GtkDrawingArea	*da_sky;
-
-		GtkScale	*s_lo;		/* lo colour thresh slider */
-		GtkScale	*s_hi;		/* hi colour thresh slider */
-		GtkScale	*s_min;		/* min cutoff slider */
-
-		GtkSpinButton	*sb_vmin;
-		GtkSpinButton	*sb_vmax;
+	guint64 seed;				/* noise generator seed */
+	gint hi_cache_tiles;			/* HI cube tile cache size */
 
-		GtkSpinButton	*sb_beam;
-
-		gdouble		th_lo;		/* lo colour threshold */
-		gdouble		th_hi;		/* hi colour threshold */
-		gdouble		min;		/* min cutoff */
+	struct {
+		gboolean ena;			/* real-time decoupled mode */
+		gdouble rate;			/* target rate in Hz (0: max) */
+		gint bins;			/* spectral bins (0: native) */
+	} bench;
 
-		enum {LIN, LOG, EXP, SQRT, SQUARE, ASINH, SINH} scale;
+	struct {
+		gboolean ena;			/* simulated clock in use */
+		gdouble accel;			/* rate relative to real time */
+		gdouble step;			/* seconds per readout (0: off) */
+		gint64 start;			/* start epoch (0: now) */
 
-	} gui;
+		gint64 epoch;			/* sim. time at ref (usec) */
+		gint64 ref;			/* monotonic reference (usec) */
+		GMutex lock;
+	} clk;
 
 } sim = {
 	.az.left  =   0.0,
@@ -205,6 +184,9 @@ static struct {
 	.hot_load_temp		= SIM_HOT_LOAD_TEMP,
 	.hot_load_ena		= FALSE,
 	.noise_fig		= SIM_NOISE_FIG,
+	.seed			= SIM_SEED,
+	.hi_cache_tiles		= SIM_HI_CACHE_TILES,
+	.clk.accel		= 1.0,
 
 };
 
@@ -221,9 +203,26 @@ static GThread *thread;
 static GCond	acq_cond;
 static GMutex   acq_lock;
 static GMutex   acq_pause;
-static GRWLock  obs_rwlock;
 
-static struct observation g_obs;
+/* the current observation, see sim_acquisition_update() */
+static struct cfg_snap *obs_snap;
+
+/* per-thread noise generators */
+static GPrivate prng_key = G_PRIVATE_INIT(g_free);
+static gint     prng_streams;
+
+/* the HI survey data cube, mapped read-only */
+static GMappedFile *hi_survey;
+
+/* alternatively, the tiled HI cube and its grid resolution */
+static struct hi_cube *hi_cube;
+static gdouble hi_res = SKY_BASE_RES;
+
+/* fingerprint of whichever survey file is in use */
+static gchar *hi_survey_id;
+
+/* drive position publisher */
+static struct pos_pub *sim_drive_pub;
 
 
 /**
@@ -303,6 +302,60 @@ static void sim_load_keys(GKeyFile *kf)
 	if (error)
 		g_error(error->message);
 
+	/* optional */
+	if (g_key_file_has_key(kf, "OTHER", "seed", NULL)) {
+		sim.seed = g_key_file_get_uint64(kf, "OTHER", "seed", &error);
+		if (error)
+			g_error(error->message);
+	}
+
+	/* optional */
+	if (g_key_file_has_key(kf, "OTHER", "hi_cache_tiles", NULL)) {
+		sim.hi_cache_tiles = g_key_file_get_integer(kf, "OTHER",
+							    "hi_cache_tiles",
+							    &error);
+		if (error)
+			g_error(error->message);
+	}
+
+	/* optional */
+	if (g_key_file_has_group(kf, "BENCH")) {
+
+		sim.bench.ena = g_key_file_get_boolean(kf, "BENCH", "enable",
+						       &error);
+		if (error)
+			g_error(error->message);
+
+		sim.bench.rate = g_key_file_get_double(kf, "BENCH", "rate",
+						       &error);
+		if (error)
+			g_error(error->message);
+
+		sim.bench.bins = g_key_file_get_integer(kf, "BENCH", "bins",
+							&error);
+		if (error)
+			g_error(error->message);
+	}
+
+	/* optional */
+	if (g_key_file_has_group(kf, "CLOCK")) {
+
+		sim.clk.accel = g_key_file_get_double(kf, "CLOCK", "accel",
+						      &error);
+		if (error)
+			g_error(error->message);
+
+		sim.clk.step = g_key_file_get_double(kf, "CLOCK", "step",
+						     &error);
+		if (error)
+			g_error(error->message);
+
+		sim.clk.start = g_key_file_get_int64(kf, "CLOCK", "start",
+						     &error);
+		if (error)
+			g_error(error->message);
+	}
+
 }
 
 /**
@@ -399,318 +452,320 @@ int sim_load_config(void)
 }
 
 
-
 /**
- * @brief check if coordinates are within limits
- *
- * @returns -1 on error, 0 otherwise
+ * @brief get a reference to a run-time adjustable parameter
  */
 
-static int sim_drive_check_limits(double az, double el)
+static gdouble *sim_param_ref(enum sim_param p)
 {
-	return 0; /** XXX **/
-	g_message(MSG "check if AZ/EL %g/%g is within limits", az, el);
-
-	if (az > sim.az.right) {
-		g_warning(MSG "error, az %g > %g", az, sim.az.right);
-		return -1;
-	}
-
-	if (az < sim.az.left) {
-		g_warning(MSG "error, az %g < %g", az, sim.az.left);
-		return -1;
-	}
-
-	if (el < sim.el.lower) {
-		g_warning(MSG "error, el %g < %g", el, sim.el.lower);
-		return -1;
+	switch (p) {
+	case SIM_PAR_R_BEAM:
+		return &sim.r_beam;
+	case SIM_PAR_TSYS:
+		return &sim.tsys;
+	case SIM_PAR_EFF:
+		return &sim.eff;
+	case SIM_PAR_SIG_N:
+		return &sim.sig_n;
+	case SIM_PAR_READOUT_HZ:
+		return &sim.readout_hz;
+	case SIM_PAR_SUN_SFU:
+		return &sim.sun_sfu;
+	case SIM_PAR_HOT_LOAD_TEMP:
+		return &sim.hot_load_temp;
+	case SIM_PAR_NOISE_FIG:
+		return &sim.noise_fig;
+	default:
+		break;
 	}
 
-	if (el > sim.el.upper) {
-		g_warning(MSG "error, el %g < %g", el, sim.el.upper);
-		return -1;
-	}
+	g_warning(MSG "unknown parameter %d", p);
 
-	return 0;
+	return NULL;
 }
 
 
 /**
- * @brief set pointing
- *
- * @returns -1 on error, 0 otherwise
+ * @brief get the current value of a simulation parameter
  */
 
-static int sim_drive_moveto(double az, double el)
+gdouble sim_get_param(enum sim_param p)
 {
-	struct getpos pos;
-
-
-	ack_moveto_azel(PKT_TRANS_ID_UNDEF, az, el);
-
-	if (sim_drive_check_limits(az, el))
-		return -1;
-
-	g_debug(MSG "rotating to AZ/EL %g/%g", az, el);
-
-	sim.az.cur = az;
-	sim.el.cur = el;
+	gdouble *ref;
 
-	/* emit notification */
-	pos.az_arcsec = (typeof(pos.az_arcsec)) (3600.0 * sim.az.cur);
-	pos.el_arcsec = (typeof(pos.el_arcsec)) (3600.0 * sim.el.cur);
-	ack_getpos_azel(PKT_TRANS_ID_UNDEF, &pos);
 
+	ref = sim_param_ref(p);
+	if (!ref)
+		return 0.0;
 
-	return 0;
+	return (*ref);
 }
 
 
 /**
- * @brief get an rgb colour mapping for a value
+ * @brief set a simulation parameter
  *
- * @note the is scheme is stolen from somewhere, but I don't remember... d'oh!
+ * @note the change applies with the next spectrum readout
  */
 
-static void sim_get_rgb(gdouble val, gdouble thr_lo, gdouble thr_hi,
-				  guchar *r, guchar *g, guchar *b)
+void sim_set_param(enum sim_param p, gdouble val)
 {
-	gdouble R, G, B;
-
-	gdouble f;
-
+	gdouble *ref;
 
-	if (val < thr_lo) {
-		(*r) = RTSIM_R_LO;
-		(*g) = RTSIM_G_LO;
-		(*b) = RTSIM_G_LO;
-		return;
-	}
 
-	if (val > thr_hi) {
-		(*r) = RTSIM_R_HI;
-		(*g) = RTSIM_G_HI;
-		(*b) = RTSIM_G_HI;
+	ref = sim_param_ref(p);
+	if (!ref)
 		return;
-	}
 
-	f = (val - thr_lo) / (thr_hi - thr_lo);
+	(*ref) = val;
+}
 
-	if (f < 2.0/9.0) {
 
-		f = f / (2.0 / 9.0);
+/**
+ * @brief apply the benchmark mode configuration
+ *
+ * @note if a number of bins is configured, the spectral resolution is
+ *	 adjusted to fit as many bins into the IF bandwidth, up to the maximum
+ *	 a single PR_SPEC_DATA packet can hold; the frequency increment is
+ *	 transferred in integer Hz, so it is limited to 1 Hz
+ */
 
-		R = (1.0 - f) * (gdouble) RTSIM_R_LO;
-		G = (1.0 - f) * (gdouble) RTSIM_G_LO;
-		B = RTSIM_B_LO + f * (gdouble) (255 - RTSIM_B_LO);
+static void sim_bench_setup(void)
+{
+	gsize max;
+	gsize bins;
 
+	gdouble inc;
 
-	} else if (f < (3.0 / 9.0)) {
 
-		f = (f - 2.0 / 9.0 ) / (1.0 / 9.0);
+	if (!sim.bench.ena)
+		return;
 
-		R = 0.0;
-		G = 255.0 * f;
-		B = 255.0;
+	g_message(MSG "benchmark mode enabled, rate: %g Hz (0: unlimited)",
+		  sim.bench.rate);
 
-	} else if (f < (4.0 / 9.0) ) {
+	if (sim.bench.bins <= 1)
+		return;
 
-		f = (f - 3.0 / 9.0) / (1.0 / 9.0);
+	bins = (gsize) sim.bench.bins;
 
-		R = 0.0;
-		G = 255.0;
-		B = 255.0 * (1.0 - f);
+	max = (MAX_PAYLOAD_SIZE - sizeof(struct spec_data)) / sizeof(uint32_t);
+	if (bins > max) {
+		g_warning(MSG "%" G_GSIZE_FORMAT " bins exceed maximum payload "
+			  "size, limiting to %" G_GSIZE_FORMAT, bins, max);
+		bins = max;
+	}
 
-	} else if (f < (5.0 / 9.0)) {
+	inc = floor(sim.radio.freq_if_bw / (gdouble) (bins - 1));
+	if (inc < 1.0)
+		inc = 1.0;
 
-		f = (f - 4.0 / 9.0 ) / (1.0 / 9.0);
+	sim.radio.freq_inc_hz = inc;
+	sim.radio.max_bins    = (int) (sim.radio.freq_if_bw / inc) + 1;
 
-		R = 255.0 * f;
-		G = 255.0;
-		B = 0.0;
+	g_message(MSG "benchmark mode: %d bins at %g Hz resolution",
+		  sim.radio.max_bins, sim.radio.freq_inc_hz);
+}
 
-	} else if ( f < (7.0 / 9.0)) {
 
-		f = (f - 5.0 / 9.0 ) / (2.0 / 9.0);
 
-		R = 255.0;
-		G = 255.0 * (1.0 - f);
-		B = 0.0;
+/**
+ * @brief get the simulated time
+ *
+ * @returns the simulated time since the unix epoch in microseconds
+ */
 
-	} else if( f < (8.0 / 9.0)) {
+static gint64 sim_clock_usec(void)
+{
+	gint64 t;
 
-		f = (f - 7.0 / 9.0 ) / (1.0 / 9.0);
 
-		R = 255.0;
-		G = 0.0;
-		B = 255.0 * f;
+	g_mutex_lock(&sim.clk.lock);
 
-	} else {
+	t = sim.clk.epoch;
 
-		f = (f - 8.0 / 9.0 ) / (1.0 / 9.0);
+	if (sim.clk.step <= 0.0)
+		t += (gint64) (sim.clk.accel * (gdouble) (g_get_monotonic_time()
+							  - sim.clk.ref));
 
-		R = 255.0 * (0.75 + 0.25 * (1.0 - f));
-		G = 0.5 * 255.0 * f;
-		B = 255.0;
-	}
+	g_mutex_unlock(&sim.clk.lock);
 
-	(*r) = (guchar) R;
-	(*g) = (guchar) G;
-	(*b) = (guchar) B;
+	return t;
 }
 
 
 /**
- * @brief append new data set to waterfall
+ * @brief the time source for the coordinate library
  */
 
-static void sim_render_sky(const gdouble *amp, gsize len)
+static time_t sim_clock_now(void)
 {
-
-	int i;
-	int rs, nc;
-
-	gdouble min = DBL_MAX;
-	gdouble max = DBL_MIN;
-
-	guchar *wf;
-	guchar *pix;
+	return (time_t) (sim_clock_usec() / G_USEC_PER_SEC);
+}
 
 
+/**
+ * @brief push the simulated clock state to the clients
+ */
 
-	GdkPixbuf *pb = sim.gui.pb_sky;
+static void sim_clock_push(void)
+{
+	struct sim_time t;
 
 
+	if (!sim.clk.ena)
+		return;
 
-	if (!pb) {
+	t.epoch_usec = sim_clock_usec();
 
+	if (sim.clk.step > 0.0)
+		t.rate_milli = 0;
+	else
+		t.rate_milli = (typeof(t.rate_milli)) (sim.clk.accel * 1000.0);
 
-		/* +2 + 1 extra for 0/360 and -90/90 duplicates */
-		pb = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, 722, 361);
+	ack_sim_time(PKT_TRANS_ID_UNDEF, &t);
+}
 
-		if (!pb) {
-			g_warning("Could not create pixbuf: out of memory");
-			return;
-		}
 
-		wf = gdk_pixbuf_get_pixels(pb);
+/**
+ * @brief push the state of a free-running clock now and then
+ *
+ * @note the clients extrapolate a free-running clock themselves, this only
+ *	 keeps them from drifting
+ */
 
-		gdk_pixbuf_fill(pb, 0x000000ff);
-		sim.gui.pb_sky = pb;
-	}
+static gboolean sim_clock_heartbeat_cb(gpointer data)
+{
+	sim_clock_push();
 
+	return G_SOURCE_CONTINUE;
+}
 
-	wf = gdk_pixbuf_get_pixels(pb);
 
-	rs = gdk_pixbuf_get_rowstride(pb);
+/**
+ * @brief advance the simulated clock by one readout step
+ *
+ * @note this only has an effect if the clock is configured in stepped mode,
+ *	 where the clients can't extrapolate and are updated on every step
+ */
 
-	nc = gdk_pixbuf_get_n_channels(pb);
+static void sim_clock_step(void)
+{
+	if (!sim.clk.ena)
+		return;
 
+	if (sim.clk.step <= 0.0)
+		return;
 
+	g_mutex_lock(&sim.clk.lock);
+	sim.clk.epoch += (gint64) (sim.clk.step * (gdouble) G_USEC_PER_SEC);
+	g_mutex_unlock(&sim.clk.lock);
 
-	for (i = 0; i < len; i++) {
-		if (amp[i] < min)
-			min = amp[i];
+	sim_clock_push();
+}
 
-		if (amp[i] > max)
-			max = amp[i];
-	}
 
-	if (!isnormal(min))
-		min = 0.;
-	if (!isnormal(max))
-		max = 1.;
+/**
+ * @brief set up the simulated clock
+ *
+ * @note if the clock runs at real time from now, the system clock is used
+ */
 
-	if (min > max) {
-		double tmp = max;
+static void sim_clock_setup(void)
+{
+	if ((sim.clk.accel == 1.0) && (sim.clk.step <= 0.0) && !sim.clk.start)
+		return;
 
-		max = min;
-		min = tmp;
+	if (sim.clk.accel < 0.0) {
+		g_warning(MSG "negative clock acceleration %g, setting to 1",
+			  sim.clk.accel);
+		sim.clk.accel = 1.0;
 	}
 
+	sim.clk.ref   = g_get_monotonic_time();
+	sim.clk.epoch = g_get_real_time();
 
+	if (sim.clk.start)
+		sim.clk.epoch = sim.clk.start * G_USEC_PER_SEC;
 
+	sim.clk.ena = TRUE;
 
+	coord_set_time_source(sim_clock_now);
 
-	gtk_range_set_range(GTK_RANGE(sim.gui.s_min), min, max);
-
-	pix = wf;
-#if 0
-	/* set image */
-	for (i = 0; i < 722; i++) {
-#if 0
-		/* first min = regulator min from scale */
-		sim_get_rgb((amp[i] - min) / (max - min),
-				   0.01, 0.99,
-				   &pix[0], &pix[1], &pix[2]);
-		pix += nc;
-#endif
-
-		pix[0] = 0;
-		pix[1] = 255;
-		pix += nc;
-
-//		if (i > 1 && i
-
+	if (sim.clk.step > 0.0) {
+		g_message(MSG "simulated clock advances %g s per readout",
+			  sim.clk.step);
+		return;
 	}
-#endif
 
-	gdouble lat, lon;
-	for (lat = -90.0; lat <= 90.0; lat += 0.5) {
-		for (lon = -180.; lon <= 180.; lon += 0.5) {
-		double val;
+	g_message(MSG "simulated clock runs at %gx real time", sim.clk.accel);
 
-		double sig = 0.0;
-		int x = (int) (2.0 * (lat + 90.));
-		int y = (int) (2.0 * (lon + 180.));
+	g_timeout_add_seconds(SIM_CLOCK_HEARTBEAT_SEC, sim_clock_heartbeat_cb,
+			      NULL);
+}
 
-		//g_message("x %d y %d", x, y);
-		pix = wf + x * rs + y * nc;
 
-		sig = amp[x * 722 + y];
+/**
+ * @brief check if coordinates are within limits
+ *
+ * @returns -1 on error, 0 otherwise
+ */
 
-		val = (sig  - sim.gui.min) / (max - min);
+static int sim_drive_check_limits(double az, double el)
+{
+	return 0; /** XXX **/
+	g_message(MSG "check if AZ/EL %g/%g is within limits", az, el);
 
-		sim_get_rgb(val,
-			    sim.gui.th_lo, sim.gui.th_hi,
-			    &pix[0], &pix[1], &pix[2]);
+	if (az > sim.az.right) {
+		g_warning(MSG "error, az %g > %g", az, sim.az.right);
+		return -1;
+	}
 
+	if (az < sim.az.left) {
+		g_warning(MSG "error, az %g < %g", az, sim.az.left);
+		return -1;
 	}
+
+	if (el < sim.el.lower) {
+		g_warning(MSG "error, el %g < %g", el, sim.el.lower);
+		return -1;
 	}
 
+	if (el > sim.el.upper) {
+		g_warning(MSG "error, el %g < %g", el, sim.el.upper);
+		return -1;
+	}
 
-	gtk_widget_queue_draw(GTK_WIDGET(sim.gui.da_sky));
+	return 0;
 }
 
 
+/**
+ * @brief set pointing
+ *
+ * @returns -1 on error, 0 otherwise
+ */
 
-
-
-
-static gboolean sim_sky_draw(GtkWidget *w, cairo_t *cr, gpointer data)
+static int sim_drive_moveto(double az, double el)
 {
+	ack_moveto_azel(PKT_TRANS_ID_UNDEF, az, el);
 
-	GdkPixbuf *pbuf = NULL;
-
-	GtkAllocation allocation;
+	if (sim_drive_check_limits(az, el))
+		return -1;
 
-	if (!sim.gui.pb_sky)
-		return FALSE;
+	g_debug(MSG "rotating to AZ/EL %g/%g", az, el);
 
+	sim.az.cur = az;
+	sim.el.cur = el;
 
-	gtk_widget_get_allocation(w, &allocation);
+	/* emit notification, the move is complete at once */
+	pos_pub_arrived(sim_drive_pub, sim.az.cur, sim.el.cur);
 
-	pbuf = gdk_pixbuf_scale_simple(sim.gui.pb_sky,
-				       allocation.width, allocation.height - 2,
-				       GDK_INTERP_NEAREST);
 
-	gdk_cairo_set_source_pixbuf(cr, pbuf, 0, 0);
-	cairo_paint(cr);
+	return 0;
+}
 
-	g_object_unref(pbuf);
 
-	return FALSE;
-}
 
 
 
@@ -773,123 +828,295 @@ static int get_offset(double glat, double glon)
 	return VEL * ((int) ((180. + 181.0) * 2. * glon) + (int) (2.0 * (glat + 90.0)));
 }
 
-static gpointer sim_spec_extract_HI_survey(gdouble glat, gdouble glon)
-{
-	static guint16 *map;
-
-	guint16 *as;
-
-	int offset;
-
-
+/**
+ * @brief compute a fingerprint of a HI survey data file
+ *
+ * @returns an allocated hex string or NULL on error
+ *
+ * @note hashing the whole survey would take about as long as the work the
+ *	 fingerprint is meant to save, so only the size and a number of
+ *	 evenly spaced blocks are hashed; this is good enough to tell apart
+ *	 different builds of the survey
+ */
 
-	if (!map) {
+static gchar *sim_HI_survey_fingerprint(const gchar *path)
+{
+	gsize i;
+	gsize n;
+	gsize len;
+	gsize off;
 
-		/* efficiency is for dopes...nahh, we'll fix this soon, just stupidly testing */
-#if 0
-		FILE *data = fopen("/home/armin/Work/radtelsim/vel_short_int.dat", "rb");
-#else
-		FILE *data = fopen("sky_vel.dat", "rb");
-#endif
-		if (!data)
-			data = fopen("../data/sky_vel.dat", "rb");
+	gchar *id;
+	const guchar *buf;
 
-		if (!data) {
-				GtkWidget *dia;
+	GChecksum *cs;
+	GMappedFile *mf;
 
-				dia = gtk_message_dialog_new(NULL,
-							     GTK_DIALOG_MODAL,
-							     GTK_MESSAGE_ERROR,
-							     GTK_BUTTONS_CLOSE,
-							     "Please place sky_vel.dat in the "
-							     "directory path this program is executed in.");
 
-				gtk_dialog_run(GTK_DIALOG(dia));
-				gtk_widget_destroy(dia);
+	mf = g_mapped_file_new(path, FALSE, NULL);
+	if (!mf)
+		return NULL;
 
+	len = g_mapped_file_get_length(mf);
+	buf = (const guchar *) g_mapped_file_get_contents(mf);
 
-			exit(0);
-			/** XXX **/
-			g_error("%s: error opening file", __func__);
-			return 0;
-		}
+	cs = g_checksum_new(G_CHECKSUM_SHA1);
 
+	g_checksum_update(cs, (const guchar *) &len, sizeof(len));
 
+	for (i = 0; i <= SIM_HI_ID_BLOCKS; i++) {
 
+		/* the last block is the tail of the file */
+		off = (len / SIM_HI_ID_BLOCKS) * i;
+		off = MIN(off, len - MIN(len, SIM_HI_ID_BLOCK_SIZE));
 
-		map = g_malloc(VEL * SKY_WIDTH * SKY_HEIGHT * sizeof(guint16));
+		n = MIN(SIM_HI_ID_BLOCK_SIZE, len - off);
 
-		fread(map, sizeof(guint16), VEL * SKY_WIDTH * SKY_HEIGHT, data);
-		fclose(data);
+		g_checksum_update(cs, &buf[off], n);
 	}
 
-	as = g_malloc(VEL * sizeof(guint16));
-	offset = get_offset(glat, glon);
+	id = g_strdup(g_checksum_get_string(cs));
 
-	memcpy(as, &map[offset], sizeof(guint16) * VEL);
+	g_checksum_free(cs);
+	g_mapped_file_unref(mf);
 
-	return as;
+	return id;
 }
 
 
 /**
- * @brief order two frequencies so f0 < f1
+ * @brief open the tiled HI survey data cube
  *
- * @param f0 the first frequency
- * @param f1 the second frequency
+ * @returns TRUE if a usable cube was found
+ *
+ * @note the cube is preferred over the flat file, as it may hold a finer
+ *	 grid and only the tiles around the current pointing are kept in
+ *	 memory
  */
 
-static void sim_order_freq(gdouble *f0, gdouble *f1)
+static gboolean sim_HI_cube_load(void)
 {
-	double tmp;
+	gsize i;
 
-	if (!f0)
-		return;
+	const struct hi_cube_hdr *h;
 
-	if (!f1)
-		return;
+	const gchar *path[] = {SIM_HI_CUBE, "../data/" SIM_HI_CUBE};
 
-	if ((*f0) < (*f1))
-		return;
 
-	tmp   = (*f1);
-	(*f1) = (*f0);
-	(*f0) = tmp;
-}
+	for (i = 0; i < G_N_ELEMENTS(path); i++) {
 
+		if (!g_file_test(path[i], G_FILE_TEST_EXISTS))
+			continue;
 
-/**
- * @brief clamp a frequency to the simulator settings
- *
- * @param f the frequency in Hz to clamp into range
- *
- * @returns the clamped frequency in Hz
- */
+		hi_cube = hi_cube_open(path[i], MAX(sim.hi_cache_tiles, 1));
+		if (hi_cube)
+			break;
+	}
 
-static gdouble sim_clamp_freq_range(gdouble f)
-{
-	if (f < sim.radio.freq_min_hz)
-		return sim.radio.freq_min_hz;
+	if (!hi_cube)
+		return FALSE;
 
-	if (f > sim.radio.freq_max_hz)
-		return sim.radio.freq_max_hz;
+	h = hi_cube_get_hdr(hi_cube);
 
-	return f;
+	if (h->nvel != VEL) {
+		g_warning(MSG "%s has %u velocity bins, need %d, ignoring",
+			  path[i], h->nvel, VEL);
+		hi_cube_close(hi_cube);
+		hi_cube = NULL;
+		return FALSE;
+	}
+
+	hi_res = h->res;
+
+	hi_survey_id = sim_HI_survey_fingerprint(path[i]);
+
+	g_message(MSG "HI survey cube opened from %s, resolution %g deg",
+		  path[i], hi_res);
+
+	return TRUE;
 }
 
 
 /**
- * @brief round off a frequency to the simulator spectral resolution setting
+ * @brief map the HI survey data file
  *
- * @param f the frequency in Hz to round off
- *
- * @returns the rounded off frequency in Hz
+ * @note the file is searched in the current working directory and in
+ *	 ../data; if it cannot be found, the simulator runs without the HI line
+ *	 instead of bailing out, so automated runs never block; since the data
+ *	 are mapped rather than read, they are only paged in as needed and
+ *	 shared between simulator instances on the same machine
  */
 
-static gdouble sim_round_freq_to_res(gdouble f)
+static void sim_HI_survey_load(void)
 {
-	return round(f / sim.radio.freq_inc_hz) * sim.radio.freq_inc_hz;
-}
+	gsize i;
+	gsize len;
+
+	GError *error = NULL;
+
+	const gchar *path[] = {SIM_HI_SURVEY, "../data/" SIM_HI_SURVEY};
+
+
+	if (hi_survey || hi_cube)
+		return;
+
+	if (sim_HI_cube_load())
+		return;
+
+	for (i = 0; i < G_N_ELEMENTS(path); i++) {
+
+		hi_survey = g_mapped_file_new(path[i], FALSE, &error);
+		if (hi_survey)
+			break;
+
+		g_clear_error(&error);
+	}
+
+	if (!hi_survey) {
+		g_warning(MSG "could not find %s or %s in ./ or ../data, the "
+			      "HI line will not be simulated",
+			      SIM_HI_CUBE, SIM_HI_SURVEY);
+		return;
+	}
+
+	/* the flat file holds only one column for 0/360 lon */
+	len = VEL * (SKY_WIDTH - 1) * SKY_HEIGHT * sizeof(guint16);
+
+	if (g_mapped_file_get_length(hi_survey) < len) {
+		g_warning(MSG "%s is truncated, the HI line will not be "
+			      "simulated", path[i]);
+		g_mapped_file_unref(hi_survey);
+		hi_survey = NULL;
+		return;
+	}
+
+	hi_survey_id = sim_HI_survey_fingerprint(path[i]);
+
+	g_message(MSG "HI survey mapped from %s", path[i]);
+}
+
+
+/**
+ * @brief check whether the HI survey data are available
+ */
+
+gboolean sim_HI_survey_loaded(void)
+{
+	return hi_survey || hi_cube;
+}
+
+
+/**
+ * @brief get the fingerprint of the HI survey data
+ *
+ * @returns the fingerprint or NULL if no survey is loaded
+ */
+
+const gchar *sim_HI_survey_id(void)
+{
+	return hi_survey_id;
+}
+
+
+/**
+ * @brief extract a HI spectrum from the survey
+ *
+ * @returns an allocated copy of the VEL raw velocity bins or NULL if the
+ *	    survey is not loaded
+ */
+
+static gpointer sim_spec_extract_HI_survey(gdouble glat, gdouble glon)
+{
+	const guint16 *map;
+
+	guint16 *as;
+
+	int offset;
+
+
+	if (hi_cube) {
+		as = g_malloc(VEL * sizeof(guint16));
+
+		if (hi_cube_get_spec(hi_cube, glat, glon, as)) {
+			g_free(as);
+			return NULL;
+		}
+
+		return as;
+	}
+
+	if (!hi_survey)
+		return NULL;
+
+	map = (const guint16 *) g_mapped_file_get_contents(hi_survey);
+
+	as = g_malloc(VEL * sizeof(guint16));
+	offset = get_offset(glat, glon);
+
+	memcpy(as, &map[offset], sizeof(guint16) * VEL);
+
+	return as;
+}
+
+
+/**
+ * @brief order two frequencies so f0 < f1
+ *
+ * @param f0 the first frequency
+ * @param f1 the second frequency
+ */
+
+static void sim_order_freq(gdouble *f0, gdouble *f1)
+{
+	double tmp;
+
+	if (!f0)
+		return;
+
+	if (!f1)
+		return;
+
+	if ((*f0) < (*f1))
+		return;
+
+	tmp   = (*f1);
+	(*f1) = (*f0);
+	(*f0) = tmp;
+}
+
+
+/**
+ * @brief clamp a frequency to the simulator settings
+ *
+ * @param f the frequency in Hz to clamp into range
+ *
+ * @returns the clamped frequency in Hz
+ */
+
+static gdouble sim_clamp_freq_range(gdouble f)
+{
+	if (f < sim.radio.freq_min_hz)
+		return sim.radio.freq_min_hz;
+
+	if (f > sim.radio.freq_max_hz)
+		return sim.radio.freq_max_hz;
+
+	return f;
+}
+
+
+/**
+ * @brief round off a frequency to the simulator spectral resolution setting
+ *
+ * @param f the frequency in Hz to round off
+ *
+ * @returns the rounded off frequency in Hz
+ */
+
+static gdouble sim_round_freq_to_res(gdouble f)
+{
+	return round(f / sim.radio.freq_inc_hz) * sim.radio.freq_inc_hz;
+}
 
 
 /**
@@ -1095,7 +1322,7 @@ static gdouble HI_fold_glat_round(gdouble lat)
 		lat = lat - 180.0;
 
 	/* map to HI data grid */
-	lat = round(( 1.0 / SKY_BASE_RES ) * lat) * SKY_BASE_RES;
+	lat = round(( 1.0 / hi_res ) * lat) * hi_res;
 
 
 	return lat;
@@ -1120,7 +1347,7 @@ static gdouble HI_fold_glon_round(gdouble lon)
 		lon = lon - 360.0;
 
 	/* map to HI data grid */
-	lon = round(( 1.0 / SKY_BASE_RES ) * lon) * SKY_BASE_RES;
+	lon = round(( 1.0 / hi_res ) * lon) * hi_res;
 
 
 	return lon;
@@ -1224,6 +1451,10 @@ static gdouble *HI_gen_conv_spec(struct coord_galactic gal,
 			lat = HI_fold_glat_round(gal.lat + y);
 
 			raw = sim_spec_extract_HI_survey(lat, lon);
+			if (!raw) {
+				g_free(spec);
+				return NULL;
+			}
 
 			for (i = r; i <= b; i++) {
 				amp = (gdouble) raw[SIM_HI_BINS - i - 1];
@@ -1311,6 +1542,9 @@ static void HI_stack_spec(struct spec_data *s,
 	gdouble *spec;
 
 
+	/* the survey is optional, we warned when it failed to load */
+	if (!sim_HI_survey_loaded())
+		return;
 
 	red  = HI_get_vel((gdouble) s->freq_min_hz, gal);
 	blue = HI_get_vel((gdouble) s->freq_max_hz, gal);
@@ -1337,18 +1571,28 @@ static void HI_stack_spec(struct spec_data *s,
 	i1 = HI_get_spec_idx(s, gal, f1);
 
 
-	for (i = i0; i <= i1; i++)
+	/* the spectral resolution may be finer than the HI data if
+	 * configured in benchmark mode, so we map the indices accordingly
+	 */
+	for (i = i0; i <= i1; i++) {
+
+		gsize j;
+
+		j = (gsize) round((gdouble) (i - i0) * sim.radio.freq_inc_hz
+				  / SIM_FREQ_STP_HZ);
+
+		if (j >= bins || i >= s->n)
+			break;
+
 		s->spec[i] = (typeof(*s->spec)) ((gdouble) s->spec[i] +
-						 spec[i - i0]);
+						 spec[j]);
+	}
 
 
 	g_free(spec);
 }
 
 
-static gdouble *gauss_2d(gdouble sigma, gdouble r, gdouble res, gint *n);
-
-
 /**
  * @brief stack the CMB for a give GLAT/GLON and a beam on a base spectrum
  *
@@ -1466,8 +1710,8 @@ static gdouble sim_sun(struct coord_galactic gal, gdouble freq,
 	sun = equatorial_to_galactic(sun_ra_dec(0.0));
 
 	/* force onto grid */
-	sun.lat = round(( 1.0 / SKY_BASE_RES ) * sun.lat) * SKY_BASE_RES;
-	sun.lon = round(( 1.0 / SKY_BASE_RES ) * sun.lon) * SKY_BASE_RES;
+	sun.lat = round(( 1.0 / hi_res ) * sun.lat) * hi_res;
+	sun.lon = round(( 1.0 / hi_res ) * sun.lon) * hi_res;
 
 	res = w / (gdouble) n;
 
@@ -1570,8 +1814,8 @@ static gdouble sim_moon(struct coord_galactic gal, const gdouble *beam,
 						  server_cfg_get_station_lon(),
 						  0.0));
 	/* force onto grid */
-	moon.lat = round(( 1.0 / SKY_BASE_RES ) * moon.lat) * SKY_BASE_RES;
-	moon.lon = round(( 1.0 / SKY_BASE_RES ) * moon.lon) * SKY_BASE_RES;
+	moon.lat = round(( 1.0 / hi_res ) * moon.lat) * hi_res;
+	moon.lon = round(( 1.0 / hi_res ) * moon.lon) * hi_res;
 
 	res = w / (gdouble) n;
 
@@ -1601,1247 +1845,409 @@ static gdouble sim_moon(struct coord_galactic gal, const gdouble *beam,
 
 	costheta = fmod(costheta - 180.0, 360.) / 180. * M_PI;
 
-	/* average the moon temperature across all degrees of latitude by
-	 * divding by pi
-	 */
-	E = 1366.0 * costheta / M_PI;
-
-	/* for emissivity ~ reflectance, we get the Moon's surface temperature
-	 * via the  Stefan-Boltzmann equation
-	 */
-	T = pow((E / 5.67e-8), 0.25);
-
-	/* scale to beam/moon ratio (apparent diameter ~0.5 deg) */
-
-	T = T * 0.25 * 0.25 / (sim.r_beam * sim.r_beam);
-
-	/* beam is normalised to integral 1, scale temperature to center bin */
-	T = T * beam[y * n + x] / beam[n/2 * n + n/2];
-
-	return T;
-}
-
-
-/**
- * @brief stack the moon for a given GLAT/GLON and a beam on a base spectrum
- *
- * @param s the target spec_data
- *
- * @param gal the galactic lat/lon
- * @param beam an nxn array which describes the shape of the beam
- * @param n the shape of the beam in data bins
- * @param w the width of the area in degrees (== width of the beam)
- *
- * @note this is a very simple moon model, where we assume that the
- *	 smallest beam is 0.5 deg, so we can use the beam itself as the
- *	 moon
- *
- * @warn this assumes that the beam's coordinate system's basis vector is in
- *	 the same rotation as the horizon coordinate system
- *
- */
-
-static void sim_stack_moon(struct spec_data *s, struct coord_galactic gal,
-			   const gdouble *beam, gint n, gdouble w)
-{
-	gsize i;
-
-	gdouble T;
-
-
-	T = sim_moon(gal, beam, n, w);
-
-	/* convert to mK */
-	T = 1000. * T;
-
-	for (i = 0; i < s->n; i++)
-		s->spec[i] = (typeof(*s->spec)) ((double) s->spec[i] + T);
-}
-
-
-/**
- * @brief stack system efficiency on a base spectrum
- *
- * @param s the target spec_data
- * @param eff a efficiency multiplier
- */
-
-static void sim_stack_eff(struct spec_data *s, gdouble eff)
-{
-	gsize i;
-
-
-	for (i = 0; i < s->n; i++)
-		s->spec[i] = (typeof(*s->spec)) ((gdouble) s->spec[i] * eff);
-}
-
-
-/**
- * @brief generate approximate gaussian noise
- *
- * @note we want something decently fast, this Box-Muller transform
- *	 appears to work quite well
- */
-
-static gdouble sim_rand_gauss(void)
-{
-	static gboolean gen;
-
-	static gdouble u, v;
-
-
-	gen = !gen;
-
-	if (!gen)
-		return sqrt(- 2.0 * log(u)) * cos(2.0 * M_PI * v);
-
-	u = (rand() + 1.0) / (RAND_MAX + 2.0);
-	v =  rand()        / (RAND_MAX + 1.0);
-
-	return sqrt(-2.0 * log(u)) * sin(2.0 * M_PI * v);
-}
-
-
-
-/**
- * @brief stack system noise on a base spectrum
- *
- * @param s the target spec_data
- * @param sig a sigma mutliplier for the noise
- *
- * @note the noise is scaled by the sqrt() of the signal amplitude
- */
-
-static void sim_stack_gnoise(struct spec_data *s, gdouble sig)
-{
-	gsize i;
-
-	gdouble amp;
-
-
-	for (i = 0; i < s->n; i++) {
-		amp = (gdouble) s->spec[i];
-		amp = amp + sqrt(amp) * sig * sim_rand_gauss();
-		s->spec[i] = (typeof(*s->spec)) amp;
-	}
-}
-
-
-/**
- * @brief stack the hot load temperature on a base spectrum
- *
- * @param tload a temperature in Kelvins
- *
- * @param s the target spec_data
- */
-
-static void sim_stack_hot_load(struct spec_data *s, gdouble tload)
-{
-	gsize i;
-
-
-	tload = tload * 1000.0; /* to mK */
-
-	for (i = 0; i < s->n; i++)
-		s->spec[i] = (typeof(*s->spec)) ((gdouble) s->spec[i] + tload);
-}
-
-/**
- * @brief transpose a two-dimensional array of complex doubles
- *
- * @param out the output array
- * @param in the input array
- *
- * @param w the width of the input array
- * @param h the height of the input array
- */
-
-static void transpose(complex double *out, complex double *in, int w, int h)
-{
-	int i, j, n;
-
-#pragma omp parallel for private(i), private(j)
-	for(n = 0; n < w * h; n++) {
-
-		i = n / h;
-		j = n % h;
-
-		out[n] = in[j * w + i];
-	}
-}
-
-/**
- * @brief put one image into another image cyclically
- *
- * @param dst the destination matrix
- * @param dw the width of the destination
- * @param dh the height of the destination
- *
- * @param src the source matrix
- * @param sw the width of the source
- * @param sh the height of the source
- *
- * @param x the upper left corner destination x coordinate
- * @param y the upper left corner destination y coordinate
- *
- * @returns 0 on success, otherwise error
- *
- * @note src must be smaller or equal dst; src will wrap within dst,
- *	 x and y are taken as mod w and mod h respectively
- */
-
-static int put_matrix(double complex *dst, int dw, int dh,
-		      const double  *src, int sw, int sh,
-		      int x, int y)
-{
-	int i, j;
-	int dx, dy;
-
-
-	if (!dst || !src)
-		return -1;
-
-	if ((dw < sw) || (dh < sh))
-		return -1;
-
-
-#pragma omp parallel for private(dy)
-	for (i = 0; i < sh; i++) {
-
-		dy = y + i;
-
-		/* fold into dest height */
-		if (dy < 0 || dy > dh)
-			dy = (dy + dh) % dh;
-
-#pragma omp parallel for private(dx)
-		for (j = 0; j < sw; j++) {
-
-			dx = x + j;
-
-			/* fold into dest width */
-			if (dx < 0 || dx > dw)
-				dx = (dx + dw) % dw;
-
-			dst[dy * dw + dx] =  src[i * sw + j];
-		}
-	}
-
-	return 0;
-}
-
-
-/**
- * @brief get one image from another image cyclically
- *
- * @param dst the destination matrix
- * @param dw the width of the destination
- * @param dh the height of the destination
- *
- * @param src the source matrix
- * @param sw the width of the source area
- * @param sh the height of the source area
- *
- * @param x the upper left corner source area x coordinate
- * @param y the upper left corner source area y coordinate
- * @param w the source area width
- * @param h the source area height
- *
- * @returns 0 on success, otherwise error
- *
- * @note dst must be larger or equal src
- *       the upper left corner of the sleected area area will be placed at 0,0
- *       within dst
- *       the src area will wrap within src, as x an y are taken as mod w and
- *       mod h respectively for both source and destination
- */
-
-static int get_matrix(double *dst, int dw, int dh,
-		      const double complex *src, int sw, int sh,
-		      int x, int y, int w, int h)
-{
-	int i, j;
-	int sx, sy;
-
-
-	if (!dst || !src)
-		return -1;
-
-	if ((dw < w) || (dh < h))
-		return -1;
-
-	if ((w > sw) || (h > sh))
-		return -1;
-
-
-#pragma omp parallel for private(sy)
-	for (i = 0; i < h; i++) {
-
-		sy = y +i;
-
-		/* fold into src height */
-		if (sy < 0 || sy > sh)
-			sy = (sy + sh) % sh;
-
-#pragma omp parallel for private(sx)
-		for (j = 0; j < w; j++) {
-
-			sx  = x + j;
-
-			/* fold into src width */
-			if (sx < 0 || sx > sw)
-				sx = (sx + sw) % sw;
-
-			dst[i * dw + j] = creal(src[sy * sw + sx]);
-		}
-	}
-
-	return 0;
-}
-
-
-/**
- * @brief in-place perform a two-dimensional fft on data
- *
- * @param data the data matrix to transform
- * @param coeff a precomputed coefficient array, may be NULL
- * @param n the fft size
- *
- * @note the data and coefficient array dimensions must match the fft size
- *
- * @returns 0 on succes, otherwise error
- */
-
-static int fft2d(double complex *data, double complex *coeff, int n)
-{
-	int i;
-	double complex *tmp;
-
-
-	tmp = malloc(n * n * sizeof(double complex));
-	if (!tmp)
-		return -1;
-	/* inverse transform rows */
-#pragma omp parallel for
-	for (i = 0; i < n; i++)
-		fft2(&data[i * n], coeff, n, FFT_INVERSE);
-
-	/* transpose forward */
-	transpose(tmp, data, n, n);
-
-	/* inverse transform columns */
-#pragma omp parallel for
-	for (i = 0; i < n; i++)
-		fft2(&tmp[i * n], coeff, n, FFT_INVERSE);
-
-	memcpy(data, tmp, n * n * sizeof(double complex));
-
-	return 0;
-}
-
-
-
-/**
- * @brief collapses the data cube along the velocity axis and return the
- *	  allocated image data
- *	  valid inputs are SIM_V_BLU_KMS to SIM_V_RED_KMS
- *
- */
-
-static gdouble *sim_rt_get_HI_img(gint vmin, gint vmax)
-{
-	gdouble sig;
-	gdouble lat, lon;
-
-	gdouble *sky;
-
-	gint16 *rawspec;
-
-
-	if (vmin > vmax) {
-		gint tmp;
-
-		/* shit happens... */
-		tmp  = vmin;
-		vmin = vmax;
-		vmax = tmp;
-	}
-
-	/* do we need to include the zero-velocity bin? */
-	if ((vmin < 0) && (vmax > 0))
-		vmax += 1;
-
-	/* to array index */
-
-	vmin += VEL / 2;
-	vmax += VEL / 2;
-
-
-	sky = g_malloc(SKY_WIDTH * SKY_HEIGHT * sizeof(gdouble));
-
-
-	for (lon = 0.; lon <= 360.; lon += 0.5) {
-		for (lat = -90.0; lat <= 90.0; lat += 0.5) {
-			int i;
-
-			rawspec = sim_spec_extract_HI_survey(lat, lon);
-
-			sig = 0.0;
-
-			for (i = vmin; i < vmax; i++)
-				sig += (double) rawspec[i];
-
-			g_free(rawspec);
-
-
-			sky[(int) (2.0 * (90. - lat)) * 722 + (int) (2.0 * fmod(540. - lon, 360.))]  = sig * SKY_SIG_TO_KELVIN;
-		}
-	}
-
-	return sky;
-}
-
-
-/**
- * @brief returns an NxN normalised gaussian convolution kernel for a given
- *	  sigma cutoff and resolution in degrees
- *
- * @note bins is always uneven (need center bin)
- *
- * @note this does not integrate the gaussian within a "pixel", i.e. with
- *	 respect to the integer coordinates between sample locations, so this
- *	 is technically not a correct convolution kernel; doing so would be
- *	 quite expensive, since we'd have to oversample the grid quite a lot
- *	 (for no added visual benefit)
- */
-
-static gdouble *gauss_2d(gdouble sigma, gdouble r, gdouble res, gint *n)
-{
-	gint i, j;
-	gint bins;
-
-	gdouble x;
-
-	gdouble sum;
-
-	gdouble *ker;
-
-
-	/* our width-normalised kernel runs from -sigma to +sigma */
-	x = gauss_half_width_sigma_r(sigma, r);
-
-	/* need an extra center bin, does not count towards stepsize */
-	bins = (gint) (round((2.0 * x) / res));
-
-	if (!(bins & 0x1))
-	    bins++;
-
-
-	ker = g_malloc(bins * bins * sizeof(double));
-
-	sum = 0.0;
-
-	for (i = 0; i < bins; i++) {
-		for (j = 0; j < bins; j++)  {
-
-			gdouble s;
-
-			/* calculate norm and scale to resolution, take 1/2
-			 * for symmetry (we go from x0 to x1)
-			 */
-			s = 0.5 * res * euclid_norm((i - bins/2), (j - bins/2));
-
-			ker[i * bins + j] = 0.5 * ((gauss_norm(s, r)));
-			sum += ker[i * bins + j];
-		}
-	}
-
-	/* normalise kernel */
-	for (i = 0; i < bins * bins; i++)
-		ker[i] /= sum;
-
-
-	(*n) = bins;
-
-	return ker;
-}
-
-
-
-
-static double complex *ft;
-static double complex *it;
-
-
-
-#define SKY1_WIDTH  1024
-#define SKY1_HEIGHT 1024
-
-#if 0
-
-static gdouble *sky_convolve(const gdouble *sky, gdouble *kernel, gint n)
-{
-	gint i, j;
-	gint x, y;
-
-	gint sx, sy;
-
-
-	gdouble sig;
-
-	gdouble *csky;
-
-
-	if (!(n & 0x1))
-	    g_warning("N is %d", n);
-
-	csky = g_malloc(SKY_WIDTH * SKY_HEIGHT * sizeof(gdouble));
-
-
-	for (y = 0; y < SKY_HEIGHT; y++) {
-		for (x = 0; x < SKY_WIDTH; x++) {
-
-			sig = 0.0;
-
-			/* n is always uneven */
-			for (i = -n/2; i < n/2; i++) {
-
-
-				sx = x + i;
-
-				/* fold into range */
-				sx = (sx + SKY_WIDTH) % SKY_WIDTH;
-
-				for (j = -n/2; j < n/2; j++) {
-					sy = y + j;
-
-					sy = (sy + SKY_HEIGHT) % SKY_HEIGHT;
-
-					sig += sky[sy * SKY_WIDTH + sx] * kernel[(i+ n/2) * n + j + n/2];
-				}
-			}
-			csky[y * SKY_WIDTH + x] = sig;
-		}
-	}
-
-	return csky;
-}
-
-#endif
-
-
-
-
-static double complex *ker;
-static double complex *csky;
-static double complex *conv;
-static gdouble *msky;
-static gdouble *raw_sky;
-static gdouble *kernel;
-
-static void sim_gen_sky(void)
-{
-	int i;
-
-	static gint vmin, vmax;
-	gint v1, v2;
-
-	gint n;
-
-
-	GTimer *timer;
-
-	timer = g_timer_new();
-
-
-
-
-	if (msky) {
-		g_free(msky);
-		msky =NULL;
-	}
-
-
-	if (kernel) {
-		g_free(kernel);
-		kernel =NULL;
-	}
-
-
-	if (ker) {
-		g_free(ker);
-		kernel =NULL;
-	}
-
-
-
-	if (!ft)
-		ft = fft_prepare_coeff(1024, FFT_FORWARD);
-
-	if (!it)
-		it = fft_prepare_coeff(1024, FFT_INVERSE);
-
-
-	v1  = gtk_spin_button_get_value_as_int(sim.gui.sb_vmin);
-	v2  = gtk_spin_button_get_value_as_int(sim.gui.sb_vmax);
-
-	if (v1 != vmin || v2 != vmax) {
-
-		if (raw_sky) {
-			g_free(raw_sky);
-			raw_sky  = NULL;
-		}
-
-		vmin = v1;
-		vmax = v2;
-	}
-
-	kernel = gauss_2d(3.0, sim.r_beam, SKY_BASE_RES, &n);
-
-	if (!conv)
-		conv = g_malloc(SKY1_WIDTH * SKY1_HEIGHT * sizeof(double complex));
-
-	if (!raw_sky) {
-#if 0
-		gdouble T;
-		struct coord_galactic gal;
-
-		gdouble w  = 2.0 * gauss_half_width_sigma_r(3.0, sim.r_beam);
-#endif
-		raw_sky = sim_rt_get_HI_img(vmin, vmax);
-
-		if (csky) {
-			g_free(csky);
-			csky =NULL;
-		}
-
-#if 0
-		gal = equatorial_to_galactic(moon_ra_dec(server_cfg_get_station_lat(),
-							 server_cfg_get_station_lon(),
-							 0.0));
-
-		T = sim_moon(gal, kernel, n, w);
-
-		T = T * VEL * 100.;
-
-		/* force onto grid */
-		gal.lat = round(( 1.0 / SKY_BASE_RES ) * gal.lat) * SKY_BASE_RES;
-		gal.lon = round(( 1.0 / SKY_BASE_RES ) * gal.lon) * SKY_BASE_RES;
-
-		gal.lat = 90. - gal.lat;
-		gal.lon = gal.lon - 90.;
-
-		raw_sky[SKY1_WIDTH * ((int)gal.lat) * 2 + (int)gal.lon * 2] += T;
-
-
-
-		gal = equatorial_to_galactic(sun_ra_dec(0.0));
-
-		T = sim_sun(gal, SIM_V_REF_HZ, kernel, n, w);
-
-		T = T * VEL * 100.;
-		g_message("at %g %g T %g", gal.lat, gal.lon, T);
-
-		/* force onto grid */
-		gal.lat = round(( 1.0 / SKY_BASE_RES ) * gal.lat) * SKY_BASE_RES;
-		gal.lon = round(( 1.0 / SKY_BASE_RES ) * gal.lon) * SKY_BASE_RES;
-
-		gal.lat = gal.lat + 90.;
-		gal.lon = gal.lon - 90.;
-		g_message("at %g %g T %g", gal.lat, gal.lon, T);
-
-		raw_sky[SKY1_WIDTH * ((int)gal.lat) * 2 + (int)gal.lon * 2] += T;
-#endif
-
-
-		csky  = g_malloc0(SKY1_WIDTH * SKY1_HEIGHT * sizeof(double complex));
-
-
-		put_matrix(csky, SKY1_WIDTH, SKY1_HEIGHT, raw_sky, SKY_WIDTH, SKY_HEIGHT, 0, 0);
-
-		fft2d(csky, ft, SKY1_WIDTH);
-	}
-
-
-#if 1
-#else
-	kernel = gauss_conv_kernel(sim.r_beam, 3.0, SKY_BASE_RES, &n);
-#endif
-	ker = g_malloc0(SKY1_WIDTH * SKY1_HEIGHT * sizeof(double complex));
-
-#if 1
-	put_matrix(ker, SKY1_WIDTH, SKY1_HEIGHT, kernel, n, n, -n/2, -n/2);
-#else
-	put_matrix(ker, SKY1_WIDTH, SKY1_HEIGHT, kernel, n, n, 360 - n/2, 180 - n/2);
-#endif
-#if 0
-	msky = g_malloc(SKY_WIDTH * SKY_HEIGHT * sizeof(double));
-	get_matrix(msky, SKY_WIDTH, SKY_HEIGHT, ker, SKY1_WIDTH, SKY1_HEIGHT,
-		   0, 0, SKY_WIDTH, SKY_HEIGHT);
-	sim_render_sky(msky, SKY_WIDTH * SKY_HEIGHT);
-
-	return;
-#endif
-	fft2d(ker, ft, SKY1_WIDTH);
-
-	g_timer_start(timer);
-
-	/* multiplication step */
-#pragma omp parallel for
-	for (i = 0; i < SKY1_HEIGHT * SKY1_WIDTH; i++)
-		conv[i] = csky[i] * ker[i];
-
-
-	fft2d(conv, it, SKY1_WIDTH);
-	msky = g_malloc(SKY_WIDTH * SKY_HEIGHT * sizeof(double));
-	get_matrix(msky, SKY_WIDTH, SKY_HEIGHT, conv, SKY1_WIDTH, SKY1_HEIGHT,
-		   0, 0, SKY_WIDTH, SKY_HEIGHT);
-
-
-	g_message("msky %g", msky[SKY_WIDTH * SKY_HEIGHT/2 + SKY_WIDTH/2]);
-
-	sim_render_sky(msky, SKY_WIDTH * SKY_HEIGHT);
-
-	g_timer_stop(timer);
-
-	g_message("render time %gs", g_timer_elapsed(timer, NULL));
-
-
-	g_timer_destroy(timer);
-
-}
-
-
-static void sim_gui_redraw_sky(void)
-{
-	if (msky)
-		sim_render_sky(msky, 722 * 361);
-}
-static void sim_redraw_cb(GtkWidget *w, gpointer dat)
-{
-	sim_gen_sky();
-}
-
-static gboolean sky_spb_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	/* we use the radius internally */
-	sim.r_beam = 0.5 * gtk_spin_button_get_value(sim.gui.sb_beam);
-	sim_gen_sky();
-}
-
-static void sim_gui_slide_value_changed(GtkRange *range, gpointer data)
-{
-	gdouble *val;
-
-
-	val = (gdouble *) data;
+	/* average the moon temperature across all degrees of latitude by
+	 * divding by pi
+	 */
+	E = 1366.0 * costheta / M_PI;
 
-	(*val) = gtk_range_get_value(range);
+	/* for emissivity ~ reflectance, we get the Moon's surface temperature
+	 * via the  Stefan-Boltzmann equation
+	 */
+	T = pow((E / 5.67e-8), 0.25);
 
-	sim_gui_redraw_sky();
-}
+	/* scale to beam/moon ratio (apparent diameter ~0.5 deg) */
 
-static gboolean sim_spb_lat_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	struct packet pkt;
+	T = T * 0.25 * 0.25 / (sim.r_beam * sim.r_beam);
 
+	/* beam is normalised to integral 1, scale temperature to center bin */
+	T = T * beam[y * n + x] / beam[n/2 * n + n/2];
 
-	server_cfg_set_station_lat(gtk_spin_button_get_value(sb));
+	return T;
+}
 
-	pkt.trans_id = PKT_TRANS_ID_UNDEF;
 
-	proc_pr_capabilities(&pkt);
-	proc_pr_capabilities_load(&pkt);
-}
+/**
+ * @brief stack the moon for a given GLAT/GLON and a beam on a base spectrum
+ *
+ * @param s the target spec_data
+ *
+ * @param gal the galactic lat/lon
+ * @param beam an nxn array which describes the shape of the beam
+ * @param n the shape of the beam in data bins
+ * @param w the width of the area in degrees (== width of the beam)
+ *
+ * @note this is a very simple moon model, where we assume that the
+ *	 smallest beam is 0.5 deg, so we can use the beam itself as the
+ *	 moon
+ *
+ * @warn this assumes that the beam's coordinate system's basis vector is in
+ *	 the same rotation as the horizon coordinate system
+ *
+ */
 
-static gboolean sim_spb_lon_value_changed_cb(GtkSpinButton *sb, gpointer data)
+static void sim_stack_moon(struct spec_data *s, struct coord_galactic gal,
+			   const gdouble *beam, gint n, gdouble w)
 {
-	struct packet pkt;
-
+	gsize i;
 
-	server_cfg_set_station_lon(gtk_spin_button_get_value(sb));
+	gdouble T;
 
-	pkt.trans_id = PKT_TRANS_ID_UNDEF;
 
-	proc_pr_capabilities(&pkt);
-	proc_pr_capabilities_load(&pkt);
-}
+	T = sim_moon(gal, beam, n, w);
 
+	/* convert to mK */
+	T = 1000. * T;
 
-static gboolean sim_spb_tsys_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	sim.tsys = gtk_spin_button_get_value(sb);
+	for (i = 0; i < s->n; i++)
+		s->spec[i] = (typeof(*s->spec)) ((double) s->spec[i] + T);
 }
 
-static gboolean sim_spb_eff_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	sim.eff = gtk_spin_button_get_value(sb);
-}
 
-static gboolean sim_spb_sig_n_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	sim.sig_n = gtk_spin_button_get_value(sb);
-}
+/**
+ * @brief stack system efficiency on a base spectrum
+ *
+ * @param s the target spec_data
+ * @param eff a efficiency multiplier
+ */
 
-static gboolean sim_spb_readout_hz_value_changed_cb(GtkSpinButton *sb, gpointer data)
+static void sim_stack_eff(struct spec_data *s, gdouble eff)
 {
-	sim.readout_hz = gtk_spin_button_get_value(sb);
-}
+	gsize i;
 
-static gboolean sim_sun_sfu_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	sim.sun_sfu = gtk_spin_button_get_value(sb);
-}
 
-static gboolean sim_noise_fig_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	sim.noise_fig = gtk_spin_button_get_value(sb);
+	for (i = 0; i < s->n; i++)
+		s->spec[i] = (typeof(*s->spec)) ((gdouble) s->spec[i] * eff);
 }
 
-static gboolean sim_hot_load_temp_value_changed_cb(GtkSpinButton *sb, gpointer data)
-{
-	struct packet pkt;
 
+/**
+ * @brief get the noise generator of the calling thread
+ *
+ * @note all generators derive from the same seed, each thread is
+ *	 jumped to its own non-overlapping stream; if the seed is 0, a
+ *	 time-based seed is picked on first use
+ */
 
-	sim.hot_load_temp = gtk_spin_button_get_value(sb);
+static struct prng *sim_get_prng(void)
+{
+	gint i, n;
 
-	pkt.trans_id = PKT_TRANS_ID_UNDEF;
+	struct prng *p;
 
-	proc_pr_capabilities_load(&pkt);
-}
+	static guint64 seed;
+	static gsize init;
 
 
-static void sim_rt_gui_defaults(void)
-{
-	sim.gui.th_lo = 0.01;
-	sim.gui.th_hi = 0.99;
-}
+	p = g_private_get(&prng_key);
+	if (p)
+		return p;
 
+	if (g_once_init_enter(&init)) {
 
-static GtkWidget *sim_rt_par_gui(void)
-{
-	GtkWidget *w;
-	GtkWidget *frame;
-	GtkWidget *grid;
+		seed = sim.seed;
+		if (!seed)
+			seed = (guint64) g_get_real_time();
 
+		g_message(MSG "noise generator seed is %" G_GUINT64_FORMAT, seed);
 
+		g_once_init_leave(&init, 1);
+	}
 
-	frame = gtk_frame_new("Simulation");
-	g_object_set(frame, "margin", 6, NULL);
+	p = g_malloc(sizeof(struct prng));
 
-	grid = gtk_grid_new();
-	gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
-	gtk_grid_set_row_spacing(GTK_GRID(grid), 6);
-	g_object_set(grid, "margin", 6, NULL);
+	prng_seed(p, seed);
 
-	gtk_container_add(GTK_CONTAINER(frame), GTK_WIDGET(grid));
+	n = g_atomic_int_add(&prng_streams, 1);
+	for (i = 0; i < n; i++)
+		prng_jump(p);
 
+	g_private_set(&prng_key, p);
 
-	w = gtk_label_new("Beam [deg]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 0, 1, 1);
+	return p;
+}
 
-	w = gtk_spin_button_new_with_range(0.5, 10.0, 0.1);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 2);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), 2.0 * sim.r_beam);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 0, 1, 1);
-	sim.gui.sb_beam = GTK_SPIN_BUTTON(w);
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sky_spb_value_changed_cb), NULL);
 
-	w = gtk_label_new("TSYS [K]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 1, 1, 1);
+/**
+ * @brief stack system noise on a base spectrum
+ *
+ * @param s the target spec_data
+ * @param sig a sigma mutliplier for the noise
+ *
+ * @note the noise is scaled by the sqrt() of the signal amplitude
+ */
 
-	w = gtk_spin_button_new_with_range(1.0, 1000., 1.);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 0);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), sim.tsys);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 1, 1, 1);
+static void sim_stack_gnoise(struct spec_data *s, gdouble sig)
+{
+	gsize i;
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_spb_tsys_value_changed_cb), NULL);
+	gdouble amp;
+	gdouble *noise;
 
-	w = gtk_label_new("Sigma");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 2, 1, 1);
 
-	w = gtk_spin_button_new_with_range(0., 20.0, 0.1);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), sim.sig_n);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 2, 1, 1);
+	noise = g_malloc(s->n * sizeof(gdouble));
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_spb_sig_n_value_changed_cb), NULL);
+	prng_gauss_fill(sim_get_prng(), noise, s->n);
 
+	for (i = 0; i < s->n; i++) {
+		amp = (gdouble) s->spec[i];
+		amp = amp + sqrt(amp) * sig * noise[i];
+		s->spec[i] = (typeof(*s->spec)) amp;
+	}
 
-	w = gtk_label_new("Eff.");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 3, 1, 1);
+	g_free(noise);
+}
 
-	w = gtk_spin_button_new_with_range(0., 1.0, 0.1);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), sim.eff);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 3, 1, 1);
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_spb_eff_value_changed_cb), NULL);
-
-
-
-	w = gtk_label_new("LAT [deg]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 4, 1, 1);
-
-	w = gtk_spin_button_new_with_range(-90., 90., 0.01);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 2);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), server_cfg_get_station_lat());
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 4, 1, 1);
-
-
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_spb_lat_value_changed_cb), NULL);
-
-	w = gtk_label_new("LON [deg]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 5, 1, 1);
-
-	w = gtk_spin_button_new_with_range(-180., 180., 0.01);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 2);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), server_cfg_get_station_lon());
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 5, 1, 1);
+/**
+ * @brief stack the hot load temperature on a base spectrum
+ *
+ * @param tload a temperature in Kelvins
+ *
+ * @param s the target spec_data
+ */
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_spb_lon_value_changed_cb), NULL);
+static void sim_stack_hot_load(struct spec_data *s, gdouble tload)
+{
+	gsize i;
 
 
-	w = gtk_label_new("Rate [Hz]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 6, 1, 1);
+	tload = tload * 1000.0; /* to mK */
 
-	w = gtk_spin_button_new_with_range(0.1, 32.0, 1.0);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), sim.readout_hz);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 6, 1, 1);
+	for (i = 0; i < s->n; i++)
+		s->spec[i] = (typeof(*s->spec)) ((gdouble) s->spec[i] + tload);
+}
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_spb_readout_hz_value_changed_cb), NULL);
 
-	w = gtk_label_new("Sun [SFU]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 7, 1, 1);
 
-	w = gtk_spin_button_new_with_range(0.0, 200., 1.0);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), sim.sun_sfu);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 7, 1, 1);
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_sun_sfu_value_changed_cb), NULL);
+/**
+ * @brief collapses the data cube along the velocity axis and return the
+ *	  allocated image data
+ *	  valid inputs are SIM_V_BLU_KMS to SIM_V_RED_KMS
+ *
+ */
 
+gdouble *sim_rt_get_HI_img(gint vmin, gint vmax)
+{
+	gdouble sig;
+	gdouble lat, lon;
 
+	gdouble *sky;
 
-	w = gtk_label_new("Hot Load [K]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 8, 1, 1);
+	gint16 *rawspec;
 
-	w = gtk_spin_button_new_with_range(0.0, 1000., 1.0);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), sim.hot_load_temp);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 8, 1, 1);
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_hot_load_temp_value_changed_cb), NULL);
+	if (!sim_HI_survey_loaded())
+		return NULL;
 
+	if (vmin > vmax) {
+		gint tmp;
 
-	w = gtk_label_new("Noise Fig. [dB]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 10, 1, 1);
+		/* shit happens... */
+		tmp  = vmin;
+		vmin = vmax;
+		vmax = tmp;
+	}
 
-	w = gtk_spin_button_new_with_range(0.1, 4.0, 0.1);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), sim.noise_fig);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 10, 1, 1);
+	/* do we need to include the zero-velocity bin? */
+	if ((vmin < 0) && (vmax > 0))
+		vmax += 1;
 
-	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
-			 G_CALLBACK(sim_noise_fig_value_changed_cb), NULL);
+	/* to array index */
 
+	vmin += VEL / 2;
+	vmax += VEL / 2;
 
 
+	sky = g_malloc(SKY_WIDTH * SKY_HEIGHT * sizeof(gdouble));
 
 
-	return frame;
-}
+	for (lon = 0.; lon <= 360.; lon += 0.5) {
+		for (lat = -90.0; lat <= 90.0; lat += 0.5) {
+			int i;
 
+			rawspec = sim_spec_extract_HI_survey(lat, lon);
+			if (!rawspec) {
+				g_free(sky);
+				return NULL;
+			}
 
+			sig = 0.0;
 
-void sim_exit_widget_destroy(GtkWidget *w)
-{
-	exit(0);
-}
+			for (i = vmin; i < vmax; i++)
+				sig += (double) rawspec[i];
 
+			g_free(rawspec);
 
-static void sim_rt_create_gui(void)
-{
-	GtkWidget *w;
-	GtkWidget *grid;
 
-	GtkWidget *win;
-	GtkWidget *box;
-	GtkWidget *vbox;
-	GtkWidget *hdr;
+			sky[(int) (2.0 * (90. - lat)) * 722 + (int) (2.0 * fmod(540. - lon, 360.))]  = sig * SKY_SIG_TO_KELVIN;
+		}
+	}
 
-	sim_rt_gui_defaults();
+	return sky;
+}
 
 
-	gtk_init(NULL, NULL);
+/**
+ * @brief returns an NxN normalised gaussian convolution kernel for a given
+ *	  sigma cutoff and resolution in degrees
+ *
+ * @note bins is always uneven (need center bin)
+ *
+ * @note this does not integrate the gaussian within a "pixel", i.e. with
+ *	 respect to the integer coordinates between sample locations, so this
+ *	 is technically not a correct convolution kernel; doing so would be
+ *	 quite expensive, since we'd have to oversample the grid quite a lot
+ *	 (for no added visual benefit)
+ */
 
-	win= gtk_window_new(GTK_WINDOW_TOPLEVEL);
+gdouble *sim_gauss_2d(gdouble sigma, gdouble r, gdouble res, gint *n)
+{
+	gint i, j;
+	gint bins;
 
-	g_signal_connect(win, "destroy", G_CALLBACK(sim_exit_widget_destroy),
-			 NULL);
+	gdouble x;
 
+	gdouble sum;
 
-	hdr = gtk_header_bar_new();
-	gtk_header_bar_set_show_close_button(GTK_HEADER_BAR(hdr), TRUE);
+	gdouble *ker;
 
-	gtk_window_set_titlebar(GTK_WINDOW(win), hdr);
 
+	/* our width-normalised kernel runs from -sigma to +sigma */
+	x = gauss_half_width_sigma_r(sigma, r);
 
+	/* need an extra center bin, does not count towards stepsize */
+	bins = (gint) (round((2.0 * x) / res));
 
+	if (!(bins & 0x1))
+	    bins++;
 
 
+	ker = g_malloc(bins * bins * sizeof(double));
 
+	sum = 0.0;
 
+	for (i = 0; i < bins; i++) {
+		for (j = 0; j < bins; j++)  {
 
+			gdouble s;
 
-	box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
-	gtk_container_add(GTK_CONTAINER(win), box);
+			/* calculate norm and scale to resolution, take 1/2
+			 * for symmetry (we go from x0 to x1)
+			 */
+			s = 0.5 * res * euclid_norm((i - bins/2), (j - bins/2));
 
+			ker[i * bins + j] = 0.5 * ((gauss_norm(s, r)));
+			sum += ker[i * bins + j];
+		}
+	}
 
-	w = gtk_frame_new("Sky Map");
-	g_object_set(w, "margin", 6, NULL);
-	gtk_box_pack_start(GTK_BOX(box), w, TRUE, TRUE, 0);
+	/* normalise kernel */
+	for (i = 0; i < bins * bins; i++)
+		ker[i] /= sum;
 
-	sim.gui.da_sky = GTK_DRAWING_AREA(gtk_drawing_area_new());
-	gtk_widget_set_size_request(GTK_WIDGET(sim.gui.da_sky), 360, 180);
-	g_object_set(GTK_WIDGET(sim.gui.da_sky), "margin", 12, NULL);
 
-	gtk_container_add(GTK_CONTAINER(w), GTK_WIDGET(sim.gui.da_sky));
+	(*n) = bins;
 
-	g_signal_connect(G_OBJECT(sim.gui.da_sky), "draw",
-			 G_CALLBACK(sim_sky_draw), NULL);
+	return ker;
+}
 
 
 
-	grid = gtk_grid_new();
-	gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
-	gtk_grid_set_row_spacing(GTK_GRID(grid), 6);
-	gtk_box_pack_start(GTK_BOX(box), grid, FALSE, TRUE, 0);
 
-	gtk_box_pack_start(GTK_BOX(box), sim_rt_par_gui(), FALSE, TRUE, 0);
 
-	w = gtk_label_new("Vmin [km/s]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 0, 1, 1);
 
-	w = gtk_spin_button_new_with_range(SIM_V_BLU_KMS, SIM_V_RED_KMS, 1);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 0);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), SIM_V_RED_KMS);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 0, 1, 1);
-	sim.gui.sb_vmin = GTK_SPIN_BUTTON(w);
 
 
-	w = gtk_label_new("Vmax [km/s]");
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_widget_set_halign(w, GTK_ALIGN_START);
-	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 1, 1, 1);
 
-	w = gtk_spin_button_new_with_range(SIM_V_BLU_KMS, SIM_V_RED_KMS, 1);
-	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
-	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
-	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 0);
-	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), SIM_V_BLU_KMS);
-	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
-	gtk_widget_set_hexpand(w, FALSE);
-	gtk_grid_attach(GTK_GRID(grid), w, 1, 1, 1, 1);
-	sim.gui.sb_vmax = GTK_SPIN_BUTTON(w);
+/**
+ * @brief report the achieved output rate in benchmark mode
+ *
+ * @param bytes the number of bytes of the last spectrum packet
+ */
 
+static void sim_bench_report(gsize bytes)
+{
+	gint64 now;
 
+	gdouble dt;
 
+	static gint64 t0;
+	static gsize n;
+	static gsize nbytes;
 
-	w = gtk_button_new_with_label("Redraw");
-	gtk_widget_set_halign(w, GTK_ALIGN_CENTER);
-	gtk_grid_attach(GTK_GRID(grid), w, 0, 2, 1, 1);
-	g_signal_connect(G_OBJECT(w), "clicked",
-			 G_CALLBACK(sim_redraw_cb), NULL);
-	gtk_widget_set_vexpand(w, FALSE);
 
+	if (!sim.bench.ena)
+		return;
 
-	box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
-	gtk_grid_attach(GTK_GRID(grid), box, 0, 3, 1, 1);
-	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	w = gtk_scale_new_with_range(GTK_ORIENTATION_VERTICAL, -0.2, 1., 0.01);
-	gtk_scale_add_mark(GTK_SCALE(w), sim.gui.th_lo, GTK_POS_LEFT, NULL);
-	gtk_range_set_value(GTK_RANGE(w), sim.gui.th_lo);
-	gtk_range_set_inverted(GTK_RANGE(w), TRUE);
-	sim.gui.s_lo = GTK_SCALE(w);
-	g_signal_connect(G_OBJECT(w), "value-changed",
-			 G_CALLBACK(sim_gui_slide_value_changed),
-			 &sim.gui.th_lo);
-	gtk_box_pack_start(GTK_BOX(vbox), w, TRUE, TRUE, 0);
-	w = gtk_label_new("Lo");
-	gtk_style_context_add_class(gtk_widget_get_style_context(w),
-				    "dim-label");
-	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
-	gtk_box_pack_start(GTK_BOX(box), vbox, TRUE, TRUE, 0);
-	gtk_widget_set_vexpand(vbox, TRUE);
+	now = g_get_monotonic_time();
 
-	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	w = gtk_scale_new_with_range(GTK_ORIENTATION_VERTICAL, 0.0, 1.2, 0.01);
-	gtk_range_set_value(GTK_RANGE(w), sim.gui.th_hi);
-	gtk_scale_add_mark(GTK_SCALE(w), sim.gui.th_hi, GTK_POS_LEFT, NULL);
-	gtk_range_set_inverted(GTK_RANGE(w), TRUE);
-	sim.gui.s_hi = GTK_SCALE(w);
-	g_signal_connect(G_OBJECT(w), "value-changed",
-			 G_CALLBACK(sim_gui_slide_value_changed),
-			 &sim.gui.th_hi);
-	gtk_box_pack_start(GTK_BOX(vbox), w, TRUE, TRUE, 0);
-	w = gtk_label_new("Hi");
-	gtk_style_context_add_class(gtk_widget_get_style_context(w),
-				    "dim-label");
-	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
-	gtk_box_pack_start(GTK_BOX(box), vbox, TRUE, TRUE, 0);
-	gtk_widget_set_vexpand(vbox, TRUE);
-
-	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-	w = gtk_scale_new(GTK_ORIENTATION_VERTICAL, NULL);
-	gtk_range_set_inverted(GTK_RANGE(w), TRUE);
-	sim.gui.s_min = GTK_SCALE(w);
-	gtk_scale_set_draw_value(GTK_SCALE(w), FALSE);
-	g_signal_connect(G_OBJECT(w), "value-changed",
-			 G_CALLBACK(sim_gui_slide_value_changed),
-			 &sim.gui.min);
-	gtk_box_pack_start(GTK_BOX(vbox), w, TRUE, TRUE, 0);
-	w = gtk_label_new("Lvl");
-	gtk_style_context_add_class(gtk_widget_get_style_context(w),
-				    "dim-label");
-	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
-	gtk_box_pack_start(GTK_BOX(box), vbox, TRUE, TRUE, 0);
-	gtk_widget_set_vexpand(vbox, TRUE);
+	if (!t0)
+		t0 = now;
 
+	n++;
+	nbytes += bytes;
 
+	dt = (gdouble) (now - t0) / (gdouble) G_USEC_PER_SEC;
+	if (dt < SIM_BENCH_REPORT_SEC)
+		return;
 
+	g_message(MSG "throughput: %.1f spectra/s, %.2f MiB/s",
+		  (gdouble) n / dt, (gdouble) nbytes / dt / 1048576.0);
 
-#if 0
-	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
-
-	w = gtk_combo_box_text_new();
-	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "LIN");
-	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "LOG");
-	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "EXP");
-	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "SQRT");
-	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "SQUARE");
-	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "ASINH");
-	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "SINH");
-	gtk_combo_box_set_active(GTK_COMBO_BOX(w), 0);
-	g_signal_connect(GTK_COMBO_BOX(w), "changed",
-			 G_CALLBACK(sim_gui_scale_mode_changed), NULL);
-
-	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
-#endif
+	t0     = now;
+	n      = 0;
+	nbytes = 0;
+}
 
 
+/**
+ * @brief wait for the next readout period
+ *
+ * @note in benchmark mode, the wait accounts for the time spent generating
+ *	 the spectrum, so the configured rate is held; if it can't be held,
+ *	 spectra are generated back-to-back
+ */
 
+static void sim_spec_pace(void)
+{
+	gint64 now;
 
+	static gint64 next;
 
 
+	if (!sim.bench.ena) {
+		g_usleep(G_USEC_PER_SEC / sim.readout_hz);
+		return;
+	}
 
+	if (sim.bench.rate <= 0.0)
+		return;
 
+	now = g_get_monotonic_time();
 
+	/* don't try to catch up if we fell behind */
+	if (next < now)
+		next = now;
 
-	gtk_widget_show_all(win);
+	next += (gint64) ((gdouble) G_USEC_PER_SEC / sim.bench.rate);
 
-	sim_gen_sky();
+	g_usleep(next - now);
 }
 
 
-
-
-
 /**
  * @brief acquire spectrea
+ *
+ * @param obs the observation
+ * @param acq_left the number of acquisitions left
+ *
  * @returns 0 on completion, 1 if more acquisitions are pending
  */
 
-static uint32_t sim_spec_acquire(struct observation *obs)
+static uint32_t sim_spec_acquire(const struct observation *obs,
+				 uint32_t *acq_left)
 {
 	struct status st;
 
@@ -2854,7 +2260,7 @@ static uint32_t sim_spec_acquire(struct observation *obs)
 
 
 #if 0
-	if (!obs->acq.acq_max)
+	if (!(*acq_left))
 		return 0;
 #endif
 	hor.az = sim.az.cur;
@@ -2877,8 +2283,8 @@ static uint32_t sim_spec_acquire(struct observation *obs)
 	static gdouble glon;
 
 
-	gal.lat = round(( 1.0 / SKY_BASE_RES ) * gal.lat) * SKY_BASE_RES;
-	gal.lon = round(( 1.0 / SKY_BASE_RES ) * gal.lon) * SKY_BASE_RES;
+	gal.lat = round(( 1.0 / hi_res ) * gal.lat) * hi_res;
+	gal.lon = round(( 1.0 / hi_res ) * gal.lon) * hi_res;
 
 	if (r != sim.r_beam || !beam) {
 
@@ -2890,7 +2296,7 @@ static uint32_t sim_spec_acquire(struct observation *obs)
 		}
 
 		sky_deg = 2.0 * gauss_half_width_sigma_r(3.0, sim.r_beam);
-		beam = gauss_2d(3.0, sim.r_beam, SKY_BASE_RES, &n_beam);
+		beam = sim_gauss_2d(3.0, sim.r_beam, hi_res, &n_beam);
 	}
 
 
@@ -2898,8 +2304,8 @@ static uint32_t sim_spec_acquire(struct observation *obs)
 		glat = gal.lat;
 
 
-	s = sim_create_empty_spectrum(g_obs.acq.freq_start_hz,
-				      g_obs.acq.freq_stop_hz);
+	s = sim_create_empty_spectrum(obs->acq.freq_start_hz,
+				      obs->acq.freq_stop_hz);
 
 
 	if (!s) {
@@ -2910,7 +2316,7 @@ static uint32_t sim_spec_acquire(struct observation *obs)
 
 	/* update theoretical rms sigma */
 	sim.sig_rms = rms_noise_sigma(sim.tsys, 1.0 / sim.readout_hz,
-				      g_obs.acq.freq_stop_hz - g_obs.acq.freq_start_hz);
+				      obs->acq.freq_stop_hz - obs->acq.freq_start_hz);
 
 
 	/* NOTE: values in s->spec must ALWAYS be >0, since it is (usually)
@@ -2943,18 +2349,23 @@ static uint32_t sim_spec_acquire(struct observation *obs)
 	/* handover for transmission */
 	ack_spec_data(PKT_TRANS_ID_UNDEF, s);
 
+	sim_bench_report(sizeof(struct packet) + sizeof(struct spec_data)
+			 + s->n * sizeof(typeof(*s->spec)));
+
 
 	st.busy = 0;
 	st.eta_msec = 0;
 	ack_status_rec(PKT_TRANS_ID_UNDEF, &st);
 
-	obs->acq.acq_max--;
+	(*acq_left)--;
 
 	g_free(s);
 
-	g_usleep(G_USEC_PER_SEC / sim.readout_hz);
+	sim_clock_step();
+
+	sim_spec_pace();
 
-	return obs->acq.acq_max;
+	return (*acq_left);
 }
 
 /**
@@ -3019,12 +2430,20 @@ static void sim_hot_load_enable(gboolean mode)
 
 /**
  * @brief thread function that does all the spectrum readout work
+ *
+ * @note the newest observation is picked up before every readout, the count
+ *	 of acquisitions starts over with each one
  */
 
 static gpointer sim_spec_thread(gpointer data)
 {
 	int run;
 
+	uint32_t acq_left = 0;
+
+	struct observation *obs = NULL;
+
+
 	while (1) {
 
 		g_mutex_lock(&acq_lock);
@@ -3043,10 +2462,19 @@ static gpointer sim_spec_thread(gpointer data)
 
 			g_mutex_unlock(&acq_pause);
 
-			g_rw_lock_reader_lock(&obs_rwlock);
-			run = sim_spec_acquire(&g_obs);
-			g_rw_lock_reader_unlock(&obs_rwlock);
-			g_usleep(1000);
+			if (!cfg_snap_is_current(obs_snap, obs)) {
+				cfg_snap_put(obs_snap, obs);
+				obs = cfg_snap_get(obs_snap);
+				acq_left = obs ? obs->acq.acq_max : 0;
+			}
+
+			if (obs)
+				run = sim_spec_acquire(obs, &acq_left);
+			else
+				run = 0;
+
+			if (!sim.bench.ena)
+				g_usleep(1000);
 		} while (run);
 
 
@@ -3054,28 +2482,19 @@ static gpointer sim_spec_thread(gpointer data)
 	}
 }
 /**
- * @brief thread function to update the acquisition information
+ * @brief publish a new observation
+ *
+ * @note the acquisition thread picks it up before its next readout
  */
 
-static gpointer sim_acquisition_update(gpointer data)
+static void sim_acquisition_update(struct observation *obs)
 {
-	struct observation *obs;
-
-
-	obs = (struct observation *) data;
-
-
-	/* wait for mutex lock to indicate abort to a single acquisition cycle
-	 * this is needed if a very wide frequency span had been selected
-	 */
+	struct spec_acq_cfg acq;
 
-	g_rw_lock_writer_lock(&obs_rwlock);
 
-	memcpy(&g_obs.acq, &obs->acq, sizeof(struct spec_acq_cfg));
+	memcpy(&acq, &obs->acq, sizeof(struct spec_acq_cfg));
 
-	g_obs.n_acs = obs->n_acs;
-
-	g_rw_lock_writer_unlock(&obs_rwlock);
+	cfg_snap_publish(obs_snap, obs);
 #if 0
 	/* signal the acquisition thread outer loop */
 	if (g_mutex_trylock(&acq_lock)) {
@@ -3084,9 +2503,7 @@ static gpointer sim_acquisition_update(gpointer data)
 	}
 #endif
 	/* push current configuration to clients */
-	ack_spec_acq_cfg(PKT_TRANS_ID_UNDEF, &g_obs.acq);
-
-	g_free(data);
+	ack_spec_acq_cfg(PKT_TRANS_ID_UNDEF, &acq);
 }
 
 
@@ -3099,7 +2516,7 @@ static void sim_spec_cfg_defaults(void)
 	struct observation *obs;
 
 
-	obs = g_malloc(sizeof(struct observation));
+	obs = cfg_snap_alloc(sizeof(struct observation));
 	if (!obs) {
 		g_error(MSG "memory allocation failed: %s: %d",
 			__func__, __LINE__);
@@ -3113,7 +2530,7 @@ static void sim_spec_cfg_defaults(void)
 	obs->acq.n_stack       = 0;
 	obs->acq.acq_max       = ~0;
 
-	g_thread_new(NULL, sim_acquisition_update, (gpointer) obs);
+	sim_acquisition_update(obs);
 }
 
 
@@ -3128,7 +2545,7 @@ int be_spec_acq_cfg(struct spec_acq_cfg *acq)
 	struct observation *obs;
 
 
-	obs = g_malloc(sizeof(struct observation));
+	obs = cfg_snap_alloc(sizeof(struct observation));
 	if (!obs) {
 		g_error(MSG "memory allocation failed: %s: %d",
 			__func__, __LINE__);
@@ -3142,7 +2559,7 @@ int be_spec_acq_cfg(struct spec_acq_cfg *acq)
 	obs->acq.n_stack       = 0;
 	obs->acq.acq_max       = ~0;
 
-	g_thread_new(NULL, sim_acquisition_update, (gpointer) obs);
+	sim_acquisition_update(obs);
 //	if (srt_spec_acquisition_configure(acq))
 //		return -1;
 
@@ -3157,10 +2574,19 @@ int be_spec_acq_cfg(struct spec_acq_cfg *acq)
 G_MODULE_EXPORT
 int be_spec_acq_cfg_get(struct spec_acq_cfg *acq)
 {
+	struct observation *obs;
+
+
 	if (!acq)
 		return -1;
 
-	memcpy(acq, &g_obs.acq, sizeof(struct spec_acq_cfg));
+	obs = cfg_snap_get(obs_snap);
+	if (!obs)
+		return -1;
+
+	memcpy(acq, &obs->acq, sizeof(struct spec_acq_cfg));
+
+	cfg_snap_put(obs_snap, obs);
 
 	return 0;
 }
@@ -3245,6 +2671,9 @@ int be_get_capabilities_load_spec(struct capabilities_load *c)
 			ack_hot_load_disable(PKT_TRANS_ID_UNDEF);
 	}
 
+	/* same for the simulated clock */
+	sim_clock_push();
+
 
 	return 0;
 }
@@ -3306,6 +2735,20 @@ int be_getpos_azel(double *az, double *el)
 }
 
 
+/**
+ * @brief the simulated drive cannot be observed while it moves
+ *
+ * @note a move completes instantly, so there are no positions between
+ *	 the ends of a row to match the spectra to
+ */
+
+G_MODULE_EXPORT
+gboolean be_drive_otf_capable(void)
+{
+	return FALSE;
+}
+
+
 /**
  * @brief get telescope drive capabilities
  */
@@ -3371,7 +2814,7 @@ void module_extra_init(void)
 
 	sim_spec_cfg_defaults();
 
-	sim_rt_create_gui();
+	sim_ui_init();
 }
 
 
@@ -3389,5 +2832,15 @@ const gchar *g_module_check_init(void)
 		g_warning(MSG "Error loading module configuration, "
 			      "this plugin may not function properly.");
 
+	sim_bench_setup();
+
+	sim_clock_setup();
+
+	sim_drive_pub = pos_pub_new(sim.az.res, sim.el.res);
+
+	obs_snap = cfg_snap_new(NULL);
+
+	sim_HI_survey_load();
+
 	return NULL;
 }
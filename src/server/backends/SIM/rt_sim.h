@@ -0,0 +1,77 @@
+/**
+ * @file    server/backends/SIM/rt_sim.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief interface between the simulator core and its (optional) front end
+ *
+ */
+
+#ifndef _RT_SIM_H_
+#define _RT_SIM_H_
+
+#include <glib.h>
+#include <math.h>
+
+
+/**
+ * default limits by velocity and rest frequency reference
+ */
+
+#define SIM_V_REF_MHZ	1420.406
+#define SIM_V_RED_KMS	 400.0
+#define SIM_V_BLU_KMS	-400.0
+#define SIM_V_RES_KMS	   1.0
+#define SIM_HI_BINS	 801
+#define SIM_HI_AMP_CAL	  10.0	/* conversion from cK to mK */
+
+
+#define SKY_GAUSS_INTG_STP	0.10	/* integration step for gaussian */
+#define SKY_BASE_RES		0.5	/* resolution of the underlying data */
+
+/* +2 and +1 extra for 0/360 lon and 0 deg lat */
+#define SKY_WIDTH		((gint) ceil(360.0 / SKY_BASE_RES) + 2)
+#define SKY_HEIGHT		((gint) ceil(180.0 / SKY_BASE_RES) + 1)
+
+#define SKY_SIG_TO_KELVIN	10.0	/* data to Kelvin conversion */
+
+
+/**
+ * @brief simulation parameters adjustable at run time
+ */
+
+enum sim_param {
+	SIM_PAR_R_BEAM,			/* beam radius */
+	SIM_PAR_TSYS,			/* system temperature */
+	SIM_PAR_EFF,			/* system efficiency */
+	SIM_PAR_SIG_N,			/* noise sigma */
+	SIM_PAR_READOUT_HZ,		/* spectrum readout frequency */
+	SIM_PAR_SUN_SFU,		/* sun solar flux units */
+	SIM_PAR_HOT_LOAD_TEMP,		/* hot load temperature */
+	SIM_PAR_NOISE_FIG,		/* noise figure of the amplifier chain */
+};
+
+
+/* simulator core, rt_sim.c */
+gdouble sim_get_param(enum sim_param p);
+void sim_set_param(enum sim_param p, gdouble val);
+
+gboolean sim_HI_survey_loaded(void);
+const gchar *sim_HI_survey_id(void);
+gdouble *sim_rt_get_HI_img(gint vmin, gint vmax);
+gdouble *sim_gauss_2d(gdouble sigma, gdouble r, gdouble res, gint *n);
+
+/* front end, rt_sim_gui.c or rt_sim_nogui.c */
+void sim_ui_init(void);
+
+
+#endif /* _RT_SIM_H_ */
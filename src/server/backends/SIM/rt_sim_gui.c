@@ -0,0 +1,1397 @@
+/**
+ * @file    server/backends/SIM/rt_sim_gui.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief GTK control window and sky map of the radio telescope simulator
+ *
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <fourier_transform.h>
+#include <colourmap.h>
+
+#include <pkt_proc.h>
+
+#include <math.h>
+#include <float.h>
+#include <complex.h>
+
+#include <cfg.h>
+
+#include <gtk/gtk.h>
+
+#include "rt_sim.h"
+
+
+#define MSG "RT SIM GUI: "
+
+
+
+static struct {
+	GdkPixbuf	*pb_sky;
+	GtkDrawingArea	*da_sky;
+
+	GtkScale	*s_lo;		/* lo colour thresh slider */
+	GtkScale	*s_hi;		/* hi colour thresh slider */
+	GtkScale	*s_min;		/* min cutoff slider */
+
+	GtkSpinButton	*sb_vmin;
+	GtkSpinButton	*sb_vmax;
+
+	GtkSpinButton	*sb_beam;
+
+	gdouble		th_lo;		/* lo colour threshold */
+	gdouble		th_hi;		/* hi colour threshold */
+	gdouble		min;		/* min cutoff */
+
+	enum {LIN, LOG, EXP, SQRT, SQUARE, ASINH, SINH} scale;
+
+	struct cmap	cmap;		/* sky map colours */
+
+} gui;
+
+
+/**
+ * @brief append new data set to waterfall
+ */
+
+static void sim_render_sky(const gdouble *amp, gsize len)
+{
+
+	int i;
+	int rs, nc;
+
+	gdouble min = DBL_MAX;
+	gdouble max = DBL_MIN;
+
+	guchar *wf;
+
+
+
+	GdkPixbuf *pb = gui.pb_sky;
+
+
+
+	if (!pb) {
+
+
+		/* +2 + 1 extra for 0/360 and -90/90 duplicates */
+		pb = gdk_pixbuf_new(GDK_COLORSPACE_RGB, FALSE, 8, 722, 361);
+
+		if (!pb) {
+			g_warning("Could not create pixbuf: out of memory");
+			return;
+		}
+
+		wf = gdk_pixbuf_get_pixels(pb);
+
+		gdk_pixbuf_fill(pb, 0x000000ff);
+		gui.pb_sky = pb;
+	}
+
+
+	wf = gdk_pixbuf_get_pixels(pb);
+
+	rs = gdk_pixbuf_get_rowstride(pb);
+
+	nc = gdk_pixbuf_get_n_channels(pb);
+
+
+
+	for (i = 0; i < len; i++) {
+		if (amp[i] < min)
+			min = amp[i];
+
+		if (amp[i] > max)
+			max = amp[i];
+	}
+
+	if (!isnormal(min))
+		min = 0.;
+	if (!isnormal(max))
+		max = 1.;
+
+	if (min > max) {
+		double tmp = max;
+
+		max = min;
+		min = tmp;
+	}
+
+
+
+
+
+	gtk_range_set_range(GTK_RANGE(gui.s_min), min, max);
+
+	/* the 360 deg column duplicates 0 deg and is not drawn */
+#pragma omp parallel for
+	for (i = 0; i < SKY_HEIGHT; i++) {
+		cmap_fill(&gui.cmap, &amp[i * SKY_WIDTH], SKY_WIDTH - 1,
+			  gui.min, 1.0 / (max - min), gui.th_lo, gui.th_hi,
+			  &wf[i * rs], nc);
+	}
+
+
+	gtk_widget_queue_draw(GTK_WIDGET(gui.da_sky));
+}
+
+
+
+
+
+
+static gboolean sim_sky_draw(GtkWidget *w, cairo_t *cr, gpointer data)
+{
+
+	GdkPixbuf *pbuf = NULL;
+
+	GtkAllocation allocation;
+
+	if (!gui.pb_sky)
+		return FALSE;
+
+
+	gtk_widget_get_allocation(w, &allocation);
+
+	pbuf = gdk_pixbuf_scale_simple(gui.pb_sky,
+				       allocation.width, allocation.height - 2,
+				       GDK_INTERP_NEAREST);
+
+	gdk_cairo_set_source_pixbuf(cr, pbuf, 0, 0);
+	cairo_paint(cr);
+
+	g_object_unref(pbuf);
+
+	return FALSE;
+}
+
+
+/**
+ * @brief put one image into another image cyclically
+ *
+ * @param dst the destination matrix
+ * @param dw the width of the destination
+ * @param dh the height of the destination
+ *
+ * @param src the source matrix
+ * @param sw the width of the source
+ * @param sh the height of the source
+ *
+ * @param x the upper left corner destination x coordinate
+ * @param y the upper left corner destination y coordinate
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note src must be smaller or equal dst; src will wrap within dst,
+ *	 x and y are taken as mod w and mod h respectively
+ */
+
+static int put_matrix(double *dst, int dw, int dh,
+		      const double  *src, int sw, int sh,
+		      int x, int y)
+{
+	int i, j;
+	int dx, dy;
+
+
+	if (!dst || !src)
+		return -1;
+
+	if ((dw < sw) || (dh < sh))
+		return -1;
+
+
+#pragma omp parallel for private(dy)
+	for (i = 0; i < sh; i++) {
+
+		dy = y + i;
+
+		/* fold into dest height */
+		if (dy < 0 || dy >= dh)
+			dy = (dy + dh) % dh;
+
+#pragma omp parallel for private(dx)
+		for (j = 0; j < sw; j++) {
+
+			dx = x + j;
+
+			/* fold into dest width */
+			if (dx < 0 || dx >= dw)
+				dx = (dx + dw) % dw;
+
+			dst[dy * dw + dx] =  src[i * sw + j];
+		}
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief get one image from another image cyclically
+ *
+ * @param dst the destination matrix
+ * @param dw the width of the destination
+ * @param dh the height of the destination
+ *
+ * @param src the source matrix
+ * @param sw the width of the source area
+ * @param sh the height of the source area
+ *
+ * @param x the upper left corner source area x coordinate
+ * @param y the upper left corner source area y coordinate
+ * @param w the source area width
+ * @param h the source area height
+ *
+ * @returns 0 on success, otherwise error
+ *
+ * @note dst must be larger or equal src
+ *       the upper left corner of the sleected area area will be placed at 0,0
+ *       within dst
+ *       the src area will wrap within src, as x an y are taken as mod w and
+ *       mod h respectively for both source and destination
+ */
+
+static int get_matrix(double *dst, int dw, int dh,
+		      const double *src, int sw, int sh,
+		      int x, int y, int w, int h)
+{
+	int i, j;
+	int sx, sy;
+
+
+	if (!dst || !src)
+		return -1;
+
+	if ((dw < w) || (dh < h))
+		return -1;
+
+	if ((w > sw) || (h > sh))
+		return -1;
+
+
+#pragma omp parallel for private(sy)
+	for (i = 0; i < h; i++) {
+
+		sy = y +i;
+
+		/* fold into src height */
+		if (sy < 0 || sy >= sh)
+			sy = (sy + sh) % sh;
+
+#pragma omp parallel for private(sx)
+		for (j = 0; j < w; j++) {
+
+			sx  = x + j;
+
+			/* fold into src width */
+			if (sx < 0 || sx >= sw)
+				sx = (sx + sw) % sw;
+
+			dst[i * dw + j] = src[sy * sw + sx];
+		}
+	}
+
+	return 0;
+}
+
+
+static struct fft2d_plan *sky_fft;
+
+
+
+#define SKY1_WIDTH  1024
+#define SKY1_HEIGHT 1024
+
+/* the number of columns of the real-to-complex spectra */
+#define SKY1_HWIDTH (SKY1_WIDTH / 2 + 1)
+
+/* number of kernel spectra kept around */
+#define SIM_KER_CACHE_LEN 4
+
+/* the on-disk cache of convolved sky maps */
+#define SIM_SKY_CACHE_MAGIC	"RTSKYMP1"
+#define SIM_SKY_CACHE_MAX	64	/* maximum number of cached maps */
+
+#if 0
+
+static gdouble *sky_convolve(const gdouble *sky, gdouble *kernel, gint n)
+{
+	gint i, j;
+	gint x, y;
+
+	gint sx, sy;
+
+
+	gdouble sig;
+
+	gdouble *csky;
+
+
+	if (!(n & 0x1))
+	    g_warning("N is %d", n);
+
+	csky = g_malloc(SKY_WIDTH * SKY_HEIGHT * sizeof(gdouble));
+
+
+	for (y = 0; y < SKY_HEIGHT; y++) {
+		for (x = 0; x < SKY_WIDTH; x++) {
+
+			sig = 0.0;
+
+			/* n is always uneven */
+			for (i = -n/2; i < n/2; i++) {
+
+
+				sx = x + i;
+
+				/* fold into range */
+				sx = (sx + SKY_WIDTH) % SKY_WIDTH;
+
+				for (j = -n/2; j < n/2; j++) {
+					sy = y + j;
+
+					sy = (sy + SKY_HEIGHT) % SKY_HEIGHT;
+
+					sig += sky[sy * SKY_WIDTH + sx] * kernel[(i+ n/2) * n + j + n/2];
+				}
+			}
+			csky[y * SKY_WIDTH + x] = sig;
+		}
+	}
+
+	return csky;
+}
+
+#endif
+
+
+
+/**
+ * @brief a cached kernel spectrum
+ */
+
+struct ker_spec {
+	gdouble r_beam;
+	double complex *spec;
+};
+
+/* most recently used first */
+static GList *ker_cache;
+
+static double complex *csky;
+static double complex *conv;
+static gdouble *msky;
+static gdouble *raw_sky;
+static gdouble *grid;
+
+/* set if msky is mapped read-only from the sky map cache */
+static GMappedFile *msky_map;
+
+
+/**
+ * @brief the header of a cached sky map, the map follows immediately
+ */
+
+struct sky_cache_hdr {
+	gchar   magic[8];	/* SIM_SKY_CACHE_MAGIC, not terminated */
+	gint32  vmin;
+	gint32  vmax;
+	gdouble r_beam;
+	gchar   id[40];		/* survey fingerprint, not terminated */
+};
+
+/**
+ * @brief a file in the sky map cache
+ */
+
+struct sky_cache_ent {
+	gint64 mtime;
+	gchar *path;
+};
+
+
+/**
+ * @brief get the spectrum of the beam convolution kernel for a beam radius
+ *
+ * @note the kernel spectrum depends only on the radius, so the last
+ *	 SIM_KER_CACHE_LEN of them are kept; the returned spectrum is owned
+ *	 by the cache
+ */
+
+static double complex *sim_get_ker_spec(gdouble r_beam)
+{
+	gint n;
+
+	GList *elem;
+
+	gdouble *kernel;
+
+	struct ker_spec *ks;
+
+
+	for (elem = ker_cache; elem; elem = elem->next) {
+
+		ks = (struct ker_spec *) elem->data;
+
+		if (ks->r_beam != r_beam)
+			continue;
+
+		ker_cache = g_list_remove_link(ker_cache, elem);
+		ker_cache = g_list_concat(elem, ker_cache);
+
+		return ks->spec;
+	}
+
+
+	if (g_list_length(ker_cache) >= SIM_KER_CACHE_LEN) {
+
+		elem = g_list_last(ker_cache);
+		ks   = (struct ker_spec *) elem->data;
+
+		ker_cache = g_list_delete_link(ker_cache, elem);
+
+		g_free(ks->spec);
+		g_free(ks);
+	}
+
+
+	kernel = sim_gauss_2d(3.0, r_beam, SKY_BASE_RES, &n);
+
+	ks = g_malloc(sizeof(struct ker_spec));
+	ks->r_beam = r_beam;
+	ks->spec   = g_malloc(SKY1_HEIGHT * SKY1_HWIDTH * sizeof(double complex));
+
+	/* center the kernel on the origin */
+	memset(grid, 0, SKY1_WIDTH * SKY1_HEIGHT * sizeof(double));
+	put_matrix(grid, SKY1_WIDTH, SKY1_HEIGHT, kernel, n, n, -n/2, -n/2);
+
+	fft2d_r2c(sky_fft, grid, ks->spec);
+
+	g_free(kernel);
+
+	ker_cache = g_list_prepend(ker_cache, ks);
+
+	return ks->spec;
+}
+
+
+/**
+ * @brief release the current sky map
+ */
+
+static void sim_sky_release(void)
+{
+	if (msky_map)
+		g_mapped_file_unref(msky_map);
+	else
+		g_free(msky);
+
+	msky_map = NULL;
+	msky     = NULL;
+}
+
+
+/**
+ * @brief set up the cache header of a sky map
+ */
+
+static void sim_sky_cache_hdr(struct sky_cache_hdr *h,
+			      gint vmin, gint vmax, gdouble r_beam)
+{
+	memset(h, 0, sizeof(struct sky_cache_hdr));
+
+	memcpy(h->magic, SIM_SKY_CACHE_MAGIC, sizeof(h->magic));
+
+	h->vmin   = vmin;
+	h->vmax   = vmax;
+	h->r_beam = r_beam;
+
+	if (sim_HI_survey_id())
+		strncpy(h->id, sim_HI_survey_id(), sizeof(h->id));
+}
+
+
+/**
+ * @brief get the cache file of a sky map
+ *
+ * @returns an allocated path or NULL if the map cannot be cached
+ *
+ * @note the file is named by the hash of its header, so any change in the
+ *	 parameters or the survey data results in a different file
+ */
+
+static gchar *sim_sky_cache_path(const struct sky_cache_hdr *h)
+{
+	gchar *sum;
+	gchar *name;
+	gchar *path;
+
+
+	if (!sim_HI_survey_id())
+		return NULL;
+
+	sum  = g_compute_checksum_for_data(G_CHECKSUM_SHA1,
+					   (const guchar *) h, sizeof(*h));
+	name = g_strconcat(sum, ".sky", NULL);
+	path = g_build_filename(g_get_user_cache_dir(), "radtel", "sky",
+				name, NULL);
+
+	g_free(sum);
+	g_free(name);
+
+	return path;
+}
+
+
+/**
+ * @brief try to map a sky map from the cache
+ *
+ * @returns TRUE if msky now holds the cached map
+ */
+
+static gboolean sim_sky_cache_load(const gchar *path,
+				   const struct sky_cache_hdr *h)
+{
+	const gchar *buf;
+
+	GMappedFile *mf;
+
+	const gsize len = sizeof(*h) + SKY_WIDTH * SKY_HEIGHT * sizeof(gdouble);
+
+
+	mf = g_mapped_file_new(path, FALSE, NULL);
+	if (!mf)
+		return FALSE;
+
+	buf = g_mapped_file_get_contents(mf);
+
+	if (g_mapped_file_get_length(mf) != len || memcmp(buf, h, sizeof(*h))) {
+		g_mapped_file_unref(mf);
+		return FALSE;
+	}
+
+	sim_sky_release();
+
+	msky_map = mf;
+	msky     = (gdouble *) (buf + sizeof(*h));
+
+	return TRUE;
+}
+
+
+/**
+ * @brief remove the least recently written maps from the cache directory
+ *
+ * @param dir the cache directory
+ * @param keep the number of maps to keep
+ */
+
+static void sim_sky_cache_prune(const gchar *dir, guint keep)
+{
+	guint i;
+
+	gchar *path;
+	const gchar *name;
+
+	GDir *d;
+	GStatBuf st;
+	GArray *age;
+
+	struct sky_cache_ent e;
+
+
+	d = g_dir_open(dir, 0, NULL);
+	if (!d)
+		return;
+
+	age = g_array_new(FALSE, FALSE, sizeof(e));
+
+	while ((name = g_dir_read_name(d))) {
+
+		if (!g_str_has_suffix(name, ".sky"))
+			continue;
+
+		path = g_build_filename(dir, name, NULL);
+
+		if (g_stat(path, &st)) {
+			g_free(path);
+			continue;
+		}
+
+		e.mtime = (gint64) st.st_mtime;
+		e.path  = path;
+
+		g_array_append_val(age, e);
+	}
+
+	g_dir_close(d);
+
+	while (age->len > keep) {
+
+		guint old = 0;
+
+		for (i = 1; i < age->len; i++) {
+			if (g_array_index(age, struct sky_cache_ent, i).mtime <
+			    g_array_index(age, struct sky_cache_ent, old).mtime)
+				old = i;
+		}
+
+		g_remove(g_array_index(age, struct sky_cache_ent, old).path);
+		g_free(g_array_index(age, struct sky_cache_ent, old).path);
+		g_array_remove_index_fast(age, old);
+	}
+
+	for (i = 0; i < age->len; i++)
+		g_free(g_array_index(age, struct sky_cache_ent, i).path);
+
+	g_array_free(age, TRUE);
+}
+
+
+/**
+ * @brief store the current sky map in the cache
+ */
+
+static void sim_sky_cache_store(const gchar *path,
+				const struct sky_cache_hdr *h)
+{
+	gsize len;
+
+	gchar *buf;
+	gchar *dir;
+
+	GError *error = NULL;
+
+
+	dir = g_path_get_dirname(path);
+
+	if (g_mkdir_with_parents(dir, 0700)) {
+		g_warning(MSG "could not create sky map cache %s", dir);
+		g_free(dir);
+		return;
+	}
+
+	sim_sky_cache_prune(dir, SIM_SKY_CACHE_MAX - 1);
+
+	g_free(dir);
+
+	len = SKY_WIDTH * SKY_HEIGHT * sizeof(gdouble);
+
+	buf = g_malloc(sizeof(*h) + len);
+	memcpy(buf, h, sizeof(*h));
+	memcpy(buf + sizeof(*h), msky, len);
+
+	/* written to a temporary file and renamed, so a reader never sees a
+	 * partial map
+	 */
+	if (!g_file_set_contents(path, buf, sizeof(*h) + len, &error)) {
+		g_warning(MSG "could not cache sky map: %s", error->message);
+		g_clear_error(&error);
+	}
+
+	g_free(buf);
+}
+
+
+/**
+ * @brief generate the beam-convolved HI sky map
+ *
+ * @note the spectrum of the sky is recomputed only if the velocity range
+ *	 changes, the kernel spectra are cached, so a change of the beam
+ *	 usually needs only the multiplication and the inverse transform
+ *
+ * @note finished maps are kept in an on-disk cache keyed by the velocity
+ *	 range, the beam and the survey data, so a restarted simulator shows
+ *	 a map it has made before immediately
+ */
+
+static void sim_gen_sky(void)
+{
+	int i;
+
+	static gint vmin, vmax;
+	gint v1, v2;
+
+	gdouble r_beam;
+
+	gchar *path;
+
+	double complex *ker;
+
+	GTimer *timer;
+
+	struct sky_cache_hdr hdr;
+
+
+	timer = g_timer_new();
+
+	v1  = gtk_spin_button_get_value_as_int(gui.sb_vmin);
+	v2  = gtk_spin_button_get_value_as_int(gui.sb_vmax);
+
+	if (v1 != vmin || v2 != vmax) {
+
+		g_free(raw_sky);
+		raw_sky = NULL;
+
+		vmin = v1;
+		vmax = v2;
+	}
+
+	r_beam = sim_get_param(SIM_PAR_R_BEAM);
+
+	sim_sky_cache_hdr(&hdr, vmin, vmax, r_beam);
+	path = sim_sky_cache_path(&hdr);
+
+	if (path && sim_sky_cache_load(path, &hdr)) {
+
+		sim_render_sky(msky, SKY_WIDTH * SKY_HEIGHT);
+
+		g_message(MSG "sky map loaded from cache in %gs",
+			  g_timer_elapsed(timer, NULL));
+		goto exit;
+	}
+
+
+	if (!sky_fft)
+		sky_fft = fft2d_plan_create(SKY1_WIDTH, SKY1_HEIGHT);
+
+	if (!sky_fft) {
+		g_warning(MSG "could not create the sky map transform");
+		goto exit;
+	}
+
+	if (!grid)
+		grid = g_malloc(SKY1_WIDTH * SKY1_HEIGHT * sizeof(double));
+
+	if (!conv)
+		conv = g_malloc(SKY1_HEIGHT * SKY1_HWIDTH * sizeof(double complex));
+
+	if (!raw_sky) {
+
+		raw_sky = sim_rt_get_HI_img(vmin, vmax);
+
+		/* no survey data, nothing to show */
+		if (!raw_sky)
+			goto exit;
+
+		if (!csky)
+			csky = g_malloc(SKY1_HEIGHT * SKY1_HWIDTH *
+					sizeof(double complex));
+
+		memset(grid, 0, SKY1_WIDTH * SKY1_HEIGHT * sizeof(double));
+		put_matrix(grid, SKY1_WIDTH, SKY1_HEIGHT,
+			   raw_sky, SKY_WIDTH, SKY_HEIGHT, 0, 0);
+
+		fft2d_r2c(sky_fft, grid, csky);
+	}
+
+	ker = sim_get_ker_spec(r_beam);
+
+	/* multiplication step */
+#pragma omp parallel for
+	for (i = 0; i < SKY1_HEIGHT * SKY1_HWIDTH; i++)
+		conv[i] = csky[i] * ker[i];
+
+	fft2d_c2r(sky_fft, conv, grid);
+
+	/* the cached map is read-only */
+	if (msky_map)
+		sim_sky_release();
+
+	if (!msky)
+		msky = g_malloc(SKY_WIDTH * SKY_HEIGHT * sizeof(double));
+
+	get_matrix(msky, SKY_WIDTH, SKY_HEIGHT, grid, SKY1_WIDTH, SKY1_HEIGHT,
+		   0, 0, SKY_WIDTH, SKY_HEIGHT);
+
+	sim_render_sky(msky, SKY_WIDTH * SKY_HEIGHT);
+
+	g_message(MSG "sky map generated in %gs", g_timer_elapsed(timer, NULL));
+
+	if (path)
+		sim_sky_cache_store(path, &hdr);
+
+exit:
+	g_free(path);
+	g_timer_destroy(timer);
+}
+
+
+static void sim_gui_redraw_sky(void)
+{
+	if (msky)
+		sim_render_sky(msky, 722 * 361);
+}
+static void sim_redraw_cb(GtkWidget *w, gpointer dat)
+{
+	sim_gen_sky();
+}
+
+static gboolean sky_spb_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	/* we use the radius internally */
+	sim_set_param(SIM_PAR_R_BEAM,
+		      0.5 * gtk_spin_button_get_value(gui.sb_beam));
+	sim_gen_sky();
+}
+
+static void sim_gui_slide_value_changed(GtkRange *range, gpointer data)
+{
+	gdouble *val;
+
+
+	val = (gdouble *) data;
+
+	(*val) = gtk_range_get_value(range);
+
+	sim_gui_redraw_sky();
+}
+
+static gboolean sim_spb_lat_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	struct packet pkt;
+
+
+	server_cfg_set_station_lat(gtk_spin_button_get_value(sb));
+
+	pkt.trans_id = PKT_TRANS_ID_UNDEF;
+
+	proc_pr_capabilities(&pkt);
+	proc_pr_capabilities_load(&pkt);
+}
+
+static gboolean sim_spb_lon_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	struct packet pkt;
+
+
+	server_cfg_set_station_lon(gtk_spin_button_get_value(sb));
+
+	pkt.trans_id = PKT_TRANS_ID_UNDEF;
+
+	proc_pr_capabilities(&pkt);
+	proc_pr_capabilities_load(&pkt);
+}
+
+
+static gboolean sim_spb_tsys_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	sim_set_param(SIM_PAR_TSYS, gtk_spin_button_get_value(sb));
+}
+
+static gboolean sim_spb_eff_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	sim_set_param(SIM_PAR_EFF, gtk_spin_button_get_value(sb));
+}
+
+static gboolean sim_spb_sig_n_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	sim_set_param(SIM_PAR_SIG_N, gtk_spin_button_get_value(sb));
+}
+
+static gboolean sim_spb_readout_hz_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	sim_set_param(SIM_PAR_READOUT_HZ, gtk_spin_button_get_value(sb));
+}
+
+static gboolean sim_sun_sfu_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	sim_set_param(SIM_PAR_SUN_SFU, gtk_spin_button_get_value(sb));
+}
+
+static gboolean sim_noise_fig_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	sim_set_param(SIM_PAR_NOISE_FIG, gtk_spin_button_get_value(sb));
+}
+
+static gboolean sim_hot_load_temp_value_changed_cb(GtkSpinButton *sb, gpointer data)
+{
+	struct packet pkt;
+
+
+	sim_set_param(SIM_PAR_HOT_LOAD_TEMP, gtk_spin_button_get_value(sb));
+
+	pkt.trans_id = PKT_TRANS_ID_UNDEF;
+
+	proc_pr_capabilities_load(&pkt);
+}
+
+
+static void sim_rt_gui_defaults(void)
+{
+	gui.th_lo = 0.01;
+	gui.th_hi = 0.99;
+}
+
+
+static GtkWidget *sim_rt_par_gui(void)
+{
+	GtkWidget *w;
+	GtkWidget *frame;
+	GtkWidget *grid;
+
+
+
+	frame = gtk_frame_new("Simulation");
+	g_object_set(frame, "margin", 6, NULL);
+
+	grid = gtk_grid_new();
+	gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
+	gtk_grid_set_row_spacing(GTK_GRID(grid), 6);
+	g_object_set(grid, "margin", 6, NULL);
+
+	gtk_container_add(GTK_CONTAINER(frame), GTK_WIDGET(grid));
+
+
+	w = gtk_label_new("Beam [deg]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 0, 1, 1);
+
+	w = gtk_spin_button_new_with_range(0.5, 10.0, 0.1);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 2);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  2.0 * sim_get_param(SIM_PAR_R_BEAM));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 0, 1, 1);
+	gui.sb_beam = GTK_SPIN_BUTTON(w);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sky_spb_value_changed_cb), NULL);
+
+	w = gtk_label_new("TSYS [K]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 1, 1, 1);
+
+	w = gtk_spin_button_new_with_range(1.0, 1000., 1.);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 0);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  sim_get_param(SIM_PAR_TSYS));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 1, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_spb_tsys_value_changed_cb), NULL);
+
+	w = gtk_label_new("Sigma");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 2, 1, 1);
+
+	w = gtk_spin_button_new_with_range(0., 20.0, 0.1);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  sim_get_param(SIM_PAR_SIG_N));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 2, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_spb_sig_n_value_changed_cb), NULL);
+
+
+	w = gtk_label_new("Eff.");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 3, 1, 1);
+
+	w = gtk_spin_button_new_with_range(0., 1.0, 0.1);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  sim_get_param(SIM_PAR_EFF));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 3, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_spb_eff_value_changed_cb), NULL);
+
+
+
+	w = gtk_label_new("LAT [deg]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 4, 1, 1);
+
+	w = gtk_spin_button_new_with_range(-90., 90., 0.01);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 2);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), server_cfg_get_station_lat());
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 4, 1, 1);
+
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_spb_lat_value_changed_cb), NULL);
+
+	w = gtk_label_new("LON [deg]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 5, 1, 1);
+
+	w = gtk_spin_button_new_with_range(-180., 180., 0.01);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 2);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), server_cfg_get_station_lon());
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 5, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_spb_lon_value_changed_cb), NULL);
+
+
+	w = gtk_label_new("Rate [Hz]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 6, 1, 1);
+
+	w = gtk_spin_button_new_with_range(0.1, 32.0, 1.0);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  sim_get_param(SIM_PAR_READOUT_HZ));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 6, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_spb_readout_hz_value_changed_cb), NULL);
+
+	w = gtk_label_new("Sun [SFU]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 7, 1, 1);
+
+	w = gtk_spin_button_new_with_range(0.0, 200., 1.0);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  sim_get_param(SIM_PAR_SUN_SFU));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 7, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_sun_sfu_value_changed_cb), NULL);
+
+
+
+	w = gtk_label_new("Hot Load [K]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 8, 1, 1);
+
+	w = gtk_spin_button_new_with_range(0.0, 1000., 1.0);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  sim_get_param(SIM_PAR_HOT_LOAD_TEMP));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 8, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_hot_load_temp_value_changed_cb), NULL);
+
+
+	w = gtk_label_new("Noise Fig. [dB]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 10, 1, 1);
+
+	w = gtk_spin_button_new_with_range(0.1, 4.0, 0.1);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 1);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w),
+				  sim_get_param(SIM_PAR_NOISE_FIG));
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 10, 1, 1);
+
+	g_signal_connect(GTK_SPIN_BUTTON(w), "value-changed",
+			 G_CALLBACK(sim_noise_fig_value_changed_cb), NULL);
+
+
+
+
+
+	return frame;
+}
+
+
+
+void sim_exit_widget_destroy(GtkWidget *w)
+{
+	exit(0);
+}
+
+
+static void sim_rt_create_gui(void)
+{
+	GtkWidget *w;
+	GtkWidget *grid;
+
+	GtkWidget *win;
+	GtkWidget *box;
+	GtkWidget *vbox;
+	GtkWidget *hdr;
+
+	sim_rt_gui_defaults();
+
+
+	gtk_init(NULL, NULL);
+
+	win= gtk_window_new(GTK_WINDOW_TOPLEVEL);
+
+	g_signal_connect(win, "destroy", G_CALLBACK(sim_exit_widget_destroy),
+			 NULL);
+
+
+	hdr = gtk_header_bar_new();
+	gtk_header_bar_set_show_close_button(GTK_HEADER_BAR(hdr), TRUE);
+
+	gtk_window_set_titlebar(GTK_WINDOW(win), hdr);
+
+
+
+
+
+
+
+
+
+	box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 8);
+	gtk_container_add(GTK_CONTAINER(win), box);
+
+
+	w = gtk_frame_new("Sky Map");
+	g_object_set(w, "margin", 6, NULL);
+	gtk_box_pack_start(GTK_BOX(box), w, TRUE, TRUE, 0);
+
+	gui.da_sky = GTK_DRAWING_AREA(gtk_drawing_area_new());
+	gtk_widget_set_size_request(GTK_WIDGET(gui.da_sky), 360, 180);
+	g_object_set(GTK_WIDGET(gui.da_sky), "margin", 12, NULL);
+
+	gtk_container_add(GTK_CONTAINER(w), GTK_WIDGET(gui.da_sky));
+
+	g_signal_connect(G_OBJECT(gui.da_sky), "draw",
+			 G_CALLBACK(sim_sky_draw), NULL);
+
+
+
+	grid = gtk_grid_new();
+	gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
+	gtk_grid_set_row_spacing(GTK_GRID(grid), 6);
+	gtk_box_pack_start(GTK_BOX(box), grid, FALSE, TRUE, 0);
+
+	gtk_box_pack_start(GTK_BOX(box), sim_rt_par_gui(), FALSE, TRUE, 0);
+
+	w = gtk_label_new("Vmin [km/s]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 0, 1, 1);
+
+	w = gtk_spin_button_new_with_range(SIM_V_BLU_KMS, SIM_V_RED_KMS, 1);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 0);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), SIM_V_RED_KMS);
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 0, 1, 1);
+	gui.sb_vmin = GTK_SPIN_BUTTON(w);
+
+
+	w = gtk_label_new("Vmax [km/s]");
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_widget_set_halign(w, GTK_ALIGN_START);
+	gtk_label_set_xalign(GTK_LABEL(w), 0.0);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 1, 1, 1);
+
+	w = gtk_spin_button_new_with_range(SIM_V_BLU_KMS, SIM_V_RED_KMS, 1);
+	gtk_entry_set_alignment(GTK_ENTRY(w), 1.0);
+	gtk_spin_button_set_numeric(GTK_SPIN_BUTTON(w), TRUE);
+	gtk_spin_button_set_digits(GTK_SPIN_BUTTON(w), 0);
+	gtk_spin_button_set_value(GTK_SPIN_BUTTON(w), SIM_V_BLU_KMS);
+	gtk_widget_set_halign(w, GTK_ALIGN_FILL);
+	gtk_widget_set_hexpand(w, FALSE);
+	gtk_grid_attach(GTK_GRID(grid), w, 1, 1, 1, 1);
+	gui.sb_vmax = GTK_SPIN_BUTTON(w);
+
+
+
+
+	w = gtk_button_new_with_label("Redraw");
+	gtk_widget_set_halign(w, GTK_ALIGN_CENTER);
+	gtk_grid_attach(GTK_GRID(grid), w, 0, 2, 1, 1);
+	g_signal_connect(G_OBJECT(w), "clicked",
+			 G_CALLBACK(sim_redraw_cb), NULL);
+	gtk_widget_set_vexpand(w, FALSE);
+
+
+	box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
+	gtk_grid_attach(GTK_GRID(grid), box, 0, 3, 1, 1);
+	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	w = gtk_scale_new_with_range(GTK_ORIENTATION_VERTICAL, -0.2, 1., 0.01);
+	gtk_scale_add_mark(GTK_SCALE(w), gui.th_lo, GTK_POS_LEFT, NULL);
+	gtk_range_set_value(GTK_RANGE(w), gui.th_lo);
+	gtk_range_set_inverted(GTK_RANGE(w), TRUE);
+	gui.s_lo = GTK_SCALE(w);
+	g_signal_connect(G_OBJECT(w), "value-changed",
+			 G_CALLBACK(sim_gui_slide_value_changed),
+			 &gui.th_lo);
+	gtk_box_pack_start(GTK_BOX(vbox), w, TRUE, TRUE, 0);
+	w = gtk_label_new("Lo");
+	gtk_style_context_add_class(gtk_widget_get_style_context(w),
+				    "dim-label");
+	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
+	gtk_box_pack_start(GTK_BOX(box), vbox, TRUE, TRUE, 0);
+	gtk_widget_set_vexpand(vbox, TRUE);
+
+	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	w = gtk_scale_new_with_range(GTK_ORIENTATION_VERTICAL, 0.0, 1.2, 0.01);
+	gtk_range_set_value(GTK_RANGE(w), gui.th_hi);
+	gtk_scale_add_mark(GTK_SCALE(w), gui.th_hi, GTK_POS_LEFT, NULL);
+	gtk_range_set_inverted(GTK_RANGE(w), TRUE);
+	gui.s_hi = GTK_SCALE(w);
+	g_signal_connect(G_OBJECT(w), "value-changed",
+			 G_CALLBACK(sim_gui_slide_value_changed),
+			 &gui.th_hi);
+	gtk_box_pack_start(GTK_BOX(vbox), w, TRUE, TRUE, 0);
+	w = gtk_label_new("Hi");
+	gtk_style_context_add_class(gtk_widget_get_style_context(w),
+				    "dim-label");
+	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
+	gtk_box_pack_start(GTK_BOX(box), vbox, TRUE, TRUE, 0);
+	gtk_widget_set_vexpand(vbox, TRUE);
+
+	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	w = gtk_scale_new(GTK_ORIENTATION_VERTICAL, NULL);
+	gtk_range_set_inverted(GTK_RANGE(w), TRUE);
+	gui.s_min = GTK_SCALE(w);
+	gtk_scale_set_draw_value(GTK_SCALE(w), FALSE);
+	g_signal_connect(G_OBJECT(w), "value-changed",
+			 G_CALLBACK(sim_gui_slide_value_changed),
+			 &gui.min);
+	gtk_box_pack_start(GTK_BOX(vbox), w, TRUE, TRUE, 0);
+	w = gtk_label_new("Lvl");
+	gtk_style_context_add_class(gtk_widget_get_style_context(w),
+				    "dim-label");
+	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
+	gtk_box_pack_start(GTK_BOX(box), vbox, TRUE, TRUE, 0);
+	gtk_widget_set_vexpand(vbox, TRUE);
+
+
+
+
+#if 0
+	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+
+	w = gtk_combo_box_text_new();
+	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "LIN");
+	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "LOG");
+	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "EXP");
+	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "SQRT");
+	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "SQUARE");
+	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "ASINH");
+	gtk_combo_box_text_append(GTK_COMBO_BOX_TEXT(w), NULL, "SINH");
+	gtk_combo_box_set_active(GTK_COMBO_BOX(w), 0);
+	g_signal_connect(GTK_COMBO_BOX(w), "changed",
+			 G_CALLBACK(sim_gui_scale_mode_changed), NULL);
+
+	gtk_box_pack_start(GTK_BOX(vbox), w, FALSE, TRUE, 0);
+#endif
+
+
+
+
+
+
+
+
+
+
+	gtk_widget_show_all(win);
+
+	sim_gen_sky();
+}
+
+
+/**
+ * @brief set up the control window of the simulator
+ *
+ * @note this is called from module_extra_init(); if the HI survey could not
+ *	 be loaded, the user is told so, but the simulator keeps running
+ */
+
+void sim_ui_init(void)
+{
+	GtkWidget *dia;
+
+
+	cmap_init(&gui.cmap);
+
+	sim_rt_create_gui();
+
+	if (sim_HI_survey_loaded())
+		return;
+
+	dia = gtk_message_dialog_new(NULL,
+				     GTK_DIALOG_MODAL,
+				     GTK_MESSAGE_ERROR,
+				     GTK_BUTTONS_CLOSE,
+				     "Please place sky_vel.dat in the "
+				     "directory path this program is executed "
+				     "in. The HI line will not be simulated.");
+
+	gtk_dialog_run(GTK_DIALOG(dia));
+	gtk_widget_destroy(dia);
+}
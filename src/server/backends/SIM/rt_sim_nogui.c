@@ -0,0 +1,39 @@
+/**
+ * @file    server/backends/SIM/rt_sim_nogui.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief headless front end of the radio telescope simulator
+ *
+ * @note all parameters are taken from backends/rt_sim.cfg, there is no way
+ *	 to adjust them at run time
+ */
+
+
+#include <glib.h>
+
+#include "rt_sim.h"
+
+
+#define MSG "RT SIM: "
+
+
+/**
+ * @brief initialise the (non-existing) front end
+ */
+
+void sim_ui_init(void)
+{
+	g_message(MSG "running headless, beam %g deg, tsys %g K",
+		  2.0 * sim_get_param(SIM_PAR_R_BEAM),
+		  sim_get_param(SIM_PAR_TSYS));
+}
@@ -20,12 +20,6 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <fcntl.h>
-#include <unistd.h>
-#include <errno.h>
-#include <ctype.h>
-
-#include <termios.h>
 
 #include <glib.h>
 #include <gmodule.h>
@@ -33,262 +27,80 @@
 
 #include <math.h>
 #include <backend.h>
+#include <serial.h>
 
 
 #define MSG "SRT COM: "
 
 #define SRT_SPEC_MSG_LEN 128
+#define SRT_COM_LINE_MAX 256
 
+#define SRT_COM_BAUD			2400
+#define SRT_COM_WRITE_TIMEOUT_MS	1000
 
-static char *srt_tty = "/dev/ttyUSB0";
-
-static int fd;
-static GMutex linkmutex;
-static GMutex readmutex;
-static GCond cond;
-static gchar *line;
-static gsize line_len;
-static gboolean raw_read;
-
-/**
- * @brief open a serial tty
- * @param tty the path to the tty
- *
- * @return 0 on error, file descriptor otherwise
+/* a drive command is answered once the motion completed, which may take
+ * a long time for a full rotation
  */
+#define SRT_COM_TIMEOUT_SEC		3600
 
-static int srt_com_serial_open_port(const char *tty)
-{
-	int fd;
-
-
-
-	fd = open(tty, O_RDWR | O_NOCTTY | O_NDELAY | O_NONBLOCK);
-
-	if (fd < 0) {
-		perror("unable to open serial port");
-		return 0;
-	}
-
-#if 0
-	fcntl(fd, F_SETFL, O_NONBLOCK);
-#else
-	fcntl(fd, F_SETFL, 0);
-#endif
-
-	return fd;
-}
-
-#if 0
-/**
- * @brief close a serial tty
- * @param fd the file descriptor to close
- * @return see man 3 close()
+/* a spectrometer step is answered within a few seconds; a silent
+ * spectrometer must not hold up the drive for long
  */
+#define SRT_COM_SPEC_TIMEOUT_SEC	10
 
-static int srt_com_serial_close_port(int fd)
-{
-	return close(fd);
-}
-#endif
+/* interval between queue statistics reports */
+#define SRT_COM_STATS_INTERVAL_SEC	600
 
-/**
- * @brief set the serial link parameters (for the SRT)
- *
- * @param fd the file descriptor of the serial tty
- *
- * @return see man 3 tcsetattr
- */
-
-static int srt_com_serial_set_comm_param(int fd)
-{
-	struct termios cfg;
-
-
-	/* get current port attributes */
-	tcgetattr(fd, &cfg);
-
-
-	/* char size is 8 */
-	cfg.c_cflag &= ~CSIZE;		/* clear character size bits */
-	cfg.c_cflag |= CS8;		/* set with to 8 bits */
-
-	/* baud rate is 2400 */
-	cfsetispeed(&cfg, B2400);
-	cfsetospeed(&cfg, B2400);
-
-	/* single stop bit */
-	cfg.c_cflag &= ~CSTOPB;	/* 1 stop bit */
-
-	/* no parity */
-	cfg.c_cflag &= ~PARENB;
-	cfg.c_iflag &=  ~INPCK;
-
-	/* no flow control */
-	cfg.c_iflag &= ~(IXON | IXOFF | IXANY);
-
-	/* set raw i/o */
-	cfg.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
-	cfg.c_oflag &= ~OPOST;
-
-	/* enable receiver and set local mode */
-	cfg.c_cflag |= (CLOCAL | CREAD);
-
-	cfg.c_cc[VTIME] = 1;
-
-	/* set configuration */
-	return tcsetattr (fd, TCSANOW, &cfg);
-}
 
-#if 0
-/**
- * @brief read from the serial port
- *
- * @param fd the file descriptor of the serial tty
- * @param buf the buffer to read to
- * @parma nbyte the size of the buffer (maximum number of bytes to read)
- *
- * @return see man 3 read
- *
- * @note unused
- */
-
-static int srt_com_serial_read(int fd, char *buf, size_t nbyte)
-{
-	int n;
-
-	fcntl(fd, F_SETFL, O_NONBLOCK);
-
-	n = read(fd, buf, nbyte);
+static char *srt_tty = "/dev/ttyUSB0";
+static gint srt_timeout_sec = SRT_COM_TIMEOUT_SEC;
+static gint srt_spec_timeout_sec = SRT_COM_SPEC_TIMEOUT_SEC;
 
-	if (n < 0)
-		perror("serial port read failed");
+static struct serial_link *com_link;
+static GMutex linkmutex;
 
-	return n;
-}
-#endif
 
 /**
- * @brief write to the serial port
- *
- * @param fd the file descriptor of the serial tty
- * @param buf the buffer to write from
- * @parma nbyte the size of the data in the buffer
- * @param drain if set, waits until all output has been transmitted
- *
- * @return see man 3 write
+ * @brief a request on the shared link
  */
 
-static int srt_com_serial_write(int fd, const char *buf,
-				size_t nbyte, int drain)
-{
-	int n;
-
-
-	/* always write a newline first, or the device might not detect
-	 * the command. This may be due g_io_channel_read_line not clearing
-	 * the input or something...
-	 */
-
-	write(fd, " \n", 2);
+struct comlink_req {
+	enum comlink_class cls;
 
-	n = write(fd, buf, nbyte);
+	const gchar *cmd;
+	gsize len;
 
-	if (drain)
-		tcdrain(fd);
+	gint64 t_enq;			/* time of submission (usec) */
+	gint64 deadline;		/* latest start of execution (usec) */
 
-	if (n < 0)
-		perror("serial port write failed");
+	gchar *rsp;
+	gsize rsp_len;
+	gint64 exec_us;			/* time spent on the link (usec) */
 
-	return n;
-}
+	gboolean done;
+};
 
 
 /**
- * @brief glib io watch callback
+ * @brief the request queue, one per class
  */
 
-static gboolean srt_com_serial_glib_callback(GIOChannel *src,
-					     GIOCondition giocond,
-					     gpointer unused)
-{
-	GIOStatus ret;
-
-	GError *err = NULL;
-
+static struct {
+	GMutex lock;
+	GCond work;			/* a request was queued */
+	GCond done;			/* a request was completed */
 
+	GQueue q[COMLINK_CLASS_N];
 
-	/* something arrived when noone listened, release it so we don't leak */
-	if (line) {
-		g_warning(MSG "a serial read was lost: %s", line);
-		g_free(line);
-	}
-
-
-	/* if the last command was "freq", raw_read is true */
+	struct {
+		guint64 n;		/* requests dequeued */
+		guint64 n_expired;	/* requests dropped on deadline */
+		gint64 wait_sum_us;	/* total time spent queued */
+		gint64 wait_max_us;	/* longest time spent queued */
+	} st[COMLINK_CLASS_N];
 
-	if (raw_read) {
-		line = g_malloc(SRT_SPEC_MSG_LEN);
-		ret = g_io_channel_read_chars(src, line, SRT_SPEC_MSG_LEN,
-					      &line_len, &err);
-
-		if (line_len != SRT_SPEC_MSG_LEN)
-			g_warning(MSG "Expected %d bytes, but got %d",
-				  SRT_SPEC_MSG_LEN, line_len);
-	} else {
-		ret = g_io_channel_read_line(src, &line, &line_len, NULL, &err);
-	}
-
-
-	if (ret == G_IO_STATUS_ERROR) {
-		g_error("Error reading: %s\n", err->message);
-		g_error_free(err);
-	}
-
-
-	g_mutex_lock(&readmutex);
-	g_cond_signal(&cond);
-	g_mutex_unlock(&readmutex);
-
-	return TRUE;
-}
-
-
-/**
- * @brief configure glib io polling of the serial tty
- */
-
-static GIOChannel *srt_com_serial_init_glib_poll(int fd)
-{
-	GIOChannel *g_io_ch = NULL;
-
-
-	g_io_ch = g_io_channel_unix_new(fd);
-
-	/* explicitly set line terminator, autodetection does not appear
-	 * to work properly here
-	 *
-	 * WARNING: if the plugin does not work (correctly), make sure to
-	 * try a line terminator of both \r and \n, as this appears to
-	 * randomly change for different versions of glib
-	 * The nominal terminator char for the device is \r, but we're
-	 * not using the tty directly
-	 */
-	g_io_channel_set_line_term(g_io_ch, "\n", 1);
-
-	/* set to raw encoding */
-	g_io_channel_set_encoding(g_io_ch, NULL, NULL);
-
-	/* limit buffer size so we can read both line terminated and raw
-	 * messages
-	 */
-	g_io_channel_set_buffer_size(g_io_ch, SRT_SPEC_MSG_LEN);
-
-	g_io_add_watch(g_io_ch, (G_IO_IN | G_IO_PRI),
-		       srt_com_serial_glib_callback, NULL);
-
-	return g_io_ch;
-}
+	gint64 t_report;		/* time of the last report (usec) */
+} queue;
 
 
 /**
@@ -304,6 +116,16 @@ static void srt_com_load_keys(GKeyFile *kf)
 
 	if (error)
 		g_error(error->message);
+
+	/* optional */
+	if (g_key_file_has_key(kf, "Serial", "timeout", NULL))
+		srt_timeout_sec = g_key_file_get_integer(kf, "Serial",
+							 "timeout", NULL);
+
+	if (g_key_file_has_key(kf, "Serial", "spec_timeout", NULL))
+		srt_spec_timeout_sec = g_key_file_get_integer(kf, "Serial",
+							      "spec_timeout",
+							      NULL);
 }
 
 
@@ -388,62 +210,215 @@ int srt_com_load_config(void)
 
 
 /**
- * @brief read from the shared link
- * @note this blocks until one line has been read
+ * @brief run a command on the serial link and read the response
+ *
+ * @param req the request
+ *
+ * @note the response is always NUL-terminated and may be empty if the
+ *	 link timed out
+ */
+
+static void srt_com_exec(struct comlink_req *req)
+{
+	gssize n;
+
+
+	/* whatever arrived when noone listened is not the response */
+	serial_flush(com_link, 0);
+
+	/* always write a newline first, or the device might not detect
+	 * the command
+	 */
+	serial_write(com_link, " \n", 2, SRT_COM_WRITE_TIMEOUT_MS);
+	serial_write(com_link, req->cmd, req->len, SRT_COM_WRITE_TIMEOUT_MS);
+
+	/* "freq" commands start with a \0 and are answered with raw data,
+	 * everything else with a line
+	 */
+	if (req->cmd[0] == '\0') {
+		req->rsp = g_malloc0(SRT_SPEC_MSG_LEN + 1);
+		n = serial_read(com_link, req->rsp, SRT_SPEC_MSG_LEN,
+				srt_spec_timeout_sec * 1000);
+
+		if (n != SRT_SPEC_MSG_LEN)
+			g_warning(MSG "Expected %d bytes, but got %zd",
+				  SRT_SPEC_MSG_LEN, n);
+	} else {
+		req->rsp = g_malloc0(SRT_COM_LINE_MAX);
+		n = serial_read_line(com_link, req->rsp, SRT_COM_LINE_MAX,
+				     srt_timeout_sec * 1000);
+	}
+
+	req->rsp_len = (gsize) MAX(n, 0);
+}
+
+
+/**
+ * @brief log the queue statistics
+ *
+ * @note call with the queue locked
  */
 
-G_MODULE_EXPORT
-gchar *be_shared_comlink_read(gsize *nbytes)
+static void srt_com_log_stats(void)
 {
-	gchar *tmp;
+	int i;
 
+	const gchar *name[COMLINK_CLASS_N] = {"drive", "spectrometer"};
 
-	g_mutex_lock(&readmutex);
 
-	g_debug(MSG "waiting for serial response");
-	g_cond_wait(&cond, &readmutex);
+	for (i = 0; i < COMLINK_CLASS_N; i++) {
 
+		if (!queue.st[i].n)
+			continue;
 
-	tmp = line;
-	(*nbytes) = line_len;
+		g_message(MSG "%s requests: %" G_GUINT64_FORMAT " served, "
+			  "%" G_GUINT64_FORMAT " expired, queue wait avg/max "
+			  "%.1f/%.1f ms", name[i],
+			  queue.st[i].n - queue.st[i].n_expired,
+			  queue.st[i].n_expired,
+			  (gdouble) queue.st[i].wait_sum_us * 1e-3 /
+			  (gdouble) queue.st[i].n,
+			  (gdouble) queue.st[i].wait_max_us * 1e-3);
+	}
+
+	serial_log_stats(com_link);
+}
+
+
+/**
+ * @brief thread function that executes the queued requests
+ *
+ * @note the most urgent class is always served first; as a transaction on
+ *	 the link cannot be interrupted, a drive command issued during a
+ *	 spectrometer sweep waits at most for the current step to complete
+ */
+
+static gpointer srt_com_dispatch_thread(gpointer data)
+{
+	int i;
+
+	gint64 now;
+	gint64 wait;
+
+	struct comlink_req *req;
+
+
+	g_mutex_lock(&queue.lock);
+
+	while (1) {
+
+		req = NULL;
+
+		for (i = 0; i < COMLINK_CLASS_N && !req; i++)
+			req = g_queue_pop_head(&queue.q[i]);
+
+		if (!req) {
+			g_cond_wait(&queue.work, &queue.lock);
+			continue;
+		}
+
+		now  = g_get_monotonic_time();
+		wait = now - req->t_enq;
 
-	/* we have it, now clear the line pointer */
-	line = NULL;
+		queue.st[req->cls].n++;
+		queue.st[req->cls].wait_sum_us += wait;
+		if (wait > queue.st[req->cls].wait_max_us)
+			queue.st[req->cls].wait_max_us = wait;
 
-	g_mutex_unlock(&readmutex);
+		if (now > req->deadline) {
+			/* too late, the requester has moved on */
+			queue.st[req->cls].n_expired++;
+			req->rsp = g_malloc0(1);
+			req->rsp_len = 0;
+		} else {
+			g_mutex_unlock(&queue.lock);
+			srt_com_exec(req);
+			req->exec_us = g_get_monotonic_time() - now;
+			g_mutex_lock(&queue.lock);
+		}
 
-	return tmp;
+		req->done = TRUE;
+		g_cond_broadcast(&queue.done);
+
+		if (now - queue.t_report > (gint64) SRT_COM_STATS_INTERVAL_SEC *
+					   G_USEC_PER_SEC) {
+			queue.t_report = now;
+			srt_com_log_stats();
+		}
+	}
+
+	g_mutex_unlock(&queue.lock);
+
+	return NULL;
 }
 
 
 /**
- * @brief write on the shared link
+ * @brief send a command on the shared link and wait for the response
  *
+ * @param cls the class of the request, determines its priority
+ * @param buf the command
+ * @param nbytes the length of the command
+ * @param timeout_ms the time the request may wait for its turn, -1 for no
+ *	  limit; an expired request is not sent and gets an empty response
+ * @param[out] rsp_len the number of bytes in the response
+ * @param[out] exec_ms the time the command took on the link, excluding the
+ *	       time it was queued; may be NULL
+ *
+ * @returns the response, always NUL-terminated, g_free() when done
  */
 
 G_MODULE_EXPORT
-int be_shared_comlink_write(const gchar *buf, gsize nbytes)
+gchar *be_shared_comlink_xfer(enum comlink_class cls,
+			      const gchar *buf, gsize nbytes,
+			      gint timeout_ms, gsize *rsp_len,
+			      gdouble *exec_ms)
 {
-	/* switch between line termination read and binary read
-	 * based on the last command written
-	 * (note: "freq" commands start with a \0
-	 */
-	if (buf[0] == '\0')
-		raw_read = TRUE;
+	struct comlink_req req = {0};
+
+
+	if (cls >= COMLINK_CLASS_N)
+		cls = COMLINK_CLASS_N - 1;
+
+	req.cls   = cls;
+	req.cmd   = buf;
+	req.len   = nbytes;
+	req.t_enq = g_get_monotonic_time();
+
+	if (timeout_ms < 0)
+		req.deadline = G_MAXINT64;
 	else
-		raw_read = FALSE;
+		req.deadline = req.t_enq + (gint64) timeout_ms * 1000;
+
+	g_mutex_lock(&queue.lock);
+
+	g_queue_push_tail(&queue.q[cls], &req);
+	g_cond_signal(&queue.work);
+
+	while (!req.done)
+		g_cond_wait(&queue.done, &queue.lock);
+
+	g_mutex_unlock(&queue.lock);
 
-	return srt_com_serial_write(fd, buf, nbytes, 0);
+	(*rsp_len) = req.rsp_len;
+
+	if (exec_ms)
+		(*exec_ms) = (gdouble) req.exec_us * 1e-3;
+
+	return req.rsp;
 }
 
+
 /**
  * @brief acquire exclusive use of shared link
+ *
+ * @note this only keeps sequences of commands from being interleaved with
+ *	 other sequences, single requests need not hold the link
  */
 
 G_MODULE_EXPORT
 void be_shared_comlink_acquire(void)
 {
-	g_usleep(1000.0);
 	g_mutex_lock(&linkmutex);
 	g_debug(MSG "shared comlink acquired");
 }
@@ -475,15 +450,13 @@ void module_extra_init(void)
 {
         g_message(MSG "configuring serial link");
 
-	fd = srt_com_serial_open_port(srt_tty);
-	if (!fd)
+	com_link = serial_open(srt_tty, SRT_COM_BAUD);
+	if (!com_link)
 		g_error(MSG "Error opening serial port %s\n", srt_tty);
 
-	if (srt_com_serial_set_comm_param(fd))
-		g_error(MSG "Error setting parameters for serial port %s\n",
-			srt_tty);
+	queue.t_report = g_get_monotonic_time();
 
-	srt_com_serial_init_glib_poll(fd);
+	g_thread_new(NULL, srt_com_dispatch_thread, NULL);
 }
 
 
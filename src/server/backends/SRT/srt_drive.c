@@ -29,6 +29,8 @@
 #include <math.h>
 #include <backend.h>
 #include <ack.h>
+#include <eta.h>
+#include <pos_pub.h>
 
 #include <net.h>
 
@@ -38,6 +40,23 @@
 #define DEG(x) ((x) / G_PI * 180.0)
 #define RAD(x) ((x) * G_PI / 180.0)
 
+/* slew time models in ms per count, these are refined with every move */
+#define SRT_DRIVE_ETA_AZ	0
+#define SRT_DRIVE_ETA_EL	1
+
+static const gdouble srt_drive_eta_init[] = {174.1202, 304.33578};
+
+static struct eta_model *srt_drive_eta;
+static struct pos_pub *srt_drive_pub;
+
+/* moves shorter than this are dominated by the command overhead and do not
+ * go into the slew time models
+ */
+#define SRT_DRIVE_ETA_MIN_CNT	10
+
+/* worst-case counts for a move from an unknown position */
+#define SRT_DRIVE_ETA_UNKNOWN_CNT	5000.
+
 static GThread *thread;
 static GCond cond;
 static GMutex mutex;
@@ -114,7 +133,7 @@ static struct {
 
 
 
-static void srt_drive_notify_pos_update(void);
+static void srt_drive_notify_pos_update(gboolean arrived);
 
 
 /**
@@ -678,10 +697,13 @@ static int srt_drive_get_el_motor_id(double cnts)
  * @brief command the drive motors via the shared com link and evaluate
  *	  the response
  *
+ * @param cmd the command
+ * @param[out] exec_ms the time the command took on the link, may be NULL
+ *
  * @return total number of counts + halfcounts driven (see also SRT MEMO #022)
  */
 
-static double srt_drive_motor_cmd_eval(gchar *cmd)
+static double srt_drive_motor_cmd_eval(gchar *cmd, gdouble *exec_ms)
 {
 	gsize len;
 
@@ -698,9 +720,8 @@ static double srt_drive_motor_cmd_eval(gchar *cmd)
 	g_debug(MSG "CMD: %s", cmd);
 
 
-	be_shared_comlink_write(cmd, strlen(cmd));
-
-	response = be_shared_comlink_read(&len);
+	response = be_shared_comlink_xfer(COMLINK_DRIVE, cmd, strlen(cmd),
+					  -1, &len, exec_ms);
 
 	if (sscanf(response, "%c %d %d %d", &c, &cnts, &f1, &f2) != 4)
 		g_warning(MSG, "error scanning com link response: %s", response);
@@ -737,6 +758,22 @@ static double srt_drive_motor_cmd_eval(gchar *cmd)
 }
 
 
+/**
+ * @brief estimate the duration of a move
+ *
+ * @param az_cnt the counts to move in azimuth
+ * @param el_cnt the counts to move in elevation
+ *
+ * @returns the estimated duration in ms
+ */
+
+static double srt_drive_eta_msec(double az_cnt, double el_cnt)
+{
+	return eta_model_get(srt_drive_eta, SRT_DRIVE_ETA_AZ) * fabs(az_cnt) +
+	       eta_model_get(srt_drive_eta, SRT_DRIVE_ETA_EL) * fabs(el_cnt);
+}
+
+
 /**
  * @brief command the drive motors
  */
@@ -748,14 +785,11 @@ static int srt_drive_cmd_motors(double *az_cnt, double *el_cnt)
 
 	gchar *cmd;
 
-	GTimer *tm;
+	gdouble exec_ms;
 
 	struct status s;
 
 
-	tm = g_timer_new();
-
-
 	g_message(MSG "rotating AZ/EL counts: %d %d", azc, elc);
 
 	/* azimuth drive */
@@ -765,12 +799,14 @@ static int srt_drive_cmd_motors(double *az_cnt, double *el_cnt)
 				      abs(azc));
 
 		s.busy = 1;
-		s.eta_msec = (typeof(s.eta_msec)) 174.1202 * fabs(*az_cnt); /** XXX add config file entry **/
+		s.eta_msec = (typeof(s.eta_msec)) srt_drive_eta_msec(*az_cnt, 0.0);
 		ack_status_slew(PKT_TRANS_ID_UNDEF, &s);
 
-		g_timer_start(tm);
-		(*az_cnt) = copysign(srt_drive_motor_cmd_eval(cmd), azc);
-		g_timer_stop(tm);
+		/* the time spent queued behind a spectrometer step is not
+		 * part of the slew time
+		 */
+		(*az_cnt) = copysign(srt_drive_motor_cmd_eval(cmd, &exec_ms),
+				     azc);
 
 		s.busy = 0;
 		s.eta_msec = 0;
@@ -781,7 +817,11 @@ static int srt_drive_cmd_motors(double *az_cnt, double *el_cnt)
 		if ((*az_cnt) == 0.0)
 			return -1;
 
-		g_message("Azimuth: %f sec/count", g_timer_elapsed(tm, NULL) / (*az_cnt));
+		g_message("Azimuth: %f sec/count", exec_ms * 1e-3 / (*az_cnt));
+
+		if (fabs(*az_cnt) >= SRT_DRIVE_ETA_MIN_CNT)
+			eta_model_update(srt_drive_eta, SRT_DRIVE_ETA_AZ,
+					 exec_ms / fabs(*az_cnt));
 	}
 
 	/* elevation drive */
@@ -792,12 +832,11 @@ static int srt_drive_cmd_motors(double *az_cnt, double *el_cnt)
 
 		/* note: assuming worst-case speed */
 		s.busy = 1;
-		s.eta_msec = (typeof(s.eta_msec)) 304.33578 * fabs(*el_cnt); /** XXX add config file entry **/
+		s.eta_msec = (typeof(s.eta_msec)) srt_drive_eta_msec(0.0, *el_cnt);
 		ack_status_slew(PKT_TRANS_ID_UNDEF, &s);
 
-		g_timer_start(tm);
-		(*el_cnt) = copysign(srt_drive_motor_cmd_eval(cmd), elc);
-		g_timer_stop(tm);
+		(*el_cnt) = copysign(srt_drive_motor_cmd_eval(cmd, &exec_ms),
+				     elc);
 
 		s.busy = 0;
 		s.eta_msec = 0;
@@ -808,10 +847,12 @@ static int srt_drive_cmd_motors(double *az_cnt, double *el_cnt)
 		if ((*el_cnt) == 0.0)
 			return -1;
 
-		g_message("Elevation: %f sec/count", g_timer_elapsed(tm, NULL) / (*el_cnt));
-	}
+		g_message("Elevation: %f sec/count", exec_ms * 1e-3 / (*el_cnt));
 
-	g_timer_destroy(tm);
+		if (fabs(*el_cnt) >= SRT_DRIVE_ETA_MIN_CNT)
+			eta_model_update(srt_drive_eta, SRT_DRIVE_ETA_EL,
+					 exec_ms / fabs(*el_cnt));
+	}
 
 	return 0;
 }
@@ -879,11 +920,11 @@ static int srt_drive_move(void)
 	az_cnt = fabs(srt_drive_az_counts(srt.pos.az_tgt) - srt.pos.az_cnts);
 	el_cnt = fabs(srt_drive_cassi_el_counts(srt.pos.el_tgt) - srt.pos.el_cnts);
 	s.busy = 1;
-	s.eta_msec = (typeof(s.eta_msec)) 174.1202 * az_cnt + 304.33578 * el_cnt; /** XXX config file! **/
+	s.eta_msec = (typeof(s.eta_msec)) srt_drive_eta_msec(az_cnt, el_cnt);
 	ack_status_move(PKT_TRANS_ID_UNDEF, &s);
 
 
-	srt_drive_notify_pos_update();
+	srt_drive_notify_pos_update(FALSE);
 
 	g_message(MSG "now at telescope AZ/EL: %g %g",
 		  srt_drive_az_to_telescope_ref(srt.pos.az_cur),
@@ -920,12 +961,14 @@ static gpointer srt_drive_thread(gpointer data)
 		el_cnt = fabs(srt_drive_cassi_el_counts(srt.pos.el_tgt) - srt.pos.el_cnts);
 
 		s.busy = 1;
-		s.eta_msec = (typeof(s.eta_msec)) 174.1202 * az_cnt + 304.33578 * el_cnt; /** XXX config file! **/
+		s.eta_msec = (typeof(s.eta_msec)) srt_drive_eta_msec(az_cnt, el_cnt);
 		ack_status_move(PKT_TRANS_ID_UNDEF, &s);
 
 		/* move until complete */
 		while (srt_drive_move());
 
+		srt_drive_notify_pos_update(TRUE);
+
 		s.busy = 0;
 		s.eta_msec = 0;
 		ack_status_move(PKT_TRANS_ID_UNDEF, &s);
@@ -986,12 +1029,12 @@ static gpointer srt_park_thread(gpointer data)
 		  srt.pos.az_cnts, srt.pos.el_cnts);
 
 	s.busy = 1;
-	/** XXX config file! **/
-	msec = 174.1202 * srt.pos.az_cnts + 304.33578 * srt.pos.el_cnts;
+	msec = srt_drive_eta_msec(srt.pos.az_cnts, srt.pos.el_cnts);
 
 	/** worst-case scenario: full rotation and then some **/
 	if (msec == 0.0)
-		msec = 174.1202 * 5000. + 304.33578 * 5000.;
+		msec = srt_drive_eta_msec(SRT_DRIVE_ETA_UNKNOWN_CNT,
+					  SRT_DRIVE_ETA_UNKNOWN_CNT);
 
 	s.eta_msec = (typeof(s.eta_msec)) msec;
 	ack_status_move(PKT_TRANS_ID_UNDEF, &s);
@@ -999,7 +1042,7 @@ static gpointer srt_park_thread(gpointer data)
 
 
 	/* move to stow in azimuth */
-	if (srt_drive_motor_cmd_eval("move 0 5000\n") == 0.0) {
+	if (srt_drive_motor_cmd_eval("move 0 5000\n", NULL) == 0.0) {
 		srt.pos.az_cur  = 0.0;
 		srt.pos.az_tgt  = 0.0;
 		srt.pos.az_cnts = 0.0;
@@ -1009,7 +1052,7 @@ static gpointer srt_park_thread(gpointer data)
 
 
 	/* move to stow in elevation */
-	if (srt_drive_motor_cmd_eval("move 2 5000\n") == 0.0) {
+	if (srt_drive_motor_cmd_eval("move 2 5000\n", NULL) == 0.0) {
 		srt.pos.el_cur  = 0.0;
 		srt.pos.el_tgt = 0.0;
 		srt.pos.el_cnts = 0.0;
@@ -1020,7 +1063,7 @@ static gpointer srt_park_thread(gpointer data)
 	be_shared_comlink_release();
 	g_mutex_unlock(&mutex);
 
-	srt_drive_notify_pos_update();
+	srt_drive_notify_pos_update(TRUE);
 
 	s.busy = 0;
 	s.eta_msec = 0;
@@ -1051,12 +1094,12 @@ static gpointer srt_recal_thread(gpointer data)
 		  srt.pos.az_cnts, srt.pos.el_cnts);
 
 	s.busy = 1;
-	/** XXX config file! **/
-	msec = 174.1202 * srt.pos.az_cnts + 304.33578 * srt.pos.el_cnts;
+	msec = srt_drive_eta_msec(srt.pos.az_cnts, srt.pos.el_cnts);
 
 	/** worst-case scenario: full rotation and then some **/
 	if (msec == 0.0)
-		msec = 174.1202 * 5000. + 304.33578 * 5000.;
+		msec = srt_drive_eta_msec(SRT_DRIVE_ETA_UNKNOWN_CNT,
+					  SRT_DRIVE_ETA_UNKNOWN_CNT);
 
 	s.eta_msec = (typeof(s.eta_msec)) msec;
 	ack_status_move(PKT_TRANS_ID_UNDEF, &s);
@@ -1065,7 +1108,7 @@ static gpointer srt_recal_thread(gpointer data)
 
 	be_shared_comlink_acquire();
 	/* move to stow in azimuth */
-	if (srt_drive_motor_cmd_eval("move 0 5000\n") == 0.0) {
+	if (srt_drive_motor_cmd_eval("move 0 5000\n", NULL) == 0.0) {
 		srt.pos.az_cur  = 0.0;
 		srt.pos.az_cnts = 0.0;
 	} else {
@@ -1074,7 +1117,7 @@ static gpointer srt_recal_thread(gpointer data)
 
 
 	/* move to stow in elevation */
-	if (srt_drive_motor_cmd_eval("move 2 5000\n") == 0.0) {
+	if (srt_drive_motor_cmd_eval("move 2 5000\n", NULL) == 0.0) {
 		srt.pos.el_cur  = 0.0;
 		srt.pos.el_cnts = 0.0;
 	} else {
@@ -1124,7 +1167,7 @@ static gpointer srt_hot_load_thread(gpointer data)
 		cmd = "move 6 0\n";	/* id: 6 -> diode off */
 
 	/* toggle diode */
-	if (srt_drive_motor_cmd_eval(cmd) == 0.0)
+	if (srt_drive_motor_cmd_eval(cmd, NULL) == 0.0)
 		srt.hot_load_state = srt.hot_load_ena;
 	else
 		g_message(MSG "unexpected response while changing hot load state");
@@ -1145,23 +1188,23 @@ static gpointer srt_hot_load_thread(gpointer data)
 
 /**
  * @brief push drive position to server
+ *
+ * @param arrived TRUE if the move is complete
  */
 
-static void srt_drive_notify_pos_update(void)
+static void srt_drive_notify_pos_update(gboolean arrived)
 {
-	double az_arcsec;
-	double el_arcsec;
+	gdouble az;
+	gdouble el;
 
-	struct getpos pos;
 
+	az = srt_drive_az_to_telescope_ref(srt.pos.az_cur);
+	el = srt_drive_el_to_telescope_ref(srt.pos.el_cur);
 
-	az_arcsec = srt_drive_az_to_telescope_ref(srt.pos.az_cur) * 3600.0;
-	el_arcsec = srt_drive_el_to_telescope_ref(srt.pos.el_cur) * 3600.0;
-
-	/* emit notification */
-	pos.az_arcsec = (typeof(pos.az_arcsec)) az_arcsec;
-	pos.el_arcsec = (typeof(pos.el_arcsec)) el_arcsec;
-	ack_getpos_azel(PKT_TRANS_ID_UNDEF, &pos);
+	if (arrived)
+		pos_pub_arrived(srt_drive_pub, az, el);
+	else
+		pos_pub_push(srt_drive_pub, az, el);
 }
 
 
@@ -1252,16 +1295,58 @@ int be_getpos_azel(double *az, double *el)
 
 
 /**
- * @brief get telescope drive capabilities
+ * @brief the SRT cannot be observed while it moves
+ *
+ * @note a move occupies the shared comlink until it is complete, so
+ *	 neither the position nor a spectrum is updated in the meantime
  */
 
 G_MODULE_EXPORT
-int be_get_capabilities_drive(struct capabilities *c)
+gboolean be_drive_otf_capable(void)
+{
+	return FALSE;
+}
+
+
+/**
+ * @brief estimate the duration of a move in seconds
+ *
+ * @note the axes are driven one after the other, so their times add up;
+ *	 azimuth is mapped to the drive range, so a move across the end of
+ *	 the range is estimated the long way round, as it is executed
+ */
+
+G_MODULE_EXPORT
+gdouble be_drive_slew_time(gdouble az0, gdouble el0, gdouble az1, gdouble el1)
+{
+	gdouble az_cnt;
+	gdouble el_cnt;
+
+
+	az0 = srt_drive_az_to_drive_ref(srt_drive_map_az(az0));
+	az1 = srt_drive_az_to_drive_ref(srt_drive_map_az(az1));
+	el0 = srt_drive_el_to_drive_ref(el0);
+	el1 = srt_drive_el_to_drive_ref(el1);
+
+	az_cnt = srt_drive_az_counts(az1) - srt_drive_az_counts(az0);
+	el_cnt = srt_drive_cassi_el_counts(el1) - srt_drive_cassi_el_counts(el0);
+
+	return srt_drive_eta_msec(az_cnt, el_cnt) * 0.001;
+}
+
+
+/**
+ * @brief get the resolution of the drive
+ *
+ * @param[out] az_res the azimuth resolution in degrees
+ * @param[out] el_res the mean elevation resolution in degrees
+ */
+
+static void srt_drive_get_res(double *az_res, double *el_res)
 {
 	double el_drive_min;
 	double el_drive_max;
 	double el_drive_cnt;
-	double el_drive_res;
 
 
 	el_drive_min = srt_drive_el_to_drive_ref(srt.el_limits.lower);
@@ -1270,16 +1355,31 @@ int be_get_capabilities_drive(struct capabilities *c)
 	el_drive_cnt = srt_drive_cassi_el_counts(el_drive_max)
 		     - srt_drive_cassi_el_counts(el_drive_min);
 
-	el_drive_res = (el_drive_max - el_drive_min) / el_drive_cnt;
+	(*az_res) = 1.0 / srt.az_counts_per_deg;
+	(*el_res) = (el_drive_max - el_drive_min) / el_drive_cnt;
+}
 
 
+/**
+ * @brief get telescope drive capabilities
+ */
+
+G_MODULE_EXPORT
+int be_get_capabilities_drive(struct capabilities *c)
+{
+	double az_res;
+	double el_res;
+
+
+	srt_drive_get_res(&az_res, &el_res);
+
 	c->az_min_arcsec = (int32_t) (3600.0 * srt.az_limits.left);
 	c->az_max_arcsec = (int32_t) (3600.0 * srt.az_limits.right);
-	c->az_res_arcsec = (int32_t) (3600.0 / srt.az_counts_per_deg);
+	c->az_res_arcsec = (int32_t) (3600.0 * az_res);
 
 	c->el_min_arcsec = (int32_t) (3600.0 * srt.el_limits.lower);
 	c->el_max_arcsec = (int32_t) (3600.0 * srt.el_limits.upper);
-	c->el_res_arcsec = (int32_t) (3600.0 * el_drive_res);
+	c->el_res_arcsec = (int32_t) (3600.0 * el_res);
 
 	return 0;
 }
@@ -1292,28 +1392,19 @@ int be_get_capabilities_drive(struct capabilities *c)
 G_MODULE_EXPORT
 int be_get_capabilities_load_drive(struct capabilities_load *c)
 {
-	double el_drive_min;
-	double el_drive_max;
-	double el_drive_cnt;
-	double el_drive_res;
-
-
-	el_drive_min = srt_drive_el_to_drive_ref(srt.el_limits.lower);
-	el_drive_max = srt_drive_el_to_drive_ref(srt.el_limits.upper);
-
-	el_drive_cnt = srt_drive_cassi_el_counts(el_drive_max)
-		     - srt_drive_cassi_el_counts(el_drive_min);
+	double az_res;
+	double el_res;
 
-	el_drive_res = (el_drive_max - el_drive_min) / el_drive_cnt;
 
+	srt_drive_get_res(&az_res, &el_res);
 
 	c->az_min_arcsec = (int32_t) (3600.0 * srt.az_limits.left);
 	c->az_max_arcsec = (int32_t) (3600.0 * srt.az_limits.right);
-	c->az_res_arcsec = (int32_t) (3600.0 / srt.az_counts_per_deg);
+	c->az_res_arcsec = (int32_t) (3600.0 * az_res);
 
 	c->el_min_arcsec = (int32_t) (3600.0 * srt.el_limits.lower);
 	c->el_max_arcsec = (int32_t) (3600.0 * srt.el_limits.upper);
-	c->el_res_arcsec = (int32_t) (3600.0 * el_drive_res);
+	c->el_res_arcsec = (int32_t) (3600.0 * el_res);
 
 	c->hot_load = (uint32_t) (srt.hot_load_temp * 1000.0);
 
@@ -1379,6 +1470,9 @@ void module_extra_init(void)
 G_MODULE_EXPORT
 const gchar *g_module_check_init(void)
 {
+	double az_res;
+	double el_res;
+
 
         g_message(MSG "initialising module");
 
@@ -1389,6 +1483,15 @@ const gchar *g_module_check_init(void)
 	srt_drive_cassi_set_pushdrod_zero_len_counts();
 	srt_drive_set_az_center();
 
-	
+	srt_drive_eta = eta_model_new("srt_drive",
+				      G_N_ELEMENTS(srt_drive_eta_init),
+				      srt_drive_eta_init);
+
+	/* not via be_get_capabilities_drive(), which would resolve to the
+	 * server's wrapper, as the plugin is not registered yet
+	 */
+	srt_drive_get_res(&az_res, &el_res);
+	srt_drive_pub = pos_pub_new(fabs(az_res), fabs(el_res));
+
 	return NULL;
 }
@@ -34,6 +34,8 @@
 #include <backend.h>
 #include <cmd.h>
 #include <ack.h>
+#include <eta.h>
+#include <cfg_snap.h>
 
 
 #define MSG "SRT SPEC: "
@@ -62,6 +64,16 @@
 #define SRT_INIT_NSTACK			 1
 
 
+/* initial duration of a raw spectrum acquisition in ms per bw_div, these are
+ * refined with every acquisition
+ */
+static const gdouble srt_spec_eta_init[SRT_DIGITAL_BW_DIV_MAX + 1] = {
+	2389.112, 2908.880, 3957.814
+};
+
+static struct eta_model *srt_spec_eta;
+
+
 
 /**
  * @brief the configuration of the digital spectrometer
@@ -142,11 +154,10 @@ struct observation {
 static GThread *thread;
 static GCond	acq_cond;
 static GMutex   acq_lock;
-static GMutex   acq_abort;
 static GMutex   acq_pause;
-static GRWLock  obs_rwlock;
 
-static struct observation g_obs;
+/* the current observation, see srt_acquisition_update() */
+static struct cfg_snap *obs_snap;
 
 
 
@@ -524,7 +535,7 @@ static guint16 *srt_spec_acquire_raw(guint32 refdiv, int mode, gsize *len)
 
 	guint16 *response;
 
-	GTimer *timer;
+	gdouble exec_ms;
 
 	struct status s;
 
@@ -538,46 +549,30 @@ static guint16 *srt_spec_acquire_raw(guint32 refdiv, int mode, gsize *len)
 			      mode);
 
 
-
-	timer = g_timer_new();
-
-
-	be_shared_comlink_acquire();
-
 	s.busy = 1;
-	switch (mode) {
-		case 0:
-			s.eta_msec = (typeof(s.eta_msec)) 2389.112;
-			break;
-		case 1:
-			s.eta_msec = (typeof(s.eta_msec)) 2908.880;
-			break;
-		case 2:
-			s.eta_msec = (typeof(s.eta_msec)) 3957.814;
-			break;
-	}
-
+	s.eta_msec = (typeof(s.eta_msec)) eta_model_get(srt_spec_eta, mode);
 	ack_status_acq(PKT_TRANS_ID_UNDEF, &s);
 
-	g_timer_start(timer);
-	/* give size explicitly, as command starts with '\0' */
-	be_shared_comlink_write(cmd, 9);
-
+	/* give size explicitly, as command starts with '\0'; the link is not
+	 * held across the acquisition, so drive commands can go first
+	 * between two steps of a sweep; the time spent waiting for a drive
+	 * command is not part of the acquisition time
+	 */
+	response = (guint16 *) be_shared_comlink_xfer(COMLINK_SPEC, cmd, 9,
+						      -1, len, &exec_ms);
 	/* actual raw data is 16 bit unsigned @128 bytes total */
-	response = (guint16 *) be_shared_comlink_read(len);
-	g_timer_stop(timer);
 
 	s.busy = 0;
 	s.eta_msec = 0;
 	ack_status_acq(PKT_TRANS_ID_UNDEF, &s);
 
-	be_shared_comlink_release();
-
 
 	g_message(MSG "raw spectrum acquisition time: %f sec %d bwdiv",
-		     g_timer_elapsed(timer, NULL), g_timer_elapsed(timer, NULL), mode);
+		     exec_ms * 1e-3, mode);
 
-	g_timer_destroy(timer);
+	/* a short read is no measure of the acquisition time */
+	if ((*len) == SRT_DIGITAL_BINS * sizeof(typeof(*response)))
+		eta_model_update(srt_spec_eta, mode, exec_ms);
 
 	/* len is in bytes, we need elements */
 	(*len) /= sizeof(typeof(*response));
@@ -1198,38 +1193,46 @@ static void srt_comp_obs_strategy_dealloc(struct acq_strategy **acs, gsize n)
  * @todo polynomial preamp/inputfilter curve calibration
  */
 
-static void srt_apply_temp_calibration(struct spec_data *s)
+static void srt_apply_temp_calibration(uint32_t *spec, gsize n)
 {
 	gsize i;
 
 
-	for (i = 0; i < s->n; i++)
-		s->spec[i] = (uint32_t) ((double) s->spec[i] * 1000.0) * srt.temp_cal_factor;
+	for (i = 0; i < n; i++)
+		spec[i] = (uint32_t) ((double) spec[i] * 1000.0) * srt.temp_cal_factor;
 
 }
 
+
 /**
  * @brief acquire spectrea
  *
- * @param acq the acquisition configuration
+ * @param obs the observation
+ * @param acq_left the number of acquisitions left
  * @returns 0 on completion, 1 if more acquisitions are pending
  *
+ * @note if the sweep takes more than one step, the bins of each step are sent
+ *	 as a segment as soon as the step completes, so clients see data after
+ *	 a single step rather than after the whole sweep; the full spectrum is
+ *	 assembled by the client
  */
 
-static uint32_t srt_spec_acquire(struct observation *obs)
+static uint32_t srt_spec_acquire(const struct observation *obs,
+				 uint32_t *acq_left)
 {
 	int i, j;
 
 
 	struct status st;
 
-
+	static guint32 sweep_id;
 
 	const struct acq_strategy *acs = obs->acs;
 	const gsize n                  = obs->n_acs;
 
-	guint16 **raw = NULL;
+	guint16 *raw = NULL;
 	gsize    len;
+	gsize    off;
 	gsize    total = 0;
 
 
@@ -1238,63 +1241,42 @@ static uint32_t srt_spec_acquire(struct observation *obs)
 	uint32_t *p;
 
 
-	if (!obs->acq.acq_max)
+	if (!(*acq_left))
 		return 0;
 
 
-	raw = g_malloc0(n * sizeof(*raw));
-	if (!raw) {
-		g_error(MSG "memory allocation of %d elements failed: %s:%d",
-			n, __func__, __LINE__);
-		return 0;
-	}
+	for (i = 0; i < n; i++)
+		total += acs[i].nbins;
 
+	/* prepare: allocate full length */
+	s = g_malloc0(sizeof(struct spec_data) + total * sizeof(uint32_t));
 
-	st.busy = 1;
-	switch (obs->acq.bw_div) {
-		case 0:
-			st.eta_msec = (typeof(st.eta_msec)) 2389.112;
-			break;
-		case 1:
-			st.eta_msec = (typeof(st.eta_msec)) 2908.880;
-			break;
-		case 2:
-			st.eta_msec = (typeof(st.eta_msec)) 3957.814;
-			break;
-	}
+	s->freq_min_hz = (typeof(s->freq_min_hz)) acs[0].fq[acs[0].offset];
+	s->freq_max_hz = (typeof(s->freq_max_hz)) acs[n - 1].fq[acs[n - 1].offset + acs[n - 1].nbins];
+	s->freq_inc_hz = (typeof(s->freq_inc_hz)) srt_get_bin_bw(obs->acq.bw_div);
+
+	sweep_id++;
 
-	st.eta_msec *= n;
+
+	st.busy = 1;
+	st.eta_msec = (typeof(st.eta_msec)) (eta_model_get(srt_spec_eta, obs->acq.bw_div) * n);
 	ack_status_rec(PKT_TRANS_ID_UNDEF, &st);
 
 	for (i = 0; i < n; i++) {
 
 #if 1
 		st.busy = 1;
-		switch (obs->acq.bw_div) {
-			case 0:
-				st.eta_msec = (typeof(st.eta_msec)) 2389.112;
-				break;
-			case 1:
-				st.eta_msec = (typeof(st.eta_msec)) 2908.880;
-				break;
-			case 2:
-				st.eta_msec = (typeof(st.eta_msec)) 3957.814;
-				break;
-		}
-
-		st.eta_msec *= (n - i);
+		st.eta_msec = (typeof(st.eta_msec)) (eta_model_get(srt_spec_eta, obs->acq.bw_div) * (n - i));
 		ack_status_rec(PKT_TRANS_ID_UNDEF, &st);
 #endif
 
-		if (!g_mutex_trylock(&acq_abort)) {
+		if (!cfg_snap_is_current(obs_snap, obs)) {
 			g_message(MSG "acquisition loop abort indicated");
 			goto cleanup;
 		}
 
-		g_mutex_unlock(&acq_abort);
-
-		raw[i] = srt_spec_acquire_raw(acs[i].refdiv,
-					      obs->acq.bw_div, &len);
+		raw = srt_spec_acquire_raw(acs[i].refdiv,
+					   obs->acq.bw_div, &len);
 
 		if (len != SRT_DIGITAL_BINS) {
 			g_message(MSG "raw data size mismatch in %s: %d "
@@ -1303,29 +1285,17 @@ static uint32_t srt_spec_acquire(struct observation *obs)
 			goto cleanup;
 		}
 
-		srt_spec_prepare_raw(raw[i], len);
-
-		total += len;
-	}
-
+		srt_spec_prepare_raw(raw, len);
 
+		/* add the selected bins of the raw spectrum to the sweep */
+		off = s->n;
+		p   = &s->spec[off];
 
-	/* prepare and send: allocate full length */
-	s = g_malloc0(sizeof(struct spec_data) + total * sizeof(uint32_t));
-
-	s->freq_min_hz = (typeof(s->freq_min_hz)) acs[0].fq[acs[0].offset];
-	s->freq_max_hz = (typeof(s->freq_max_hz)) acs[n - 1].fq[acs[n - 1].offset + acs[n - 1].nbins];
-	s->freq_inc_hz = (typeof(s->freq_inc_hz)) srt_get_bin_bw(obs->acq.bw_div);
-
-
-	/* construct final spectrum from the selected bins of each raw spectrum */
-	p = s->spec;
-	for (i = 0; i < n; i++) {
 		for (j = 0; j < acs[i].nbins; j++) {
 			/* XXX YUCK! I do this here for now, but the spectrum
 			 * preparation really needs some refactoring...
 			 */
-			(*p) = (uint32_t)  raw[i][j + srt.bin_cut_lo + acs[i].offset];
+			(*p) = (uint32_t)  raw[j + srt.bin_cut_lo + acs[i].offset];
 #if 1
 			if (acs[i].cal) 
 				(*p) = (uint32_t) (acs[i].cal[j] * (gdouble) (*p));
@@ -1334,29 +1304,35 @@ static uint32_t srt_spec_acquire(struct observation *obs)
 
 			s->n++;
 		}
+
+		srt_apply_temp_calibration(&s->spec[off], s->n - off);
+
+		if (n > 1)
+			ack_spec_data_seg(PKT_TRANS_ID_UNDEF, s, sweep_id,
+					  i, n, total, off, s->n - off);
+
+		g_free(raw);
+		raw = NULL;
 	}
 
-	srt_apply_temp_calibration(s);
 
 	/* handover for transmission */
-	ack_spec_data(PKT_TRANS_ID_UNDEF, s);
+	if (n == 1)
+		ack_spec_data(PKT_TRANS_ID_UNDEF, s);
 
 	st.busy = 0;
 	st.eta_msec = 0;
 	ack_status_rec(PKT_TRANS_ID_UNDEF, &st);
 
-	obs->acq.acq_max--;
+	(*acq_left)--;
 
 cleanup:
 
-	for (i = 0; i < n; i++)
-		g_free(raw[i]);
-
 	g_free(raw);
 	g_free(s);
 
 
-	return obs->acq.acq_max;
+	return (*acq_left);
 }
 
 
@@ -1444,12 +1420,20 @@ static void srt_spec_acq_enable(gboolean mode)
 
 /**
  * @brief thread function that does all the spectrum readout work
+ *
+ * @note the newest observation is picked up before every sweep, the count
+ *	 of acquisitions starts over with each one
  */
 
 static gpointer srt_spec_thread(gpointer data)
 {
 	int run;
 
+	uint32_t acq_left = 0;
+
+	struct observation *obs = NULL;
+
+
 	while (1) {
 
 		g_mutex_lock(&acq_lock);
@@ -1468,9 +1452,16 @@ static gpointer srt_spec_thread(gpointer data)
 
 			g_mutex_unlock(&acq_pause);
 
-			g_rw_lock_reader_lock(&obs_rwlock);
-			run = srt_spec_acquire(&g_obs);
-			g_rw_lock_reader_unlock(&obs_rwlock);
+			if (!cfg_snap_is_current(obs_snap, obs)) {
+				cfg_snap_put(obs_snap, obs);
+				obs = cfg_snap_get(obs_snap);
+				acq_left = obs ? obs->acq.acq_max : 0;
+			}
+
+			if (obs)
+				run = srt_spec_acquire(obs, &acq_left);
+			else
+				run = 0;
 		} while (run);
 
 
@@ -1480,34 +1471,33 @@ static gpointer srt_spec_thread(gpointer data)
 
 
 /**
- * @brief thread function to update the acquisition information
+ * @brief release the acquisition strategy of an observation
  */
 
-static gpointer srt_acquisition_update(gpointer data)
+static void srt_obs_clear(gpointer data)
 {
-	struct observation *obs;
-
-
-	obs = (struct observation *) data;
+	struct observation *obs = (struct observation *) data;
 
 
-	/* wait for mutex lock to indicate abort to a single acquisition cycle
-	 * this is needed if a very wide frequency span had been selected
-	 */
-	g_mutex_lock(&acq_abort);
+	srt_comp_obs_strategy_dealloc(&obs->acs, obs->n_acs);
+}
 
-	g_rw_lock_writer_lock(&obs_rwlock);
 
-	memcpy(&g_obs.acq, &obs->acq, sizeof(struct spec_acq_cfg));
+/**
+ * @brief publish a new observation
+ *
+ * @note a sweep in progress is aborted at its next step, the acquisition
+ *	 thread then picks up the new observation
+ */
 
-	srt_comp_obs_strategy_dealloc(&g_obs.acs, g_obs.n_acs);
+static void srt_acquisition_update(struct observation *obs)
+{
+	struct spec_acq_cfg acq;
 
-	g_obs.n_acs = obs->n_acs;
-	g_obs.acs   = obs->acs;
 
-	g_rw_lock_writer_unlock(&obs_rwlock);
+	memcpy(&acq, &obs->acq, sizeof(struct spec_acq_cfg));
 
-	g_mutex_unlock(&acq_abort);
+	cfg_snap_publish(obs_snap, obs);
 
 	/* signal the acquisition thread outer loop */
 	if (g_mutex_trylock(&acq_lock)) {
@@ -1516,9 +1506,7 @@ static gpointer srt_acquisition_update(gpointer data)
 	}
 
 	/* push current configuration to clients */
-	ack_spec_acq_cfg(PKT_TRANS_ID_UNDEF, &g_obs.acq);
-
-	g_free(data);
+	ack_spec_acq_cfg(PKT_TRANS_ID_UNDEF, &acq);
 }
 
 
@@ -1547,7 +1535,7 @@ static int srt_spec_acquisition_configure(struct spec_acq_cfg *acq)
 		      acq->acq_max);
 
 
-	obs = g_malloc(sizeof(struct observation));
+	obs = cfg_snap_alloc(sizeof(struct observation));
 	if (!obs) {
 		g_error(MSG "memory allocation failed: %s: %d",
 			__func__, __LINE__);
@@ -1559,10 +1547,7 @@ static int srt_spec_acquisition_configure(struct spec_acq_cfg *acq)
 
 	obs->n_acs = srt_comp_obs_strategy(&obs->acq, &obs->acs);
 
-	/* create new thread to update acquisition thread, so we don't
-	 * lock down the main loop
-	 */
-	g_thread_new(NULL, srt_acquisition_update, (gpointer) obs);
+	srt_acquisition_update(obs);
 
 
 	/* XXX: send return packet with actual configuration */
@@ -1586,7 +1571,7 @@ static void srt_spec_cfg_defaults(void)
 	struct observation *obs;
 
 
-	obs = g_malloc(sizeof(struct observation));
+	obs = cfg_snap_alloc(sizeof(struct observation));
 	if (!obs) {
 		g_error(MSG "memory allocation failed: %s: %d",
 			__func__, __LINE__);
@@ -1602,7 +1587,7 @@ static void srt_spec_cfg_defaults(void)
 
 	obs->n_acs = srt_comp_obs_strategy(&obs->acq, &obs->acs);
 
-	g_thread_new(NULL, srt_acquisition_update, (gpointer) obs);
+	srt_acquisition_update(obs);
 }
 
 
@@ -1627,10 +1612,19 @@ int be_spec_acq_cfg(struct spec_acq_cfg *acq)
 G_MODULE_EXPORT
 int be_spec_acq_cfg_get(struct spec_acq_cfg *acq)
 {
+	struct observation *obs;
+
+
 	if (!acq)
 		return -1;
 
-	memcpy(acq, &g_obs.acq, sizeof(struct spec_acq_cfg));
+	obs = cfg_snap_get(obs_snap);
+	if (!obs)
+		return -1;
+
+	memcpy(acq, &obs->acq, sizeof(struct spec_acq_cfg));
+
+	cfg_snap_put(obs_snap, obs);
 
 	return 0;
 }
@@ -1737,5 +1731,10 @@ const gchar *g_module_check_init(void)
 
 	srt_spec_load_calibration();
 
+	srt_spec_eta = eta_model_new("srt_spec", ARRAY_SIZE(srt_spec_eta_init),
+				     srt_spec_eta_init);
+
+	obs_snap = cfg_snap_new(srt_obs_clear);
+
 	return NULL;
 }
@@ -0,0 +1,158 @@
+/**
+ * @file    server/cfg_snap.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief configuration snapshots for the backends
+ *
+ * @note a snapshot is a reference counted configuration that is never
+ *	 modified once published; publishing replaces the current snapshot,
+ *	 while readers keep using the one they hold until they let it go, so
+ *	 a new configuration never waits for a running acquisition
+ *
+ * @note the lock only covers taking a reference to the current snapshot or
+ *	 replacing it, never the use of a snapshot; whether a snapshot is still
+ *	 the current one is checked without it
+ */
+
+#include <cfg_snap.h>
+
+
+struct cfg_snap {
+	gpointer cur;			/* the current snapshot */
+	GDestroyNotify clear;		/* releases the contents of a snapshot */
+
+	GMutex lock;
+};
+
+
+/**
+ * @brief create a snapshot cell
+ *
+ * @param clear a function to release the contents of a snapshot before it is
+ *	  freed, may be NULL
+ *
+ * @returns the snapshot cell, initially empty
+ */
+
+struct cfg_snap *cfg_snap_new(GDestroyNotify clear)
+{
+	struct cfg_snap *s;
+
+
+	s = g_malloc0(sizeof(struct cfg_snap));
+
+	s->clear = clear;
+
+	g_mutex_init(&s->lock);
+
+	return s;
+}
+
+
+/**
+ * @brief allocate a zeroed snapshot
+ *
+ * @param size the size of the configuration
+ *
+ * @returns the snapshot, to be filled in and published
+ */
+
+gpointer cfg_snap_alloc(gsize size)
+{
+	return g_atomic_rc_box_alloc0(size);
+}
+
+
+/**
+ * @brief publish a snapshot as the current configuration
+ *
+ * @param s the snapshot cell
+ * @param data a snapshot from cfg_snap_alloc(); the cell takes over the
+ *	  reference and the snapshot must not be modified from here on
+ */
+
+void cfg_snap_publish(struct cfg_snap *s, gpointer data)
+{
+	gpointer old;
+
+
+	g_mutex_lock(&s->lock);
+
+	old = s->cur;
+	g_atomic_pointer_set(&s->cur, data);
+
+	g_mutex_unlock(&s->lock);
+
+	if (old)
+		cfg_snap_put(s, old);
+}
+
+
+/**
+ * @brief get a reference to the current snapshot
+ *
+ * @param s the snapshot cell
+ *
+ * @returns the snapshot or NULL if none was published yet
+ *
+ * @note release the reference with cfg_snap_put()
+ */
+
+gpointer cfg_snap_get(struct cfg_snap *s)
+{
+	gpointer data;
+
+
+	g_mutex_lock(&s->lock);
+
+	data = s->cur;
+	if (data)
+		g_atomic_rc_box_acquire(data);
+
+	g_mutex_unlock(&s->lock);
+
+	return data;
+}
+
+
+/**
+ * @brief release a reference to a snapshot
+ *
+ * @param s the snapshot cell
+ * @param data the snapshot, may be NULL
+ */
+
+void cfg_snap_put(struct cfg_snap *s, gpointer data)
+{
+	if (!data)
+		return;
+
+	g_atomic_rc_box_release_full(data, s->clear);
+}
+
+
+/**
+ * @brief check whether a snapshot is the current one
+ *
+ * @param s the snapshot cell
+ * @param data a snapshot the caller holds a reference to, may be NULL
+ *
+ * @returns TRUE if nothing newer was published
+ *
+ * @note this is cheap enough to be called at every step of an acquisition
+ */
+
+gboolean cfg_snap_is_current(struct cfg_snap *s, gconstpointer data)
+{
+	return g_atomic_pointer_get(&s->cur) == data;
+}
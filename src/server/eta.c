@@ -0,0 +1,326 @@
+/**
+ * @file    server/eta.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief self-calibrating timing models for the hardware backends
+ *
+ * @note a model is a set of running estimates, e.g. the duration of an
+ *	 acquisition step per bandwidth mode or the time per encoder count per
+ *	 drive axis; every estimate is an exponentially weighted mean that
+ *	 follows the measurements the backend feeds it
+ *
+ * @note the residual of a measurement is clipped to a multiple of the mean
+ *	 absolute deviation, so a single outlier (a retried command, a busy
+ *	 link) barely moves the estimate, while a lasting change widens the
+ *	 deviation and is followed within a few measurements
+ *
+ * @note the estimates are saved to the user configuration directory from the
+ *	 main loop a while after they were updated and restored on the next
+ *	 start, so the first ETA after a restart is already realistic
+ */
+
+#include <math.h>
+#include <glib/gstdio.h>
+
+#include <eta.h>
+
+
+#define MSG "ETA: "
+
+#define ETA_MODEL_GROUP		"Model"
+
+/* the number of measurements the running estimate effectively averages */
+#define ETA_MODEL_WINDOW		10
+
+/* measurements before residuals are clipped */
+#define ETA_MODEL_MIN_SAMPLES		3
+
+/* residual clipping threshold in mean absolute deviations */
+#define ETA_MODEL_CLIP			3.0
+
+/* lower limit of the deviation used for clipping relative to the estimate,
+ * or very steady measurements would lock the estimate in place
+ */
+#define ETA_MODEL_DEV_FLOOR		0.02
+
+/* delay of a save after an update */
+#define ETA_MODEL_SAVE_INTERVAL_SEC	60
+
+
+struct eta_est {
+	gdouble est;			/* the estimate */
+	gdouble dev;			/* mean absolute deviation */
+	guint64 n;			/* measurements taken */
+};
+
+struct eta_model {
+	gchar *name;
+	gchar *path;
+
+	gsize n;
+	struct eta_est *e;
+
+	gboolean save_pending;		/* a save is scheduled */
+
+	GMutex lock;
+};
+
+
+/**
+ * @brief restore the estimates of a model from its file
+ *
+ * @note nothing is restored unless the number of estimates matches
+ */
+
+static void eta_model_load(struct eta_model *m)
+{
+	gsize i;
+	gsize n_est, n_dev, n_cnt;
+
+	gdouble *est = NULL;
+	gdouble *dev = NULL;
+	gint *cnt = NULL;
+
+	GKeyFile *kf;
+
+
+	kf = g_key_file_new();
+
+	if (!g_key_file_load_from_file(kf, m->path, G_KEY_FILE_NONE, NULL))
+		goto exit;
+
+	est = g_key_file_get_double_list(kf, ETA_MODEL_GROUP, "estimate",
+					 &n_est, NULL);
+	dev = g_key_file_get_double_list(kf, ETA_MODEL_GROUP, "deviation",
+					 &n_dev, NULL);
+	cnt = g_key_file_get_integer_list(kf, ETA_MODEL_GROUP, "samples",
+					  &n_cnt, NULL);
+
+	if (!est || !dev || !cnt ||
+	    n_est != m->n || n_dev != m->n || n_cnt != m->n) {
+		g_warning(MSG "ignoring incompatible %s", m->path);
+		goto exit;
+	}
+
+	for (i = 0; i < m->n; i++) {
+
+		if (!isfinite(est[i]) || est[i] <= 0.0)
+			continue;
+
+		m->e[i].est = est[i];
+		m->e[i].dev = fabs(dev[i]);
+		m->e[i].n   = (guint64) MAX(cnt[i], 0);
+	}
+
+	g_message(MSG "%s estimates restored from %s", m->name, m->path);
+
+exit:
+	g_free(est);
+	g_free(dev);
+	g_free(cnt);
+
+	g_key_file_free(kf);
+}
+
+
+/**
+ * @brief save the estimates of a model to its file
+ *
+ * @note this is a main loop callback
+ */
+
+static gboolean eta_model_save_cb(gpointer data)
+{
+	gsize i;
+	gsize len;
+
+	gdouble *est;
+	gdouble *dev;
+	gint *cnt;
+
+	gchar *buf;
+	gchar *dir;
+
+	GKeyFile *kf;
+	GError *error = NULL;
+
+	struct eta_model *m = (struct eta_model *) data;
+
+
+	est = g_malloc(m->n * sizeof(gdouble));
+	dev = g_malloc(m->n * sizeof(gdouble));
+	cnt = g_malloc(m->n * sizeof(gint));
+
+	g_mutex_lock(&m->lock);
+
+	for (i = 0; i < m->n; i++) {
+		est[i] = m->e[i].est;
+		dev[i] = m->e[i].dev;
+		cnt[i] = (gint) MIN(m->e[i].n, G_MAXINT);
+	}
+
+	m->save_pending = FALSE;
+
+	g_mutex_unlock(&m->lock);
+
+	kf = g_key_file_new();
+
+	g_key_file_set_double_list(kf, ETA_MODEL_GROUP, "estimate", est, m->n);
+	g_key_file_set_double_list(kf, ETA_MODEL_GROUP, "deviation", dev, m->n);
+	g_key_file_set_integer_list(kf, ETA_MODEL_GROUP, "samples", cnt, m->n);
+
+	buf = g_key_file_to_data(kf, &len, NULL);
+
+	dir = g_path_get_dirname(m->path);
+	g_mkdir_with_parents(dir, 0755);
+
+	if (!g_file_set_contents(m->path, buf, len, &error)) {
+		g_warning(MSG "could not save %s: %s", m->path, error->message);
+		g_clear_error(&error);
+	}
+
+	g_free(dir);
+	g_free(buf);
+	g_key_file_free(kf);
+
+	g_free(est);
+	g_free(dev);
+	g_free(cnt);
+
+	return G_SOURCE_REMOVE;
+}
+
+
+/**
+ * @brief create a timing model
+ *
+ * @param name the name of the model, also names its file
+ * @param n the number of estimates
+ * @param init the initial estimates, used unless saved ones are found
+ *
+ * @returns the model
+ */
+
+struct eta_model *eta_model_new(const gchar *name, gsize n,
+				const gdouble *init)
+{
+	gsize i;
+	gchar *file;
+
+	struct eta_model *m;
+
+
+	m = g_malloc0(sizeof(struct eta_model));
+
+	m->name = g_strdup(name);
+	m->n    = n;
+	m->e    = g_malloc0(n * sizeof(struct eta_est));
+
+	for (i = 0; i < n; i++)
+		m->e[i].est = init[i];
+
+	file    = g_strconcat(name, ".eta", NULL);
+	m->path = g_build_filename(g_get_user_config_dir(), CONFDIR, file,
+				   NULL);
+	g_free(file);
+
+	g_mutex_init(&m->lock);
+
+	eta_model_load(m);
+
+	return m;
+}
+
+
+/**
+ * @brief get an estimate
+ *
+ * @param m the model
+ * @param i the index of the estimate
+ *
+ * @returns the estimate or 0.0 if the index is out of range
+ */
+
+gdouble eta_model_get(struct eta_model *m, gsize i)
+{
+	gdouble est;
+
+
+	if (i >= m->n)
+		return 0.0;
+
+	g_mutex_lock(&m->lock);
+	est = m->e[i].est;
+	g_mutex_unlock(&m->lock);
+
+	return est;
+}
+
+
+/**
+ * @brief feed a measurement to the model
+ *
+ * @param m the model
+ * @param i the index of the estimate
+ * @param x the measurement
+ *
+ * @note the first measurements are averaged with equal weight, so the initial
+ *	 guess is replaced quickly
+ */
+
+void eta_model_update(struct eta_model *m, gsize i, gdouble x)
+{
+	gdouble r;
+	gdouble lim;
+	gdouble alpha;
+
+	struct eta_est *e;
+
+
+	if (i >= m->n)
+		return;
+
+	if (!isfinite(x) || x <= 0.0)
+		return;
+
+	g_mutex_lock(&m->lock);
+
+	e = &m->e[i];
+
+	alpha = 1.0 / (gdouble) MIN(e->n + 1, ETA_MODEL_WINDOW);
+
+	r = x - e->est;
+
+	if (e->n >= ETA_MODEL_MIN_SAMPLES) {
+		lim = ETA_MODEL_CLIP * MAX(e->dev, ETA_MODEL_DEV_FLOOR * e->est);
+		r   = CLAMP(r, -lim, lim);
+	}
+
+	e->est += alpha * r;
+
+	if (e->n)
+		e->dev += alpha * (fabs(r) - e->dev);
+
+	e->n++;
+
+	g_debug(MSG "%s[%zu]: measured %g, estimate %g +- %g",
+		m->name, i, x, e->est, e->dev);
+
+	if (!m->save_pending) {
+		m->save_pending = TRUE;
+		g_timeout_add_seconds(ETA_MODEL_SAVE_INTERVAL_SEC,
+				      eta_model_save_cb, m);
+	}
+
+	g_mutex_unlock(&m->lock);
+}
@@ -20,12 +20,26 @@
 #include <gmodule.h>
 #include <protocol.h>
 
+
+/**
+ * @brief shared comlink request classes, in order of priority
+ */
+
+enum comlink_class {
+	COMLINK_DRIVE,		/* drive commands, e.g. tracking corrections */
+	COMLINK_SPEC,		/* spectrometer acquisitions */
+	COMLINK_CLASS_N
+};
+
+
 /* backend calls */
 int be_moveto_azel(double az, double el);
 void be_shared_comlink_acquire(void);
 void be_shared_comlink_release(void);
-int be_shared_comlink_write(const gchar *buf, gsize nbytes);
-gchar *be_shared_comlink_read(gsize *nbytes);
+gchar *be_shared_comlink_xfer(enum comlink_class cls,
+			      const gchar *buf, gsize nbytes,
+			      gint timeout_ms, gsize *rsp_len,
+			      gdouble *exec_ms);
 void be_recalibrate_pointing(void);
 void be_park_telescope(void);
 int be_spec_acq_cfg(struct spec_acq_cfg *acq);
@@ -41,13 +55,14 @@ int be_radiometer_pwr_ctrl(gboolean mode);
 int be_drive_pwr_ctrl(gboolean mode);
 void be_drive_pwr_cycle(void);
 gboolean be_drive_pwr_status(void);
+gdouble be_drive_slew_time(gdouble az0, gdouble el0, gdouble az1, gdouble el1);
+gboolean be_drive_otf_capable(void);
 
 /* backend call loaders */
 int be_moveto_azel_load(GModule *mod);
 int be_shared_comlink_acquire_load(GModule *mod);
 int be_shared_comlink_release_load(GModule *mod);
-int be_shared_comlink_write_load(GModule *mod);
-int be_shared_comlink_read_load(GModule *mod);
+int be_shared_comlink_xfer_load(GModule *mod);
 int be_recalibrate_pointing_load(GModule *mod);
 int be_park_telescope_load(GModule *mod);
 int be_spec_acq_cfg_load(GModule *mod);
@@ -63,6 +78,8 @@ int be_radiometer_pwr_ctrl_load(GModule *mde);
 int be_drive_pwr_ctrl_load(GModule *mde);
 int be_drive_pwr_cycle_load(GModule *mde);
 int be_drive_pwr_status_load(GModule *mde);
+int be_drive_slew_time_load(GModule *mde);
+int be_drive_otf_capable_load(GModule *mde);
 
 
 int backend_load_plugins(void);
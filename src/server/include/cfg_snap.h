@@ -0,0 +1,35 @@
+/**
+ * @file    server/include/cfg_snap.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _SERVER_INCLUDE_CFG_SNAP_H_
+#define _SERVER_INCLUDE_CFG_SNAP_H_
+
+#include <glib.h>
+
+
+struct cfg_snap;
+
+struct cfg_snap *cfg_snap_new(GDestroyNotify clear);
+
+gpointer cfg_snap_alloc(gsize size);
+void cfg_snap_publish(struct cfg_snap *s, gpointer data);
+
+gpointer cfg_snap_get(struct cfg_snap *s);
+void cfg_snap_put(struct cfg_snap *s, gpointer data);
+gboolean cfg_snap_is_current(struct cfg_snap *s, gconstpointer data);
+
+
+#endif /* _SERVER_INCLUDE_CFG_SNAP_H_ */
@@ -0,0 +1,32 @@
+/**
+ * @file    server/include/eta.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _SERVER_INCLUDE_ETA_H_
+#define _SERVER_INCLUDE_ETA_H_
+
+#include <glib.h>
+
+
+struct eta_model;
+
+struct eta_model *eta_model_new(const gchar *name, gsize n,
+				const gdouble *init);
+
+gdouble eta_model_get(struct eta_model *m, gsize i);
+void eta_model_update(struct eta_model *m, gsize i, gdouble x);
+
+
+#endif /* _SERVER_INCLUDE_ETA_H_ */
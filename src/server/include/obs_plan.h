@@ -0,0 +1,33 @@
+/**
+ * @file    server/include/obs_plan.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _SERVER_INCLUDE_OBS_PLAN_H_
+#define _SERVER_INCLUDE_OBS_PLAN_H_
+
+#include <glib.h>
+#include <coordinates.h>
+
+
+gdouble obs_plan_cost(struct coord_horizontal a, struct coord_horizontal b);
+gboolean obs_plan_timed(void);
+
+gdouble obs_plan_path(const struct coord_horizontal *pos, guint n,
+		      struct coord_horizontal start, const guint *order);
+gdouble obs_plan_order(const struct coord_horizontal *pos, guint n,
+		       struct coord_horizontal start, guint *order);
+
+
+#endif /* _SERVER_INCLUDE_OBS_PLAN_H_ */
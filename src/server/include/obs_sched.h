@@ -0,0 +1,29 @@
+/**
+ * @file    server/include/obs_sched.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _SERVER_INCLUDE_OBS_SCHED_H_
+#define _SERVER_INCLUDE_OBS_SCHED_H_
+
+#include <glib.h>
+#include <protocol.h>
+
+
+void obs_sched_init(void);
+guint32 obs_sched_submit(struct obs_job *j);
+int obs_sched_cancel(guint32 id);
+
+
+#endif /* _SERVER_INCLUDE_OBS_SCHED_H_ */
@@ -41,6 +41,9 @@ void proc_pr_hot_load_enable(struct packet *pkt, gpointer ref);
 void proc_pr_hot_load_disable(struct packet *pkt, gpointer ref);
 void proc_pr_cold_load_enable(struct packet *pkt, gpointer ref);
 void proc_pr_cold_load_disable(struct packet *pkt, gpointer ref);
+void proc_pr_track(struct packet *pkt, gpointer ref);
+void proc_pr_obs_job(struct packet *pkt, gpointer ref);
+void proc_pr_obs_cancel(struct packet *pkt, gpointer ref);
 
 #endif /* _SERVER_INCLUDE_PKT_PROC_H_ */
 
@@ -0,0 +1,33 @@
+/**
+ * @file    server/include/pos_pub.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _SERVER_INCLUDE_POS_PUB_H_
+#define _SERVER_INCLUDE_POS_PUB_H_
+
+#include <glib.h>
+
+
+struct pos_pub;
+
+struct pos_pub *pos_pub_new(gdouble az_res, gdouble el_res);
+
+gboolean pos_pub_push(struct pos_pub *p, gdouble az, gdouble el);
+void pos_pub_arrived(struct pos_pub *p, gdouble az, gdouble el);
+void pos_pub_moving(struct pos_pub *p);
+void pos_pub_wait(struct pos_pub *p);
+
+
+#endif /* _SERVER_INCLUDE_POS_PUB_H_ */
@@ -0,0 +1,65 @@
+/**
+ * @file    server/include/serial.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _SERVER_INCLUDE_SERIAL_H_
+#define _SERVER_INCLUDE_SERIAL_H_
+
+#include <glib.h>
+
+
+/* wait indefinitely */
+#define SERIAL_TIMEOUT_INF	(-1)
+
+
+/**
+ * @brief serial link statistics
+ */
+
+struct serial_stats {
+	guint64 tx_bytes;		/* bytes written */
+	guint64 rx_bytes;		/* bytes read */
+
+	guint64 n_rsp;			/* responses received */
+	guint64 n_timeout;		/* reads or writes that timed out */
+
+	gint64 lat_min_us;		/* response latency: last byte written */
+	gint64 lat_max_us;		/* to first byte received */
+	gint64 lat_sum_us;
+
+	gint64 t_open_us;		/* time the link has been open */
+
+	gdouble util;			/* fraction of the line rate used */
+};
+
+
+struct serial_link;
+
+struct serial_link *serial_open(const gchar *tty, gint baud);
+void serial_close(struct serial_link *l);
+
+gssize serial_write(struct serial_link *l, const void *buf, gsize n,
+		    gint timeout_ms);
+gssize serial_read(struct serial_link *l, void *buf, gsize n,
+		   gint timeout_ms);
+gssize serial_read_line(struct serial_link *l, gchar *buf, gsize n,
+			gint timeout_ms);
+void serial_flush(struct serial_link *l, gint quiet_ms);
+
+void serial_get_stats(struct serial_link *l, struct serial_stats *st);
+void serial_log_stats(struct serial_link *l);
+
+
+#endif /* _SERVER_INCLUDE_SERIAL_H_ */
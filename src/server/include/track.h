@@ -0,0 +1,33 @@
+/**
+ * @file    server/include/track.h
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#ifndef _SERVER_INCLUDE_TRACK_H_
+#define _SERVER_INCLUDE_TRACK_H_
+
+#include <glib.h>
+#include <coordinates.h>
+
+
+int track_sky(guint32 sys, gdouble lon, gdouble lat);
+void track_stop(void);
+void track_push_state(void);
+
+struct coord_horizontal track_get_hor(guint32 sys, gdouble lon, gdouble lat);
+void track_get_sky(guint32 sys, struct coord_horizontal hor,
+		   gdouble *lon, gdouble *lat);
+
+
+#endif /* _SERVER_INCLUDE_TRACK_H_ */
@@ -20,6 +20,7 @@
 #include <cfg.h>
 #include <backend.h>
 #include <net.h>
+#include <obs_sched.h>
 
 
 int main(void)
@@ -30,6 +31,8 @@ int main(void)
 	if (backend_load_plugins())
 		return -1;
 
+	obs_sched_init();
+
 	if (net_server())
 		return -1;
 }
@@ -27,6 +27,9 @@
 #include <ack.h>
 #include <pkt_proc.h>
 #include <backend.h>
+#include <track.h>
+
+#include <string.h>
 
 #include <gio/gio.h>
 #include <glib.h>
@@ -39,6 +42,11 @@
 /* max allowed client */
 #define SERVER_CON_MAX 64
 
+/* max packets waiting for broadcast; producers drop rather than wait, so this
+ * only bounds the memory held while the dispatcher is stalled
+ */
+#define SERVER_PUB_MAX 1024
+
 /* privilege range */
 #define PRIV_DEFAULT	0
 #define PRIV_CONTROL	1
@@ -67,6 +75,30 @@ struct thread {
 	gsize bytes;
 };
 
+/* a packet waiting for dispatch */
+struct pub_pkt {
+	struct pub_pkt *next;
+	struct con_data *con;		/* the recipient, NULL for all clients */
+	gsize bytes;
+	gchar buf[];
+};
+
+/* the publication queue of broadcasts and direct replies
+ *
+ * producers push on a lock-free stack and never wait for the dispatcher, the
+ * dispatcher takes the whole stack at once and restores the order of
+ * submission; the lock only guards the wakeup of an idle dispatcher and is
+ * never held while sending
+ */
+static struct {
+	struct pub_pkt *head;
+	gint pending;
+	gint dropped;
+
+	GMutex lock;
+	GCond wake;
+} pub;
+
 /* tracks client connections */
 static GList *con_list;
 
@@ -743,7 +775,7 @@ pending:
 
 #if 1 /* careful there, this has abuse potential :) */
 		/* here's your shit back */
-		if (net_send_single(c, buf, nbytes) < 0)
+		if (net_send_con(c, buf, nbytes) < 0)
 			goto error;
 #endif
 
@@ -992,6 +1024,7 @@ static gboolean net_incoming(GSocketService    *service,
 	g_mutex_unlock(&listlock);
 
 	net_push_video_uri_single();
+	track_push_state();
 
 	/* push usernames and messages after 1 seconds, so the incoming
 	 * connections have time to configure theirs
@@ -1015,19 +1048,15 @@ static gboolean net_incoming(GSocketService    *service,
 
 
 /**
- * @brief send a packet to single client
+ * @brief send a packet to a single client right away
  *
  * @returns <0 on error
  */
 
-gint net_send_single(gpointer ref, const char *pkt, gsize nbytes)
+static gint net_send_con(struct con_data *c, const char *pkt, gsize nbytes)
 {
 	gint ret;
 
-	struct con_data *c;
-
-
-	c = (struct con_data *) ref;
 
 	g_mutex_lock(&netlock);
 
@@ -1042,10 +1071,10 @@ gint net_send_single(gpointer ref, const char *pkt, gsize nbytes)
 /**
  * @brief send a packet to all connected clients
  *
- * @returns <0 on error
+ * @note this is called from the dispatch thread only
  */
 
-gint net_send(const char *pkt, gsize nbytes)
+static gint net_send_dispatch(const char *pkt, gsize nbytes)
 {
 	int ret = 0;
 
@@ -1071,7 +1100,7 @@ gint net_send(const char *pkt, gsize nbytes)
 			continue;
 		}
 
-		ret |= net_send_single(c, pkt, nbytes);
+		ret |= net_send_con(c, pkt, nbytes);
 	}
 
 	g_mutex_unlock(&listlock);
@@ -1088,6 +1117,185 @@ gint net_send(const char *pkt, gsize nbytes)
 	return ret;
 }
 
+
+/**
+ * @brief send a packet to a single client if it is still connected
+ *
+ * @note this is called from the dispatch thread only
+ */
+
+static gint net_send_dispatch_single(struct con_data *c, const char *pkt,
+				     gsize nbytes)
+{
+	int ret = 0;
+
+
+	g_mutex_lock(&netlock_big);
+	g_mutex_lock(&listlock);
+
+	/* the client may have gone while the packet was queued */
+	if (g_list_find(con_list, c) && G_IS_OBJECT(c->con) && !c->kick)
+		ret = net_send_con(c, pkt, nbytes);
+
+	g_mutex_unlock(&listlock);
+	g_mutex_unlock(&netlock_big);
+
+	return ret;
+}
+
+
+/**
+ * @brief take all queued packets in order of submission
+ */
+
+static struct pub_pkt *net_pub_take(void)
+{
+	struct pub_pkt *p;
+	struct pub_pkt *next;
+	struct pub_pkt *fifo = NULL;
+
+
+	do {
+		p = g_atomic_pointer_get(&pub.head);
+	} while (!g_atomic_pointer_compare_and_exchange(&pub.head, p, NULL));
+
+	/* the stack is last-in first-out */
+	while (p) {
+		next    = p->next;
+		p->next = fifo;
+		fifo    = p;
+		p       = next;
+	}
+
+	return fifo;
+}
+
+
+/**
+ * @brief the packet dispatch thread
+ */
+
+static gpointer net_pub_dispatch(gpointer data)
+{
+	gint n;
+	gint dropped;
+
+	struct pub_pkt *p;
+	struct pub_pkt *next;
+
+
+	while (1) {
+
+		g_mutex_lock(&pub.lock);
+
+		while (!g_atomic_pointer_get(&pub.head))
+			g_cond_wait(&pub.wake, &pub.lock);
+
+		g_mutex_unlock(&pub.lock);
+
+		n = 0;
+
+		for (p = net_pub_take(); p; p = next) {
+			next = p->next;
+
+			if (p->con)
+				net_send_dispatch_single(p->con, p->buf,
+							 p->bytes);
+			else
+				net_send_dispatch(p->buf, p->bytes);
+
+			g_free(p);
+			n++;
+		}
+
+		g_atomic_int_add(&pub.pending, -n);
+
+		dropped = g_atomic_int_get(&pub.dropped);
+		if (dropped) {
+			g_atomic_int_add(&pub.dropped, -dropped);
+			g_warning("Dropped %d outgoing packets, more than %d "
+				  "were pending", dropped, SERVER_PUB_MAX);
+		}
+	}
+
+	return NULL;
+}
+
+
+/**
+ * @brief queue a packet for dispatch
+ *
+ * @param c the recipient, NULL for all clients
+ *
+ * @returns <0 on error
+ */
+
+static gint net_pub_push(struct con_data *c, const char *pkt, gsize nbytes)
+{
+	struct pub_pkt *p;
+	struct pub_pkt *old;
+
+
+	if (g_atomic_int_add(&pub.pending, 1) >= SERVER_PUB_MAX) {
+		g_atomic_int_add(&pub.pending, -1);
+		g_atomic_int_inc(&pub.dropped);
+		return -1;
+	}
+
+	p = g_malloc(sizeof(struct pub_pkt) + nbytes);
+
+	p->con   = c;
+	p->bytes = nbytes;
+	memcpy(p->buf, pkt, nbytes);
+
+	do {
+		old     = g_atomic_pointer_get(&pub.head);
+		p->next = old;
+	} while (!g_atomic_pointer_compare_and_exchange(&pub.head, old, p));
+
+	/* the dispatcher only sleeps on an empty queue */
+	if (!old) {
+		g_mutex_lock(&pub.lock);
+		g_cond_signal(&pub.wake);
+		g_mutex_unlock(&pub.lock);
+	}
+
+	return 0;
+}
+
+
+/**
+ * @brief queue a packet for all connected clients
+ *
+ * @returns <0 on error
+ *
+ * @note this never waits for the network or any client, so it is safe to
+ *	 call from the acquisition threads of the backends; the packet is copied
+ *	 and sent from the dispatch thread in order of submission
+ */
+
+gint net_send(const char *pkt, gsize nbytes)
+{
+	return net_pub_push(NULL, pkt, nbytes);
+}
+
+
+/**
+ * @brief queue a packet for a single client
+ *
+ * @returns <0 on error
+ *
+ * @note replies share the queue with the broadcasts, so a client never
+ *	 sees e.g. PR_SUCCESS before the state update that was queued ahead
+ *	 of it
+ */
+
+gint net_send_single(gpointer ref, const char *pkt, gsize nbytes)
+{
+	return net_pub_push((struct con_data *) ref, pkt, nbytes);
+}
+
+
 /**
  * @brief assign control privilege level to connection
  */
@@ -1381,6 +1589,8 @@ int net_server(void)
 
 	g_socket_service_start(service);
 
+	g_thread_new("net_pub", net_pub_dispatch, NULL);
+
 
 	loop = g_main_loop_new(NULL, FALSE);
 
@@ -0,0 +1,290 @@
+/**
+ * @file    server/obs_plan.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief slew path planning for observation jobs
+ *
+ * @note the cost of a move is the duration estimated by the drive backend,
+ *	 which knows its axis speeds and whether the axes move together or one
+ *	 after the other; if the backend cannot estimate durations, the cost
+ *	 is the angular travel summed over both axes
+ *
+ * @note orders are open paths starting at the current drive position; the
+ *	 heuristics assume symmetric move costs
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <obs_plan.h>
+#include <backend.h>
+
+
+/* improvement passes of the 2-opt heuristic */
+#define OBS_PLAN_2OPT_PASSES	100
+
+/* element of the cost matrix of n positions */
+#define C(c, n, i, k)	((c)[(i) * ((n) + 1) + (k)])
+
+
+/**
+ * @brief get the cost of a move
+ */
+
+gdouble obs_plan_cost(struct coord_horizontal a, struct coord_horizontal b)
+{
+	gdouble t;
+	gdouble d_az;
+
+
+	t = be_drive_slew_time(a.az, a.el, b.az, b.el);
+	if (t >= 0.0)
+		return t;
+
+	d_az = fmod(fabs(b.az - a.az), 360.0);
+	d_az = MIN(d_az, 360.0 - d_az);
+
+	return d_az + fabs(b.el - a.el);
+}
+
+
+/**
+ * @brief check whether costs are durations in seconds or angles in degrees
+ */
+
+gboolean obs_plan_timed(void)
+{
+	return be_drive_slew_time(0.0, 0.0, 0.0, 0.0) >= 0.0;
+}
+
+
+/**
+ * @brief compute the cost matrix
+ *
+ * @note row and column 0 are the start position, i + 1 is position i
+ */
+
+static gdouble *obs_plan_matrix(const struct coord_horizontal *pos, guint n,
+				struct coord_horizontal start)
+{
+	guint i, k;
+
+	gdouble *c;
+
+
+	c = g_malloc((n + 1) * (n + 1) * sizeof(gdouble));
+
+	for (i = 0; i <= n; i++) {
+		C(c, n, i, i) = 0.0;
+
+		for (k = i + 1; k <= n; k++) {
+			C(c, n, i, k) = obs_plan_cost(i ? pos[i - 1] : start,
+						      pos[k - 1]);
+			C(c, n, k, i) = C(c, n, i, k);
+		}
+	}
+
+	return c;
+}
+
+
+/**
+ * @brief get the cost of a path through the matrix
+ */
+
+static gdouble obs_plan_matrix_path(const gdouble *c, guint n,
+				    const guint *order)
+{
+	guint i;
+	guint prev = 0;
+
+	gdouble sum = 0.0;
+
+
+	for (i = 0; i < n; i++) {
+		sum += C(c, n, prev, order[i] + 1);
+		prev = order[i] + 1;
+	}
+
+	return sum;
+}
+
+
+/**
+ * @brief get the cost of visiting positions in a given order
+ *
+ * @param pos the positions
+ * @param n the number of positions
+ * @param start the current drive position
+ * @param order the order of the positions
+ *
+ * @returns the total cost
+ */
+
+gdouble obs_plan_path(const struct coord_horizontal *pos, guint n,
+		      struct coord_horizontal start, const guint *order)
+{
+	guint i;
+
+	gdouble sum = 0.0;
+
+
+	for (i = 0; i < n; i++) {
+		sum += obs_plan_cost(start, pos[order[i]]);
+		start = pos[order[i]];
+	}
+
+	return sum;
+}
+
+
+/**
+ * @brief order positions by visiting the nearest unvisited one next
+ */
+
+static void obs_plan_matrix_nearest(const gdouble *c, guint n, guint *order)
+{
+	guint i, k;
+	guint best;
+	guint prev = 0;
+
+	gboolean *done;
+
+
+	done = g_malloc0(n * sizeof(gboolean));
+
+	for (i = 0; i < n; i++) {
+
+		best = n;
+
+		for (k = 0; k < n; k++) {
+
+			if (done[k])
+				continue;
+
+			if (best == n ||
+			    C(c, n, prev, k + 1) < C(c, n, prev, best + 1))
+				best = k;
+		}
+
+		done[best] = TRUE;
+		order[i]   = best;
+		prev       = best + 1;
+	}
+
+	g_free(done);
+}
+
+
+/**
+ * @brief improve an order by reversing sections of the path
+ *
+ * @note this is the 2-opt heuristic for an open path with a fixed start
+ */
+
+static void obs_plan_matrix_2opt(const gdouble *c, guint n, guint *order)
+{
+	guint i, k;
+	guint a, b, d, e;
+	guint pass;
+	guint tmp;
+	guint lo, hi;
+
+	gdouble delta;
+
+	gboolean improved = TRUE;
+
+
+	for (pass = 0; improved && pass < OBS_PLAN_2OPT_PASSES; pass++) {
+
+		improved = FALSE;
+
+		for (i = 0; i < n; i++) {
+
+			/* the node before the section, 0 is the start */
+			a = i ? order[i - 1] + 1 : 0;
+			b = order[i] + 1;
+
+			for (k = i + 1; k < n; k++) {
+
+				d = order[k] + 1;
+
+				delta = C(c, n, a, d) - C(c, n, a, b);
+
+				/* the end of the path is open */
+				if (k + 1 < n) {
+					e = order[k + 1] + 1;
+					delta += C(c, n, b, e) - C(c, n, d, e);
+				}
+
+				if (delta > -1e-9)
+					continue;
+
+				for (lo = i, hi = k; lo < hi; lo++, hi--) {
+					tmp       = order[lo];
+					order[lo] = order[hi];
+					order[hi] = tmp;
+				}
+
+				b = order[i] + 1;
+
+				improved = TRUE;
+			}
+		}
+	}
+}
+
+
+/**
+ * @brief plan an order of positions with short slews
+ *
+ * @param pos the positions
+ * @param n the number of positions
+ * @param start the current drive position
+ * @param[inout] order a candidate order, replaced by the planned order
+ *
+ * @returns the total cost of the planned order
+ *
+ * @note the better of the candidate and a nearest-neighbour tour is
+ *	 improved with 2-opt
+ */
+
+gdouble obs_plan_order(const struct coord_horizontal *pos, guint n,
+		       struct coord_horizontal start, guint *order)
+{
+	gdouble *c;
+	guint *nn;
+
+	gdouble cost;
+
+
+	if (!n)
+		return 0.0;
+
+	c  = obs_plan_matrix(pos, n, start);
+	nn = g_malloc(n * sizeof(guint));
+
+	obs_plan_matrix_nearest(c, n, nn);
+
+	if (obs_plan_matrix_path(c, n, nn) < obs_plan_matrix_path(c, n, order))
+		memcpy(order, nn, n * sizeof(guint));
+
+	obs_plan_matrix_2opt(c, n, order);
+
+	cost = obs_plan_matrix_path(c, n, order);
+
+	g_free(nn);
+	g_free(c);
+
+	return cost;
+}
@@ -0,0 +1,1331 @@
+/**
+ * @file    server/obs_sched.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief observation job queue
+ *
+ * @note jobs are executed one after another in a thread of the server, so
+ *	 they do not depend on any client being connected; for every
+ *	 position of a job, the telescope is moved (and tracks, unless the
+ *	 job is in the horizon system), the acquisition is enabled once the
+ *	 drive has arrived and the next move is issued as soon as the
+ *	 requested number of spectra was recorded
+ *
+ * @note in on-the-fly mode, the drive is sent to the end of a row once it
+ *	 has arrived at its start and acquisition stays enabled during the
+ *	 sweep; the drive position is sampled meanwhile and every spectrum
+ *	 is reported at the position interpolated to the middle of its
+ *	 integration, converted back to the coordinate system of the job
+ *
+ * @note before a grid job starts, the order of its positions is planned
+ *	 for short slews from the current drive position, see obs_plan.c;
+ *	 the estimated savings and the actual slew time are reported
+ *
+ * @note the result of every position is broadcast to the clients, the
+ *	 spectra themselves are distributed as usual
+ *
+ * @note the queue, including the progress of the running job, is saved to
+ *	 the user configuration directory and resumed when the server starts
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <glib/gstdio.h>
+
+#include <obs_sched.h>
+#include <obs_plan.h>
+#include <track.h>
+#include <backend.h>
+#include <ack.h>
+#include <net.h>
+
+
+#define MSG "SCHED: "
+
+#define OBS_SCHED_QUEUE_FILE	"obs_sched.queue"
+
+/* drive position poll interval while waiting for arrival */
+#define OBS_SCHED_POLL_MS		100
+
+/* give up on a position if the drive has not arrived in time */
+#define OBS_SCHED_MOVE_TIMEOUT_SEC	600
+
+/* give up on a position if no spectrum arrives in time */
+#define OBS_SCHED_ACQ_TIMEOUT_SEC	600
+
+/* arrival tolerance in units of the drive resolution */
+#define OBS_SCHED_ARRIVAL_TOL	1.5
+
+/* lower limit of the arrival tolerance */
+#define OBS_SCHED_ARRIVAL_TOL_MIN	0.01
+
+/* upper limit of the number of positions in a job */
+#define OBS_SCHED_POINTS_MAX	100000
+
+/* tolerance of the axis limits against rounding of the step (arcsec) */
+#define OBS_SCHED_AXIS_TOL	1
+
+/* upper limit of the number of positions of a planned job */
+#define OBS_SCHED_PLAN_MAX	1024
+
+
+struct obs_sched_job {
+	struct obs_job j;
+
+	guint32 n_lon;			/* steps along the outer axis */
+	guint32 n_lat;			/* steps along the inner axis */
+	gint32 lat_stp;			/* inner axis step in arcsec */
+	guint32 idx;			/* next position or row */
+
+	guint *order;			/* planned order of grid indices */
+	gdouble slew_plan;		/* estimated slew cost of the order */
+
+	gboolean cancel;		/* end the job at the next opportunity */
+};
+
+/* a spectrum recorded on the fly */
+struct obs_sched_dump {
+	gint64 t0;			/* start of the integration */
+	gint64 t1;			/* end of the integration */
+	gdouble amp;
+};
+
+/* a drive position sample */
+struct obs_sched_pos {
+	gint64 t;
+	gdouble az;
+	gdouble el;
+};
+
+
+static struct {
+	GMutex lock;
+	GCond wake;			/* queue changed or spectrum received */
+
+	GQueue q;			/* head is the running job */
+	guint32 id_next;
+
+	gdouble slew_sec;		/* slew time of the running job */
+
+	/* integration of the current position */
+	gboolean integrating;
+	guint32 n_spec;			/* spectra completed */
+	gdouble sum;			/* sum of all bins */
+	guint64 n_bin;			/* number of bins summed */
+
+	/* on-the-fly integration of the current row */
+	gboolean otf;
+	gint64 t_dump;			/* end of the last spectrum */
+	GArray *dumps;			/* struct obs_sched_dump */
+	GArray *trail;			/* struct obs_sched_pos */
+
+	gchar *path;
+} obs_sched;
+
+
+/**
+ * @brief get the number of steps along an axis
+ *
+ * @note the last step does not go beyond the upper limit
+ */
+
+static guint32 obs_sched_axis_steps(gint32 lo, gint32 hi, gint32 stp)
+{
+	gint64 span;
+
+
+	if (stp <= 0 || hi <= lo)
+		return 1;
+
+	span = (gint64) hi - (gint64) lo + OBS_SCHED_AXIS_TOL;
+
+	return (guint32) (span / stp) + 1;
+}
+
+
+/**
+ * @brief free a job
+ */
+
+static void obs_sched_job_free(struct obs_sched_job *job)
+{
+	if (job)
+		g_free(job->order);
+
+	g_free(job);
+}
+
+
+/**
+ * @brief get the coordinates of a grid index of a job in degrees
+ */
+
+static void obs_sched_grid_point(struct obs_sched_job *job, guint32 g,
+				 gdouble *lon, gdouble *lat)
+{
+	guint32 i_lon;
+	guint32 i_lat;
+
+
+	i_lon = g / job->n_lat;
+	i_lat = g % job->n_lat;
+
+	(*lon) = ((gdouble) job->j.lon_lo_arcsec +
+		  (gdouble) i_lon * (gdouble) job->j.lon_stp_arcsec) / 3600.0;
+
+	(*lat) = ((gdouble) job->j.lat_lo_arcsec +
+		  (gdouble) i_lat * (gdouble) job->lat_stp) / 3600.0;
+}
+
+
+/**
+ * @brief get the coordinates of a position of a job in degrees
+ *
+ * @note unless planned, the inner axis is traversed back and forth
+ */
+
+static void obs_sched_job_point(struct obs_sched_job *job, guint32 idx,
+				gdouble *lon, gdouble *lat)
+{
+	guint32 i_lon;
+	guint32 i_lat;
+
+
+	if (job->order) {
+		obs_sched_grid_point(job, job->order[idx], lon, lat);
+		return;
+	}
+
+	i_lon = idx / job->n_lat;
+	i_lat = idx % job->n_lat;
+
+	if (i_lon & 1)
+		i_lat = job->n_lat - 1 - i_lat;
+
+	obs_sched_grid_point(job, i_lon * job->n_lat + i_lat, lon, lat);
+}
+
+
+/**
+ * @brief get the number of positions or rows of a job
+ */
+
+static guint32 obs_sched_job_len(struct obs_sched_job *job)
+{
+	if (job->j.mode == OBS_MODE_OTF)
+		return job->n_lon;
+
+	return job->n_lon * job->n_lat;
+}
+
+
+/**
+ * @brief validate a job and set up its grid
+ *
+ * @returns 0 on success, -1 if the job is invalid
+ */
+
+static int obs_sched_job_setup(struct obs_sched_job *job)
+{
+	struct obs_job *j = &job->j;
+
+
+	if (j->sys != OBS_SYS_EQU && j->sys != OBS_SYS_GAL &&
+	    j->sys != OBS_SYS_HOR)
+		return -1;
+
+	j->name[OBS_JOB_NAME_LEN - 1] = '\0';
+
+	job->n_lon = obs_sched_axis_steps(j->lon_lo_arcsec, j->lon_hi_arcsec,
+					  j->lon_stp_arcsec);
+
+	switch (j->mode) {
+	case OBS_MODE_GRID:
+		/* only grid positions average, OTF rows record continuously */
+		if (!j->n_avg)
+			return -1;
+		job->n_lat   = obs_sched_axis_steps(j->lat_lo_arcsec,
+						    j->lat_hi_arcsec,
+						    j->lat_stp_arcsec);
+		job->lat_stp = j->lat_stp_arcsec;
+		break;
+	case OBS_MODE_OTF:
+		/* the spectra of a row are matched to the drive positions */
+		if (!be_drive_otf_capable()) {
+			g_message(MSG "job (%s): drive does not support "
+				  "on-the-fly scans", j->name);
+			return -1;
+		}
+		/* the positions are the ends of the rows */
+		if (j->lat_hi_arcsec <= j->lat_lo_arcsec)
+			return -1;
+		job->n_lat   = 2;
+		job->lat_stp = j->lat_hi_arcsec - j->lat_lo_arcsec;
+		break;
+	default:
+		return -1;
+	}
+
+	if ((guint64) job->n_lon * job->n_lat > OBS_SCHED_POINTS_MAX)
+		return -1;
+
+	return 0;
+}
+
+
+/**
+ * @brief save the queue
+ *
+ * @note call with the queue locked
+ */
+
+static void obs_sched_save(void)
+{
+	gsize len;
+
+	gchar *buf;
+	gchar *dir;
+	gchar *grp;
+
+	GList *l;
+	GKeyFile *kf;
+	GError *error = NULL;
+
+	struct obs_sched_job *job;
+
+
+	kf = g_key_file_new();
+
+	for (l = obs_sched.q.head; l; l = l->next) {
+
+		job = (struct obs_sched_job *) l->data;
+
+		gint lon[3] = {job->j.lon_lo_arcsec, job->j.lon_hi_arcsec,
+			       job->j.lon_stp_arcsec};
+		gint lat[3] = {job->j.lat_lo_arcsec, job->j.lat_hi_arcsec,
+			       job->j.lat_stp_arcsec};
+
+		grp = g_strdup_printf("Job %u", job->j.id);
+
+		g_key_file_set_string(kf, grp, "name", job->j.name);
+		g_key_file_set_integer(kf, grp, "tag", (gint) job->j.tag);
+		g_key_file_set_integer(kf, grp, "sys", (gint) job->j.sys);
+		g_key_file_set_integer(kf, grp, "mode", (gint) job->j.mode);
+		g_key_file_set_integer_list(kf, grp, "lon", lon, 3);
+		g_key_file_set_integer_list(kf, grp, "lat", lat, 3);
+		g_key_file_set_integer(kf, grp, "n_avg", (gint) job->j.n_avg);
+		g_key_file_set_integer(kf, grp, "next", (gint) job->idx);
+
+		if (job->order)
+			g_key_file_set_integer_list(kf, grp, "order",
+						    (gint *) job->order,
+						    obs_sched_job_len(job));
+
+		g_free(grp);
+	}
+
+	buf = g_key_file_to_data(kf, &len, NULL);
+
+	dir = g_path_get_dirname(obs_sched.path);
+	g_mkdir_with_parents(dir, 0755);
+
+	if (!g_file_set_contents(obs_sched.path, buf, len, &error)) {
+		g_warning(MSG "could not save %s: %s", obs_sched.path,
+			  error->message);
+		g_clear_error(&error);
+	}
+
+	g_free(dir);
+	g_free(buf);
+	g_key_file_free(kf);
+}
+
+
+/**
+ * @brief restore the queue
+ */
+
+static void obs_sched_load(void)
+{
+	gsize i, k;
+	gsize n;
+	gsize n_lon, n_lat, n_ord;
+
+	gint *lon;
+	gint *lat;
+	gint *ord;
+
+	gchar **grp;
+	gchar *name;
+
+	GKeyFile *kf;
+
+	struct obs_sched_job *job;
+
+
+	kf = g_key_file_new();
+
+	if (!g_key_file_load_from_file(kf, obs_sched.path, G_KEY_FILE_NONE,
+				       NULL))
+		goto exit;
+
+	grp = g_key_file_get_groups(kf, &n);
+
+	for (i = 0; i < n; i++) {
+
+		lon = g_key_file_get_integer_list(kf, grp[i], "lon", &n_lon,
+						  NULL);
+		lat = g_key_file_get_integer_list(kf, grp[i], "lat", &n_lat,
+						  NULL);
+		ord = g_key_file_get_integer_list(kf, grp[i], "order", &n_ord,
+						  NULL);
+		name = g_key_file_get_string(kf, grp[i], "name", NULL);
+
+		job = g_malloc0(sizeof(struct obs_sched_job));
+
+		if (sscanf(grp[i], "Job %u", &job->j.id) != 1 ||
+		    !lon || !lat || n_lon != 3 || n_lat != 3)
+			goto skip;
+
+		job->j.tag   = g_key_file_get_integer(kf, grp[i], "tag", NULL);
+		job->j.sys   = g_key_file_get_integer(kf, grp[i], "sys", NULL);
+		job->j.mode  = g_key_file_get_integer(kf, grp[i], "mode", NULL);
+		job->j.n_avg = g_key_file_get_integer(kf, grp[i], "n_avg",
+						      NULL);
+		job->idx     = g_key_file_get_integer(kf, grp[i], "next", NULL);
+
+		job->j.lon_lo_arcsec  = lon[0];
+		job->j.lon_hi_arcsec  = lon[1];
+		job->j.lon_stp_arcsec = lon[2];
+		job->j.lat_lo_arcsec  = lat[0];
+		job->j.lat_hi_arcsec  = lat[1];
+		job->j.lat_stp_arcsec = lat[2];
+
+		if (name)
+			g_strlcpy(job->j.name, name, OBS_JOB_NAME_LEN);
+
+		if (obs_sched_job_setup(job))
+			goto skip;
+
+		if (ord) {
+			if (n_ord != obs_sched_job_len(job))
+				goto skip;
+
+			for (k = 0; k < n_ord; k++)
+				if (ord[k] < 0 || ord[k] >= (gint) n_ord)
+					goto skip;
+
+			job->order = (guint *) ord;
+			ord = NULL;
+		}
+
+		g_queue_push_tail(&obs_sched.q, job);
+
+		obs_sched.id_next = MAX(obs_sched.id_next, job->j.id + 1);
+
+		job = NULL;
+skip:
+		if (job)
+			g_warning(MSG "ignoring invalid %s in %s",
+				  grp[i], obs_sched.path);
+		obs_sched_job_free(job);
+		g_free(name);
+		g_free(lon);
+		g_free(lat);
+		g_free(ord);
+	}
+
+	g_strfreev(grp);
+
+	if (obs_sched.q.length)
+		g_message(MSG "%u observation jobs restored from %s",
+			  obs_sched.q.length, obs_sched.path);
+exit:
+	g_key_file_free(kf);
+}
+
+
+/**
+ * @brief broadcast the status of a job at a position
+ *
+ * @note call with the queue locked
+ */
+
+static void obs_sched_status_at(struct obs_sched_job *job, guint32 state,
+				guint32 idx, gdouble lon, gdouble lat,
+				gboolean valid, gdouble amp)
+{
+	struct obs_status s = {0};
+
+
+	s.id         = job->j.id;
+	s.tag        = job->j.tag;
+	s.state      = state;
+	s.idx        = idx;
+	s.n          = obs_sched_job_len(job);
+	s.n_queued   = obs_sched.q.length;
+	s.lon_arcsec = (int32_t) (lon * 3600.0);
+	s.lat_arcsec = (int32_t) (lat * 3600.0);
+	s.valid      = valid;
+	s.amp        = (uint32_t) CLAMP(amp, 0.0, (gdouble) G_MAXUINT32);
+
+	ack_obs_status(PKT_TRANS_ID_UNDEF, &s);
+}
+
+
+/**
+ * @brief broadcast the status of a job
+ *
+ * @note call with the queue locked
+ */
+
+static void obs_sched_status(struct obs_sched_job *job, guint32 state,
+			     guint32 idx, gboolean valid, gdouble amp)
+{
+	gdouble lon = 0.0;
+	gdouble lat = 0.0;
+
+
+	if (job->j.mode == OBS_MODE_GRID && idx < obs_sched_job_len(job))
+		obs_sched_job_point(job, idx, &lon, &lat);
+
+	obs_sched_status_at(job, state, idx, lon, lat, valid, amp);
+}
+
+
+/**
+ * @brief spectral data observer
+ */
+
+static void obs_sched_spec_observer(const uint32_t *spec, uint32_t n,
+				    gboolean last)
+{
+	uint32_t i;
+	guint64 n_bin;
+
+
+	g_mutex_lock(&obs_sched.lock);
+
+	if (obs_sched.integrating) {
+
+		n_bin = MAX(obs_sched.n_bin + n, 1);
+
+		for (i = 0; i < n; i++)
+			obs_sched.sum += (gdouble) spec[i];
+
+		obs_sched.n_bin += n;
+
+		if (last && obs_sched.otf) {
+			struct obs_sched_dump d;
+
+			d.t0  = obs_sched.t_dump;
+			d.t1  = g_get_monotonic_time();
+			d.amp = obs_sched.sum / (gdouble) n_bin;
+
+			g_array_append_val(obs_sched.dumps, d);
+
+			obs_sched.t_dump = d.t1;
+			obs_sched.sum    = 0.0;
+			obs_sched.n_bin  = 0;
+		}
+
+		if (last) {
+			obs_sched.n_spec++;
+			g_cond_signal(&obs_sched.wake);
+		}
+	}
+
+	g_mutex_unlock(&obs_sched.lock);
+}
+
+
+/**
+ * @brief check whether the running job was cancelled
+ *
+ * @note call with the queue locked
+ */
+
+static gboolean obs_sched_cancelled(void)
+{
+	struct obs_sched_job *job;
+
+
+	job = g_queue_peek_head(&obs_sched.q);
+	if (!job)
+		return FALSE;
+
+	return job->cancel;
+}
+
+
+/**
+ * @brief wait on the queue condition
+ *
+ * @returns FALSE if the running job was cancelled or the time is up
+ *
+ * @note call with the queue locked
+ */
+
+static gboolean obs_sched_wait_until(gint64 end)
+{
+	if (obs_sched_cancelled())
+		return FALSE;
+
+	if (!g_cond_wait_until(&obs_sched.wake, &obs_sched.lock, end))
+		return FALSE;
+
+	return !obs_sched_cancelled();
+}
+
+
+/**
+ * @brief check whether the drive has arrived at a position
+ *
+ * @note we use 1.5x the axis resolution for tolerance to avoid sampling issues
+ */
+
+static gboolean obs_sched_arrived(const struct capabilities *c,
+				  gdouble az, gdouble el,
+				  struct coord_horizontal hor)
+{
+	gdouble d_az, d_el;
+	gdouble tol_az, tol_el;
+
+
+	tol_az = OBS_SCHED_ARRIVAL_TOL * (gdouble) c->az_res_arcsec / 3600.0;
+	tol_el = OBS_SCHED_ARRIVAL_TOL * (gdouble) c->el_res_arcsec / 3600.0;
+
+	tol_az = MAX(tol_az, OBS_SCHED_ARRIVAL_TOL_MIN);
+	tol_el = MAX(tol_el, OBS_SCHED_ARRIVAL_TOL_MIN);
+
+	d_az = fmod(fabs(az - hor.az), 360.0);
+	d_az = MIN(d_az, 360.0 - d_az);
+	d_el = fabs(el - hor.el);
+
+	return (d_az <= tol_az && d_el <= tol_el);
+}
+
+
+/**
+ * @brief move to a position and wait for the drive to arrive
+ *
+ * @returns 0 on arrival, -1 otherwise
+ *
+ * @note call with the queue locked
+ */
+
+static int obs_sched_goto(guint32 sys, gdouble lon, gdouble lat)
+{
+	gint ret;
+
+	gdouble az, el;
+
+	gint64 t0;
+	gint64 end;
+
+	struct capabilities c = {0};
+	struct coord_horizontal hor;
+
+
+	g_mutex_unlock(&obs_sched.lock);
+
+	t0 = g_get_monotonic_time();
+
+	if (sys == OBS_SYS_HOR) {
+		track_stop();
+		ret = be_moveto_azel(lon, lat);
+	} else {
+		ret = track_sky(sys, lon, lat);
+	}
+
+	be_get_capabilities_drive(&c);
+
+	g_mutex_lock(&obs_sched.lock);
+
+	if (ret)
+		return -1;
+
+	end = g_get_monotonic_time() +
+	      (gint64) OBS_SCHED_MOVE_TIMEOUT_SEC * G_USEC_PER_SEC;
+
+	while (g_get_monotonic_time() < end) {
+
+		g_mutex_unlock(&obs_sched.lock);
+
+		if (sys == OBS_SYS_HOR) {
+			hor.az = lon;
+			hor.el = lat;
+		} else {
+			hor = track_get_hor(sys, lon, lat);
+		}
+
+		ret = be_getpos_azel(&az, &el);
+
+		g_mutex_lock(&obs_sched.lock);
+
+		if (!ret && obs_sched_arrived(&c, az, el, hor)) {
+			t0 = g_get_monotonic_time() - t0;
+			obs_sched.slew_sec += (gdouble) t0 / G_USEC_PER_SEC;
+			return 0;
+		}
+
+		if (obs_sched_cancelled())
+			return -1;
+
+		obs_sched_wait_until(g_get_monotonic_time() +
+				     (gint64) OBS_SCHED_POLL_MS * 1000);
+	}
+
+	g_warning(MSG "drive did not arrive at %g/%g", lon, lat);
+
+	return -1;
+}
+
+
+/**
+ * @brief record spectra at the current position
+ *
+ * @param n_avg the number of spectra to record
+ * @param[out] amp the average of all bins of all spectra
+ *
+ * @returns 0 on success, -1 otherwise
+ *
+ * @note call with the queue locked
+ */
+
+static int obs_sched_integrate(guint32 n_avg, gdouble *amp)
+{
+	gint64 end;
+
+
+	obs_sched.integrating = TRUE;
+	obs_sched.n_spec      = 0;
+	obs_sched.sum         = 0.0;
+	obs_sched.n_bin       = 0;
+
+	g_mutex_unlock(&obs_sched.lock);
+	be_spec_acq_enable(TRUE);
+	g_mutex_lock(&obs_sched.lock);
+
+	end = g_get_monotonic_time() +
+	      (gint64) OBS_SCHED_ACQ_TIMEOUT_SEC * G_USEC_PER_SEC;
+
+	while (obs_sched.n_spec < n_avg) {
+
+		guint32 n_spec = obs_sched.n_spec;
+
+		if (!obs_sched_wait_until(end))
+			break;
+
+		/* the timeout applies to every spectrum */
+		if (obs_sched.n_spec != n_spec)
+			end = g_get_monotonic_time() + (gint64)
+			      OBS_SCHED_ACQ_TIMEOUT_SEC * G_USEC_PER_SEC;
+	}
+
+	obs_sched.integrating = FALSE;
+
+	/* the next move is issued right away, stop recording meanwhile */
+	g_mutex_unlock(&obs_sched.lock);
+	be_spec_acq_enable(FALSE);
+	g_mutex_lock(&obs_sched.lock);
+
+	if (obs_sched.n_spec < n_avg || !obs_sched.n_bin)
+		return -1;
+
+	(*amp) = obs_sched.sum / (gdouble) obs_sched.n_bin;
+
+	return 0;
+}
+
+
+/**
+ * @brief get the drive position at a time from the sampled trail
+ *
+ * @note positions outside of the trail are clamped to its ends
+ *
+ * @note call with the queue locked
+ */
+
+static void obs_sched_trail_at(gint64 t, gdouble *az, gdouble *el)
+{
+	guint i;
+
+	gdouble f;
+	gdouble d_az;
+
+	struct obs_sched_pos *a;
+	struct obs_sched_pos *b;
+
+
+	a = &g_array_index(obs_sched.trail, struct obs_sched_pos, 0);
+
+	for (i = 1; i < obs_sched.trail->len; i++) {
+
+		b = &g_array_index(obs_sched.trail, struct obs_sched_pos, i);
+
+		if (b->t < t) {
+			a = b;
+			continue;
+		}
+
+		f = 0.0;
+		if (b->t > a->t)
+			f = (gdouble) (t - a->t) / (gdouble) (b->t - a->t);
+
+		f = CLAMP(f, 0.0, 1.0);
+
+		/* interpolate the short way around */
+		d_az = fmod(b->az - a->az + 540.0, 360.0) - 180.0;
+
+		(*az) = fmod(a->az + f * d_az + 360.0, 360.0);
+		(*el) = a->el + f * (b->el - a->el);
+
+		return;
+	}
+
+	(*az) = a->az;
+	(*el) = a->el;
+}
+
+
+/**
+ * @brief report the spectra recorded on the fly at their positions
+ *
+ * @param all report also spectra that ended after the last position sample
+ *
+ * @note call with the queue locked
+ */
+
+static void obs_sched_otf_flush(struct obs_sched_job *job, guint32 row,
+				gboolean all)
+{
+	guint i;
+
+	gint64 t_last;
+
+	gdouble lon, lat;
+
+	struct obs_sched_dump *d;
+	struct coord_horizontal hor;
+
+
+	if (!obs_sched.trail->len)
+		return;
+
+	t_last = g_array_index(obs_sched.trail, struct obs_sched_pos,
+			       obs_sched.trail->len - 1).t;
+
+	for (i = 0; i < obs_sched.dumps->len; i++) {
+
+		d = &g_array_index(obs_sched.dumps, struct obs_sched_dump, i);
+
+		/* wait for the position sample after the integration */
+		if (!all && d->t1 > t_last)
+			break;
+
+		obs_sched_trail_at(d->t0 + (d->t1 - d->t0) / 2,
+				   &hor.az, &hor.el);
+
+		if (job->j.sys == OBS_SYS_HOR) {
+			lon = hor.az;
+			lat = hor.el;
+		} else {
+			track_get_sky(job->j.sys, hor, &lon, &lat);
+		}
+
+		obs_sched_status_at(job, OBS_STATE_RUNNING, row, lon, lat,
+				    TRUE, d->amp);
+	}
+
+	g_array_remove_range(obs_sched.dumps, 0, i);
+}
+
+
+/**
+ * @brief sweep a row on the fly
+ *
+ * @returns 0 on success, -1 otherwise
+ *
+ * @note call with the queue locked
+ */
+
+static int obs_sched_otf_row(struct obs_sched_job *job, guint32 row)
+{
+	int ret;
+
+	gdouble lon;
+	gdouble lat0, lat1;
+
+	gint64 end;
+
+	struct capabilities c = {0};
+	struct obs_sched_pos pos;
+	struct coord_horizontal hor0;
+	struct coord_horizontal hor1;
+
+
+	obs_sched_job_point(job, 2 * row, &lon, &lat0);
+	obs_sched_job_point(job, 2 * row + 1, &lon, &lat1);
+
+	/* the row is swept in the horizon system, the drive must not track */
+	if (job->j.sys == OBS_SYS_HOR) {
+		hor0.az = lon;
+		hor0.el = lat0;
+	} else {
+		g_mutex_unlock(&obs_sched.lock);
+		hor0 = track_get_hor(job->j.sys, lon, lat0);
+		g_mutex_lock(&obs_sched.lock);
+	}
+
+	if (obs_sched_goto(OBS_SYS_HOR, hor0.az, hor0.el))
+		return -1;
+
+	g_array_set_size(obs_sched.trail, 0);
+	g_array_set_size(obs_sched.dumps, 0);
+
+	obs_sched.integrating = TRUE;
+	obs_sched.otf         = TRUE;
+	obs_sched.sum         = 0.0;
+	obs_sched.n_bin       = 0;
+	obs_sched.t_dump      = g_get_monotonic_time();
+
+	g_mutex_unlock(&obs_sched.lock);
+
+	if (job->j.sys == OBS_SYS_HOR) {
+		hor1.az = lon;
+		hor1.el = lat1;
+	} else {
+		hor1 = track_get_hor(job->j.sys, lon, lat1);
+	}
+
+	be_get_capabilities_drive(&c);
+
+	be_spec_acq_enable(TRUE);
+	ret = be_moveto_azel(hor1.az, hor1.el);
+
+	g_mutex_lock(&obs_sched.lock);
+
+	end = g_get_monotonic_time() +
+	      (gint64) OBS_SCHED_MOVE_TIMEOUT_SEC * G_USEC_PER_SEC;
+
+	while (!ret) {
+
+		g_mutex_unlock(&obs_sched.lock);
+		ret = be_getpos_azel(&pos.az, &pos.el);
+		pos.t = g_get_monotonic_time();
+		g_mutex_lock(&obs_sched.lock);
+
+		if (!ret) {
+			g_array_append_val(obs_sched.trail, pos);
+			obs_sched_otf_flush(job, row, FALSE);
+
+			if (obs_sched_arrived(&c, pos.az, pos.el, hor1))
+				break;
+		}
+
+		if (job->cancel || pos.t > end) {
+			ret = -1;
+			break;
+		}
+
+		obs_sched_wait_until(g_get_monotonic_time() +
+				     (gint64) OBS_SCHED_POLL_MS * 1000);
+		ret = 0;
+	}
+
+	/* report the rest at the end of the row, the spectrum in progress
+	 * is dropped
+	 */
+	obs_sched_otf_flush(job, row, TRUE);
+
+	obs_sched.integrating = FALSE;
+	obs_sched.otf         = FALSE;
+
+	g_mutex_unlock(&obs_sched.lock);
+	be_spec_acq_enable(FALSE);
+	g_mutex_lock(&obs_sched.lock);
+
+	return ret;
+}
+
+
+/**
+ * @brief plan the order of the positions of a grid job
+ *
+ * @note the candidates are the boustrophedon orders along either axis from
+ *	 every corner; the best one is refined by the planner
+ *
+ * @note the positions are converted to the horizon system at the start of
+ *	 the job, the slow drift of the sky during the job is ignored
+ *
+ * @note call with the queue locked
+ */
+
+static void obs_sched_plan(struct obs_sched_job *job)
+{
+	guint i, k, m;
+	guint n, n_in, n_out;
+	guint v;
+	guint i_out, i_in;
+
+	gdouble lon, lat;
+	gdouble cost;
+	gdouble raster = 0.0;
+	gdouble best   = G_MAXDOUBLE;
+
+	gchar *msg;
+
+	guint *order;
+	guint *cand;
+
+	struct coord_horizontal start;
+	struct coord_horizontal *hor;
+
+
+	n = obs_sched_job_len(job);
+
+	if (job->j.mode != OBS_MODE_GRID || job->order || job->idx)
+		return;
+
+	if (n < 3 || n > OBS_SCHED_PLAN_MAX)
+		return;
+
+	g_mutex_unlock(&obs_sched.lock);
+
+	if (be_getpos_azel(&start.az, &start.el)) {
+		g_mutex_lock(&obs_sched.lock);
+		return;
+	}
+
+	hor   = g_malloc(n * sizeof(struct coord_horizontal));
+	order = g_malloc(n * sizeof(guint));
+	cand  = g_malloc(n * sizeof(guint));
+
+	for (i = 0; i < n; i++) {
+
+		obs_sched_grid_point(job, i, &lon, &lat);
+
+		if (job->j.sys == OBS_SYS_HOR) {
+			hor[i].az = lon;
+			hor[i].el = lat;
+		} else {
+			hor[i] = track_get_hor(job->j.sys, lon, lat);
+		}
+	}
+
+	/* bit 0: inner axis is longitude, bit 1: reverse outer axis,
+	 * bit 2: the first row runs backwards
+	 */
+	for (v = 0; v < 8; v++) {
+
+		n_in  = (v & 1) ? job->n_lon : job->n_lat;
+		n_out = (v & 1) ? job->n_lat : job->n_lon;
+
+		for (k = 0, m = 0; k < n_out; k++) {
+
+			i_out = (v & 2) ? n_out - 1 - k : k;
+
+			for (i = 0; i < n_in; i++) {
+
+				i_in = (((v >> 2) ^ k) & 1) ? n_in - 1 - i : i;
+
+				if (v & 1)
+					cand[m++] = i_in * job->n_lat + i_out;
+				else
+					cand[m++] = i_out * job->n_lat + i_in;
+			}
+		}
+
+		cost = obs_plan_path(hor, n, start, cand);
+
+		/* the unplanned order */
+		if (!v)
+			raster = cost;
+
+		if (cost < best) {
+			best = cost;
+			memcpy(order, cand, n * sizeof(guint));
+		}
+	}
+
+	cost = obs_plan_order(hor, n, start, order);
+
+	msg = g_strdup_printf("Observation job %u: estimated slew %s %.1f%s "
+			      "planned, %.1f%s in raster order\n",
+			      job->j.id,
+			      obs_plan_timed() ? "time" : "travel",
+			      cost, obs_plan_timed() ? " s" : "°",
+			      raster, obs_plan_timed() ? " s" : "°");
+	g_message(MSG "%s", msg);
+	net_server_broadcast_message(msg, NULL);
+	g_free(msg);
+
+	g_free(cand);
+	g_free(hor);
+
+	g_mutex_lock(&obs_sched.lock);
+
+	job->order     = order;
+	job->slew_plan = cost;
+}
+
+
+/**
+ * @brief execute a job
+ *
+ * @note call with the queue locked
+ */
+
+static void obs_sched_run(struct obs_sched_job *job)
+{
+	int ret;
+
+	gchar *msg;
+
+	gdouble lon, lat;
+	gdouble amp;
+
+	gboolean valid;
+
+
+	g_message(MSG "starting job %u (%s) at %s %u of %u",
+		  job->j.id, job->j.name,
+		  job->j.mode == OBS_MODE_OTF ? "row" : "position",
+		  job->idx + 1, obs_sched_job_len(job));
+
+	obs_sched.slew_sec = 0.0;
+
+	obs_sched_plan(job);
+
+	for (; job->idx < obs_sched_job_len(job); job->idx++) {
+
+		if (job->j.mode == OBS_MODE_OTF) {
+
+			ret = obs_sched_otf_row(job, job->idx);
+
+			if (job->cancel)
+				break;
+
+			if (ret)
+				g_message(MSG "job %u: skipped row %u",
+					  job->j.id, job->idx);
+
+			job->idx++;
+			obs_sched_save();
+			job->idx--;
+
+			continue;
+		}
+
+		obs_sched_job_point(job, job->idx, &lon, &lat);
+
+		amp   = 0.0;
+		valid = FALSE;
+
+		if (!obs_sched_goto(job->j.sys, lon, lat))
+			valid = !obs_sched_integrate(job->j.n_avg, &amp);
+
+		if (job->cancel)
+			break;
+
+		if (!valid)
+			g_message(MSG "job %u: skipped position %g/%g",
+				  job->j.id, lon, lat);
+
+		obs_sched_status(job, OBS_STATE_RUNNING, job->idx, valid, amp);
+
+		/* the position is complete, resume after it on restart */
+		job->idx++;
+		obs_sched_save();
+		job->idx--;
+	}
+
+	g_mutex_unlock(&obs_sched.lock);
+	track_stop();
+	g_mutex_lock(&obs_sched.lock);
+
+	if (job->cancel) {
+		g_message(MSG "job %u cancelled", job->j.id);
+		obs_sched_status(job, OBS_STATE_CANCELLED, job->idx,
+				 FALSE, 0.0);
+	} else {
+		g_message(MSG "job %u complete", job->j.id);
+		obs_sched_status(job, OBS_STATE_DONE, job->idx, FALSE, 0.0);
+	}
+
+	/* slew times include settling and the arrival poll interval */
+	if (!job->cancel && job->slew_plan > 0.0 && obs_plan_timed()) {
+		msg = g_strdup_printf("Observation job %u: actual slew time "
+				      "%.1f s, estimated %.1f s\n", job->j.id,
+				      obs_sched.slew_sec, job->slew_plan);
+		g_message(MSG "%s", msg);
+		net_server_broadcast_message(msg, NULL);
+		g_free(msg);
+	}
+}
+
+
+/**
+ * @brief the scheduler thread
+ */
+
+static gpointer obs_sched_thread(gpointer data)
+{
+	struct obs_sched_job *job;
+
+
+	g_mutex_lock(&obs_sched.lock);
+
+	while (1) {
+
+		job = g_queue_peek_head(&obs_sched.q);
+
+		if (!job) {
+			g_cond_wait(&obs_sched.wake, &obs_sched.lock);
+			continue;
+		}
+
+		obs_sched_run(job);
+
+		g_queue_remove(&obs_sched.q, job);
+		obs_sched_job_free(job);
+
+		obs_sched_save();
+	}
+
+	g_mutex_unlock(&obs_sched.lock);
+
+	return NULL;
+}
+
+
+/**
+ * @brief submit an observation job
+ *
+ * @param j the job description; the id is assigned
+ *
+ * @returns the id of the job or 0 if it was rejected
+ */
+
+guint32 obs_sched_submit(struct obs_job *j)
+{
+	guint32 id;
+
+	struct obs_sched_job *job;
+
+
+	job = g_malloc0(sizeof(struct obs_sched_job));
+
+	job->j = (*j);
+
+	if (obs_sched_job_setup(job)) {
+		obs_sched_job_free(job);
+		return 0;
+	}
+
+	g_mutex_lock(&obs_sched.lock);
+
+	id = job->j.id = obs_sched.id_next++;
+
+	g_message(MSG "queued job %u (%s) with %u %s", id, job->j.name,
+		  obs_sched_job_len(job),
+		  job->j.mode == OBS_MODE_OTF ? "rows" : "positions");
+
+	g_queue_push_tail(&obs_sched.q, job);
+	obs_sched_save();
+
+	obs_sched_status(job, OBS_STATE_QUEUED, 0, FALSE, 0.0);
+
+	g_cond_signal(&obs_sched.wake);
+
+	g_mutex_unlock(&obs_sched.lock);
+
+	/* the job may already be running or gone */
+	return id;
+}
+
+
+/**
+ * @brief cancel an observation job
+ *
+ * @param id the job to cancel, 0 cancels all jobs
+ *
+ * @returns 0 on success, -1 if no such job exists
+ */
+
+int obs_sched_cancel(guint32 id)
+{
+	int ret = -1;
+
+	GList *l;
+	GList *next;
+
+	struct obs_sched_job *job;
+
+
+	g_mutex_lock(&obs_sched.lock);
+
+	for (l = obs_sched.q.head; l; l = next) {
+
+		next = l->next;
+		job  = (struct obs_sched_job *) l->data;
+
+		if (id && job->j.id != id)
+			continue;
+
+		ret = 0;
+
+		/* the running job ends at the next opportunity */
+		if (l == obs_sched.q.head) {
+			job->cancel = TRUE;
+			g_cond_signal(&obs_sched.wake);
+			continue;
+		}
+
+		obs_sched_status(job, OBS_STATE_CANCELLED, job->idx,
+				 FALSE, 0.0);
+
+		g_queue_delete_link(&obs_sched.q, l);
+		obs_sched_job_free(job);
+	}
+
+	obs_sched_save();
+
+	g_mutex_unlock(&obs_sched.lock);
+
+	return ret;
+}
+
+
+/**
+ * @brief initialise the scheduler and resume the saved queue
+ */
+
+void obs_sched_init(void)
+{
+	obs_sched.id_next = 1;
+	obs_sched.dumps   = g_array_new(FALSE, FALSE,
+					sizeof(struct obs_sched_dump));
+	obs_sched.trail   = g_array_new(FALSE, FALSE,
+					sizeof(struct obs_sched_pos));
+	obs_sched.path    = g_build_filename(g_get_user_config_dir(), CONFDIR,
+					     OBS_SCHED_QUEUE_FILE, NULL);
+
+	obs_sched_load();
+
+	ack_spec_set_observer(obs_sched_spec_observer);
+
+	g_thread_new(NULL, obs_sched_thread, NULL);
+}
@@ -42,6 +42,9 @@ static gboolean cmd_is_priv(struct packet *pkt)
 	case PR_SPEC_ACQ_DISABLE:
 	case PR_HOT_LOAD_ENABLE:
 	case PR_HOT_LOAD_DISABLE:
+	case PR_TRACK:
+	case PR_OBS_JOB:
+	case PR_OBS_CANCEL:
 		return TRUE;
 	default:
 		break;
@@ -153,6 +156,18 @@ static int process_pkt_priv(struct packet *pkt, gpointer ref)
 		proc_pr_hot_load_disable(pkt, ref);
 		break;
 
+	case PR_TRACK:
+		proc_pr_track(pkt, ref);
+		break;
+
+	case PR_OBS_JOB:
+		proc_pr_obs_job(pkt, ref);
+		break;
+
+	case PR_OBS_CANCEL:
+		proc_pr_obs_cancel(pkt, ref);
+		break;
+
 	default:
 		/* connection has priviledge, but command is other */
 		return process_pkt_other(pkt, ref);
@@ -0,0 +1,245 @@
+/**
+ * @file    server/pos_pub.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief drive position publishing policy for the backends
+ *
+ * @note a position is published only if it differs from the last published
+ *	 one by at least the drive resolution in either axis, or if nothing
+ *	 was published for a heartbeat interval; the position at the end of a
+ *	 move is always published, so a final step smaller than the resolution
+ *	 is not lost
+ *
+ * @note a drive is considered moving if it was commanded or its position
+ *	 changed within the settle time; backends which must poll the
+ *	 position from their hardware use pos_pub_wait() to poll fast while
+ *	 the drive moves and slowly while it is idle
+ */
+
+#include <math.h>
+
+#include <pos_pub.h>
+#include <ack.h>
+
+
+/* poll interval while the drive moves */
+#define POS_PUB_FAST_MS		100
+
+/* poll interval while the drive is idle, catches manual motion */
+#define POS_PUB_IDLE_MS		2000
+
+/* time without a change before a drive is considered idle */
+#define POS_PUB_SETTLE_MS	2000
+
+/* maximum time between publications */
+#define POS_PUB_HEARTBEAT_SEC	10
+
+
+struct pos_pub {
+	gdouble az_res;			/* deadband in azimuth (deg) */
+	gdouble el_res;			/* deadband in elevation (deg) */
+
+	gdouble az;			/* last published azimuth */
+	gdouble el;			/* last published elevation */
+	gboolean valid;			/* a position was published */
+
+	gint64 t_pub;			/* time of the last publication (usec) */
+	gint64 t_change;		/* time of the last motion (usec) */
+
+	gboolean kick;			/* a move was commanded */
+
+	GMutex lock;
+	GCond wake;
+};
+
+
+/**
+ * @brief check whether the drive is moving
+ *
+ * @note call with the publisher locked
+ */
+
+static gboolean pos_pub_is_moving(struct pos_pub *p, gint64 now)
+{
+	return (now - p->t_change) < (gint64) POS_PUB_SETTLE_MS * 1000;
+}
+
+
+/**
+ * @brief create a position publisher
+ *
+ * @param az_res the azimuth resolution of the drive in degrees
+ * @param el_res the elevation resolution of the drive in degrees
+ *
+ * @returns the publisher
+ */
+
+struct pos_pub *pos_pub_new(gdouble az_res, gdouble el_res)
+{
+	struct pos_pub *p;
+
+
+	p = g_malloc0(sizeof(struct pos_pub));
+
+	if (isfinite(az_res))
+		p->az_res = fabs(az_res);
+
+	if (isfinite(el_res))
+		p->el_res = fabs(el_res);
+
+	g_mutex_init(&p->lock);
+	g_cond_init(&p->wake);
+
+	return p;
+}
+
+
+/**
+ * @brief publish a drive position if it is worth it or forced to
+ *
+ * @returns TRUE if the position was sent to the clients
+ */
+
+static gboolean pos_pub_update(struct pos_pub *p, gdouble az, gdouble el,
+			       gboolean force)
+{
+	gint64 now;
+
+	gdouble d_az;
+	gdouble d_el;
+
+	gboolean pub;
+
+	struct getpos pos;
+
+
+	now = g_get_monotonic_time();
+
+	g_mutex_lock(&p->lock);
+
+	d_az = fmod(fabs(az - p->az), 360.0);
+	d_az = MIN(d_az, 360.0 - d_az);
+	d_el = fabs(el - p->el);
+
+	pub = !p->valid || d_az >= p->az_res || d_el >= p->el_res;
+
+	if (pub)
+		p->t_change = now;
+
+	if (now - p->t_pub >= (gint64) POS_PUB_HEARTBEAT_SEC * G_USEC_PER_SEC)
+		pub = TRUE;
+
+	if (force)
+		pub = TRUE;
+
+	if (pub) {
+		p->az    = az;
+		p->el    = el;
+		p->valid = TRUE;
+		p->t_pub = now;
+	}
+
+	g_mutex_unlock(&p->lock);
+
+	if (!pub)
+		return FALSE;
+
+	pos.az_arcsec = (typeof(pos.az_arcsec)) (az * 3600.0);
+	pos.el_arcsec = (typeof(pos.el_arcsec)) (el * 3600.0);
+	ack_getpos_azel(PKT_TRANS_ID_UNDEF, &pos);
+
+	return TRUE;
+}
+
+
+/**
+ * @brief publish an intermediate drive position if it is worth it
+ *
+ * @param p the publisher
+ * @param az the azimuth in degrees
+ * @param el the elevation in degrees
+ *
+ * @returns TRUE if the position was sent to the clients
+ */
+
+gboolean pos_pub_push(struct pos_pub *p, gdouble az, gdouble el)
+{
+	return pos_pub_update(p, az, el, FALSE);
+}
+
+
+/**
+ * @brief publish the drive position at the end of a move
+ *
+ * @param p the publisher
+ * @param az the azimuth in degrees
+ * @param el the elevation in degrees
+ *
+ * @note the position is sent regardless of the deadband
+ */
+
+void pos_pub_arrived(struct pos_pub *p, gdouble az, gdouble el)
+{
+	pos_pub_update(p, az, el, TRUE);
+}
+
+
+/**
+ * @brief signal that the drive was commanded to move
+ *
+ * @note this wakes a poller waiting in pos_pub_wait()
+ */
+
+void pos_pub_moving(struct pos_pub *p)
+{
+	g_mutex_lock(&p->lock);
+
+	p->t_change = g_get_monotonic_time();
+	p->kick     = TRUE;
+
+	g_cond_signal(&p->wake);
+
+	g_mutex_unlock(&p->lock);
+}
+
+
+/**
+ * @brief wait until the position should be polled again
+ *
+ * @note returns early if a move was commanded
+ */
+
+void pos_pub_wait(struct pos_pub *p)
+{
+	gint64 now;
+	gint64 end;
+
+
+	g_mutex_lock(&p->lock);
+
+	now = g_get_monotonic_time();
+
+	if (pos_pub_is_moving(p, now))
+		end = now + (gint64) POS_PUB_FAST_MS * 1000;
+	else
+		end = now + (gint64) POS_PUB_IDLE_MS * 1000;
+
+	while (!p->kick) {
+		if (!g_cond_wait_until(&p->wake, &p->lock, end))
+			break;
+	}
+
+	p->kick = FALSE;
+
+	g_mutex_unlock(&p->lock);
+}
@@ -18,6 +18,7 @@
 
 #include <ack.h>
 #include <backend.h>
+#include <track.h>
 
 
 /**
@@ -47,6 +48,9 @@ void proc_pr_moveto_azel(struct packet *pkt, gpointer ref)
 	el = (double) m->el_arcsec / 3600.0;
 
 
+	/* an explicit move ends tracking */
+	track_stop();
+
 	if(be_moveto_azel(az, el))
 		ack_fail(pkt->trans_id, ref);
 	else
@@ -0,0 +1,45 @@
+/**
+ * @file    server/proc/proc_pr_obs_cancel.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <ack.h>
+#include <obs_sched.h>
+
+
+/**
+ * @brief process command obs cancel
+ */
+
+void proc_pr_obs_cancel(struct packet *pkt, gpointer ref)
+{
+	struct obs_cancel *c;
+
+
+	g_debug("Client requested observation job cancellation");
+
+	if (pkt->data_size != sizeof(struct obs_cancel)) {
+		ack_invalid_pkt(pkt->trans_id);
+		return;
+	}
+
+	c = (struct obs_cancel *) pkt->data;
+
+	if (obs_sched_cancel(c->id))
+		ack_fail(pkt->trans_id, ref);
+	else
+		ack_success(pkt->trans_id, ref);
+}
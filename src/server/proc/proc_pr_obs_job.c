@@ -0,0 +1,40 @@
+/**
+ * @file    server/proc/proc_pr_obs_job.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <ack.h>
+#include <obs_sched.h>
+
+
+/**
+ * @brief process command obs job
+ */
+
+void proc_pr_obs_job(struct packet *pkt, gpointer ref)
+{
+	g_debug("Client requested observation job");
+
+	if (pkt->data_size != sizeof(struct obs_job)) {
+		ack_invalid_pkt(pkt->trans_id);
+		return;
+	}
+
+	if (obs_sched_submit((struct obs_job *) pkt->data))
+		ack_success(pkt->trans_id, ref);
+	else
+		ack_fail(pkt->trans_id, ref);
+}
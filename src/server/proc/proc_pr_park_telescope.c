@@ -18,6 +18,7 @@
 
 #include <ack.h>
 #include <backend.h>
+#include <track.h>
 
 
 /**
@@ -28,6 +29,8 @@ void proc_pr_park_telescope(struct packet *pkt, gpointer ref)
 {
 	g_message("Client requested park_telescope");
 
+	track_stop();
+
 	be_park_telescope();
 
 	ack_success(pkt->trans_id, ref);
@@ -18,6 +18,7 @@
 
 #include <ack.h>
 #include <backend.h>
+#include <track.h>
 
 
 /**
@@ -28,6 +29,8 @@ void proc_pr_recalibrate_pointing(struct packet *pkt, gpointer ref)
 {
 	g_message("Client requested recalibrate_pointing");
 
+	track_stop();
+
 	be_recalibrate_pointing();
 
 	ack_success(pkt->trans_id, ref);
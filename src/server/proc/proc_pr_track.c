@@ -0,0 +1,64 @@
+/**
+ * @file    server/proc/proc_pr_track.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ */
+
+#include <glib.h>
+
+#include <ack.h>
+#include <track.h>
+
+
+/**
+ * @brief process command track
+ */
+
+void proc_pr_track(struct packet *pkt, gpointer ref)
+{
+	double lon;
+	double lat;
+
+	struct track *t;
+
+
+	g_debug("Client requested track");
+
+	if (pkt->data_size != sizeof(struct track)) {
+		ack_invalid_pkt(pkt->trans_id);
+		return;
+	}
+
+
+	t = (struct track *) pkt->data;
+
+	if (!t->enable) {
+		track_stop();
+		ack_success(pkt->trans_id, ref);
+		return;
+	}
+
+	/* convert arcseconds to degrees */
+	lon = (double) t->lon_arcsec / 3600.0;
+	lat = (double) t->lat_arcsec / 3600.0;
+
+	if (track_sky(t->sys, lon, lat)) {
+		ack_fail(pkt->trans_id, ref);
+		/* let the clients resynchronise their state */
+		track_push_state();
+	} else {
+		ack_success(pkt->trans_id, ref);
+	}
+
+	return;
+}
@@ -0,0 +1,632 @@
+/**
+ * @file    server/serial.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief serial transport for the hardware backends
+ *
+ * @note the tty is opened non-blocking and every transfer waits in poll()
+ *	 with a deadline, so a device that stops responding results in a
+ *	 short read rather than a thread stuck in read() forever
+ *
+ * @note a link does no locking of its own, the backends serialise access
+ *	 (e.g. via the shared comlink lock), only the statistics are protected
+ *	 so they can be read from any thread
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include <serial.h>
+
+
+#define MSG "SERIAL: "
+
+/* interval between periodic statistics reports */
+#define SERIAL_STATS_INTERVAL_SEC	600
+
+/* bits on the line per byte in 8N1 */
+#define SERIAL_BITS_PER_BYTE		10
+
+
+struct serial_link {
+	gchar *tty;
+	gint fd;
+	gint baud;
+
+	gboolean stalled;		/* last transfer timed out */
+
+	gint64 t_write;			/* time of the last write (usec) */
+	gint64 t_open;			/* time the link was opened (usec) */
+	gint64 t_report;		/* time of the last report (usec) */
+
+	GMutex lock;			/* protects st */
+	struct serial_stats st;
+};
+
+
+/**
+ * @brief convert numerical value to speed_t
+ * @note see man 3 termios
+ */
+
+static speed_t serial_baudrate(gint baud)
+{
+	switch (baud) {
+	case 2400:
+		return B2400;
+	case 4800:
+		return B4800;
+	case 9600:
+		return B9600;
+	case 19200:
+		return B19200;
+	case 38400:
+		return B38400;
+	case 57600:
+		return B57600;
+	case 115200:
+		return B115200;
+	case 230400:
+		return B230400;
+	case 460800:
+		return B460800;
+	case 500000:
+		return B500000;
+	case 576000:
+		return B576000;
+	case 921600:
+		return B921600;
+	case 1000000:
+		return B1000000;
+	case 1152000:
+		return B1152000;
+	case 1500000:
+		return B1500000;
+	case 2000000:
+		return B2000000;
+	default:
+		g_warning(MSG "unsupported baud rate %d", baud);
+		return B0;	/* hang up */
+	}
+}
+
+
+/**
+ * @brief set raw 8N1 mode at a given rate
+ *
+ * @return see man 3 tcsetattr
+ */
+
+static int serial_set_comm_param(gint fd, gint baud)
+{
+	struct termios cfg = {0};
+
+
+	/* we start from a cleared struct, so we need only set our config;
+	 * reads never block in the tty layer, we wait in poll() instead
+	 */
+	cfg.c_cflag = CS8 | CLOCAL | CREAD;
+	cfg.c_iflag = IGNPAR;
+
+	cfsetispeed(&cfg, serial_baudrate(baud));
+	cfsetospeed(&cfg, serial_baudrate(baud));
+
+	cfg.c_cc[VMIN]  = 0;
+	cfg.c_cc[VTIME] = 0;
+
+	return tcsetattr(fd, TCSANOW, &cfg);
+}
+
+
+/**
+ * @brief get the deadline for a timeout
+ */
+
+static gint64 serial_deadline(gint timeout_ms)
+{
+	if (timeout_ms < 0)
+		return G_MAXINT64;
+
+	return g_get_monotonic_time() + (gint64) timeout_ms * 1000;
+}
+
+
+/**
+ * @brief wait for the tty to become ready until a deadline
+ *
+ * @returns 1 if ready, 0 on timeout, -1 on error
+ */
+
+static gint serial_wait(struct serial_link *l, gshort events, gint64 deadline)
+{
+	gint ret;
+	gint ms;
+
+	gint64 left;
+
+	struct pollfd pfd;
+
+
+	pfd.fd     = l->fd;
+	pfd.events = events;
+
+	do {
+		if (deadline == G_MAXINT64) {
+			ms = -1;
+		} else {
+			left = deadline - g_get_monotonic_time();
+			if (left <= 0)
+				return 0;
+
+			/* round up, or we spin for the last millisecond */
+			ms = (gint) ((left + 999) / 1000);
+		}
+
+		ret = poll(&pfd, 1, ms);
+
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0) {
+		g_warning(MSG "%s: poll failed: %s", l->tty, g_strerror(errno));
+		return -1;
+	}
+
+	if (ret && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))) {
+		g_warning(MSG "%s: device error or hangup", l->tty);
+		return -1;
+	}
+
+	return ret;
+}
+
+
+/**
+ * @brief report the statistics every now and then
+ */
+
+static void serial_report(struct serial_link *l)
+{
+	gint64 now;
+
+
+	now = g_get_monotonic_time();
+
+	if (now - l->t_report < (gint64) SERIAL_STATS_INTERVAL_SEC *
+				G_USEC_PER_SEC)
+		return;
+
+	l->t_report = now;
+
+	serial_log_stats(l);
+}
+
+
+/**
+ * @brief account for a completed or timed out transfer
+ */
+
+static void serial_account(struct serial_link *l, gboolean timeout)
+{
+	if (timeout) {
+
+		g_mutex_lock(&l->lock);
+		l->st.n_timeout++;
+		g_mutex_unlock(&l->lock);
+
+		/* only report the transition, not every poll of a dead device */
+		if (!l->stalled)
+			g_warning(MSG "%s: device not responding", l->tty);
+
+		l->stalled = TRUE;
+
+		return;
+	}
+
+	if (l->stalled)
+		g_message(MSG "%s: device is responding again", l->tty);
+
+	l->stalled = FALSE;
+
+	serial_report(l);
+}
+
+
+/**
+ * @brief note the arrival of the first byte of a response
+ */
+
+static void serial_rsp_started(struct serial_link *l)
+{
+	gint64 lat;
+
+
+	if (!l->t_write)
+		return;
+
+	lat = g_get_monotonic_time() - l->t_write;
+	l->t_write = 0;
+
+	g_mutex_lock(&l->lock);
+
+	if (!l->st.n_rsp || lat < l->st.lat_min_us)
+		l->st.lat_min_us = lat;
+
+	if (lat > l->st.lat_max_us)
+		l->st.lat_max_us = lat;
+
+	l->st.lat_sum_us += lat;
+	l->st.n_rsp++;
+
+	g_mutex_unlock(&l->lock);
+}
+
+
+/**
+ * @brief read from the tty until a deadline
+ *
+ * @param l the serial link
+ * @param buf the buffer to read to
+ * @param n the number of bytes to read
+ * @param line if set, stop after a line terminator (\r or \n) and skip
+ *	  leading terminators
+ * @param deadline the deadline
+ * @param[out] timeout set if the deadline passed before we were done
+ *
+ * @returns the number of bytes read, excluding the terminator of a line,
+ *	    or -1 on error
+ *
+ * @note lines are read one byte at a time so we never consume the start of
+ *	 the next message
+ */
+
+static gssize serial_recv(struct serial_link *l, guint8 *buf, gsize n,
+			  gboolean line, gint64 deadline, gboolean *timeout)
+{
+	gint ret;
+
+	gsize got = 0;
+	ssize_t nr;
+
+
+	(*timeout) = FALSE;
+
+	while (got < n) {
+
+		ret = serial_wait(l, POLLIN, deadline);
+		if (ret < 0)
+			return -1;
+
+		if (!ret) {
+			(*timeout) = TRUE;
+			break;
+		}
+
+		nr = read(l->fd, &buf[got], line ? 1 : n - got);
+		if (nr < 0) {
+			if (errno == EAGAIN || errno == EINTR)
+				continue;
+
+			g_warning(MSG "%s: read failed: %s", l->tty,
+				  g_strerror(errno));
+			return -1;
+		}
+
+		if (!nr)
+			continue;
+
+		serial_rsp_started(l);
+
+		g_mutex_lock(&l->lock);
+		l->st.rx_bytes += (guint64) nr;
+		g_mutex_unlock(&l->lock);
+
+		if (line && (buf[got] == '\r' || buf[got] == '\n')) {
+			if (got)
+				break;
+			continue;
+		}
+
+		got += (gsize) nr;
+	}
+
+	return (gssize) got;
+}
+
+
+/**
+ * @brief open and configure a serial tty
+ *
+ * @param tty the path to the tty
+ * @param baud the line rate
+ *
+ * @returns the link or NULL on error
+ */
+
+struct serial_link *serial_open(const gchar *tty, gint baud)
+{
+	gint fd;
+
+	struct serial_link *l;
+
+
+	fd = open(tty, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0) {
+		g_warning(MSG "unable to open %s: %s", tty, g_strerror(errno));
+		return NULL;
+	}
+
+	if (serial_set_comm_param(fd, baud)) {
+		g_warning(MSG "unable to configure %s: %s", tty,
+			  g_strerror(errno));
+		close(fd);
+		return NULL;
+	}
+
+	tcflush(fd, TCIOFLUSH);
+
+	l = g_malloc0(sizeof(struct serial_link));
+
+	l->tty  = g_strdup(tty);
+	l->fd   = fd;
+	l->baud = baud;
+
+	l->t_open   = g_get_monotonic_time();
+	l->t_report = l->t_open;
+
+	g_mutex_init(&l->lock);
+
+	g_message(MSG "opened %s at %d baud", tty, baud);
+
+	return l;
+}
+
+
+/**
+ * @brief close a serial link
+ *
+ * @param l the serial link (may be NULL)
+ */
+
+void serial_close(struct serial_link *l)
+{
+	if (!l)
+		return;
+
+	serial_log_stats(l);
+
+	close(l->fd);
+
+	g_mutex_clear(&l->lock);
+	g_free(l->tty);
+	g_free(l);
+}
+
+
+/**
+ * @brief write to a serial link
+ *
+ * @param l the serial link
+ * @param buf the buffer to write from
+ * @param n the number of bytes to write
+ * @param timeout_ms the time allowed for the transfer or SERIAL_TIMEOUT_INF
+ *
+ * @returns the number of bytes written, which is less than n on timeout,
+ *	    or -1 on error
+ *
+ * @note this returns when the data is in the output queue of the tty, not
+ *	 when they were sent
+ */
+
+gssize serial_write(struct serial_link *l, const void *buf, gsize n,
+		    gint timeout_ms)
+{
+	gint ret;
+
+	gsize put = 0;
+	ssize_t nw;
+
+	gint64 deadline;
+
+	const guint8 *p = buf;
+
+
+	deadline = serial_deadline(timeout_ms);
+
+	while (put < n) {
+
+		nw = write(l->fd, &p[put], n - put);
+
+		if (nw < 0) {
+
+			if (errno != EAGAIN && errno != EINTR) {
+				g_warning(MSG "%s: write failed: %s", l->tty,
+					  g_strerror(errno));
+				return -1;
+			}
+
+			ret = serial_wait(l, POLLOUT, deadline);
+			if (ret < 0)
+				return -1;
+
+			if (!ret)
+				break;
+
+			continue;
+		}
+
+		put += (gsize) nw;
+	}
+
+	g_mutex_lock(&l->lock);
+	l->st.tx_bytes += put;
+	g_mutex_unlock(&l->lock);
+
+	serial_account(l, put < n);
+
+	l->t_write = g_get_monotonic_time();
+
+	return (gssize) put;
+}
+
+
+/**
+ * @brief read a number of bytes from a serial link
+ *
+ * @param l the serial link
+ * @param buf the buffer to read to
+ * @param n the number of bytes to read
+ * @param timeout_ms the time allowed for the transfer or SERIAL_TIMEOUT_INF
+ *
+ * @returns the number of bytes read, which is less than n on timeout,
+ *	    or -1 on error
+ */
+
+gssize serial_read(struct serial_link *l, void *buf, gsize n, gint timeout_ms)
+{
+	gssize ret;
+
+	gboolean timeout;
+
+
+	ret = serial_recv(l, buf, n, FALSE, serial_deadline(timeout_ms),
+			  &timeout);
+
+	if (ret >= 0)
+		serial_account(l, timeout);
+
+	return ret;
+}
+
+
+/**
+ * @brief read a line from a serial link
+ *
+ * @param l the serial link
+ * @param buf the buffer to read to, always NUL-terminated on return
+ * @param n the size of the buffer
+ * @param timeout_ms the time allowed for the transfer or SERIAL_TIMEOUT_INF
+ *
+ * @returns the length of the line without terminator, or -1 on error
+ *
+ * @note either of \r and \n terminate a line, so it does not matter what
+ *	 the device or the tty settings produce; empty lines are skipped
+ */
+
+gssize serial_read_line(struct serial_link *l, gchar *buf, gsize n,
+			gint timeout_ms)
+{
+	gssize ret;
+
+	gboolean timeout;
+
+
+	if (!n)
+		return -1;
+
+	ret = serial_recv(l, (guint8 *) buf, n - 1, TRUE,
+			  serial_deadline(timeout_ms), &timeout);
+
+	buf[MAX(ret, 0)] = '\0';
+
+	if (ret >= 0)
+		serial_account(l, timeout);
+
+	return ret;
+}
+
+
+/**
+ * @brief discard pending input
+ *
+ * @param l the serial link
+ * @param quiet_ms if not 0, also discard whatever arrives until the line was
+ *	  quiet for this long
+ */
+
+void serial_flush(struct serial_link *l, gint quiet_ms)
+{
+	guint8 c[64];
+
+
+	tcflush(l->fd, TCIFLUSH);
+
+	if (!quiet_ms)
+		return;
+
+	while (serial_wait(l, POLLIN, serial_deadline(quiet_ms)) > 0) {
+		if (read(l->fd, c, sizeof(c)) <= 0)
+			break;
+	}
+
+	/* whatever arrived was not a response */
+	l->t_write = 0;
+}
+
+
+/**
+ * @brief get the statistics of a serial link
+ *
+ * @param l the serial link
+ * @param[out] st the statistics
+ */
+
+void serial_get_stats(struct serial_link *l, struct serial_stats *st)
+{
+	gdouble bits;
+
+
+	g_mutex_lock(&l->lock);
+	(*st) = l->st;
+	g_mutex_unlock(&l->lock);
+
+	st->t_open_us = g_get_monotonic_time() - l->t_open;
+
+	bits = (gdouble) (st->tx_bytes + st->rx_bytes) * SERIAL_BITS_PER_BYTE;
+
+	/* full duplex, but the backends only ever talk one way at a time */
+	if (st->t_open_us > 0 && l->baud > 0)
+		st->util = bits / (gdouble) l->baud /
+			   ((gdouble) st->t_open_us * 1e-6);
+	else
+		st->util = 0.0;
+}
+
+
+/**
+ * @brief log the statistics of a serial link
+ *
+ * @param l the serial link
+ */
+
+void serial_log_stats(struct serial_link *l)
+{
+	struct serial_stats st;
+
+
+	serial_get_stats(l, &st);
+
+	g_message(MSG "%s: %" G_GUINT64_FORMAT " bytes out, %" G_GUINT64_FORMAT
+		  " bytes in, %.2f%% utilisation, %" G_GUINT64_FORMAT
+		  " timeouts, response latency min/avg/max %.1f/%.1f/%.1f ms",
+		  l->tty, st.tx_bytes, st.rx_bytes, 100.0 * st.util,
+		  st.n_timeout,
+		  (gdouble) st.lat_min_us * 1e-3,
+		  st.n_rsp ? (gdouble) st.lat_sum_us * 1e-3 / (gdouble) st.n_rsp
+			   : 0.0,
+		  (gdouble) st.lat_max_us * 1e-3);
+}
@@ -0,0 +1,401 @@
+/**
+ * @file    server/track.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief sidereal tracking of a sky position
+ *
+ * @note the target is converted to horizontal coordinates for the station
+ *	 location and the drive is commanded whenever the sky has moved the
+ *	 target out of the deadband around the last commanded position; the
+ *	 deadband is the step resolution of the drive, so no command is sent
+ *	 that the drive could not execute anyway
+ *
+ * @note the update interval follows from the time the target takes to drift
+ *	 through the deadband at sidereal rate, so a coarse drive is polled
+ *	 less often than a fine one
+ *
+ * @note tracking runs in a thread of its own and continues regardless of
+ *	 any clients; it is stopped on request, when the target leaves the
+ *	 drive limits or when the drive refuses a move
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include <track.h>
+#include <backend.h>
+#include <cfg.h>
+#include <net.h>
+#include <ack.h>
+#include <coordinates.h>
+
+
+#define MSG "TRACK: "
+
+/* lower limit of the deadband, for drives that report no resolution */
+#define TRACK_DEADBAND_MIN_DEG		0.01
+
+/* the angular rate of the sky in degrees per second */
+#define TRACK_SIDEREAL_DEG_SEC		(360.0 / 86164.0905)
+
+/* update interval limits */
+#define TRACK_INTERVAL_MIN_SEC		1.0
+#define TRACK_INTERVAL_MAX_SEC		60.0
+
+
+static struct {
+	GMutex lock;
+	GCond wake;			/* target changed or tracking stopped */
+
+	GThread *thread;
+
+	gboolean enable;
+	guint32 sys;			/* TRACK_SYS_* */
+	gdouble lon;			/* RA or galactic longitude (deg) */
+	gdouble lat;			/* Dec or galactic latitude (deg) */
+
+	guint64 gen;			/* target generation */
+} track;
+
+
+/**
+ * @brief compute the current horizontal position of a sky position
+ *
+ * @param sys the coordinate system (TRACK_SYS_*)
+ * @param lon the right ascension or galactic longitude in degrees
+ * @param lat the declination or galactic latitude in degrees
+ */
+
+struct coord_horizontal track_get_hor(guint32 sys, gdouble lon, gdouble lat)
+{
+	struct coord_equatorial equ;
+	struct coord_galactic gal;
+
+
+	if (sys == TRACK_SYS_GAL) {
+		gal.lon = lon;
+		gal.lat = lat;
+
+		return galactic_to_horizontal(gal,
+					      server_cfg_get_station_lat(),
+					      server_cfg_get_station_lon(),
+					      0.0);
+	}
+
+	equ.ra  = DEG_TO_HOUR(lon);
+	equ.dec = lat;
+
+	return equatorial_to_horizontal(equ,
+					server_cfg_get_station_lat(),
+					server_cfg_get_station_lon(),
+					0.0);
+}
+
+
+/**
+ * @brief compute the current sky position of a horizontal position
+ *
+ * @param sys the coordinate system (TRACK_SYS_*)
+ * @param hor the horizontal position
+ * @param[out] lon the right ascension or galactic longitude in degrees
+ * @param[out] lat the declination or galactic latitude in degrees
+ */
+
+void track_get_sky(guint32 sys, struct coord_horizontal hor,
+		   gdouble *lon, gdouble *lat)
+{
+	struct coord_equatorial equ;
+	struct coord_galactic gal;
+
+
+	if (sys == TRACK_SYS_GAL) {
+		gal = horizontal_to_galactic(hor,
+					     server_cfg_get_station_lat(),
+					     server_cfg_get_station_lon());
+		(*lon) = gal.lon;
+		(*lat) = gal.lat;
+		return;
+	}
+
+	equ = horizontal_to_equatorial(hor,
+				       server_cfg_get_station_lat(),
+				       server_cfg_get_station_lon(),
+				       0.0);
+
+	(*lon) = HOUR_TO_DEG(equ.ra);
+	(*lat) = equ.dec;
+}
+
+
+/**
+ * @brief check whether a position is within the drive limits
+ *
+ * @note identical azimuth limits are interpreted as no limit
+ */
+
+static gboolean track_in_limits(struct capabilities *c,
+				struct coord_horizontal hor)
+{
+	gdouble az_min = (gdouble) c->az_min_arcsec / 3600.0;
+	gdouble az_max = (gdouble) c->az_max_arcsec / 3600.0;
+	gdouble el_min = (gdouble) c->el_min_arcsec / 3600.0;
+	gdouble el_max = (gdouble) c->el_max_arcsec / 3600.0;
+
+
+	if (az_min != az_max) {
+		if (hor.az < az_min || hor.az > az_max)
+			return FALSE;
+	}
+
+	if (hor.el < el_min || hor.el > el_max)
+		return FALSE;
+
+	return TRUE;
+}
+
+
+/**
+ * @brief stop tracking from the tracking thread and tell the clients why
+ *
+ * @note call with the state locked
+ */
+
+static void track_abort(guint64 gen, const gchar *reason)
+{
+	gchar *msg;
+
+
+	/* superseded in the meantime */
+	if (gen != track.gen || !track.enable)
+		return;
+
+	track.enable = FALSE;
+	track.gen++;
+
+	msg = g_strdup_printf("Tracking stopped: %s\n", reason);
+	g_message(MSG "%s", msg);
+	net_server_broadcast_message(msg, NULL);
+	g_free(msg);
+
+	ack_track(PKT_TRANS_ID_UNDEF, FALSE, track.sys, track.lon, track.lat);
+}
+
+
+/**
+ * @brief the tracking thread
+ */
+
+static gpointer track_thread(gpointer data)
+{
+	guint32 sys;
+	guint64 gen;
+
+	gdouble lon, lat;
+	gdouble d_az, d_el;
+	gdouble db_az, db_el;
+	gdouble interval;
+
+	gint64 end;
+
+	gboolean full_circle;
+	const gchar *reason;
+
+	struct capabilities c;
+	struct coord_horizontal hor;
+	struct coord_horizontal cmd = {0.0, 0.0};
+
+	guint64 cmd_gen = 0;
+
+
+	g_mutex_lock(&track.lock);
+
+	while (1) {
+
+		while (!track.enable)
+			g_cond_wait(&track.wake, &track.lock);
+
+		sys = track.sys;
+		lon = track.lon;
+		lat = track.lat;
+		gen = track.gen;
+
+		g_mutex_unlock(&track.lock);
+
+		reason = NULL;
+
+		memset(&c, 0, sizeof(struct capabilities));
+		be_get_capabilities_drive(&c);
+
+		db_az = MAX((gdouble) c.az_res_arcsec / 3600.0,
+			    TRACK_DEADBAND_MIN_DEG);
+		db_el = MAX((gdouble) c.el_res_arcsec / 3600.0,
+			    TRACK_DEADBAND_MIN_DEG);
+
+		full_circle = (c.az_min_arcsec == c.az_max_arcsec);
+
+		hor = track_get_hor(sys, lon, lat);
+
+		if (!track_in_limits(&c, hor)) {
+			reason = "target is outside of the drive limits";
+		} else {
+			d_az = fabs(hor.az - cmd.az);
+			d_el = fabs(hor.el - cmd.el);
+
+			if (full_circle)
+				d_az = MIN(d_az, 360.0 - d_az);
+
+			/* always move on a new target */
+			if (cmd_gen != gen || d_az >= db_az || d_el >= db_el) {
+
+				if (be_moveto_azel(hor.az, hor.el)) {
+					reason = "drive refused to move";
+				} else {
+					cmd     = hor;
+					cmd_gen = gen;
+				}
+			}
+		}
+
+		interval = 0.5 * MIN(db_az, db_el) / TRACK_SIDEREAL_DEG_SEC;
+		interval = CLAMP(interval, TRACK_INTERVAL_MIN_SEC,
+				 TRACK_INTERVAL_MAX_SEC);
+
+		g_mutex_lock(&track.lock);
+
+		if (reason) {
+			track_abort(gen, reason);
+			continue;
+		}
+
+		end = g_get_monotonic_time() +
+		      (gint64) (interval * (gdouble) G_USEC_PER_SEC);
+
+		while (gen == track.gen) {
+			if (!g_cond_wait_until(&track.wake, &track.lock, end))
+				break;
+		}
+	}
+
+	g_mutex_unlock(&track.lock);
+
+	return NULL;
+}
+
+
+/**
+ * @brief start tracking a position on the sky
+ *
+ * @param sys the coordinate system (TRACK_SYS_*)
+ * @param lon the right ascension or galactic longitude in degrees
+ * @param lat the declination or galactic latitude in degrees
+ *
+ * @returns 0 on success, -1 if the position is not reachable
+ *
+ * @note a new target replaces the current one immediately
+ */
+
+int track_sky(guint32 sys, gdouble lon, gdouble lat)
+{
+	struct capabilities c = {0};
+
+
+	if (sys != TRACK_SYS_EQU && sys != TRACK_SYS_GAL)
+		return -1;
+
+	be_get_capabilities_drive(&c);
+
+	if (!track_in_limits(&c, track_get_hor(sys, lon, lat)))
+		return -1;
+
+	g_mutex_lock(&track.lock);
+
+	track.enable = TRUE;
+	track.sys    = sys;
+	track.lon    = lon;
+	track.lat    = lat;
+	track.gen++;
+
+	if (!track.thread)
+		track.thread = g_thread_new(NULL, track_thread, NULL);
+
+	g_cond_signal(&track.wake);
+
+	g_mutex_unlock(&track.lock);
+
+	g_message(MSG "tracking %s %g/%g", sys == TRACK_SYS_GAL ? "GLON/GLAT" :
+		  "RA/DE", lon, lat);
+
+	ack_track(PKT_TRANS_ID_UNDEF, TRUE, sys, lon, lat);
+
+	return 0;
+}
+
+
+/**
+ * @brief stop tracking
+ *
+ * @note the clients are notified only if tracking was active
+ */
+
+void track_stop(void)
+{
+	gboolean active;
+	guint32 sys;
+	gdouble lon, lat;
+
+
+	g_mutex_lock(&track.lock);
+
+	active = track.enable;
+	sys    = track.sys;
+	lon    = track.lon;
+	lat    = track.lat;
+
+	track.enable = FALSE;
+	track.gen++;
+
+	g_cond_signal(&track.wake);
+
+	g_mutex_unlock(&track.lock);
+
+	if (!active)
+		return;
+
+	g_message(MSG "tracking stopped");
+
+	ack_track(PKT_TRANS_ID_UNDEF, FALSE, sys, lon, lat);
+}
+
+
+/**
+ * @brief distribute the current tracking state
+ */
+
+void track_push_state(void)
+{
+	gboolean enable;
+	guint32 sys;
+	gdouble lon, lat;
+
+
+	g_mutex_lock(&track.lock);
+
+	enable = track.enable;
+	sys    = track.sys;
+	lon    = track.lon;
+	lat    = track.lat;
+
+	g_mutex_unlock(&track.lock);
+
+	ack_track(PKT_TRANS_ID_UNDEF, enable, sys, lon, lat);
+}
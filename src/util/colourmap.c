@@ -0,0 +1,211 @@
+/**
+ * @file    colourmap.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief the false-colour map used for the sky map and the waterfall
+ *
+ * @note the colour ramp is tabulated once; the thresholds and the scaling
+ *	 of the input are folded into a single multiply-add per value that
+ *	 yields the table index, so moving a threshold does not require the
+ *	 table to be rebuilt
+ */
+
+
+#include <string.h>
+
+#include <colourmap.h>
+
+
+/* colour below the lower threshold */
+#define CMAP_R_LO	0
+#define CMAP_G_LO	0
+#define CMAP_B_LO	0
+
+/* colour above the upper threshold */
+#define CMAP_R_HI	255
+#define CMAP_G_HI	255
+#define CMAP_B_HI	255
+
+/* values are indexed in blocks of this size */
+#define CMAP_BLK	256
+
+
+
+/**
+ * @brief get the colour for a value within the thresholds
+ *
+ * @param f the value, normalised to 0.0...1.0
+ * @param[out] rgb the colour
+ *
+ * @note the is scheme is stolen from somewhere, but I don't remember... d'oh!
+ */
+
+static void cmap_ramp(double f, uint8_t *rgb)
+{
+	double R, G, B;
+
+
+	if (f < 2.0/9.0) {
+
+		f = f / (2.0 / 9.0);
+
+		R = (1.0 - f) * (double) CMAP_R_LO;
+		G = (1.0 - f) * (double) CMAP_G_LO;
+		B = CMAP_B_LO + f * (double) (255 - CMAP_B_LO);
+
+
+	} else if (f < (3.0 / 9.0)) {
+
+		f = (f - 2.0 / 9.0 ) / (1.0 / 9.0);
+
+		R = 0.0;
+		G = 255.0 * f;
+		B = 255.0;
+
+	} else if (f < (4.0 / 9.0) ) {
+
+		f = (f - 3.0 / 9.0) / (1.0 / 9.0);
+
+		R = 0.0;
+		G = 255.0;
+		B = 255.0 * (1.0 - f);
+
+	} else if (f < (5.0 / 9.0)) {
+
+		f = (f - 4.0 / 9.0 ) / (1.0 / 9.0);
+
+		R = 255.0 * f;
+		G = 255.0;
+		B = 0.0;
+
+	} else if ( f < (7.0 / 9.0)) {
+
+		f = (f - 5.0 / 9.0 ) / (2.0 / 9.0);
+
+		R = 255.0;
+		G = 255.0 * (1.0 - f);
+		B = 0.0;
+
+	} else if( f < (8.0 / 9.0)) {
+
+		f = (f - 7.0 / 9.0 ) / (1.0 / 9.0);
+
+		R = 255.0;
+		G = 0.0;
+		B = 255.0 * f;
+
+	} else {
+
+		f = (f - 8.0 / 9.0 ) / (1.0 / 9.0);
+
+		R = 255.0 * (0.75 + 0.25 * (1.0 - f));
+		G = 0.5 * 255.0 * f;
+		B = 255.0;
+	}
+
+	rgb[0] = (uint8_t) R;
+	rgb[1] = (uint8_t) G;
+	rgb[2] = (uint8_t) B;
+}
+
+
+/**
+ * @brief tabulate the colour map
+ *
+ * @param c the colour map to initialise
+ */
+
+void cmap_init(struct cmap *c)
+{
+	size_t i;
+
+
+	c->rgb[0][0] = CMAP_R_LO;
+	c->rgb[0][1] = CMAP_G_LO;
+	c->rgb[0][2] = CMAP_B_LO;
+
+	for (i = 0; i < CMAP_LUT_LEN; i++)
+		cmap_ramp(((double) i + 0.5) / (double) CMAP_LUT_LEN,
+			  c->rgb[i + 1]);
+
+	c->rgb[CMAP_LUT_LEN + 1][0] = CMAP_R_HI;
+	c->rgb[CMAP_LUT_LEN + 1][1] = CMAP_G_HI;
+	c->rgb[CMAP_LUT_LEN + 1][2] = CMAP_B_HI;
+}
+
+
+/**
+ * @brief map a line of values to colours
+ *
+ * @param c the colour map
+ * @param val the values
+ * @param n the number of values
+ * @param off the offset subtracted from a value
+ * @param scale the scale applied to a value after the offset, the result is
+ *	  compared against the thresholds
+ * @param th_lo the lower threshold
+ * @param th_hi the upper threshold
+ * @param pix the output pixels, RGB in the first 3 bytes of each pixel
+ * @param nc the number of bytes per pixel
+ *
+ * @note this is not threaded, callers rendering larger images may split
+ *	 them into lines and fill those in parallel
+ */
+
+void cmap_fill(const struct cmap *c, const double *val, size_t n,
+	       double off, double scale, double th_lo, double th_hi,
+	       uint8_t *pix, size_t nc)
+{
+	size_t i, j, m;
+
+	double a, b, k;
+
+	int32_t idx[CMAP_BLK];
+
+	const double top = (double) (CMAP_LUT_LEN + 1);
+
+
+	k = th_hi - th_lo;
+	if (k < 1e-12)
+		k = 1e-12;
+
+	k = (double) CMAP_LUT_LEN / k;
+
+	/* ((v - off) * scale - th_lo) * k + 1, below 1 is below th_lo */
+	a = scale * k;
+	b = (-off * scale - th_lo) * k + 1.0;
+
+	for (i = 0; i < n; i += CMAP_BLK) {
+
+		m = n - i;
+		if (m > CMAP_BLK)
+			m = CMAP_BLK;
+
+#pragma omp simd
+		for (j = 0; j < m; j++) {
+
+			double t = val[i + j] * a + b;
+
+			/* also catches NaN */
+			t = (t >= 0.0) ? t : 0.0;
+			t = (t <= top) ? t : top;
+
+			idx[j] = (int32_t) t;
+		}
+
+		for (j = 0; j < m; j++) {
+			memcpy(pix, c->rgb[idx[j]], 3);
+			pix += nc;
+		}
+	}
+}
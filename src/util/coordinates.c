@@ -22,6 +22,10 @@
 #include <coordinates.h>
 
 
+/* the current time source, NULL selects the system clock */
+static time_t (*coord_time_src)(void);
+
+
 /**
  * @brief map an hour angle to sidereal from mean solar
  *
@@ -94,6 +98,36 @@ time_t epoch(void)
 }
 
 
+/**
+ * @brief set the time source for all time-dependent computations
+ *
+ * @param src a function returning the current time in seconds since the
+ *	      unix epoch, NULL to use the system clock
+ *
+ * @note this may be used to run on a simulated clock
+ */
+
+void coord_set_time_source(time_t (*src)(void))
+{
+	coord_time_src = src;
+}
+
+
+/**
+ * @brief get the current time from the configured time source
+ *
+ * @return the current time in seconds since the unix epoch
+ */
+
+time_t coord_time(void)
+{
+	if (coord_time_src)
+		return coord_time_src();
+
+	return time(NULL);
+}
+
+
 /**
  * @brief get the current universal time
  *
@@ -105,7 +139,7 @@ struct tm *get_UT(void)
 	time_t current;
 
 
-	time(&current);
+	current = coord_time();
 
 	return gmtime(&current);
 }
@@ -0,0 +1,319 @@
+/**
+ * @file    fft2d.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief two-dimensional real-to-complex and complex-to-real transforms
+ *
+ * @note the spectrum of a real matrix is hermitian, so only the w / 2 + 1
+ *	 non-redundant columns are stored; two rows at a time are transformed
+ *	 as the real and imaginary parts of one complex row and separated
+ *	 afterwards
+ *
+ * @note the columns are not transformed one at a time, which would touch a
+ *	 new cache line for every element, but in blocks of FFT2D_BLK: a block
+ *	 is transposed into the scratch space of the thread, where each column
+ *	 is contiguous, transformed and transposed back; reading a block row
+ *	 uses full cache lines
+ *
+ * @note the scratch space for all threads is allocated with the plan, so
+ *	 the transforms themselves do not allocate; in turn, a plan must not
+ *	 be used by more than one caller at a time
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <complex.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <fourier_transform.h>
+
+
+/* columns transformed per block, 8 complex doubles are 2 cache lines */
+#define FFT2D_BLK	8
+
+
+/**
+ * @brief a two-dimensional transform plan
+ */
+
+struct fft2d_plan {
+	size_t w;			/* width of the real matrix */
+	size_t h;			/* height of the real matrix */
+	size_t hw;			/* width of the spectrum */
+
+	struct fft_plan *row_fwd;
+	struct fft_plan *row_inv;
+	struct fft_plan *col_fwd;
+	struct fft_plan *col_inv;
+
+	int nthr;			/* number of threads */
+	size_t stride;			/* scratch elements per thread */
+	double complex *scratch;
+};
+
+
+/**
+ * @brief get the scratch space of the calling thread
+ */
+
+static double complex *fft2d_scratch(const struct fft2d_plan *p)
+{
+#ifdef _OPENMP
+	return &p->scratch[(size_t) omp_get_thread_num() * p->stride];
+#else
+	return p->scratch;
+#endif
+}
+
+
+/**
+ * @brief in-place separate the spectra of two real rows transformed at once
+ *
+ * @param z the transform of a + i * b, holds the spectrum of a on return
+ * @param[out] fb the spectrum of b
+ * @param n the length of the transform
+ *
+ * @note only the n / 2 + 1 non-redundant bins are computed
+ */
+
+static void fft2d_split_real_pair(double complex *z, double complex *fb,
+				  size_t n)
+{
+	size_t k;
+
+	double complex zk;
+	double complex zn;
+
+
+	/* z[n - k] is never in the part we overwrite, except for k == 0 and
+	 * k == n / 2, which are their own mirrors
+	 */
+	for (k = 0; k <= n / 2; k++) {
+
+		zk = z[k];
+		zn = conj(z[(n - k) % n]);
+
+		z[k]  =  0.5 * (zk + zn);
+		fb[k] = -0.5 * I * (zk - zn);
+	}
+}
+
+
+/**
+ * @brief transform the columns of a spectrum in blocks
+ *
+ * @param p the plan
+ * @param data the h x hw spectrum
+ * @param col the column plan to use
+ */
+
+static void fft2d_columns(const struct fft2d_plan *p, double complex *data,
+			  const struct fft_plan *col)
+{
+	size_t i, j, b;
+	size_t j0, nb;
+
+	double complex *t;
+
+
+#pragma omp parallel for num_threads(p->nthr) private(i, j, b, nb, t)
+	for (j0 = 0; j0 < p->hw; j0 += FFT2D_BLK) {
+
+		t  = fft2d_scratch(p);
+		nb = p->hw - j0;
+		if (nb > FFT2D_BLK)
+			nb = FFT2D_BLK;
+
+		for (i = 0; i < p->h; i++) {
+			for (b = 0; b < nb; b++)
+				t[b * p->h + i] = data[i * p->hw + j0 + b];
+		}
+
+		for (b = 0; b < nb; b++)
+			fft_plan_execute(col, &t[b * p->h]);
+
+		for (i = 0; i < p->h; i++) {
+			for (j = j0, b = 0; b < nb; b++, j++)
+				data[i * p->hw + j] = t[b * p->h + i];
+		}
+	}
+}
+
+
+/**
+ * @brief create a two-dimensional transform plan
+ *
+ * @param w the width of the real matrix (a power of two)
+ * @param h the height of the real matrix (a power of two, at least 2)
+ *
+ * @returns the plan or NULL on error
+ */
+
+struct fft2d_plan *fft2d_plan_create(size_t w, size_t h)
+{
+	struct fft2d_plan *p;
+
+
+	if (w < 2 || h < 2)
+		return NULL;
+
+	p = calloc(1, sizeof(struct fft2d_plan));
+	if (!p)
+		return NULL;
+
+	p->w  = w;
+	p->h  = h;
+	p->hw = w / 2 + 1;
+
+	p->row_fwd = fft_plan_create(w, FFT_FORWARD);
+	p->row_inv = fft_plan_create(w, FFT_INVERSE);
+	p->col_fwd = fft_plan_create(h, FFT_FORWARD);
+	p->col_inv = fft_plan_create(h, FFT_INVERSE);
+
+#ifdef _OPENMP
+	p->nthr = omp_get_max_threads();
+#else
+	p->nthr = 1;
+#endif
+	/* a row or a block of columns */
+	p->stride = w;
+	if (p->stride < FFT2D_BLK * h)
+		p->stride = FFT2D_BLK * h;
+
+	p->scratch = malloc((size_t) p->nthr * p->stride *
+			    sizeof(double complex));
+
+	if (!p->row_fwd || !p->row_inv || !p->col_fwd || !p->col_inv ||
+	    !p->scratch) {
+		fft2d_plan_destroy(p);
+		return NULL;
+	}
+
+	return p;
+}
+
+
+/**
+ * @brief destroy a two-dimensional transform plan
+ *
+ * @param p the plan (may be NULL)
+ */
+
+void fft2d_plan_destroy(struct fft2d_plan *p)
+{
+	if (!p)
+		return;
+
+	fft_plan_destroy(p->row_fwd);
+	fft_plan_destroy(p->row_inv);
+	fft_plan_destroy(p->col_fwd);
+	fft_plan_destroy(p->col_inv);
+
+	free(p->scratch);
+	free(p);
+}
+
+
+/**
+ * @brief two-dimensional real-to-complex fft
+ *
+ * @param p the plan
+ * @param data the h x w real input matrix
+ * @param out the h x (w / 2 + 1) output matrix
+ */
+
+void fft2d_r2c(const struct fft2d_plan *p, const double *data,
+	       double complex *out)
+{
+	size_t i, j;
+
+	double complex *z;
+
+	const size_t w  = p->w;
+	const size_t hw = p->hw;
+
+
+	/* rows, two at a time */
+#pragma omp parallel for num_threads(p->nthr) private(j, z)
+	for (i = 0; i < p->h; i += 2) {
+
+		z = fft2d_scratch(p);
+
+		for (j = 0; j < w; j++)
+			z[j] = data[i * w + j] + I * data[(i + 1) * w + j];
+
+		fft_plan_execute(p->row_fwd, z);
+		fft2d_split_real_pair(z, &out[(i + 1) * hw], w);
+
+		memcpy(&out[i * hw], z, hw * sizeof(double complex));
+	}
+
+	fft2d_columns(p, out, p->col_fwd);
+}
+
+
+/**
+ * @brief two-dimensional complex-to-real inverse fft
+ *
+ * @param p the plan
+ * @param data the h x (w / 2 + 1) hermitian spectrum, destroyed on return
+ * @param out the h x w real output matrix
+ *
+ * @note this is the inverse of fft2d_r2c(); after the columns are
+ *	 transformed, two rows at a time are joined into a + i * b, so a single
+ *	 complex inverse transform yields both real rows
+ */
+
+void fft2d_c2r(const struct fft2d_plan *p, double complex *data, double *out)
+{
+	size_t i, j;
+
+	double complex *a;
+	double complex *b;
+	double complex *z;
+
+	const size_t w  = p->w;
+	const size_t hw = p->hw;
+
+
+	fft2d_columns(p, data, p->col_inv);
+
+	/* rows, two at a time */
+#pragma omp parallel for num_threads(p->nthr) private(j, a, b, z)
+	for (i = 0; i < p->h; i += 2) {
+
+		z = fft2d_scratch(p);
+
+		a = &data[i * hw];
+		b = &data[(i + 1) * hw];
+
+		for (j = 0; j < hw; j++)
+			z[j] = a[j] + I * b[j];
+
+		/* restore the redundant half */
+		for (j = hw; j < w; j++)
+			z[j] = conj(a[w - j]) + I * conj(b[w - j]);
+
+		fft_plan_execute(p->row_inv, z);
+
+		for (j = 0; j < w; j++) {
+			out[i * w + j]       = creal(z[j]);
+			out[(i + 1) * w + j] = cimag(z[j]);
+		}
+	}
+}
@@ -0,0 +1,283 @@
+/**
+ * @file    fft_bench.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief check and time the planned fft against fft2() and the former
+ *	  recursive implementation
+ *
+ * @note this is not built by default, use "make fft_bench" in src/util
+ *
+ *	 usage: fft_bench [min log2 n] [max log2 n]
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <math.h>
+#include <complex.h>
+
+#include <fourier_transform.h>
+
+
+/* minimum run time per size and implementation in seconds */
+#define BENCH_SEC	0.5
+
+
+
+/**
+ * @brief the former recursive fft, kept for reference
+ */
+
+static void fft_recursive_internal(double complex *tmp, double complex *out,
+				   const double complex *c, size_t n, size_t stp)
+{
+	size_t i;
+	size_t i2;
+
+	double complex t;
+
+
+	if (stp >= n)
+		return;
+
+	fft_recursive_internal(out,       tmp,       c, n, 2 * stp);
+	fft_recursive_internal(out + stp, tmp + stp, c, n, 2 * stp);
+
+	for (i = 0, i2 = 0; i < n; i += 2 * stp, i2 += stp) {
+
+		t = c[i2] * out[stp + i];
+
+		tmp[i2        ] = out[i] + t ;
+		tmp[i2 + n / 2] = out[i] - t;
+	}
+}
+
+
+/**
+ * @brief the former fft2(), including its scratch buffer
+ */
+
+static void fft_recursive(double complex *data, const double complex *c,
+			  size_t n)
+{
+	double complex *tmp;
+
+
+	tmp = malloc(n * sizeof(double complex));
+	memcpy(tmp, data, n * sizeof(double complex));
+
+	fft_recursive_internal(data, tmp, c, n, 1);
+
+	free(tmp);
+}
+
+
+static double now(void)
+{
+	struct timespec ts;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (double) ts.tv_sec + 1e-9 * (double) ts.tv_nsec;
+}
+
+
+static double max_diff(const double complex *a, const double complex *b,
+		       size_t n)
+{
+	size_t i;
+
+	double d = 0.0;
+
+
+	for (i = 0; i < n; i++)
+		d = fmax(d, cabs(a[i] - b[i]));
+
+	return d;
+}
+
+
+/**
+ * @brief check a size against the reference DFT and the round trip
+ *
+ * @returns 0 if all is well
+ */
+
+static int check(size_t n)
+{
+	size_t i;
+
+	int ret = 0;
+
+	double e_fwd;
+	double e_inv;
+
+	double complex *x;
+	double complex *y;
+	double complex *r;
+	double complex *c;
+
+	struct fft_plan *fwd;
+	struct fft_plan *inv;
+
+
+	x = malloc(n * sizeof(double complex));
+	y = malloc(n * sizeof(double complex));
+	r = malloc(n * sizeof(double complex));
+
+	for (i = 0; i < n; i++)
+		x[i] = drand48() - 0.5 + I * (drand48() - 0.5);
+
+	fwd = fft_plan_create(n, FFT_FORWARD);
+	inv = fft_plan_create(n, FFT_INVERSE);
+
+	memcpy(y, x, n * sizeof(double complex));
+	fft_plan_execute(fwd, y);
+
+	/* the DFT takes forever for larger sizes */
+	if (n <= 2048) {
+		dft(x, r, (int) n);
+	} else {
+		c = fft_prepare_coeff(n, FFT_FORWARD);
+		memcpy(r, x, n * sizeof(double complex));
+		fft_recursive(r, c, n);
+		free(c);
+	}
+
+	e_fwd = max_diff(y, r, n) / sqrt((double) n);
+
+	fft_plan_execute(inv, y);
+	e_inv = max_diff(y, x, n);
+
+	/* compare fft2() as well */
+	memcpy(r, x, n * sizeof(double complex));
+	fft2(r, NULL, n, FFT_FORWARD);
+	fft2(r, NULL, n, FFT_INVERSE);
+	e_inv = fmax(e_inv, max_diff(r, x, n));
+
+	if (e_fwd > 1e-12 || e_inv > 1e-12) {
+		printf("n = %zu: error %g (forward) %g (round trip)\n",
+		       n, e_fwd, e_inv);
+		ret = -1;
+	}
+
+	fft_plan_destroy(fwd);
+	fft_plan_destroy(inv);
+
+	free(x);
+	free(y);
+	free(r);
+
+	return ret;
+}
+
+
+/**
+ * @brief time the implementations for a size
+ */
+
+static void bench(size_t n)
+{
+	size_t i;
+	size_t cnt;
+
+	double t0;
+	double t_rec, t_fft2, t_plan;
+
+	double complex *x;
+	double complex *c;
+
+	struct fft_plan *p;
+
+
+	x = malloc(n * sizeof(double complex));
+	for (i = 0; i < n; i++)
+		x[i] = drand48() - 0.5 + I * (drand48() - 0.5);
+
+	c = fft_prepare_coeff(n, FFT_FORWARD);
+	p = fft_plan_create(n, FFT_FORWARD);
+
+	/* the transforms are unnormalised, so the data grow; this does not
+	 * matter for the timing as long as they stay finite, so rescale now
+	 * and then
+	 */
+
+	t0 = now();
+	for (cnt = 0; now() - t0 < BENCH_SEC; cnt++) {
+		fft_recursive(x, c, n);
+		x[0] = x[1] = 1.0;
+		if (!(cnt & 15))
+			memset(x, 0, n * sizeof(double complex));
+	}
+	t_rec = (now() - t0) / (double) cnt;
+
+	t0 = now();
+	for (cnt = 0; now() - t0 < BENCH_SEC; cnt++) {
+		fft2(x, c, n, FFT_FORWARD);
+		x[0] = x[1] = 1.0;
+		if (!(cnt & 15))
+			memset(x, 0, n * sizeof(double complex));
+	}
+	t_fft2 = (now() - t0) / (double) cnt;
+
+	t0 = now();
+	for (cnt = 0; now() - t0 < BENCH_SEC; cnt++) {
+		fft_plan_execute(p, x);
+		x[0] = x[1] = 1.0;
+		if (!(cnt & 15))
+			memset(x, 0, n * sizeof(double complex));
+	}
+	t_plan = (now() - t0) / (double) cnt;
+
+	printf("%8zu %14.2f %14.2f %14.2f %8.1fx\n", n,
+	       t_rec * 1e6, t_fft2 * 1e6, t_plan * 1e6, t_rec / t_plan);
+
+	fft_plan_destroy(p);
+	free(c);
+	free(x);
+}
+
+
+int main(int argc, char *argv[])
+{
+	size_t i;
+	size_t lo = 4;
+	size_t hi = 16;
+
+
+	if (argc > 1)
+		lo = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		hi = strtoul(argv[2], NULL, 0);
+
+	for (i = 0; i <= 20; i++) {
+		if (check((size_t) 1 << i)) {
+			printf("check failed\n");
+			return EXIT_FAILURE;
+		}
+	}
+
+	printf("all sizes up to 2^20 check out\n\n");
+
+	printf("%8s %14s %14s %14s %9s\n", "n", "recursive/us", "fft2/us",
+	       "plan/us", "speedup");
+
+	for (i = lo; i <= hi; i++)
+		bench((size_t) 1 << i);
+
+	return EXIT_SUCCESS;
+}
@@ -15,16 +15,44 @@
  * @brief provides an implementation of a FFT (Cooley-Tuckey-ish)
  *
  * @note this is not an ideal implementation, it just works for my purpose
+ *
+ * @note for repeated transforms of the same size, create a plan with
+ *	 fft_plan_create() and use fft_plan_execute(); the plan holds the
+ *	 bit-reversal permutation and the twiddles of every stage in the order
+ *	 they are used, the transform runs in place in radix-4 passes (plus one
+ *	 radix-2 pass for odd powers of two) and the butterflies are written
+ *	 out in real arithmetic, so they vectorise and never end up in the
+ *	 libgcc complex multiply with its inf/nan handling
  */
 
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #include <math.h>
 #include <complex.h>
 
+#include <fourier_transform.h>
+
+
+/**
+ * @brief a transform plan
+ */
+
+struct fft_plan {
+	size_t n;		/* transform size */
+	int inv;		/* direction, FFT_FORWARD or FFT_INVERSE */
+
+	size_t nswp;		/* number of bit-reversal swaps */
+	uint32_t *swp;		/* pairs of indices to swap */
+
+	double complex *tw;	/* twiddles of the stage with half size h
+				 * start at tw[h - 1], n - 1 in total
+				 */
+};
+
 
 /**
  * @brief essentially 2^(log2(n -1) + 1)
@@ -41,35 +69,37 @@ static size_t get_next_pow_2_bound(size_t n)
 	return (1 << (c + 1));
 }
 
-#if 0
-#pragma GCC optimize("O3","unroll-loops","omit-frame-pointer","inline") //Optimization flags
-#pragma GCC option("arch=native","tune=native","no-zero-upper") //Enable AVX
-#pragma GCC target("avx")  //Enable AVX
-#endif
+/**
+ * @brief reverse the lowest bits of an index
+ */
 
-static void fft_internal(double complex *tmp, double complex *out,
-			 const double complex *c, size_t n, int stp)
+static size_t bit_reverse(size_t i, size_t bits)
 {
-	size_t i;
-	size_t i2;
+	size_t r = 0;
 
-	double complex t;
-	double complex t2;
 
+	while (bits--) {
+		r = (r << 1) | (i & 1);
+		i >>= 1;
+	}
 
-	if (stp >= n)
-		return;
+	return r;
+}
 
-	fft_internal(out,        tmp,      c, n, 2 * stp);
-	fft_internal(out + stp, tmp + stp, c, n, 2 * stp);
 
-	for (i = 0, i2 = 0; i < n; i += 2 * stp, i2 += stp) {
+/**
+ * @brief get the number of bits of a power of two
+ */
 
-		t = c[i2] * out[stp + i];
+static size_t log2_pow2(size_t n)
+{
+	size_t c = 0;
 
-		tmp[i2        ] = out[i] + t ;
-		tmp[i2 + n / 2] = out[i] - t;
-	}
+
+	while (n >>= 1)
+		c++;
+
+	return c;
 }
 
 
@@ -163,10 +193,12 @@ double complex *fft_extract(const double complex *data, size_t fftsize,
 
 int fft2(double complex *data, double complex *coeff, size_t n, int inv)
 {
-	size_t i;
+	size_t i, j, k;
+	size_t h, s;
+	size_t bits;
 
+	double complex t;
 	double complex *c;
-	double complex *tmp;
 
 
 	if (!n)
@@ -179,25 +211,42 @@ int fft2(double complex *data, double complex *coeff, size_t n, int inv)
 	if (!data)
 		return -1;
 
-	/* create a work copy */
-	tmp = malloc(n * sizeof(double complex));
-	if (!tmp)
-		return -1;
-
-	memcpy(tmp, data, n * sizeof(double complex));
-
 	if (!coeff)
 		c = fft_prepare_coeff(n, inv);
 	else
 		c = coeff;
 
-	if (!c) {
-		free(tmp);
+	if (!c)
 		return -1;
+
+	bits = log2_pow2(n);
+
+	for (i = 0; i < n; i++) {
+
+		j = bit_reverse(i, bits);
+
+		if (i < j) {
+			t       = data[i];
+			data[i] = data[j];
+			data[j] = t;
+		}
 	}
 
+	/* stage with half size h uses every (n / 2h)th coefficient */
+	for (h = 1; h < n; h <<= 1) {
+
+		s = n / (2 * h);
 
-	fft_internal(data, tmp, c, n, 1);
+		for (i = 0; i < n; i += 2 * h) {
+			for (k = 0; k < h; k++) {
+
+				t = c[k * s] * data[i + k + h];
+
+				data[i + k + h] = data[i + k] - t;
+				data[i + k]     = data[i + k] + t;
+			}
+		}
+	}
 
 	/* normalise inverse transform*/
 	if (inv) {
@@ -205,8 +254,6 @@ int fft2(double complex *data, double complex *coeff, size_t n, int inv)
 			data[i] /= (double) n;
 	}
 
-	free(tmp);
-
 	if (!coeff)
 		free(c);
 
@@ -214,6 +261,280 @@ int fft2(double complex *data, double complex *coeff, size_t n, int inv)
 }
 
 
+/**
+ * @brief create a transform plan
+ *
+ * @param n the length of the transform (must be a power of two)
+ * @param inv direction of the transform (FFT_FORWARD or FFT_INVERSE)
+ *
+ * @returns the plan or NULL on error
+ *
+ * @note a plan is not modified by fft_plan_execute(), so a single plan may
+ *	 be used by any number of threads at once
+ */
+
+struct fft_plan *fft_plan_create(size_t n, int inv)
+{
+	size_t i, j;
+	size_t h, k;
+	size_t bits;
+
+	double sig;
+
+	struct fft_plan *p;
+
+
+	if (!n || (n & (n - 1)))
+		return NULL;
+
+	if (n > UINT32_MAX)
+		return NULL;
+
+	p = calloc(1, sizeof(struct fft_plan));
+	if (!p)
+		return NULL;
+
+	p->n   = n;
+	p->inv = inv;
+
+	bits = log2_pow2(n);
+
+	/* less than n / 2 swaps */
+	p->swp = malloc(n * sizeof(uint32_t));
+	p->tw  = malloc(n * sizeof(double complex));
+
+	if (!p->swp || !p->tw) {
+		fft_plan_destroy(p);
+		return NULL;
+	}
+
+	for (i = 0; i < n; i++) {
+
+		j = bit_reverse(i, bits);
+
+		if (i < j) {
+			p->swp[2 * p->nswp]     = (uint32_t) i;
+			p->swp[2 * p->nswp + 1] = (uint32_t) j;
+			p->nswp++;
+		}
+	}
+
+	if (inv)
+		sig =  1.0;
+	else
+		sig = -1.0;
+
+	for (h = 1; h < n; h <<= 1) {
+		for (k = 0; k < h; k++)
+			p->tw[h - 1 + k] = cexp(sig * I * M_PI * (double) k /
+						(double) h);
+	}
+
+	return p;
+}
+
+
+/**
+ * @brief destroy a transform plan
+ *
+ * @param p the plan (may be NULL)
+ */
+
+void fft_plan_destroy(struct fft_plan *p)
+{
+	if (!p)
+		return;
+
+	free(p->swp);
+	free(p->tw);
+	free(p);
+}
+
+
+/**
+ * @brief get the size of a plan
+ */
+
+size_t fft_plan_size(const struct fft_plan *p)
+{
+	return p->n;
+}
+
+
+/**
+ * @brief the first radix-2 pass, all twiddles are 1
+ *
+ * @param d the data as interleaved real and imaginary parts
+ * @param n the transform size
+ */
+
+static void fft_pass_radix2(double *restrict d, size_t n)
+{
+	size_t j;
+
+	double ar, ai;
+	double br, bi;
+
+
+#pragma omp simd private(ar, ai, br, bi)
+	for (j = 0; j < n; j += 2) {
+
+		ar = d[2 * j];
+		ai = d[2 * j + 1];
+		br = d[2 * j + 2];
+		bi = d[2 * j + 3];
+
+		d[2 * j]     = ar + br;
+		d[2 * j + 1] = ai + bi;
+		d[2 * j + 2] = ar - br;
+		d[2 * j + 3] = ai - bi;
+	}
+}
+
+
+/**
+ * @brief a radix-4 pass, i.e. the stages with half sizes h and 2h at once
+ *
+ * @param d the data as interleaved real and imaginary parts
+ * @param n the transform size
+ * @param h the half size of the first stage
+ * @param w1 the twiddles of the first stage (h of them)
+ * @param w2 the twiddles of the second stage (the first h of them)
+ * @param s -1.0 for the forward, 1.0 for the inverse transform
+ *
+ * @note the second stage twiddles w2[k + h] are w2[k] * (s * i), so only
+ *	 the first half is needed
+ */
+
+static void fft_pass_radix4(double *restrict d, size_t n, size_t h,
+			    const double *restrict w1,
+			    const double *restrict w2, double s)
+{
+	size_t j, k;
+
+	double *x0, *x1, *x2, *x3;
+
+
+	for (j = 0; j < n; j += 4 * h) {
+
+		x0 = &d[2 * j];
+		x1 = &d[2 * (j + h)];
+		x2 = &d[2 * (j + 2 * h)];
+		x3 = &d[2 * (j + 3 * h)];
+
+#pragma omp simd
+		for (k = 0; k < h; k++) {
+
+			double ar, ai, br, bi, cr, ci, dr, di;
+			double tr, ti, ur, ui;
+
+			const double w1r = w1[2 * k], w1i = w1[2 * k + 1];
+			const double w2r = w2[2 * k], w2i = w2[2 * k + 1];
+
+
+			/* first stage */
+			tr = w1r * x1[2 * k] - w1i * x1[2 * k + 1];
+			ti = w1r * x1[2 * k + 1] + w1i * x1[2 * k];
+
+			ar = x0[2 * k] + tr;
+			ai = x0[2 * k + 1] + ti;
+			br = x0[2 * k] - tr;
+			bi = x0[2 * k + 1] - ti;
+
+			tr = w1r * x3[2 * k] - w1i * x3[2 * k + 1];
+			ti = w1r * x3[2 * k + 1] + w1i * x3[2 * k];
+
+			cr = x2[2 * k] + tr;
+			ci = x2[2 * k + 1] + ti;
+			dr = x2[2 * k] - tr;
+			di = x2[2 * k + 1] - ti;
+
+			/* second stage */
+			tr = w2r * cr - w2i * ci;
+			ti = w2r * ci + w2i * cr;
+
+			ur = w2r * dr - w2i * di;
+			ui = w2r * di + w2i * dr;
+
+			/* times s * i */
+			dr = -s * ui;
+			di =  s * ur;
+
+			x0[2 * k]     = ar + tr;
+			x0[2 * k + 1] = ai + ti;
+			x2[2 * k]     = ar - tr;
+			x2[2 * k + 1] = ai - ti;
+
+			x1[2 * k]     = br + dr;
+			x1[2 * k + 1] = bi + di;
+			x3[2 * k]     = br - dr;
+			x3[2 * k + 1] = bi - di;
+		}
+	}
+}
+
+
+/**
+ * @brief perform an in-place fft according to a plan
+ *
+ * @param p the plan
+ * @param data the data buffer of fft_plan_size() elements
+ *
+ * @note like fft2(), the inverse transform is normalised
+ */
+
+void fft_plan_execute(const struct fft_plan *p, double complex *data)
+{
+	size_t i;
+	size_t h;
+
+	uint32_t a, b;
+
+	double s;
+	double f;
+	double complex t;
+
+	double *d = (double *) data;
+
+
+	for (i = 0; i < p->nswp; i++) {
+
+		a = p->swp[2 * i];
+		b = p->swp[2 * i + 1];
+
+		t       = data[a];
+		data[a] = data[b];
+		data[b] = t;
+	}
+
+	h = 1;
+
+	if (log2_pow2(p->n) & 1) {
+		fft_pass_radix2(d, p->n);
+		h = 2;
+	}
+
+	if (p->inv)
+		s =  1.0;
+	else
+		s = -1.0;
+
+	for (; h < p->n; h *= 4)
+		fft_pass_radix4(d, p->n, h,
+				(const double *) &p->tw[h - 1],
+				(const double *) &p->tw[2 * h - 1], s);
+
+	if (p->inv) {
+
+		f = 1.0 / (double) p->n;
+
+#pragma omp simd
+		for (i = 0; i < 2 * p->n; i++)
+			d[i] *= f;
+	}
+}
+
+
 
 /**
  * @brief perform an fft on a buffer of arbitrary size
@@ -0,0 +1,206 @@
+/**
+ * @file    prng.c
+ * @author  Armin Luntzer (armin.luntzer@univie.ac.at)
+ *
+ * @copyright GPLv2
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * @brief a seedable xoshiro256** pseudo random number generator with a
+ *	  block-wise gaussian deviate generator
+ *
+ * @note the generator keeps no global state, so each thread must use its own
+ *	 struct prng; use prng_jump() to derive non-overlapping streams from
+ *	 a common seed
+ *
+ * @see http://prng.di.unimi.it/
+ */
+
+
+#include <string.h>
+#include <math.h>
+
+#include <prng.h>
+
+
+/* number of gaussian pairs generated per block */
+#define PRNG_GAUSS_BLK	256
+
+
+
+static inline uint64_t rotl(const uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+
+/**
+ * @brief splitmix64 step, used to expand a seed into the generator state
+ */
+
+static uint64_t splitmix64(uint64_t *x)
+{
+	uint64_t z;
+
+
+	z = ((*x) += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+
+
+/**
+ * @brief seed a generator
+ *
+ * @param p the generator state
+ * @param seed an arbitrary seed value
+ *
+ * @note the same seed always produces the same sequence
+ */
+
+void prng_seed(struct prng *p, uint64_t seed)
+{
+	int i;
+
+
+	for (i = 0; i < 4; i++)
+		p->s[i] = splitmix64(&seed);
+}
+
+
+/**
+ * @brief get the next 64 bit random number
+ */
+
+uint64_t prng_next(struct prng *p)
+{
+	uint64_t t;
+	uint64_t res;
+
+
+	res = rotl(p->s[1] * 5, 7) * 9;
+
+	t = p->s[1] << 17;
+
+	p->s[2] ^= p->s[0];
+	p->s[3] ^= p->s[1];
+	p->s[1] ^= p->s[2];
+	p->s[0] ^= p->s[3];
+
+	p->s[2] ^= t;
+
+	p->s[3] = rotl(p->s[3], 45);
+
+	return res;
+}
+
+
+/**
+ * @brief advance the generator by 2^128 steps
+ *
+ * @note this is equivalent to 2^128 calls to prng_next(); it can be used to
+ *	 generate 2^128 non-overlapping sequences for parallel computations
+ */
+
+void prng_jump(struct prng *p)
+{
+	int i, b;
+
+	uint64_t s[4] = {0};
+
+	static const uint64_t jump[] = {0x180ec6d33cfd0abaULL,
+					0xd5a61266f0c9392cULL,
+					0xa9582618e03fc9aaULL,
+					0x39abdc4529b1661cULL};
+
+
+	for (i = 0; i < 4; i++) {
+		for (b = 0; b < 64; b++) {
+
+			if (jump[i] & (1ULL << b)) {
+				s[0] ^= p->s[0];
+				s[1] ^= p->s[1];
+				s[2] ^= p->s[2];
+				s[3] ^= p->s[3];
+			}
+
+			prng_next(p);
+		}
+	}
+
+	memcpy(p->s, s, sizeof(s));
+}
+
+
+/**
+ * @brief get a uniform deviate in [0, 1)
+ */
+
+double prng_uniform(struct prng *p)
+{
+	return (double) (prng_next(p) >> 11) * 0x1.0p-53;
+}
+
+
+/**
+ * @brief fill a buffer with standard normal deviates
+ *
+ * @param p the generator state
+ * @param buf the buffer to fill
+ * @param n the number of elements in the buffer
+ *
+ * @note this is a Box-Muller transform, the uniform deviates are drawn for
+ *	 a whole block first, so the transcendental part can be vectorised
+ */
+
+void prng_gauss_fill(struct prng *p, double *buf, size_t n)
+{
+	size_t i;
+	size_t m;
+	size_t k;
+
+	double r;
+
+	double u[PRNG_GAUSS_BLK];
+	double v[PRNG_GAUSS_BLK];
+	double w[PRNG_GAUSS_BLK];
+
+
+	while (n) {
+
+		/* each pair of uniform deviates yields two gaussians */
+		m = (n + 1) / 2;
+		if (m > PRNG_GAUSS_BLK)
+			m = PRNG_GAUSS_BLK;
+
+		k = 2 * m;
+		if (k > n)
+			k = n;
+
+		/* u must be in (0, 1] for the logarithm */
+		for (i = 0; i < m; i++) {
+			u[i] = 1.0 - prng_uniform(p);
+			v[i] = prng_uniform(p);
+		}
+
+#pragma omp simd private(r)
+		for (i = 0; i < m; i++) {
+			r = sqrt(-2.0 * log(u[i]));
+			buf[i] = r * cos(2.0 * M_PI * v[i]);
+			w[i]   = r * sin(2.0 * M_PI * v[i]);
+		}
+
+		memcpy(&buf[m], w, (k - m) * sizeof(double));
+
+		buf += k;
+		n   -= k;
+	}
+}